@@ -0,0 +1,228 @@
+## -*- Mode: CPerl -*-
+
+## File: DTA::TokWrap::XS.pm
+## Author: Bryan Jurish <moocow@cpan.org>
+## Description: DTA tokenizer wrappers: in-process bindings for libdtatw
+
+package DTA::TokWrap::XS;
+
+use XSLoader;
+use strict;
+
+our $VERSION = '0.99';
+XSLoader::load('DTA::TokWrap::XS', $VERSION);
+
+1; ##-- be happy
+
+__END__
+
+##========================================================================
+## POD DOCUMENTATION
+=pod
+
+=head1 NAME
+
+DTA::TokWrap::XS - DTA tokenizer wrappers: in-process bindings for the dta-tokwrap C utilities
+
+=head1 SYNOPSIS
+
+ use DTA::TokWrap::XS;
+ 
+ $nchrs   = DTA::TokWrap::XS::mkindex($xmlfile, $cxfile, $sxfile, $txfile, $njobs, $compress);
+ $ttdata  = DTA::TokWrap::XS::b2xb($tdata, $cxfile, $bxfile, $tfilename, $coords);
+ $txmldata = DTA::TokWrap::XS::tok2xml($ttdata, $xmlbase, $ttfilename, $coords);
+ 
+ $cxp = DTA::TokWrap::XS::CxData->new($cxfile);
+ $cx  = $cxp->record($i);
+
+=head1 DESCRIPTION
+
+DTA::TokWrap::XS provides perl bindings for F<libdtatw>, the C core of the
+F<dtatw-mkindex>, F<dtatw-b2xb>, and F<dtatw-tok2xml> programs.
+If it is installed, the
+L<DTA::TokWrap::Processor::mkindex|DTA::TokWrap::Processor::mkindex> and
+L<DTA::TokWrap::Processor::tok2xml|DTA::TokWrap::Processor::tok2xml>
+processors call these functions in-process instead of spawning external programs,
+and pass tokenizer data directly as perl scalars.
+
+Output is identical to that of the corresponding programs.
+As for the programs, gzip- or zstd-compressed input files (e.g. F<.cx>, F<.bx>)
+are decompressed transparently if F<libdtatw> was built with zlib or libzstd.
+All functions croak() on error.
+
+This module is not built by the top-level F<configure> script.
+Build the C sources first, then:
+
+ cd DTA-TokWrap-XS
+ perl Makefile.PL    ##-- or: DTATW_SRCDIR=/path/to/src DTATW_BUILDDIR=/path/to/build/src perl Makefile.PL
+ make && make test && make install
+
+=head1 FUNCTIONS
+
+=over 4
+
+=item mkindex
+
+ $nchrs = DTA::TokWrap::XS::mkindex($xmlfile, $cxfile, $sxfile, $txfile, $njobs, $compress);
+
+Equivalent to C<dtatw-mkindex --compress=$compress $xmlfile $cxfile $sxfile $txfile $njobs>,
+but undefined or empty output filenames suppress the respective output.
+$compress is an optional output compression specification
+(C<zstd[:LEVEL]>, C<gzip[:LEVEL]>, or C<none> (default)).
+As in F<dtatw-mkindex>, each output file is written (and compressed) by its own writer thread.
+Returns the number of logical characters indexed.
+
+=item b2xb
+
+ $ttdata = DTA::TokWrap::XS::b2xb($tdata, $cxfile, $bxfile, $tfilename, $coords);
+
+Equivalent to C<dtatw-b2xb $tfilename $cxfile $bxfile ->
+(or C<dtatw-b2xb -coords ...> if $coords is true),
+but reads tokenizer output from the string $tdata and returns the result as a string.
+$tfilename is used only for messages and header comments.
+
+=item tok2xml
+
+ $txmldata = DTA::TokWrap::XS::tok2xml($ttdata, $xmlbase, $ttfilename, $coords);
+
+Equivalent to C<dtatw-tok2xml - - $xmlbase>
+(or C<dtatw-tok2xml -coords ...> if $coords is true),
+but reads from the string $ttdata and returns the result as a string.
+$ttfilename is used only for error messages.
+
+=back
+
+=head1 DTA::TokWrap::XS::CxData
+
+DTA::TokWrap::XS::CxData objects hold the contents of a binary F<.cx> file
+as packed C columns (about 15 bytes per record, plus 16 bytes per record with attributes),
+rather than as one perl array per record as returned by
+L<DTA::TokWrap::CxData::cx_slurp()|DTA::TokWrap::CxData>.
+The file is mmap()ed and decoded in a single pass.
+Methods taking a record index $i return undef (or the empty list) if $i is out of range.
+
+=over 4
+
+=item new
+
+ $cxp = DTA::TokWrap::XS::CxData->new($cxfile);
+
+Loads $cxfile; croak()s on error.
+
+=item size
+
+ $n = $cxp->size();
+
+Returns the number of records.
+
+=item offset_bits
+
+ $bits = DTA::TokWrap::XS::CxData->offset_bits();
+
+Returns the width of byte offsets in the underlying libdtatw build:
+32, or 64 if it was configured with C<--enable-large-offsets>.
+
+=item flags, type, xoff, xlen, toff, tlen
+
+ $val = $cxp->xoff($i);
+
+Returns a single field of record $i.
+type() is flags() masked with $DTA::TokWrap::CxData::cxfTypeMask;
+toff() is the F<.tx> byte offset of record $i, i.e. the sum of all preceding tlen() values.
+
+=item attrs
+
+ @attrs = $cxp->attrs($i);
+
+Returns ($ulx,$uly,$lrx,$lry) for characters with a bounding box,
+($facs) for page-breaks with @facs, and the empty list otherwise.
+
+=item record
+
+ $cx = $cxp->record($i);
+
+Returns a new array [$flags,$xoff,$xlen,$tlen,@attrs],
+as for L<DTA::TokWrap::CxData::cx_get_record()|DTA::TokWrap::CxData>.
+
+=item find_xoff, find_toff
+
+ $i = $cxp->find_xoff($xoff);
+ $i = $cxp->find_toff($toff);
+
+Binary search.
+find_xoff() returns the index of the first record with xoff() E<gt>= $xoff;
+find_toff() returns the index of the record containing F<.tx> byte $toff.
+Both return size() if no such record exists.
+
+=item xrange
+
+ @is = $cxp->xrange($xoff, $xend);
+
+Returns the indices of all records with $xoff E<lt>= xoff() E<lt> $xend.
+
+=item xoffv, toffv
+
+ $vec = $cxp->xoffv();
+
+Returns a packed column s.t. C<vec($vec,$i,$cxp-E<gt>offset_bits) == $cxp-E<gt>xoff($i)> (rsp. toff()),
+e.g. for use with L<Algorithm::BinarySearch::Vec>.
+
+=back
+
+=head1 DTA::TokWrap::XS::TokPlugin
+
+DTA::TokWrap::XS::TokPlugin objects hold a tokenizer plugin (see F<dtatwTokPlugin.h>)
+loaded in-process with dlopen(), together with a single tokenizer instance.
+
+=over 4
+
+=item new
+
+ $tp = DTA::TokWrap::XS::TokPlugin->new($plugin, @opts);
+
+Loads $plugin, a shared object FILE (if it contains a '/')
+or a plugin NAME resolved to F<dtatw-tokplugin-NAME.so>
+in C<$DTATW_PLUGIN_PATH> and the package library directory,
+and creates a tokenizer instance with "KEY=VALUE" options @opts;
+croak()s on error.
+
+=item tokenize
+
+ $tokdata = $tp->tokenize($txtdata);
+
+Tokenizes the serialized UTF-8 text $txtdata and returns raw tokenizer output
+as produced by C<dtatw-tokenize-plugin>, without the header comment.
+
+=item name, version, filename
+
+ $str = $tp->name();
+
+Returns the plugin name, plugin version, or resolved plugin filename.
+
+=item reentrant
+
+ $bool = $tp->reentrant();
+
+True iff distinct instances of the plugin may tokenize concurrently in different threads.
+
+=back
+
+=head1 SEE ALSO
+
+L<DTA::TokWrap::Intro(3pm)|DTA::TokWrap::Intro>,
+L<dta-tokwrap.perl(1)|dta-tokwrap.perl>,
+...
+
+=head1 AUTHOR
+
+Bryan Jurish E<lt>moocow@cpan.orgE<gt>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2026 by Bryan Jurish
+
+This package is free software; you can redistribute it and/or modify
+it under the same terms as Perl itself, either Perl version 5.14.2 or,
+at your option, any later version of Perl 5 you may have available.
+
+=cut
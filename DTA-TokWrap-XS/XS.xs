@@ -0,0 +1,498 @@
+/*-*- Mode: C -*-*/
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#undef assert
+#include "dtatwMkindex.h"
+#include "dtatwB2xb.h"
+#include "dtatwTok2Xml.h"
+#include "dtatwCxPacked.h"
+#include "dtatwTokHost.h"
+#include "dtatwZio.h"
+
+typedef cxPacked* DTA__TokWrap__XS__CxData;
+typedef TokHost*  DTA__TokWrap__XS__TokPlugin;
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// f = dtatwxs_fopen(filename, mode, label)
+//  + returns NULL for undef or empty filename; croak()s on failure
+static FILE *dtatwxs_fopen(SV *filename, const char *mode, const char *label)
+{
+  const char *name;
+  FILE *f;
+  if (!filename || !SvOK(filename)) return NULL;
+  name = SvPV_nolen(filename);
+  if (!*name) return NULL;
+  if (!(f = fopen(name, mode)))
+    croak("DTA::TokWrap::XS: open failed for %s file `%s': %s", label, name, strerror(errno));
+  return f;
+}
+
+//--------------------------------------------------------------
+// f = dtatwxs_memopen(sv)
+//  + opens a read-only FILE on the string buffer of sv
+static FILE *dtatwxs_memopen(SV *sv)
+{
+  STRLEN len;
+  char *buf = SvPV(sv, len);
+  FILE *f = fmemopen(len ? buf : "", len ? len : 1, "r");
+  if (!f) croak("DTA::TokWrap::XS: fmemopen() failed: %s", strerror(errno));
+  if (!len) getc(f); //-- empty buffer: move to EOF
+  return f;
+}
+
+//--------------------------------------------------------------
+// sv = dtatwxs_memstream_sv(f,buf,len)
+//  + closes memory stream f and returns its contents as a new SV
+static SV *dtatwxs_memstream_sv(FILE *f, char **buf, size_t *len)
+{
+  SV *sv;
+  fclose(f);
+  sv = newSVpvn(*buf ? *buf : "", *len);
+  if (*buf) free(*buf);
+  return sv;
+}
+
+//--------------------------------------------------------------
+// sv = dtatwxs_column_sv(col,n)
+//  + returns a new SV containing n ByteOffset values col[0..n-1] in network byte order (for perl vec())
+//  + values are 32 bits wide, or 64 bits with DTATW_LARGE_OFFSETS (see offset_bits())
+static SV *dtatwxs_column_sv(const ByteOffset *col, ByteOffset n)
+{
+  const size_t w = sizeof(ByteOffset);
+  SV *sv = newSV(n*w + 1);
+  unsigned char *p = (unsigned char*)SvPVX(sv);
+  ByteOffset i;
+  size_t j;
+  for (i=0; i < n; ++i) {
+    for (j=w; j > 0; --j) {
+      *p++ = ((uint64_t)col[i] >> (8*(j-1))) & 0xff;
+    }
+  }
+  SvPOK_only(sv);
+  SvCUR_set(sv, n*w);
+  *SvEND(sv) = '\0';
+  return sv;
+}
+
+//--------------------------------------------------------------
+// nattrs = dtatwxs_cx_nattrs(cxp,i)
+//  + number of defined attributes for record i (as returned by DTA::TokWrap::CxData::cx_get_record())
+static int dtatwxs_cx_nattrs(const cxPacked *cxp, ByteOffset i)
+{
+  if (!(cxp->flags[i] & cxfHasAttrs)) return 0;
+  switch (cxp->flags[i] & cxfTypeMask) {
+  case cxrChar: return 4;
+  case cxrPb:   return 1;
+  default: break;
+  }
+  return 0;
+}
+
+/*======================================================================
+ * XS
+ */
+
+MODULE = DTA::TokWrap::XS		PACKAGE = DTA::TokWrap::XS
+
+PROTOTYPES: DISABLE
+
+##--------------------------------------------------------------
+UV
+mkindex(xmlfile, cxfile=&PL_sv_undef, sxfile=&PL_sv_undef, txfile=&PL_sv_undef, njobs=1, compress=&PL_sv_undef)
+  SV *xmlfile
+  SV *cxfile
+  SV *sxfile
+  SV *txfile
+  int njobs
+  SV *compress
+PREINIT:
+  FILE *f_in, *f_cx, *f_sx, *f_tx;
+  MkindexStats stats;
+  dtatwError err;
+  zioSpec zspec;
+  char *oldprog = prog;
+  int status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  if (zio_parse_spec((SvOK(compress) ? SvPV_nolen(compress) : NULL), &zspec, &err) != 0)
+    croak("DTA::TokWrap::XS::mkindex(): %s", err.msg);
+  f_in = dtatwxs_fopen(xmlfile, "rb", "input XML");
+  if (!f_in) croak("DTA::TokWrap::XS::mkindex(): no input file");
+  f_cx = dtatwxs_fopen(cxfile, "wb", "output .cx");
+  f_sx = dtatwxs_fopen(sxfile, "wb", "output .sx");
+  f_tx = dtatwxs_fopen(txfile, "wb", "output .tx");
+  if ( (f_cx && !(f_cx = zio_fwrap_out(f_cx, &zspec, SvPV_nolen(cxfile), 1, &err)))
+       || (f_sx && !(f_sx = zio_fwrap_out(f_sx, &zspec, SvPV_nolen(sxfile), 1, &err)))
+       || (f_tx && !(f_tx = zio_fwrap_out(f_tx, &zspec, SvPV_nolen(txfile), 1, &err)))
+       || (f_cx && !(f_cx = zio_fwrap_async(f_cx, SvPV_nolen(cxfile), 1, &err)))
+       || (f_sx && !(f_sx = zio_fwrap_async(f_sx, SvPV_nolen(sxfile), 1, &err)))
+       || (f_tx && !(f_tx = zio_fwrap_async(f_tx, SvPV_nolen(txfile), 1, &err))) )
+    croak("DTA::TokWrap::XS::mkindex(): %s", err.msg);
+  prog = "dtatw-mkindex";
+  status = mkindex_file(f_in, SvPV_nolen(xmlfile), f_cx,f_sx,f_tx, njobs, &stats, &err);
+  prog = oldprog;
+  fclose(f_in);
+  if (f_cx && fclose(f_cx) != 0 && status == 0) status = dtatw_error(&err, 2, "error closing output .cx file");
+  if (f_sx && fclose(f_sx) != 0 && status == 0) status = dtatw_error(&err, 2, "error closing output .sx file");
+  if (f_tx && fclose(f_tx) != 0 && status == 0) status = dtatw_error(&err, 2, "error closing output .tx file");
+  if (status != 0) croak("dtatw-mkindex: %s", err.msg);
+  RETVAL = stats.n_chrs;
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+SV *
+b2xb(tdata, cxfile, bxfile, tfilename=&PL_sv_undef, coords=0)
+  SV *tdata
+  SV *cxfile
+  SV *bxfile
+  SV *tfilename
+  int coords
+PREINIT:
+  FILE *f_in, *f_cx, *f_bx, *f_out;
+  char *outbuf = NULL;
+  size_t outlen = 0;
+  B2xbData *b;
+  dtatwError err;
+  char *argv[6], **av;
+  char *xmlbase = NULL;
+  char *oldprog = prog;
+  int status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  RETVAL = NULL;
+  f_cx = dtatwxs_fopen(cxfile, "rb", "input .cx");
+  f_bx = dtatwxs_fopen(bxfile, "rb", "input .bx");
+  if (!f_cx || !f_bx) croak("DTA::TokWrap::XS::b2xb(): no .cx or .bx file");
+  Newxz(b, 1, B2xbData);
+  prog = "dtatw-b2xb";
+  status = b2xb_init(b, f_cx, SvPV_nolen(cxfile), f_bx, coords, &err);
+  fclose(f_cx);
+  fclose(f_bx);
+  if (status == 0) {
+    //-- emulate 'dtatw-b2xb [-coords] TFILE CXFILE BXFILE -' command-line (for header comments)
+    argv[0] = prog;
+    argv[1] = "-coords";
+    av = coords ? argv+1 : argv;
+    av[1] = (SvOK(tfilename) ? SvPV_nolen(tfilename) : "-");
+    av[2] = SvPV_nolen(cxfile);
+    av[3] = SvPV_nolen(bxfile);
+    av[4] = "-";
+    if (av[2][0] && strcmp(av[2],"-") != 0) xmlbase = file_basename(NULL, av[2], ".cx", -1,0);
+    f_in  = dtatwxs_memopen(tdata);
+    f_out = open_memstream(&outbuf, &outlen);
+    if (!f_out) croak("DTA::TokWrap::XS::b2xb(): open_memstream() failed: %s", strerror(errno));
+    b2xb_put_header(b, f_out, (coords ? 6 : 5), argv, xmlbase, ".xml");
+    status = b2xb_process(b, f_in, av[1], f_out, &err);
+    fclose(f_in);
+    RETVAL = dtatwxs_memstream_sv(f_out, &outbuf, &outlen);
+    if (xmlbase) free(xmlbase);
+  }
+  prog = oldprog;
+  b2xb_free(b);
+  Safefree(b);
+  if (status != 0) {
+    if (RETVAL) SvREFCNT_dec(RETVAL);
+    croak("dtatw-b2xb: %s", err.msg);
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+SV *
+tok2xml(ttdata, xmlbase=&PL_sv_undef, ttfilename=&PL_sv_undef, coords=0)
+  SV *ttdata
+  SV *xmlbase
+  SV *ttfilename
+  int coords
+PREINIT:
+  FILE *f_in, *f_out;
+  char *outbuf = NULL;
+  size_t outlen = 0;
+  Tok2XmlData t;
+  dtatwError err;
+  char *oldprog = prog;
+  int status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  tok2xml_init(&t);
+  t.want_coords = coords;
+  prog  = "dtatw-tok2xml";
+  f_in  = dtatwxs_memopen(ttdata);
+  f_out = open_memstream(&outbuf, &outlen);
+  if (!f_out) croak("DTA::TokWrap::XS::tok2xml(): open_memstream() failed: %s", strerror(errno));
+  tok2xml_put_header(&t, f_out, 0, NULL, (SvOK(xmlbase) ? SvPV_nolen(xmlbase) : NULL), "");
+  status = tok2xml_process(&t, f_in, (SvOK(ttfilename) ? SvPV_nolen(ttfilename) : "-"), f_out, &err);
+  tok2xml_put_footer(&t, f_out);
+  fclose(f_in);
+  prog = oldprog;
+  RETVAL = dtatwxs_memstream_sv(f_out, &outbuf, &outlen);
+  if (status != 0) {
+    SvREFCNT_dec(RETVAL);
+    croak("dtatw-tok2xml: %s", err.msg);
+  }
+OUTPUT:
+  RETVAL
+
+
+##======================================================================
+## DTA::TokWrap::XS::CxData: column-packed .cx data
+##  + methods taking a record index $i return undef (or the empty list) if $i is out of range
+
+MODULE = DTA::TokWrap::XS		PACKAGE = DTA::TokWrap::XS::CxData
+
+##--------------------------------------------------------------
+DTA::TokWrap::XS::CxData
+new(CLASS, cxfile)
+  const char *CLASS
+  const char *cxfile
+PREINIT:
+  dtatwError err;
+  int status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  Newxz(RETVAL, 1, cxPacked);
+  status = cxPackedLoadFile(RETVAL, cxfile, &err);
+  if (status != 0) {
+    Safefree(RETVAL);
+    croak("DTA::TokWrap::XS::CxData: %s", err.msg);
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+void
+DESTROY(cxp)
+  DTA::TokWrap::XS::CxData cxp
+CODE:
+  cxPackedFree(cxp);
+  Safefree(cxp);
+
+##--------------------------------------------------------------
+UV
+size(cxp)
+  DTA::TokWrap::XS::CxData cxp
+CODE:
+  RETVAL = cxp->len;
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## $bits = DTA::TokWrap::XS::CxData->offset_bits()
+##  + width of byte offsets in this build, e.g. for vec($cxp->xoffv,$i,$bits)
+UV
+offset_bits(...)
+CODE:
+  RETVAL = 8*sizeof(ByteOffset);
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## $val = $cxp->flags($i), ->type($i), ->xoff($i), ->xlen($i), ->toff($i), ->tlen($i)
+SV *
+flags(cxp, i)
+  DTA::TokWrap::XS::CxData cxp
+  UV i
+ALIAS:
+  type = 1
+  xoff = 2
+  xlen = 3
+  toff = 4
+  tlen = 5
+CODE:
+  if (i >= cxp->len) XSRETURN_UNDEF;
+  switch (ix) {
+  case 0:  RETVAL = newSVuv(cxp->flags[i]); break;
+  case 1:  RETVAL = newSVuv(cxp->flags[i] & cxfTypeMask); break;
+  case 2:  RETVAL = newSVuv(cxp->xoff[i]); break;
+  case 3:  RETVAL = newSVuv(cxp->xlen[i]); break;
+  case 4:  RETVAL = newSVuv(cxp->toff[i]); break;
+  default: RETVAL = newSVuv(cxp->tlen[i]); break;
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## @attrs = $cxp->attrs($i)
+##  + ($ulx,$uly,$lrx,$lry) for <c> with @bbox, ($facs) for <pb> with @facs, otherwise empty
+void
+attrs(cxp, i)
+  DTA::TokWrap::XS::CxData cxp
+  UV i
+PREINIT:
+  int j, n;
+PPCODE:
+  if (i >= cxp->len) XSRETURN_EMPTY;
+  n = dtatwxs_cx_nattrs(cxp, i);
+  EXTEND(SP, n);
+  for (j=0; j < n; ++j) mPUSHu(cxp_attr(cxp,i,j));
+
+##--------------------------------------------------------------
+## \@cx = $cxp->record($i)
+##  + [$flags,$xoff,$xlen,$tlen,@attrs], as for DTA::TokWrap::CxData::cx_get_record()
+SV *
+record(cxp, i)
+  DTA::TokWrap::XS::CxData cxp
+  UV i
+PREINIT:
+  AV *av;
+  int j, n;
+CODE:
+  if (i >= cxp->len) XSRETURN_UNDEF;
+  n  = dtatwxs_cx_nattrs(cxp, i);
+  av = newAV();
+  av_extend(av, 4+n);
+  av_push(av, newSVuv(cxp->flags[i]));
+  av_push(av, newSVuv(cxp->xoff[i]));
+  av_push(av, newSVuv(cxp->xlen[i]));
+  av_push(av, newSVuv(cxp->tlen[i]));
+  for (j=0; j < n; ++j) av_push(av, newSVuv(cxp_attr(cxp,i,j)));
+  RETVAL = newRV_noinc((SV*)av);
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## $i = $cxp->find_xoff($xoff)
+##  + index of first record with xoff >= $xoff (size() if none)
+## $i = $cxp->find_toff($toff)
+##  + index of record containing .tx byte $toff (size() if none)
+UV
+find_xoff(cxp, off)
+  DTA::TokWrap::XS::CxData cxp
+  UV off
+ALIAS:
+  find_toff = 1
+CODE:
+  RETVAL = (ix==0 ? cxPackedFindXoff(cxp, off) : cxPackedFindToff(cxp, off));
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## @is = $cxp->xrange($xoff,$xend)
+##  + indices of all records with $xoff <= xoff < $xend
+void
+xrange(cxp, xoff, xend)
+  DTA::TokWrap::XS::CxData cxp
+  UV xoff
+  UV xend
+PREINIT:
+  ByteOffset i;
+PPCODE:
+  for (i=cxPackedFindXoff(cxp, xoff); i < cxp->len && cxp->xoff[i] < xend; ++i) {
+    mXPUSHu(i);
+  }
+
+##--------------------------------------------------------------
+## $vec = $cxp->xoffv(), $cxp->toffv()
+##  + packed columns, s.t. vec($vec,$i,$cxp->offset_bits) == $cxp->xoff($i) (rsp. toff)
+SV *
+xoffv(cxp)
+  DTA::TokWrap::XS::CxData cxp
+ALIAS:
+  toffv = 1
+CODE:
+  RETVAL = dtatwxs_column_sv((ix==0 ? cxp->xoff : cxp->toff), cxp->len);
+OUTPUT:
+  RETVAL
+
+##======================================================================
+## DTA::TokWrap::XS::TokPlugin: in-process tokenizer plugin (dtatwTokHost.h)
+##======================================================================
+MODULE = DTA::TokWrap::XS		PACKAGE = DTA::TokWrap::XS::TokPlugin
+
+##--------------------------------------------------------------
+## $tp = CLASS->new($plugin, @opts)
+##  + @opts are "KEY=VALUE" plugin options
+DTA::TokWrap::XS::TokPlugin
+new(CLASS, plugin, ...)
+  const char *CLASS
+  const char *plugin
+PREINIT:
+  dtatwError err;
+  const char **opts = NULL;
+  int i, nopts = items-2, status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  if (nopts > 0) {
+    Newx(opts, nopts, const char*);
+    for (i=0; i < nopts; ++i) opts[i] = SvPV_nolen(ST(i+2));
+  }
+  Newxz(RETVAL, 1, TokHost);
+  status = tokhost_open(RETVAL, plugin, nopts, opts, &err);
+  if (opts) Safefree(opts);
+  if (status != 0) {
+    Safefree(RETVAL);
+    croak("DTA::TokWrap::XS::TokPlugin: %s", err.msg);
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+void
+DESTROY(tp)
+  DTA::TokWrap::XS::TokPlugin tp
+CODE:
+  tokhost_close(tp);
+  Safefree(tp);
+
+##--------------------------------------------------------------
+## $tdata = $tp->tokenize($txtdata)
+##  + returns raw tokenizer output for $txtdata (without header comments)
+SV *
+tokenize(tp, txtdata)
+  DTA::TokWrap::XS::TokPlugin tp
+  SV *txtdata
+PREINIT:
+  dtatwError err;
+  STRLEN len;
+  const char *buf;
+  char *outbuf = NULL;
+  size_t outlen = 0;
+  FILE *f_out;
+  int status;
+CODE:
+  memset(&err, 0, sizeof(err));
+  buf = SvPV(txtdata, len);
+  f_out = open_memstream(&outbuf, &outlen);
+  if (!f_out) croak("DTA::TokWrap::XS::TokPlugin::tokenize(): open_memstream() failed: %s", strerror(errno));
+  status = tokhost_write(tp, buf, len, f_out, &err);
+  RETVAL = dtatwxs_memstream_sv(f_out, &outbuf, &outlen);
+  if (status != 0) {
+    SvREFCNT_dec(RETVAL);
+    croak("DTA::TokWrap::XS::TokPlugin::tokenize(): %s", err.msg);
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## $str = $tp->name(), $tp->version(), $tp->filename()
+SV *
+name(tp)
+  DTA::TokWrap::XS::TokPlugin tp
+ALIAS:
+  version  = 1
+  filename = 2
+CODE:
+  switch (ix) {
+  case 0: RETVAL = newSVpv(tp->plugin->name, 0); break;
+  case 1: RETVAL = newSVpv(tp->plugin->version, 0); break;
+  default: RETVAL = newSVpv(tp->filename, 0); break;
+  }
+OUTPUT:
+  RETVAL
+
+##--------------------------------------------------------------
+## $bool = $tp->reentrant()
+bool
+reentrant(tp)
+  DTA::TokWrap::XS::TokPlugin tp
+CODE:
+  RETVAL = (tp->plugin->flags & DTATW_TOKPLUGIN_REENTRANT) ? 1 : 0;
+OUTPUT:
+  RETVAL
@@ -0,0 +1,9 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+
+BEGIN {
+  use_ok('DTA::TokWrap::XS');
+}
+can_ok('DTA::TokWrap::XS::CxData', qw(new size record attrs find_xoff find_toff xrange));
+can_ok('DTA::TokWrap::XS::TokPlugin', qw(new tokenize name version filename reentrant));
+done_testing();
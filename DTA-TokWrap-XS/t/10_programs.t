@@ -0,0 +1,116 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our ($bindir,$scriptdir);
+BEGIN {
+  ##-- programs: from the build directory (see Makefile.PL)
+  $bindir    = $ENV{DTATW_BUILDDIR} || $ENV{DTATW_SRCDIR} || "$FindBin::Bin/../../src";
+  $scriptdir = "$FindBin::Bin/../../scripts";
+  $ENV{PATH} = "$bindir:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy dtatw-b2xb dtatw-tok2xml)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  plan skip_all => "$scriptdir/dtatw-generate-bench.perl not found"
+    if (!-e "$scriptdir/dtatw-generate-bench.perl");
+  use_ok('DTA::TokWrap::XS');
+}
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## $data = slurp($file)
+sub slurp {
+  open(my $fh, '<:raw', $_[0]) or die("open failed for $_[0]: $!");
+  local $/ = undef;
+  return <$fh>;
+}
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## $data = nocmdline($data)
+##  + removes the "Command-line:" header comment, which records how the output was produced
+sub nocmdline {
+  (my $data = shift) =~ s/^(?:%%|<!--)[^\n]*Command-line:[^\n]*\n//mg;
+  return $data;
+}
+
+## $data = run($cmd)
+##  + returns stdout of shell command $cmd; dies on failure
+sub run {
+  my $cmd = shift;
+  my $out = `$cmd`;
+  die("command failed ($?): $cmd") if ($? != 0);
+  return $out;
+}
+
+##======================================================================
+## fixture: generated document
+
+my $base = "$tmpdir/gen";
+is(system($^X, "$scriptdir/dtatw-generate-bench.perl", '-preset=mixed', '-size=64K', "-output=$base.xml"), 0, "generate");
+
+##======================================================================
+## tests: mkindex
+
+foreach my $njobs (1,3) {
+  is(system('dtatw-mkindex', "$base.xml", map({"$base.prog$njobs.$_"} qw(cx sx tx)), $njobs), 0, "mkindex: njobs=$njobs: program");
+  cmp_ok(DTA::TokWrap::XS::mkindex("$base.xml", map({"$base.xs$njobs.$_"} qw(cx sx tx)), $njobs), '>', 0, "mkindex: njobs=$njobs: xs");
+  foreach (qw(cx sx tx)) {
+    ok(slurp("$base.xs$njobs.$_") eq slurp("$base.prog$njobs.$_"), "mkindex: njobs=$njobs: .$_ identical");
+  }
+}
+rename("$base.prog1.$_", "$base.$_") foreach (qw(cx sx tx));
+
+##======================================================================
+## tests: b2xb, tok2xml
+
+##-- trivial block index: a single block spanning the whole .tx file (.txt = .tx), so we don't need dtatw-mkbx (XSLT)
+my ($xlen,$tlen) = map {-s $_} ("$base.xml", "$base.tx");
+spew("$base.bx", "%% single block\nblock\tTEI\t0\t$xlen\t0\t$tlen\t0\t$tlen\n");
+my $tdata = run("dtatw-tokenize-dummy '$base.tx'");
+spew("$base.t", $tdata);
+
+foreach my $coords (0,1) {
+  my $opts   = $coords ? '-coords ' : '';
+  my $label  = $coords ? ' -coords' : '';
+  my $ttprog = run("dtatw-b2xb $opts'$base.t' '$base.cx' '$base.bx' -");
+  my $ttxs   = DTA::TokWrap::XS::b2xb($tdata, "$base.cx", "$base.bx", "$base.t", $coords);
+  cmp_ok(length($ttprog), '>', length($tdata), "b2xb$label: program: non-trivial output");
+  ok(nocmdline($ttxs) eq nocmdline($ttprog), "b2xb$label: xs output identical to program");
+
+  spew("$base.$coords.tt", $ttprog);
+  my $xmlprog = run("dtatw-tok2xml $opts'$base.$coords.tt' - gen.xml");
+  my $xmlxs   = DTA::TokWrap::XS::tok2xml($ttprog, 'gen.xml', "$base.$coords.tt", $coords);
+  like($xmlprog, qr{<w\b}, "tok2xml$label: program: non-trivial output");
+  ok(nocmdline($xmlxs) eq nocmdline($xmlprog), "tok2xml$label: xs output identical to program");
+}
+
+##======================================================================
+## tests: errors croak() (rather than exit())
+
+my $missing = "$tmpdir/no-such-file";
+spew("$tmpdir/bad.cx", "this is not a .cx file\n");
+my @fail = (
+	    ['mkindex: missing .xml' => sub { DTA::TokWrap::XS::mkindex("$missing.xml", "$tmpdir/out.cx") }],
+	    ['b2xb: missing .cx'     => sub { DTA::TokWrap::XS::b2xb($tdata, "$missing.cx", "$base.bx") }],
+	    ['b2xb: missing .bx'     => sub { DTA::TokWrap::XS::b2xb($tdata, "$base.cx", "$missing.bx") }],
+	    ['b2xb: invalid .cx'     => sub { DTA::TokWrap::XS::b2xb($tdata, "$tmpdir/bad.cx", "$base.bx") }],
+	    ['b2xb: no .cx'          => sub { DTA::TokWrap::XS::b2xb($tdata, undef, "$base.bx") }],
+	   );
+foreach (@fail) {
+  my ($label,$sub) = @$_;
+  my $rc = eval { $sub->(); 1 };
+  ok(!$rc && $@ ne '', "$label: croak()s");
+}
+ok(1, "still alive");
+
+done_testing();
@@ -6,6 +6,7 @@
 
 package DTA::TokWrap;
 use Time::HiRes ('tv_interval','gettimeofday');
+use IO::File;
 use Carp;
 use strict;
 
@@ -13,7 +14,7 @@ use strict;
 use DTA::TokWrap::Version qw();
 use DTA::TokWrap::Logger;
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:si);
+use DTA::TokWrap::Utils qw(:si :time);
 use DTA::TokWrap::Document qw(:tok);
 use DTA::TokWrap::Document::Maker;
 
@@ -42,6 +43,14 @@ our $VERSION = $DTA::TokWrap::Version::VERSION;
 ##     tmpdir => $tmpdir,     ##-- passed to $doc->{tmpdir}; default=($ENV{DTATW_TMP}||$ENV{TMP}||$outdir)
 ##     keeptmp => $bool,      ##-- passed to $doc->{keeptmp}; default=0
 ##     force   => \@keys,     ##-- passed to $doc->{force}; default=none
+##     tcfstream => $bool,    ##-- passed to $doc->{tcfstream}; default=0
+##     tokenizeJobs => $n,    ##-- passed to $doc->{tokenizeJobs}; default=1
+##     tokenizeCache => $dir, ##-- passed to $doc->{tokenizeCache}; default=none
+##     mkindexJobs => $n,     ##-- passed to $doc->{mkindexJobs}; default=1
+##     compressTmp => $spec,  ##-- passed to $doc->{compressTmp}: compress temporary files ('zstd[:LEVEL]' or 'gzip[:LEVEL]'); default=none
+##     makeJobs => $n,        ##-- passed to $doc->{makeJobs} (-make mode only); default=1
+##     cstats => $bool,       ##-- passed to $doc->{cstats}: collect --stats=FILE statistics from C programs; default=0
+##     traceEvents => $file,  ##-- write Chrome/Perfetto trace-event JSON to $file (see traceDoc()); default=none
 ##     ##
 ##     ##-- Processing objects
 ##     mkindex  => $mkindex,   ##-- DTA::TokWrap::Processor::mkindex object, or option-hash
@@ -51,7 +60,7 @@ our $VERSION = $DTA::TokWrap::Version::VERSION;
 ##     tokenizeClass => $cls,  ##-- ${DTA::TokWrap::Document::TOKENIZE_CLASS} proxy
 ##     tokenize1 => $tok1,     ##-- DTA::TokWrap::Processor::tokenize1 object or option-hash
 ##     tok2xml  => $tok2xml,   ##-- DTA::TokWrap::Processor::tok2xml object, or option-hash
-##     #standoff => $standoff,  ##-- DTA::TokWrap::Processor::standoff object, or option-hash [OBSOLETE]
+##     standoff => $standoff,  ##-- DTA::TokWrap::Processor::standoff object, or option-hash
 ##     txmlanno  => $txmlanno, ##-- DTA::TokWrap::Processor::txmlanno object, or option-hash
 ##     addws => $addws,	       ##-- DTA::TokWrap::Processor::addws object, or option-hash
 ##     idsplice => $idsplice,  ##-- DTA::TokWrap::Processor::idsplice object, or option-hash
@@ -65,6 +74,7 @@ our $VERSION = $DTA::TokWrap::Version::VERSION;
 ##         nxbytes => $nxbytes,      ##-- total number of source XML bytes processed by ${proc} (if known)
 ##         elapsed => $secs,         ##-- total number of seconds spent in processor ${proc}
 ##         laststamp => $stamp,      ##-- last end stamp for ${proc}
+##         cstats => {$prog=>\%stats}, ##-- summed --stats=FILE statistics for C programs run by ${proc} (if {cstats})
 ##       },
 ##     },
 ##    )
@@ -81,6 +91,14 @@ sub defaults {
 	  tmpdir => ($ENV{DTATW_TMP}||$ENV{TMP}),
 	  keeptmp => 0,
 	  #force  => undef,
+	  tcfstream => 0,
+	  tokenizeJobs => 1,
+	  tokenizeCache => undef,
+	  mkindexJobs => 1,
+	  compressTmp => undef,
+	  makeJobs => 1,
+	  cstats => 0,
+	  traceEvents => undef,
 	  ##
 	  ##-- Processing objects
 	  mkindex => undef,
@@ -93,7 +111,7 @@ sub defaults {
 	  txmlanno => undef,
 	  addws => undef,
 	  idsplice => undef,
-	  #standoff => undef,
+	  standoff => undef,
 	  ##
 	  ##-- TCF-codec objects
 	  tcfencode=>undef,
@@ -116,10 +134,11 @@ sub init {
 		  mkindex => {inplace=>$tw->{inplacePrograms}},
 		  mkbx0 => {inplace=>$tw->{inplacePrograms}},
 		  tokenize => {inplace=>$tw->{inplacePrograms}},
+		  standoff => {inplace=>$tw->{inplacePrograms}},
 		  ALL => ($tw->{procOpts}||{}),
 		 );
   my ($class,%newopts);
-  foreach (qw(mkindex mkbx0 mkbx tokenize tokenize1 tok2xml txmlanno addws idsplice tcfencode tcftokenize tcfdecode0 tcfalign tcfdecode)) { #standoff
+  foreach (qw(mkindex mkbx0 mkbx tokenize tokenize1 tok2xml txmlanno standoff addws idsplice tcfencode tcftokenize tcfdecode0 tcfalign tcfdecode)) {
     next if (UNIVERSAL::isa($tw->{$_},"DTA::TokWrap::Processor::$_"));
     $class   = $_ eq 'tokenize' ? "DTA::TokWrap::Processor::tokenize::".($tw->{tokenizeClass}//${DTA::TokWrap::Document::TOKENIZE_CLASS}) : "DTA::TokWrap::Processor::$_";
     %newopts = (%{$key2opts{ALL}}, ($key2opts{$_} ? %{$key2opts{$_}} : qw()));
@@ -132,6 +151,9 @@ sub init {
     }
   }
 
+  ##-- trace events
+  $tw->traceOpen() if ($tw->{traceEvents});
+
   ##-- return
   return $tw;
 }
@@ -157,9 +179,20 @@ sub close {
 
 ##==============================================================================
 ## Methods: Document Processing
-##  + nothing here (yet); see DTA::TokWrap::Document e.g. $doc->makeKey()
+##  + see DTA::TokWrap::Document e.g. $doc->makeKey()
 ##==============================================================================
 
+## $tw = $tw->warm()
+##  + pre-compiles XSL stylesheets and resolves the tokenizer subclass,
+##    so that forked children (DTA::TokWrap::Daemon, DTA::TokWrap::Pipeline) inherit them
+sub warm {
+  my $tw = shift;
+  $tw->{mkbx0}->ensure_stylesheets() if ($tw->{mkbx0});
+  $tw->{standoff}->ensure_stylesheets() if ($tw->{standoff} && !$tw->{standoff}{t2so}); ##-- xsl fallback only
+  $tw->{tokenize}->ensure_tokz() if ($tw->{tokenize} && $tw->{tokenize}->can('ensure_tokz'));
+  return $tw;
+}
+
 ##==============================================================================
 ## Methods: Profiling
 ##==============================================================================
@@ -197,10 +230,156 @@ sub logProfile {
 		       sistr($elapsed, 'f', '.1'),
 		       $toksPerSec,
 		       $xbytesPerSec);
+    $logstr .= $tw->cstatsString($prof->{cstats}) if ($prof->{cstats});
   }
   $tw->vlog($level,$logstr);
 }
 
+## $str = $tw->cstatsString(\%cstats)
+##  + formats C program statistics \%cstats = {$prog=>\%stats} for logProfile()
+sub cstatsString {
+  my ($tw,$cstats) = @_;
+  my $str = '';
+  my ($prog,$st);
+  foreach $prog (sort keys %$cstats) {
+    $st   = $cstats->{$prog};
+    $str .= sprintf("\n%14s  + %s: %d run, %ssec wall, %ssec cpu, %sbyte max rss, %d alloc",
+		    '', $prog, ($st->{nruns}||0),
+		    sistr(($st->{wall}||0),'f','.1'),
+		    sistr(($st->{cpu}||0),'f','.1'),
+		    sistr(1024*($st->{maxrss_kb}||0),'f','.1'),
+		    ($st->{allocs}{count}||0));
+    $str .= join('', map {sprintf("; %s=%ssec", $_, sistr($st->{phases}{$_}{wall},'f','.1'))} sort keys %{$st->{phases}||{}});
+  }
+  return $str;
+}
+
+##==============================================================================
+## Methods: Trace Events
+##  + writes Chrome/Perfetto "Trace Event Format" JSON (JSON array format) to $tw->{traceEvents}
+##==============================================================================
+
+## $tw = $tw->traceOpen()
+##  + (re-)creates the $tw->{traceEvents} file; called by init()
+##  + event timestamps are relative to the time of this call
+sub traceOpen {
+  my $tw = shift;
+  return $tw if (!$tw->{traceEvents});
+  my $fh = IO::File->new(">$tw->{traceEvents}")
+    or $tw->logconfess("traceOpen(): open failed for '$tw->{traceEvents}': $!");
+  $fh->print("[\n");
+  $fh->close();
+  $tw->{traceStamp0} = timestamp();
+  return $tw;
+}
+
+## $bool = $tw->traceWrite(\@events, $is_last)
+##  + appends \@events to $tw->{traceEvents} with a single write(), so that forked children
+##    (e.g. DTA::TokWrap::Pipeline workers) can share the file
+##  + if $is_last is true, terminates the JSON array
+sub traceWrite {
+  my ($tw,$events,$is_last) = @_;
+  return 1 if (!$tw->{traceEvents} || !@$events);
+  require JSON::PP;
+  my $json = JSON::PP->new->utf8->canonical;
+  my $buf  = join(",\n", map {$json->encode($_)} @$events).($is_last ? "\n]\n" : ",\n");
+  my $fh = IO::File->new(">>$tw->{traceEvents}")
+    or $tw->logconfess("traceWrite(): open failed for '$tw->{traceEvents}': $!");
+  $fh->syswrite($buf)==length($buf)
+    or $tw->logconfess("traceWrite(): write failed for '$tw->{traceEvents}': $!");
+  return $fh->close();
+}
+
+## undef = $tw->traceDoc($doc)
+##  + writes trace events for $doc; called by $doc->close() if $tw->{traceEvents} is set
+##  + all events use pid=tid=$$, i.e. one track per (forked) process
+##  + events:
+##    - one complete event ("X", cat=document) for $doc, from $doc->{open_stamp} until now;
+##      cat=stage if $doc->{traceStage} is set (DTA::TokWrap::Pipeline: the parent writes the document event)
+##    - one complete event ("X", cat=processor) for each "${key}_stamp0", "${key}_stamp" pair in $doc
+##    - one complete event ("X", cat=subprocess) for each C program run in $doc->{cstatsruns},
+##      with the program's --stats=FILE data (cpu, maxrss_kb, phases, byte counts, ...) as args
+##    - counter events ("C") "tokens" and "bytes": cumulative totals for the current process (not for stages)
+sub traceDoc {
+  my ($tw,$doc) = @_;
+  my $t0    = $tw->{traceStamp0} || 0;
+  my $usec  = sub { int(1e6*($_[0]-$t0) + 0.5) };
+  my $end   = timestamp();
+  my $beg   = $doc->{open_stamp} // $end;
+  my $name  = $doc->{xmlbase} // $doc->{xmlfile};
+  my %id    = (pid=>$$, tid=>$$);
+  my $ntoks   = $doc->nTokens() || 0;
+  my $nxbytes = $doc->nXmlBytes() || 0;
+  my @events;
+
+  ##-- document (or pipeline stage)
+  if ($doc->{traceStage}) {
+    push(@events, {ph=>'M', name=>'process_name', %id, args=>{name=>"dta-tokwrap [$$]"}})
+      if (!$tw->{tracePids}{$$}++);
+    push(@events, {ph=>'X', cat=>'stage', name=>$name, %id,
+		   ts=>$usec->($beg), dur=>$usec->($end)-$usec->($beg),
+		   args=>{xmlfile=>$doc->{xmlfile}, stage=>$doc->{traceStage}, ntoks=>$ntoks}});
+  } else {
+    push(@events, $tw->traceDocEvents($name, $beg, $end, {xmlfile=>$doc->{xmlfile}, ntoks=>$ntoks, nxbytes=>$nxbytes}));
+  }
+
+  ##-- processors
+  my ($key,$stamp0,$stamp);
+  foreach $key (sort {$doc->{"${a}_stamp0"} <=> $doc->{"${b}_stamp0"} || $a cmp $b}
+		map {/^(.*)_stamp$/ && defined($doc->{"${_}0"}) ? $1 : qw()} keys(%$doc))
+    {
+      ($stamp0,$stamp) = @$doc{"${key}_stamp0","${key}_stamp"};
+      next if (!defined($stamp) || $stamp0 < 0 || $stamp < 0); ##-- (hack): ignore forced pseudo-stamps
+      push(@events, {ph=>'X', cat=>'processor', name=>$key, %id,
+		     ts=>$usec->($stamp0), dur=>$usec->($stamp)-$usec->($stamp0),
+		     args=>{doc=>$name}});
+    }
+
+  ##-- C program runs
+  my ($run,$prog,$st);
+  foreach $run (@{$doc->{cstatsruns}||[]}) {
+    ($key,$prog,$stamp,$st) = @$run;
+    $stamp0 = $stamp - ($st->{wall}||0);
+    push(@events, {ph=>'X', cat=>'subprocess', name=>$prog, %id,
+		   ts=>$usec->($stamp0), dur=>$usec->($stamp)-$usec->($stamp0),
+		   args=>{doc=>$name, processor=>$key, map {($_=>$st->{$_})} grep {!/^(?:prog|nruns)$/} keys %$st}});
+  }
+
+  $tw->traceWrite(\@events);
+}
+
+## @events = $tw->traceDocEvents($name, $beg_stamp, $end_stamp, \%args)
+##  + returns the document event ("X", cat=document) and counter events ("C") for a finished document;
+##    used by traceDoc() and by DTA::TokWrap::Pipeline (whose workers trace each stage separately)
+##  + %args should contain at least ntoks, nxbytes (summed into the counters) and xmlfile
+##  + includes a process name event ("M") for the first event of the current process
+sub traceDocEvents {
+  my ($tw,$name,$beg,$end,$args) = @_;
+  my $t0     = $tw->{traceStamp0} || 0;
+  my $usec   = sub { int(1e6*($_[0]-$t0) + 0.5) };
+  my %id     = (pid=>$$, tid=>$$);
+  my $totals = $tw->{traceTotals}{$$} //= {};
+  $totals->{ntoks}   += $args->{ntoks}||0;
+  $totals->{nxbytes} += $args->{nxbytes}||0;
+  return (
+	  ($tw->{tracePids}{$$}++ ? qw() : {ph=>'M', name=>'process_name', %id, args=>{name=>"dta-tokwrap [$$]"}}),
+	  {ph=>'X', cat=>'document', name=>$name, %id, ts=>$usec->($beg), dur=>$usec->($end)-$usec->($beg), args=>$args},
+	  {ph=>'C', name=>'tokens', %id, ts=>$usec->($end), args=>{ntoks=>$totals->{ntoks}}},
+	  {ph=>'C', name=>'bytes',  %id, ts=>$usec->($end), args=>{nxbytes=>$totals->{nxbytes}}},
+	 );
+}
+
+## undef = $tw->traceClose()
+##  + terminates the JSON array in $tw->{traceEvents} and disables further tracing;
+##    should be called once by the top-level process after all documents have been closed
+##  + trace files which were never closed (e.g. after a crash) can still be loaded by most trace viewers
+sub traceClose {
+  my $tw = shift;
+  return if (!$tw->{traceEvents});
+  $tw->traceWrite([{ph=>'M', name=>'process_name', pid=>$$, tid=>$$, args=>{name=>"dta-tokwrap [$$]"}}], 1);
+  $tw->{traceEvents} = undef;
+}
+
 1; ##-- be happy
 
 __END__
@@ -322,6 +501,30 @@ Wrapper for L<$doc-E<gt>close()|DTA::TokWrap::Document/close>
 
 =cut
 
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap: Methods: Document Processing
+=pod
+
+=head2 Methods: Document Processing
+
+=over 4
+
+=item warm
+
+ $tw = $tw->warm();
+
+Compiles the L<mkbx0|DTA::TokWrap::Processor::mkbx0> XSL stylesheets
+(and the L<standoff|DTA::TokWrap::Processor::standoff> stylesheets if F<dtatw-txml2so> is not available)
+and resolves the tokenizer subclass for the
+L<auto|DTA::TokWrap::Processor::tokenize::auto> tokenizer,
+so that forked child processes
+(L<DTA::TokWrap::Daemon|DTA::TokWrap::Daemon> workers, L<DTA::TokWrap::Pipeline|DTA::TokWrap::Pipeline> stage workers)
+inherit them instead of re-creating them for each document.
+
+=back
+
+=cut
+
 ##----------------------------------------------------------------
 ## DESCRIPTION: DTA::TokWrap: Methods: Profiling
 =pod
@@ -338,6 +541,83 @@ Logs profiling information (throughput) at $logLevel
 using the Log::Log4perl mechanism via DTA::TokWrap::Logger.
 See L<DTA::TokWrap::Logger>.
 
+If the C<cstats> option is set, statistics written by the C<--stats=FILE> option
+of the C programs (wall-clock and cpu time per phase, peak RSS, allocation counts)
+are logged below the respective processor.
+
+=item cstatsString
+
+ $str = $tw->cstatsString(\%cstats);
+
+Formats C program statistics C<\%cstats = {$prog=E<gt>\%stats}> for L</logProfile>.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap: Methods: Trace Events
+=pod
+
+=head2 Methods: Trace Events
+
+If the C<traceEvents> option is set to a filename,
+per-document timing information is written to that file in the
+"Trace Event Format" (JSON array format) understood by
+C<chrome://tracing> and L<Perfetto|https://ui.perfetto.dev>.
+Events from forked children (e.g. L<DTA::TokWrap::Pipeline|DTA::TokWrap::Pipeline> workers)
+are appended to the same file, each process on its own track.
+
+=over 4
+
+=item traceOpen
+
+ $tw = $tw->traceOpen();
+
+(Re-)creates the C<traceEvents> file; called by L</init>.
+Event timestamps are relative to the time of this call.
+
+=item traceWrite
+
+ $bool = $tw->traceWrite(\@events, $is_last);
+
+Appends \@events to the C<traceEvents> file using a single write() call.
+If $is_last is true, terminates the JSON array.
+
+=item traceDoc
+
+ undef = $tw->traceDoc($doc);
+
+Writes trace events for $doc; called by L<$doc-E<gt>close()|DTA::TokWrap::Document/close>.
+Events written are:
+one complete event (category C<document>) spanning the lifetime of $doc;
+one complete event (category C<processor>) for each processor which ran for $doc;
+one complete event (category C<subprocess>) for each C program run,
+with its C<--stats=FILE> data (cpu time, peak RSS, phases, byte and token counts) as arguments;
+and counter events C<tokens> and C<bytes> with cumulative totals for the current process.
+
+If C<$doc-E<gt>{traceStage}> is set (by L<DTA::TokWrap::Pipeline|DTA::TokWrap::Pipeline> workers),
+the outer event has category C<stage> and no counter events are written;
+the pipeline writes a single C<document> event per file (see L</traceDocEvents>).
+
+C program runs are only traced for programs supporting C<--stats=FILE>
+(see L<DTA::TokWrap::Processor::statsFile()|DTA::TokWrap::Processor/statsFile>).
+
+=item traceDocEvents
+
+ @events = $tw->traceDocEvents($name, $beg_stamp, $end_stamp, \%args);
+
+Returns the C<document> complete event for a finished document and the counter events
+C<tokens> and C<bytes>, whose totals are updated from C<$args{ntoks}> and C<$args{nxbytes}>.
+Used by L</traceDoc> and by L<DTA::TokWrap::Pipeline|DTA::TokWrap::Pipeline>.
+
+=item traceClose
+
+ undef = $tw->traceClose();
+
+Terminates the JSON array in the C<traceEvents> file and disables further tracing.
+Should be called once by the top-level process after all documents have been closed.
+
 =back
 
 =cut
@@ -25,11 +25,13 @@ our $cxfTypeMask     = 0x7;
 our $cxfHasXmlOffset = 0x8;
 our $cxfHasTxtLength = 0x10;
 our $cxfHasAttrs     = 0x20;
+our $cxfBboxDelta    = 0x40; ##-- $cxrChar attributes are zigzag-coded BER deltas against the preceding bbox
 
 ##-- header
 our $cxhMagic = "dta-tokwrap cx bin\n";
 our $cxhVersion     = $DTA::TokWrap::Version::VERSION;
 our $cxhVersionMinR = "0.39"; ##-- minimum file-version we can read
+our $cxhVersionMinV = "0.99"; ##-- minimum version_min of cx-files with varint-coded xml offsets
 
 ##-- records: indexing of returned arrays
 our $CX_FLAGS = 0;
@@ -47,6 +49,9 @@ our $CX_ATTR_ULY = $CX_ATTRS+1;
 our $CX_ATTR_LRX = $CX_ATTRS+2;
 our $CX_ATTR_LRY = $CX_ATTRS+3;
 
+##-- $HAVE_XS: whether DTA::TokWrap::XS (and hence DTA::TokWrap::XS::CxData) is available
+our $HAVE_XS = eval { require DTA::TokWrap::XS; 1 } ? 1 : 0;
+
 ##==============================================================================
 ## Functions
 ##==============================================================================
@@ -84,10 +89,37 @@ sub cx_check_header {
   return 1;
 }
 
+## $bool = cx_header_varint($hdr)
+##  + true iff $hdr describes a cx-file with varint-coded xml offsets (cf. dtatwCommon.h: cx_header_varint())
+sub cx_header_varint {
+  my ($hdr) = @_;
+  return version->new("$hdr->{version_min}") >= version->new("$cxhVersionMinV") ? 1 : 0;
+}
+
 ## [$flags,$xoff,$xlen,$tlen,@attrs] = cx_get($fh)
 ## [$flags,$xoff,$xlen,$tlen,@attrs] = cx_get($fh,$xmlOffset)
-##  + uses package-global temporaries: $_tmp,$_flags,$_cx
-my ($_tmp,$_flags,$_cx);
+## [$flags,$xoff,$xlen,$tlen,@attrs] = cx_get($fh,$xmlOffset,$varint)
+## [$flags,$xoff,$xlen,$tlen,@attrs] = cx_get($fh,$xmlOffset,$varint,\@bbox)
+##  + if $varint is true, xml offsets are read as zigzag-coded BER deltas against $xmlOffset (see cx_header_varint())
+##  + \@bbox holds the bbox of the preceding $cxrChar record with attributes (initially [0,0,0,0]),
+##    the base for records with $cxfBboxDelta; it is updated by $cxrChar records with attributes
+##    (default: a package-global array; cx_slurp() uses its own)
+##  + uses package-global temporaries: $_tmp,$_flags,$_cx,$_z,$_bb
+my ($_tmp,$_flags,$_cx,$_z,$_bb);
+my @_bbox = (0,0,0,0);
+
+## $uval = _get_packed_w($fh)
+##  + reads a single BER-compressed integer (perl pack('w')) from $fh, without read-ahead
+sub _get_packed_w {
+  my $z = 0;
+  my ($c);
+  while (read($_[0],$c,1)==1) {
+    $z = ($z<<7) | (ord($c) & 0x7f);
+    last if (!(ord($c) & 0x80));
+  }
+  return $z;
+}
+
 sub cx_get_record {
   $_cx = [$cxrEOF];
 
@@ -96,7 +128,11 @@ sub cx_get_record {
   $_flags = $_cx->[$CX_FLAGS] = ord($_tmp);
 
   ##-- xoff
-  if ($_flags & $cxfHasXmlOffset) {
+  if (($_flags & $cxfHasXmlOffset) && $_[2]) {
+    $_z = _get_packed_w($_[0]);
+    $_cx->[$CX_XOFF] = ($_[1]||0) + (($_z & 1) ? -(($_z+1)>>1) : ($_z>>1));
+  }
+  elsif ($_flags & $cxfHasXmlOffset) {
     read($_[0],$_tmp,4);
     $_cx->[$CX_XOFF] = unpack('L',$_tmp);
   } else {
@@ -118,8 +154,17 @@ sub cx_get_record {
   ##-- attrs
   if ($_flags & $cxfHasAttrs) {
     if (($_flags & $cxfTypeMask) == $cxrChar) {
-      read($_[0],$_tmp,16);
-      @$_cx[$CX_ATTRS..($CX_ATTRS+3)] = unpack('L4',$_tmp);
+      $_bb = $_[3] || \@_bbox;
+      if ($_flags & $cxfBboxDelta) {
+	foreach (0..3) {
+	  $_z = _get_packed_w($_[0]);
+	  $_bb->[$_] = ($_bb->[$_] + (($_z & 1) ? -(($_z+1)>>1) : ($_z>>1))) & 0xffffffff;
+	}
+      } else {
+	read($_[0],$_tmp,16);
+	@$_bb = unpack('L4',$_tmp);
+      }
+      @$_cx[$CX_ATTRS..($CX_ATTRS+3)] = @$_bb;
     }
     elsif (($_flags & $cxfTypeMask) == $cxrPb) {
       read($_[0],$_tmp,4);
@@ -143,12 +188,14 @@ sub cx_slurp {
   ##-- get & check header
   my $hdr = cx_get_header($fh);
   cx_check_header($hdr) or die("cx_slurp(): bad header for file '$file': $!");
+  my $varint = cx_header_varint($hdr);
+  my @bbox   = (0,0,0,0);
 
   my $xmlOffset = 0;
   my @data      = qw();
   my ($cx);
   while (!eof($fh)) {
-    push(@data, $cx=cx_get_record($fh,$xmlOffset));
+    push(@data, $cx=cx_get_record($fh,$xmlOffset,$varint,\@bbox));
     $xmlOffset = $cx->[$CX_XOFF] + $cx->[$CX_XLEN];
   }
   close($fh) if (!ref($file));
@@ -156,6 +203,15 @@ sub cx_slurp {
   return \@data;
 }
 
+## $cxp = cx_packed($filename)
+##  + returns a DTA::TokWrap::XS::CxData object for $filename (column-packed, no perl array per record)
+##  + die()s if DTA::TokWrap::XS is not available
+sub cx_packed {
+  my $file = shift;
+  die("cx_packed(): DTA::TokWrap::XS not available") if (!$HAVE_XS);
+  return DTA::TokWrap::XS::CxData->new($file);
+}
+
 
 ##==============================================================================
 ## Exports
@@ -166,12 +222,13 @@ our @EXPORT = qw();
 our %EXPORT_TAGS = (
 		    const => [
 			      qw(@cxType2Name %cxName2Type $cxrChar $cxrLb $cxrPb $cxrFormula $cxrEOF),
-			      qw($cxfTypeMask $cxfHasXmlOffset $cxfHasTxtLength $cxfHasAttrs),
-			      qw($cxhMagic $cxhVersion $cxhVersionMinR),
+			      qw($cxfTypeMask $cxfHasXmlOffset $cxfHasTxtLength $cxfHasAttrs $cxfBboxDelta),
+			      qw($cxhMagic $cxhVersion $cxhVersionMinR $cxhVersionMinV),
 			      qw($CX_FLAGS $CX_XOFF $CX_XLEN $CX_TLEN $CX_ATTRS),
 			      qw($CX_ATTR_FACS $CX_ATTR_ULX $CX_ATTR_ULY $CX_ATTR_LRX $CX_ATTR_LRY),
+			      qw($HAVE_XS),
 			     ],
-		    func  => [qw(cx_get_header cx_check_header cx_get_record cx_slurp)],
+		    func  => [qw(cx_get_header cx_check_header cx_header_varint cx_get_record cx_slurp cx_packed)],
 		   );
 $EXPORT_TAGS{all} = [map {@$_} values(%EXPORT_TAGS)];
 our @EXPORT_OK = @{$EXPORT_TAGS{all}};
@@ -220,6 +277,32 @@ DTA::TokWrap::CxData - DTA tokenizer wrappers: utilities for binary cx-file I/O
 DTA::TokWrap::CxData provides some utilities for dealing with
 *.cx files as written by the dtatw-mkindex(1) program.
 
+Since v0.99, dtatw-mkindex(1) can store xml offsets
+as zigzag-coded BER deltas (perl C<pack('w')>) against the end of the preceding record
+rather than as 4-byte integers,
+and character bounding boxes (records with $cxfBboxDelta)
+as 4 such deltas against the bounding box of the preceding character rather than as 16 raw bytes;
+such files are marked with version_min E<gt>= $cxhVersionMinV,
+and are only written if dta-tokwrap was configured with C<--enable-cx-varint>
+(implied by C<--enable-large-offsets>).
+cx_header_varint($hdr) reports the coding of a file,
+and cx_slurp() handles both transparently.
+
+cx_slurp() returns one perl array per record, which gets expensive for large files.
+If L<DTA::TokWrap::XS|DTA::TokWrap::XS> is available ($HAVE_XS is true),
+cx_packed($filename) instead returns a DTA::TokWrap::XS::CxData object,
+which decodes the whole file into packed C columns and provides
+O(1) record accessors and binary-search range queries:
+
+ $cxp = cx_packed($cxfile);
+ $n   = $cxp->size();
+ $cx  = $cxp->record($i);                ##-- [$flags,$xoff,$xlen,$tlen,@attrs], as for cx_get_record()
+ @bb  = $cxp->attrs($i);                 ##-- ($ulx,$uly,$lrx,$lry), ($facs), or ()
+ $i   = $cxp->find_xoff($xoff);          ##-- first record with xoff >= $xoff
+ @is  = $cxp->xrange($xoff,$xoff+$xlen); ##-- all records with xoff in [$xoff,$xoff+$xlen)
+
+See L<DTA::TokWrap::XS> for details.
+
 =cut
 
 
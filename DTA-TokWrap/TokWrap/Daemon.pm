@@ -0,0 +1,485 @@
+## -*- Mode: CPerl -*-
+
+## File: DTA::TokWrap::Daemon.pm
+## Author: Bryan Jurish <moocow@cpan.org>
+## Description: DTA tokenizer wrappers: preforking UNIX-socket server
+
+package DTA::TokWrap::Daemon;
+
+use DTA::TokWrap::Version;
+use DTA::TokWrap::Base;
+use DTA::TokWrap::Utils qw(:time :progs);
+use IO::Socket::UNIX;
+use POSIX qw();
+use Carp;
+use strict;
+
+##==============================================================================
+## Constants
+##==============================================================================
+our @ISA = qw(DTA::TokWrap::Base);
+
+## @DEFAULT_ALLOW_OPTS
+##  + document options which clients may set by default (see processFile())
+##  + options which select files, directories, or perl classes (e.g. outdir, tmpdir, class)
+##    must be allowed explicitly
+our @DEFAULT_ALLOW_OPTS = qw(xmlbase format keeptmp tcflang);
+
+##==============================================================================
+## Constructors etc.
+##==============================================================================
+
+## $twd = CLASS_OR_OBJ->new(%args)
+## %defaults = CLASS->defaults()
+##  + %args, %defaults, %$twd:
+##    (
+##     ##-- user options
+##     tw => $tw,                  ##-- DTA::TokWrap object (required); shared by all workers
+##     socket => $path,            ##-- UNIX-domain socket path (default='dta-tokwrap.sock')
+##     socketMode => $mode,        ##-- permissions of the socket file (default=0600: owner only)
+##     workers => $n,              ##-- number of preforked worker processes (default=4)
+##     maxRequests => $n,          ##-- respawn workers after $n requests (default=0: never)
+##     connRequests => $n,         ##-- close client connections after $n requests (default=64; 0: never)
+##     docopts => \%docopts,       ##-- options for $tw->open() (default: {}); {class} selects pseudo-make mode
+##     allowOpts => \@keys,        ##-- document options clients may set (default=\@DEFAULT_ALLOW_OPTS)
+##     targets => \@targets,       ##-- default targets for requests which don't specify any (default=['all'])
+##     makeKeyAct => $act,         ##-- one of 'make', 'remake', 'gen' (default='make')
+##     traceLevel => $level,       ##-- log level for request traces (default=undef: none)
+##     ##
+##     ##-- low-level data
+##     sock => $listener,          ##-- listening IO::Socket::UNIX (parent & workers)
+##     kids => {$pid=>$i,...},     ##-- running workers (parent only)
+##     busy => $bool,              ##-- worker is processing a request (workers only)
+##     stopping => $bool,          ##-- worker received a shutdown signal while busy (workers only)
+##    )
+sub defaults {
+  return (
+	  tw => undef,
+	  socket => 'dta-tokwrap.sock',
+	  socketMode => 0600,
+	  workers => 4,
+	  maxRequests => 0,
+	  connRequests => 64,
+	  docopts => {},
+	  allowOpts => [@DEFAULT_ALLOW_OPTS],
+	  targets => ['all'],
+	  makeKeyAct => 'make',
+	  traceLevel => undef,
+	  ##
+	  sock => undef,
+	  kids => {},
+	  busy => 0,
+	  stopping => 0,
+	 );
+}
+
+## $twd = $twd->init()
+sub init {
+  my $twd = shift;
+  $twd->logconfess("init(): no DTA::TokWrap object {tw} specified")
+    if (!UNIVERSAL::isa($twd->{tw},'DTA::TokWrap'));
+  $twd->{workers} = 1 if (($twd->{workers}||0) < 1);
+  my $class = $twd->{docopts}{class} || 'DTA::TokWrap::Document';
+  $twd->{makeKeySub} = $class->can("$twd->{makeKeyAct}Key")
+    or $twd->logconfess("init(): no method for ${class}->$twd->{makeKeyAct}Key()");
+  return $twd;
+}
+
+##==============================================================================
+## Methods: top-level
+##==============================================================================
+
+## $twd = $twd->warm()
+##  + pre-compiles XSL stylesheets and resolves the tokenizer subclass in the parent process,
+##    so that forked workers inherit them instead of re-creating them for each request
+##  + see DTA::TokWrap::warm()
+sub warm {
+  my $twd = shift;
+  $twd->{tw}->warm();
+  return $twd;
+}
+
+## $twd = $twd->run()
+##  + binds $twd->{socket}, preforks $twd->{workers} workers, and respawns them as they exit
+##  + returns on SIGTERM, SIGINT, or SIGHUP, after all workers have exited
+sub run {
+  my $twd = shift;
+  $twd->warm();
+
+  ##-- bind: create the socket file with permissions $twd->{socketMode} (no window with the default umask)
+  unlink($twd->{socket}) if (-S $twd->{socket});
+  my $umask = umask(0777 & ~$twd->{socketMode});
+  $twd->{sock} = IO::Socket::UNIX->new(Local=>$twd->{socket}, Type=>SOCK_STREAM, Listen=>SOMAXCONN);
+  my $err = $!;
+  umask($umask);
+  $twd->logconfess("run(): could not bind UNIX socket '$twd->{socket}': $err")
+    if (!$twd->{sock});
+  chmod($twd->{socketMode}, $twd->{socket})
+    or $twd->logconfess("run(): could not chmod UNIX socket '$twd->{socket}': $!");
+  $twd->info("listening on $twd->{socket} with $twd->{workers} worker(s)");
+
+  ##-- signal handlers: shutdown
+  my $done = 0;
+  my $shutdown = sub {
+    $done = 1;
+    kill('TERM', keys %{$twd->{kids}});
+  };
+  local @SIG{qw(TERM INT HUP)} = ($shutdown,$shutdown,$shutdown);
+
+  ##-- prefork & respawn
+  my ($i,$pid,$status);
+  $twd->spawn($_) foreach (0..($twd->{workers}-1));
+  while (%{$twd->{kids}}) {
+    ($pid,$status) = waitpid_any(keys %{$twd->{kids}});
+    last if ($pid <= 0);
+    $i = delete $twd->{kids}{$pid};
+    $twd->logwarn("worker #$i (pid=$pid) exited with status $status") if ($status != 0 && !$done);
+    $twd->spawn($i) if (!$done);
+  }
+
+  ##-- cleanup
+  $twd->{sock}->close();
+  delete $twd->{sock};
+  unlink($twd->{socket});
+  $twd->info("shutdown");
+  return $twd;
+}
+
+## $pid = $twd->spawn($i)
+##  + forks worker #$i (parent only)
+sub spawn {
+  my ($twd,$i) = @_;
+  my $pid = fork();
+  if (!defined($pid)) {
+    $twd->logwarn("spawn(): fork() failed for worker #$i: $!");
+    return undef;
+  }
+  elsif ($pid == 0) {
+    ##-- child: serve until signalled (or maxRequests), then exit without destructors
+    my $rc = eval { $twd->serve(); };
+    print STDERR $@ if ($@);
+    POSIX::_exit($rc ? 0 : 1);
+  }
+  $twd->{kids}{$pid} = $i;
+  return $pid;
+}
+
+## $bool = $twd->serve()
+##  + worker main loop: accept connections on $twd->{sock} and handle them in turn
+##  + shutdown signals exit immediately unless a request is being processed,
+##    in which case the worker exits after sending its response
+sub serve {
+  my $twd = shift;
+  my $nreq = 0;
+  @$twd{qw(busy stopping)} = (0,0);
+  local @SIG{qw(TERM INT HUP)} = map { sub { POSIX::_exit(0) if (!$twd->{busy}); $twd->{stopping}=1; } } (1..3);
+  my ($conn,$max);
+  while (!$twd->{stopping} && (!$twd->{maxRequests} || $nreq < $twd->{maxRequests})) {
+    next if (!($conn = $twd->{sock}->accept()));
+    $max = $twd->{maxRequests} ? ($twd->{maxRequests}-$nreq) : 0;
+    $max = $twd->{connRequests} if ($twd->{connRequests} && (!$max || $twd->{connRequests} < $max));
+    $nreq += $twd->handle($conn,$max);
+    $conn->close();
+  }
+  return 1;
+}
+
+##==============================================================================
+## Methods: requests
+##==============================================================================
+
+## $nrequests = $twd->handle($conn)
+## $nrequests = $twd->handle($conn,$max)
+##  + handles requests on a single client connection $conn, one per line:
+##      XMLFILE [ "\t" TARGETS [ "\t" KEY=VALUE ]* ]
+##    where TARGETS is a list of targets separated by commas or whitespace (empty: $twd->{targets}),
+##    and KEY=VALUE pairs are document options; 'outdir' and 'tmpdir' are applied to $twd->{tw}
+##  + writes one response line per request:
+##      "OK" "\t" XMLFILE "\t" SECONDS
+##      "ERROR" "\t" XMLFILE "\t" MESSAGE
+##  + returns at EOF, after $max requests (if $max is true), or after a shutdown signal ($twd->{stopping})
+sub handle {
+  my ($twd,$conn,$max) = @_;
+  my $nreq = 0;
+  my ($line,$xmlfile,$targets,@kvs,%opts,$t0,$rc);
+  $conn->autoflush(1);
+  while ((!$max || $nreq < $max) && !$twd->{stopping} && defined($line = <$conn>)) {
+    $line =~ s/\r?\n\z//;
+    next if ($line =~ /^\s*$/);
+    ($xmlfile,$targets,@kvs) = split(/\t/, $line);
+    %opts = map { /^([^=]*)=(.*)$/ ? ($1=>$2) : ($_=>1) } @kvs;
+    $twd->vlog($twd->{traceLevel},"request: $line") if ($twd->{traceLevel});
+
+    $twd->{busy} = 1;
+    $t0 = timestamp();
+    $rc = $twd->processFile($xmlfile, [$targets ? split(/[\,\;\s]+/,$targets) : @{$twd->{targets}}], \%opts);
+    if ($rc) {
+      $conn->print(join("\t", 'OK', $xmlfile, sprintf("%.3f", timestamp()-$t0)), "\n");
+    } else {
+      (my $msg = ($@ || 'unknown error')) =~ s/\s+\z//;
+      $msg =~ s/\s*\n\s*/ /g;
+      $conn->print(join("\t", 'ERROR', $xmlfile, $msg), "\n");
+    }
+    $twd->{busy} = 0;
+    ++$nreq;
+  }
+  return $nreq;
+}
+
+## $bool = $twd->processFile($xmlfile, \@targets, \%opts)
+##  + as for dta-tokwrap.perl processFile(); sets $@ on error
+##  + %opts keys not in @{$twd->{allowOpts}} are rejected
+sub processFile {
+  my ($twd,$xmlfile,$targets,$opts) = @_;
+  my $tw = $twd->{tw};
+  my %allow = map {($_=>undef)} @{$twd->{allowOpts}||[]};
+  if (my @denied = grep {!exists($allow{$_})} sort keys %$opts) {
+    $@ = "document option(s) not allowed: ".join(' ', @denied);
+    return 0;
+  }
+  my %docopts = (%{$twd->{docopts}}, %$opts);
+  local $tw->{outdir} = defined($docopts{outdir}) ? $docopts{outdir} : $tw->{outdir};
+  local $tw->{tmpdir} = defined($docopts{tmpdir}) ? $docopts{tmpdir} : $tw->{tmpdir};
+  delete(@docopts{qw(outdir tmpdir)});
+
+  my $rc = 1;
+  my ($doc,$target);
+  eval {
+    $rc &&= ($doc = $tw->open($xmlfile,%docopts));
+    foreach $target (@$targets) {
+      last if (!$rc);
+      $rc &&= defined($twd->{makeKeySub}->($doc,$target));
+    }
+    $rc &&= $doc->close();
+  };
+  return $rc && !$@;
+}
+
+1; ##-- be happy
+
+__END__
+
+##========================================================================
+## POD DOCUMENTATION, auto-generated by podextract.perl, edited
+
+##========================================================================
+## NAME
+=pod
+
+=head1 NAME
+
+DTA::TokWrap::Daemon - DTA tokenizer wrappers: preforking UNIX-socket server
+
+=cut
+
+##========================================================================
+## SYNOPSIS
+=pod
+
+=head1 SYNOPSIS
+
+ use DTA::TokWrap;
+ use DTA::TokWrap::Daemon;
+
+ $tw  = DTA::TokWrap->new(%opts);
+ $twd = DTA::TokWrap::Daemon->new(tw=>$tw, socket=>'/tmp/dtatw.sock', workers=>4);
+ $twd->run();   ##-- serve until SIGTERM
+
+=cut
+
+##========================================================================
+## DESCRIPTION
+=pod
+
+=head1 DESCRIPTION
+
+DTA::TokWrap::Daemon keeps a single L<DTA::TokWrap|DTA::TokWrap> object
+(with compiled XSL stylesheets and a resolved tokenizer subclass)
+alive in a long-running process, and processes documents on behalf of
+clients connecting to a UNIX-domain socket.
+This avoids the per-invocation start-up cost of F<dta-tokwrap.perl>
+(loading of perl modules, stylesheet compilation, tokenizer program probing),
+which dominates the running time for small documents.
+
+Requests are handled by a pool of preforked worker processes
+which inherit the warm DTA::TokWrap object from the parent;
+each worker handles one client connection at a time.
+Workers which exit (e.g. after C<maxRequests> requests) are respawned.
+
+=head2 Protocol
+
+Clients send one request per line:
+
+ XMLFILE [ TAB TARGETS [ TAB KEY=VALUE ]* ]
+
+XMLFILE is interpreted relative to the daemon's working directory,
+so clients should pass absolute paths.
+TARGETS is a list of targets separated by commas or whitespace;
+if empty, the daemon's default targets are used.
+KEY=VALUE pairs are passed to L<DTA::TokWrap::Document|DTA::TokWrap::Document>-E<gt>new();
+the keys C<outdir> and C<tmpdir> override the respective L<DTA::TokWrap|DTA::TokWrap> options for the request.
+Only the keys listed in C<allowOpts> are accepted (by default C<xmlbase>, C<format>, C<keeptmp>, and C<tcflang>);
+requests with any other key fail with an C<ERROR> response.
+Keys such as C<outdir>, C<tmpdir>, or C<class> let clients write to arbitrary directories
+or load arbitrary perl classes with the daemon's privileges, and must be allowed explicitly.
+
+The daemon writes one response line per request:
+
+ OK TAB XMLFILE TAB SECONDS
+ ERROR TAB XMLFILE TAB MESSAGE
+
+Requests on a single connection are processed sequentially;
+use multiple connections for concurrent processing.
+The daemon closes a connection after C<connRequests> requests;
+clients should reconnect and re-send any requests which were not answered.
+
+The socket file is created with permissions C<socketMode> (default: 0600),
+so by default only the daemon's owner may connect.
+See L<dta-tokwrap-client.perl(1)|dta-tokwrap-client.perl> for a simple client.
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Daemon: Constructors etc.
+=pod
+
+=head2 Constructors etc.
+
+=over 4
+
+=item new
+
+ $twd = $CLASS_OR_OBJ->new(%args);
+
+%args, %$twd:
+
+ ##-- user options
+ tw => $tw,                  ##-- DTA::TokWrap object (required); shared by all workers
+ socket => $path,            ##-- UNIX-domain socket path (default='dta-tokwrap.sock')
+ socketMode => $mode,        ##-- permissions of the socket file (default=0600: owner only)
+ workers => $n,              ##-- number of preforked worker processes (default=4)
+ maxRequests => $n,          ##-- respawn workers after $n requests (default=0: never)
+ connRequests => $n,         ##-- close client connections after $n requests (default=64; 0: never)
+ docopts => \%docopts,       ##-- options for $tw->open() (default: {}); {class} selects pseudo-make mode
+ allowOpts => \@keys,        ##-- document options clients may set (default=\@DEFAULT_ALLOW_OPTS)
+ targets => \@targets,       ##-- default targets for requests which don't specify any (default=['all'])
+ makeKeyAct => $act,         ##-- one of 'make', 'remake', 'gen' (default='make')
+ traceLevel => $level,       ##-- log level for request traces (default=undef: none)
+ ##
+ ##-- low-level data
+ sock => $listener,          ##-- listening IO::Socket::UNIX (parent & workers)
+ kids => {$pid=>$i,...},     ##-- running workers (parent only)
+ busy => $bool,              ##-- worker is processing a request (workers only)
+ stopping => $bool,          ##-- worker received a shutdown signal while busy (workers only)
+
+=item defaults
+
+ %defaults = CLASS->defaults();
+
+Static class-dependent defaults.
+
+=item init
+
+ $twd = $twd->init();
+
+Dynamic object-dependent defaults.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Daemon: Methods
+=pod
+
+=head2 Methods
+
+=over 4
+
+=item warm
+
+ $twd = $twd->warm();
+
+Calls L<$tw-E<gt>warm()|DTA::TokWrap/warm> to compile XSL stylesheets
+and resolve the tokenizer subclass.
+Called by L</run> before any workers are forked.
+
+=item run
+
+ $twd = $twd->run();
+
+Binds $twd-E<gt>{socket}, forks $twd-E<gt>{workers} worker processes,
+and respawns workers as they exit.
+Returns after SIGTERM, SIGINT, or SIGHUP, once all workers have exited;
+the socket file is removed on return.
+Workers finish the request they are currently processing before exiting.
+
+=item spawn
+
+ $pid = $twd->spawn($i);
+
+Low-level: fork worker number $i.
+
+=item serve
+
+ $bool = $twd->serve();
+
+Low-level: worker main loop.
+
+=item handle
+
+ $nrequests = $twd->handle($conn);
+ $nrequests = $twd->handle($conn,$max);
+
+Low-level: handle requests from the client connection $conn
+until EOF, until $max requests have been handled (if $max is true),
+or until the worker has received a shutdown signal.
+
+=item processFile
+
+ $bool = $twd->processFile($xmlfile, \@targets, \%opts);
+
+Low-level: process a single request; sets $@ on error.
+Fails if %opts contains a key which is not listed in $twd-E<gt>{allowOpts}.
+
+=back
+
+=cut
+
+##========================================================================
+## END POD DOCUMENTATION, auto-generated by podextract.perl
+
+##======================================================================
+## See Also
+##======================================================================
+
+=pod
+
+=head1 SEE ALSO
+
+L<DTA::TokWrap::Intro(3pm)|DTA::TokWrap::Intro>,
+L<dta-tokwrap.perl(1)|dta-tokwrap.perl>,
+L<dta-tokwrap-client.perl(1)|dta-tokwrap-client.perl>,
+...
+
+=cut
+
+##======================================================================
+## Footer
+##======================================================================
+
+=pod
+
+=head1 AUTHOR
+
+Bryan Jurish E<lt>moocow@cpan.orgE<gt>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2026 by Bryan Jurish
+
+This package is free software; you can redistribute it and/or modify
+it under the same terms as Perl itself, either Perl version 5.14.2 or,
+at your option, any later version of Perl 5 you may have available.
+
+=cut
@@ -7,7 +7,7 @@
 package DTA::TokWrap::Document;
 use DTA::TokWrap::Base;
 use DTA::TokWrap::Version;
-use DTA::TokWrap::Utils qw(:libxml :files :progs :slurp :time :si);
+use DTA::TokWrap::Utils qw(:libxml :files :progs :slurp :time :si :stats);
 use DTA::TokWrap::Processor::mkindex;
 use DTA::TokWrap::Processor::mkbx0;
 use DTA::TokWrap::Processor::mkbx;
@@ -20,10 +20,11 @@ use DTA::TokWrap::Processor::tokenize::tomasotath_04x;
 use DTA::TokWrap::Processor::tokenize::tomasotath_02x;
 use DTA::TokWrap::Processor::tokenize::dwds_scanner;
 use DTA::TokWrap::Processor::tokenize::dummy;
+use DTA::TokWrap::Processor::tokenize::fast;
 use DTA::TokWrap::Processor::tokenize1;
 use DTA::TokWrap::Processor::tok2xml;
 use DTA::TokWrap::Processor::txmlanno;
-#use DTA::TokWrap::Processor::standoff;
+use DTA::TokWrap::Processor::standoff;
 #use DTA::TokWrap::Processor::standoff::xsl;
 use DTA::TokWrap::Processor::addws;
 use DTA::TokWrap::Processor::idsplice;
@@ -56,6 +57,11 @@ our $TOKENIZE_CLASS = $DTA::TokWrap::Processor::tokenize::DEFAULT_SUBCLASS;
 ## $CX_ATTRS : {cxdata} index of attribute field(s)
 our ($CX_ID,$CX_XOFF,$CX_XLEN,$CX_TOFF,$CX_TLEN,$CX_TEXT,$CX_ATTRS) = (0..6);
 
+## %ZIO_KEYS
+##  + temporary file keys which are written compressed if $doc->{compressTmp} is set (see compressSpec())
+##  + not .txt, which is read by external tokenizers
+our %ZIO_KEYS = map {($_=>undef)} qw(cxfile sxfile txfile bx0file bxfile tokfile0 tokfile1 xtokfile0);
+
 our @EXPORT = qw();
 our %EXPORT_TAGS = (
 		    cx => [qw($CX_ID $CX_XOFF $CX_XLEN $CX_TOFF $CX_TLEN $CX_TEXT)],
@@ -75,8 +81,8 @@ our @EXPORT_OK = @{$EXPORT_TAGS{all}};
 ##    class => $class,      ##-- delegate call to $class->new(%args)
 ##
 ##    ##-- Source data
-##    xmlfile => $xmlfile,  ##-- source filename
-##    xmlbase => $xmlbase,  ##-- xml:base for generated files (default=basename($xmlfile))
+##    xmlfile => $xmlfile,  ##-- source filename (may be gzip- or zstd-compressed)
+##    xmlbase => $xmlbase,  ##-- xml:base for generated files (default=basename($xmlfile) without .gz or .zst suffix)
 ##    xmldata => $xmldata,  ##-- source buffer (for addws, tcfencode)
 ##
 ##    ##-- pseudo-make options
@@ -91,11 +97,16 @@ our @EXPORT_OK = @{$EXPORT_TAGS{all}};
 ##    tw => $tw,              ##-- a DTA::TokWrap object storing individual generators
 ##    traceOpen  => $level,   ##-- log-lvel for open() trace (e.g. 'info'; default=undef (none))
 ##    traceClose => $level,   ##-- log-level for close() trace (e.g. 'trace'; default=undef (none))
+##    cstats => $bool,        ##-- collect --stats=FILE statistics from C programs? (default=$tw->{cstats} or 0)
+##    cstatsdata => \%stats,  ##-- C program statistics: {$key=>{$prog=>\%stats}} (see DTA::TokWrap::Processor::statsCollect())
+##    cstatsruns => \@runs,   ##-- individual C program runs: [[$key,$prog,$end_stamp,\%stats],...] (for $tw->traceDoc())
+##    traceStage => $stage,   ##-- pipeline stage name: $tw->traceDoc() writes a 'stage' event instead of a 'document' event
 ##
 ##    ##-- generated data (common)
 ##    outdir => $outdir,    ##-- output directory for generated data (default=.)
 ##    tmpdir => $tmpdir,    ##-- temporary directory for generated data (default=$ENV{DTATW_TMP}||$outdir)
 ##    keeptmp => $bool,     ##-- if true, temporary document-local files will be kept on $doc->close()
+##    compressTmp => $spec, ##-- compress temporary files (see %ZIO_KEYS) as 'zstd[:LEVEL]' or 'gzip[:LEVEL]' (default=$tw->{compressTmp} or none)
 ##    notmpre => $regex,    ##-- non-temporary file regex
 ##    notmpkeys => $keys,   ##-- non-temporary keys, space-separated list
 ##    outbase => $filebase, ##-- output basename (default=`basename $xmlbase .xml`)
@@ -106,6 +117,7 @@ our @EXPORT_OK = @{$EXPORT_TAGS{all}};
 ##    cxdata => $cxdata,    ##-- character index data (see loadCxFile() method)
 ##    sxfile => $sxfile,    ##-- structure index file (default="$tmpdir/$outbase.sx")
 ##    txfile => $txfile,    ##-- raw text index file (default="$tmpdir/$outbase.tx")
+##    mkindexJobs => $n,    ##-- number of parallel dtatw-mkindex jobs (chunks split at <pb>; default=$tw->{mkindexJobs} or 1)
 ##
 ##    ##-- mkbx0 data (see DTA::TokWrap::Processor::mkbx0)
 ##    bx0doc  => $bx0doc,   ##-- pre-serialized block-index XML::LibXML::Document
@@ -119,6 +131,8 @@ our @EXPORT_OK = @{$EXPORT_TAGS{all}};
 ##
 ##    ##-- tokenize data (see DTA::TokWrap::Processor::tokenize, DTA::TokWrap::Processor::tokenize::dummy)
 ##    tokdata0 => $tokdata0,  ##-- tokenizer output data (slurped string)
+##    tokenizeJobs => $n,     ##-- number of parallel tokenizer jobs (chunks split at $SB$; default=$tw->{tokenizeJobs} or 1)
+##    tokenizeCache => $dir,  ##-- tokenizer output cache directory (default=$tw->{tokenizeCache} or none)
 ##    tokfile0 => $tokfile0,  ##-- tokenizer output file (default="$tmpdir/$outbase.t0"; optional)
 ##
 ##    ##-- post-tokenize data (see DTA::TokWrap::Processor::posttok)
@@ -147,15 +161,16 @@ our @EXPORT_OK = @{$EXPORT_TAGS{all}};
 ##    cwstbufr     => $wstbufr, ##-- idsplice output buffer (base + id-spliced attributes, content) -- available for override, not used by default
 ##    cwstfile     => $wstfile, ##-- idsplice output file [default="$outdir/$outbase.cwst.xml"]
 ##
-##    ##-- standoff xml data (see DTA::TokWrap::Processor::standoff -- OBSOLETE)
-##    #sosfile => $sosfile,   ##-- sentence standoff file (default="$outdir/$outbase.s.xml")
-##    #sowfile => $sowfile,   ##-- token standoff file (default="$outdir/$outbase.w.xml")
-##    #soafile => $soafile,   ##-- token-analysis standoff file (default="$outdir/$outbase.a.xml")
+##    ##-- standoff xml data (see DTA::TokWrap::Processor::standoff)
+##    sosfile => $sosfile,   ##-- sentence standoff file (default="$outdir/$outbase.s.xml")
+##    sowfile => $sowfile,   ##-- token standoff file (default="$outdir/$outbase.w.xml")
+##    soafile => $soafile,   ##-- token-analysis standoff file (default="$outdir/$outbase.a.xml")
 ##
 ##    ##-- tcfencode data (see DTA::TokWrap::Processor::tcfencode)
 ##    tcfdoc   => $tcfdoc,     ##-- XML::LibXML::Document representing TCF-encoded data
 ##    tcffile  => $tcffile,    ##-- TCF file
 ##    tcflang  => $lang,       ##-- TCF language attribute (default: 'de')
+##    tcfstream => $bool,      ##-- use streaming TCF codecs without XML::LibXML DOMs (default=$tw->{tcfstream} or 0)
 ##
 ##    ##-- tcftokenize data (see DTA::TokWrap::Processor::tcftokenize)
 ##    tcftokdoc => $tcftokdoc,    ##-- XML::LibXML::Document representing tokenized TCF data (== $tcfdoc)
@@ -223,6 +238,7 @@ sub defaults {
 	  cxdata => undef,
 	  sxfile => undef,
 	  txfile => undef,
+	  #mkindexJobs => 1,  ##-- propagated from $doc->{tw}
 
 	  ##-- mkbx0 data
 	  bx0doc  => undef,
@@ -235,6 +251,7 @@ sub defaults {
 
 	  ##-- tokenizer data
 	  tokdata0 => undef,
+	  #tokenizeJobs => 1,  ##-- propagated from $doc->{tw}
 	  tokfile0 => undef,
 
 	  ##-- post-tokenizer data
@@ -262,13 +279,14 @@ sub defaults {
 	  #sowdoc => undef,
 	  #soadoc => undef,
 	  ##
-	  #sosfile => undef,
-	  #sowfile => undef,
-	  #soafile => undef,
+	  sosfile => undef,
+	  sowfile => undef,
+	  soafile => undef,
 
 	  ##-- tcf encoding
 	  tcffile => undef,
 	  tcflang => 'de',
+	  #tcfstream => 0,  ##-- propagated from $doc->{tw}
 
 	  ##-- tcf tokenization
 	  tcftokfile => undef,
@@ -291,7 +309,7 @@ sub init {
 
   ##-- defaults: source data
   $doc->{xmlfile} = '-' if (!defined($doc->{xmlfile})); ##-- this should really be required
-  $doc->{xmlbase} = basename($doc->{xmlfile}) if (!defined($doc->{xmlbase}));
+  ($doc->{xmlbase} = basename($doc->{xmlfile})) =~ s/\.(?:gz|zst)$//i if (!defined($doc->{xmlbase}));
 
   ##-- defaults: generated data (common)
   ($doc->{outbase} = basename($doc->{xmlbase})) =~ s/\.xml$//i if (!$doc->{outbase});
@@ -301,6 +319,12 @@ sub init {
     $doc->{tmpdir} = $doc->{tw}{tmpdir};
     $doc->{keeptmp} = $doc->{tw}{keeptmp};
     $doc->{genDummy} = $doc->{tw}{genDummy} if (exists($doc->{tw}{genDummy}) && !exists($doc->{genDummy}));
+    $doc->{tcfstream} = $doc->{tw}{tcfstream} if (exists($doc->{tw}{tcfstream}) && !exists($doc->{tcfstream}));
+    $doc->{tokenizeJobs} = $doc->{tw}{tokenizeJobs} if (exists($doc->{tw}{tokenizeJobs}) && !exists($doc->{tokenizeJobs}));
+    $doc->{tokenizeCache} = $doc->{tw}{tokenizeCache} if (exists($doc->{tw}{tokenizeCache}) && !exists($doc->{tokenizeCache}));
+    $doc->{mkindexJobs} = $doc->{tw}{mkindexJobs} if (exists($doc->{tw}{mkindexJobs}) && !exists($doc->{mkindexJobs}));
+    $doc->{cstats} = $doc->{tw}{cstats} if (exists($doc->{tw}{cstats}) && !exists($doc->{cstats}));
+    $doc->{compressTmp} = $doc->{tw}{compressTmp} if (exists($doc->{tw}{compressTmp}) && !exists($doc->{compressTmp}));
   }
   $doc->{outdir} = '.' if (!$doc->{outdir});
   $doc->{tmpdir} = $doc->{outdir} if (!$doc->{tmpdir});
@@ -352,9 +376,9 @@ sub init {
   #$doc->{sowdoc} = undef;
   #$doc->{soadoc} = undef;
   ##
-  #$doc->{sosfile} = $doc->{outdir}.'/'.$doc->{outbase}.".s.xml" if (!$doc->{sosfile});
-  #$doc->{sowfile} = $doc->{outdir}.'/'.$doc->{outbase}.".w.xml" if (!$doc->{sowfile});
-  #$doc->{soafile} = $doc->{outdir}.'/'.$doc->{outbase}.".a.xml" if (!$doc->{soafile});
+  $doc->{sosfile} = $doc->{outdir}.'/'.$doc->{outbase}.".s.xml" if (!$doc->{sosfile});
+  $doc->{sowfile} = $doc->{outdir}.'/'.$doc->{outbase}.".w.xml" if (!$doc->{sowfile});
+  $doc->{soafile} = $doc->{outdir}.'/'.$doc->{outbase}.".a.xml" if (!$doc->{soafile});
 
   ##-- defaults: tcf encoding (tcfencode)
   $doc->{tcffile} = $doc->{outdir}.'/'.$doc->{outbase}.".tcf" if (!$doc->{tcffile});
@@ -428,6 +452,9 @@ sub close {
     do {$doc->logwarn("failed to unlink $_"); $rc=0; } if (-e $_ && !unlink($_));
   }
 
+  ##-- trace events
+  $doc->{tw}->traceDoc($doc) if ($doc->{tw} && $doc->{tw}{traceEvents} && $doc->{tw}->can('traceDoc'));
+
   ##-- update {tw} profiling information
   if ($doc->{tw}) {
     my $ntoks = $doc->nTokens() || 0;
@@ -455,6 +482,11 @@ sub close {
     $prof->{nxbytes} += $nxbytes;
     $prof->{laststamp} = timestamp();
     $prof->{elapsed} += $prof->{laststamp}-$doc->{open_stamp}  if (defined($doc->{open_stamp}));
+
+    ##-- C program statistics
+    foreach $key ($doc->{cstats} ? keys(%{$doc->{cstatsdata}||{}}) : qw()) {
+      stats_add(($doc->{tw}{profile}{$key}{cstats} //= {}), $doc->{cstatsdata}{$key});
+    }
   }
 
   ##-- stop here for destructor
@@ -474,6 +506,16 @@ sub notempkeys {
 
 }
 
+## $spec_or_undef = $doc->compressSpec($filekey)
+##  + returns output compression specification for $doc->{$filekey} (see DTA::TokWrap::Utils::zspec_parse()),
+##    or undef if $doc->{$filekey} should be written uncompressed
+##  + only temporary files in %ZIO_KEYS are compressed, and only if $doc->{compressTmp} is set
+sub compressSpec {
+  my ($doc,$key) = @_;
+  return undef if (!$doc->{compressTmp} || !exists($ZIO_KEYS{$key}) || grep {$_ eq $key} $doc->notempkeys);
+  return $doc->{compressTmp};
+}
+
 ## @tempfiles = $doc->tempfiles()
 ##  + returns list of temporary filenames which have been generated by $doc,
 ##    or an empty list if $doc->{keeptmp} is true
@@ -538,7 +580,7 @@ BEGIN {
        map {$_=>$spec} ("mk${_}xml", "mkso${_}", "so${_}xml","so${_}file","${_}xml")
      } ('s','w','a')),
 
-     #(map {$_=>[qw(loadXtokFile standoff)]} qw(mkstandoff standoff so mkso)),
+     (map {$_=>[qw(standoff)]} qw(mkstandoff standoff so mkso)),
 
      'tei2txt' =>[qw(mkindex),
 		  qw(mkbx0), #saveBx0File
@@ -692,10 +734,19 @@ sub mkbx {
 ## $doc_or_undef = $doc->tokenize()
 ##  + see DTA::TokWrap::Processor::tokenize::tokenize()
 ##  + default tokenizer class is given by package-global $doc->{tokenizeClass}//$TOKENIZE_CLASS
+##  + if $doc->{tokenizeJobs} > 1, uses $tz->tokenize_chunked() if available,
+##    otherwise DTA::TokWrap::Processor::tokenize::tokenize_chunked()
+##  + if $doc->{tokenizeCache} is set, uses DTA::TokWrap::Processor::tokenize::tokenize_cached()
+##    (which calls back to this method for uncached text blocks)
 sub tokenize {
   $_[0]->setLogContext();
   $_[0]->vlog($_[0]{traceProc},"tokenize()") if ($_[0]{traceProc});
-  return ($_[1] || ($_[0]{tw} && ($_[0]{tw}{tokenize}||$_[0]{tw}{tokenizeClass})) || $_[0]{tokenizeClass} || "$TOKENIZE_CLASS")->tokenize($_[0]);
+  my $tz = ($_[1] || ($_[0]{tw} && ($_[0]{tw}{tokenize}||$_[0]{tw}{tokenizeClass})) || $_[0]{tokenizeClass} || "$TOKENIZE_CLASS");
+  return DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$_[0],$_[0]{tokenizeCache},$_[0]{tokenizeJobs})
+    if ($_[0]{tokenizeCache});
+  return (UNIVERSAL::can($tz,'tokenize_chunked') || \&DTA::TokWrap::Processor::tokenize::tokenize_chunked)->($tz,$_[0],$_[0]{tokenizeJobs})
+    if (($_[0]{tokenizeJobs}||0) > 1);
+  return $tz->tokenize($_[0]);
 }
 BEGIN {
   *tokenize0 = \&tokenize;
@@ -746,6 +797,42 @@ sub idsplice {
   return ($_[1] || ($_[0]{tw} && $_[0]{tw}{idsplice}) || 'DTA::TokWrap::Processor::idsplice')->idsplice($_[0]);
 }
 
+## $doc_or_undef = $doc->standoff($standoff)
+## $doc_or_undef = $doc->standoff()
+##  + see DTA::TokWrap::Processor::standoff::standoff()
+sub standoff {
+  $_[0]->setLogContext();
+  $_[0]->vlog($_[0]{traceProc},"standoff()") if ($_[0]{traceProc});
+  return ($_[1] || ($_[0]{tw} && $_[0]{tw}{standoff}) || 'DTA::TokWrap::Processor::standoff')->standoff($_[0]);
+}
+
+## $doc_or_undef = $doc->sosxml($standoff)
+## $doc_or_undef = $doc->sosxml()
+##  + see DTA::TokWrap::Processor::standoff::sosxml()
+sub sosxml {
+  $_[0]->setLogContext();
+  $_[0]->vlog($_[0]{traceProc},"sosxml()") if ($_[0]{traceProc});
+  return ($_[1] || ($_[0]{tw} && $_[0]{tw}{standoff}) || 'DTA::TokWrap::Processor::standoff')->sosxml($_[0]);
+}
+
+## $doc_or_undef = $doc->sowxml($standoff)
+## $doc_or_undef = $doc->sowxml()
+##  + see DTA::TokWrap::Processor::standoff::sowxml()
+sub sowxml {
+  $_[0]->setLogContext();
+  $_[0]->vlog($_[0]{traceProc},"sowxml()") if ($_[0]{traceProc});
+  return ($_[1] || ($_[0]{tw} && $_[0]{tw}{standoff}) || 'DTA::TokWrap::Processor::standoff')->sowxml($_[0]);
+}
+
+## $doc_or_undef = $doc->soaxml($standoff)
+## $doc_or_undef = $doc->soaxml()
+##  + see DTA::TokWrap::Processor::standoff::soaxml()
+sub soaxml {
+  $_[0]->setLogContext();
+  $_[0]->vlog($_[0]{traceProc},"soaxml()") if ($_[0]{traceProc});
+  return ($_[1] || ($_[0]{tw} && $_[0]{tw}{standoff}) || 'DTA::TokWrap::Processor::standoff')->soaxml($_[0]);
+}
+
 ## $doc_or_undef = $doc->tcfencode($tcfencode)
 ## $doc_or_undef = $doc->tcfencode()
 ##  + see DTA::TokWrap::Processor::tcfencode::tcfencode()
@@ -820,6 +907,14 @@ sub loadFileDoc {
     ##-- load from filehandle
     $doc->{$key."doc"} = $xmlparser->parse_fh($file);
     $doc->{$key."doc_stamp"} = timestamp();
+  } elsif (zfile_format($file)) {
+    ##-- load from named compressed file
+    my $fh = zopen_file($file)
+      or $doc->logconfess("loadFileDoc($key): open failed for {${key}file} '$file': $!");
+    $doc->{$key."doc"} = $xmlparser->parse_fh($fh);
+    $fh->close()
+      or $doc->logconfess("loadFileDoc($key): decompression failed for {${key}file} '$file'");
+    $doc->{$key."doc_stamp"} = file_mtime($file);
   } else {
     ##-- load from named file
     $doc->{$key."doc"} = $xmlparser->parse_file($file);
@@ -883,9 +978,8 @@ sub loadBxFile {
 
   ##-- load .bx file
   my $bxdata = $doc->{bxdata} = [];
-  my $fh = ref($bxfile) ? $bxfile : IO::File->new("<$bxfile");
+  my $fh = ref($bxfile) ? $bxfile : zopen_file($bxfile);
   $doc->logconfess("loadBxFile(): open failed for .bx file '$bxfile': $!") if (!$fh);
-  $fh->binmode() if (!ref($bxfile));
   my ($blk);
   while (<$fh>) {
     chomp;
@@ -918,9 +1012,8 @@ sub loadCxFile {
   $doc->vlog($doc->{traceLoad}, "loadCxFile($file)") if ($doc->{traceLoad});
 
   my $cx = $doc->{cxdata} = [];
-  my $fh = ref($file) ? $file : IO::File->new("<$file");
+  my $fh = ref($file) ? $file : zopen_file($file);
   $doc->logconfess("loadCxFile(): open failed for .cx file '$file': $!") if (!$fh);
-  $fh->binmode() if (!ref($file));
   while (<$fh>) {
     chomp;
     next if (/^%%/ || /^\s*$/);
@@ -987,7 +1080,10 @@ sub loadTxtData {
 ## \$xmldoc_or_undef = $doc->loadTcfFile($filename_or_fh_or_stringref)
 ## \$tcfdoc_or_undef = $doc->loadTcfFile()
 ##  + loads $doc->{tcfdoc} from $filename_or_fh_or_stringref (default=$doc->{tcfdatar} or $doc->{tcffile})
+##  + if $doc->{tcfstream} is true and no source was specified, does nothing:
+##    streaming processors (tcfdecode0, tcftokenize) read $doc->{tcffile} directly
 sub loadTcfFile {
+  return $_[0]{tcffile} if ($_[0]{tcfstream} && !$_[1]);
   return $_[0]->loadFileDoc('tcf',$_[1],keep_blanks=>0);
 }
 
@@ -1027,6 +1123,14 @@ sub saveFileDoc {
     ##-- save: to filehandle
     $xmldoc->toFh($file,$format);
   }
+  elsif (defined(my $zspec = $doc->compressSpec("${key}file"))) {
+    ##-- save: to named file, compressed
+    my $fh = zcreate_file($file,$zspec)
+      or $doc->logconfess("saveFileDoc($key): failed to open file '$file': $!");
+    $fh->print($xmldoc->toString($format));
+    $fh->close()
+      or $doc->logconfess("saveFileDoc($key): failed to close file '$file': $!");
+  }
   else {
     ##-- save: to named file
     $xmldoc->toFile($file,$format);
@@ -1057,9 +1161,8 @@ sub saveFileData {
   $doc->vlog($doc->{traceSave}, "saveFileData($key,$suff,$file)") if ($doc->{traceSave});
 
   ##-- get filehandle & print
-  my $fh = ref($file) ? $file : IO::File->new(">$file");
+  my $fh = ref($file) ? $file : zcreate_file($file, $doc->compressSpec("${key}file${suff}"));
   $doc->logconfess("saveFileData($key,$suff): failed to open file '$file': $!") if (!$fh);
-  $fh->binmode() if (!ref($file));
   $fh->print( $$datar );
   if (!ref($file)) {
     $fh->close()
@@ -1108,7 +1211,7 @@ sub saveBxFile {
   $doc->vlog($doc->{traceSave}, "saveBxFile($file)") if ($doc->{traceSave});
 
   ##-- get filehandle & print
-  my $fh = ref($file) ? $file : IO::File->new(">$file");
+  my $fh = ref($file) ? $file : zcreate_file($file, $doc->compressSpec('bxfile'));
   $doc->logconfess("saveBxFile(): open failed for output file '$file': $!") if (!$fh);
   $fh->print(
 	      "%% XML block list file generated by ", __PACKAGE__, "::saveBxFile() (DTA::TokWrap version $DTA::TokWrap::VERSION)\n",
@@ -1117,7 +1220,10 @@ sub saveBxFile {
 	      "%% \$KEY\$\t\$ELT\$\t\$XML_OFFSET\$\t\$XML_LENGTH\$\t\$TX_OFFSET\$\t\$TX_LEN\$\t\$TXT_OFFSET\$\t\$TXT_LEN\$\t\$BX0_OFFSET\$\n",
 	      (map {join("\t", @$_{qw(key elt xoff xlen toff tlen otoff otlen bx0off)})."\n"} @$bxdata),
 	    );
-  $fh->close() if (!ref($file));
+  if (!ref($file)) {
+    $fh->close()
+      or $doc->logconfess("saveBxFile(): failed to close file '$file': $!");
+  }
 
   $doc->{bxfile_stamp} = timestamp(); ##-- stamp
   return $file;
@@ -1218,7 +1324,9 @@ sub saveXtokFile {
 ##  + $filename_or_fh defaults to $doc->{tcffile}="$doc->{outdir}/$doc->{outbase}.tcf"
 ##  + $tcfdoc defaults to $doc->{tcfdoc}
 ##  + sets $doc->{tcffile_stamp}
+##  + no-op if $doc->{tcfstream} is true and $doc->{tcfdoc} is undefined (file was written by tcfencode())
 sub saveTcfFile {
+  return $_[0]{tcffile} if ($_[0]{tcfstream} && !defined($_[0]{tcfdoc}) && @_ < 2);
   return $_[0]->saveFileDoc('tcf',@_[1..$#_]);
 }
 
@@ -1230,7 +1338,9 @@ sub saveTcfFile {
 ##  + $filename_or_fh defaults to $doc->{tcftokfile}="$doc->{outdir}/$doc->{outbase}.tcftok"
 ##  + $tcftokdoc defaults to $doc->{tcftokdoc}
 ##  + sets $doc->{tcftokfile_stamp}
+##  + no-op if $doc->{tcfstream} is true and $doc->{tcftokdoc} is undefined (file was written by tcftokenize())
 sub saveTcfTokFile {
+  return $_[0]{tcftokfile} if ($_[0]{tcfstream} && !defined($_[0]{tcftokdoc}) && @_ < 2);
   return $_[0]->saveFileDoc('tcftok',@_[1..$#_]);
 }
 
@@ -1410,6 +1520,12 @@ Default tokenizer sub-processor class
 Field indices in .cx files generated by the
 L<mkindex()|/mkindex> method.
 
+=item Variable: %ZIO_KEYS
+
+Temporary file keys (C<cxfile sxfile txfile bx0file bxfile tokfile0 tokfile1 xtokfile0>)
+which are written compressed if $doc-E<gt>{compressTmp} is set;
+see L<compressSpec()|/compressSpec>.
+
 =back
 
 =cut
@@ -1438,8 +1554,8 @@ instead of calling this constructor directly.
  class => $class,      ##-- delegate call to $class->new(%args)
  ##
  ##-- Source data
- xmlfile => $xmlfile,  ##-- source filename
- xmlbase => $xmlbase,  ##-- xml:base for generated files (default=basename($xmlfile))
+ xmlfile => $xmlfile,  ##-- source filename (may be gzip- or zstd-compressed)
+ xmlbase => $xmlbase,  ##-- xml:base for generated files (default=basename($xmlfile) without .gz or .zst suffix)
  xmldata => $xmldata,  ##-- source buffer (for addws, tcfencode)
  ##
  ##-- pseudo-make options
@@ -1454,11 +1570,16 @@ instead of calling this constructor directly.
  tw => $tw,              ##-- a DTA::TokWrap object storing individual generators
  traceOpen  => $leve,    ##-- log-lvel for open() trace (e.g. 'info'; default=undef (none))
  traceClose => $level,   ##-- log-level for close() trace (e.g. 'trace'; default=undef (none))
+ cstats => $bool,        ##-- collect --stats=FILE statistics from C programs? (default=$tw->{cstats} or 0)
+ cstatsdata => \%stats,  ##-- C program statistics: {$key=>{$prog=>\%stats}} (see DTA::TokWrap::Processor::statsCollect())
+ cstatsruns => \@runs,   ##-- individual C program runs: [[$key,$prog,$end_stamp,\%stats],...] (for $tw->traceDoc())
+ traceStage => $stage,   ##-- pipeline stage name: $tw->traceDoc() writes a 'stage' event instead of a 'document' event
  ##
  ##-- generated data (common)
  outdir => $outdir,    ##-- output directory for generated data (default=.)
  tmpdir => $tmpdir,    ##-- temporary directory for generated data (default=$ENV{DTATW_TMP}||$outdir)
  keeptmp => $bool,     ##-- if true, temporary document-local files will be kept on $doc->close()
+ compressTmp => $spec, ##-- compress temporary files (see %ZIO_KEYS) as 'zstd[:LEVEL]' or 'gzip[:LEVEL]' (default=$tw->{compressTmp} or none)
  notmpre => $regex,    ##-- non-temporary filename regex
  notmpkeys => $keys,   ##-- non-temporary keys, space-separated list
  outbase => $filebase, ##-- output basename (default=`basename $xmlbase .xml`)
@@ -1469,6 +1590,7 @@ instead of calling this constructor directly.
  cxdata => $cxdata,    ##-- character index data (see loadCxFile() method)
  sxfile => $sxfile,    ##-- structure index file (default="$tmpdir/$outbase.sx")
  txfile => $txfile,    ##-- raw text index file (default="$tmpdir/$outbase.tx")
+ mkindexJobs => $n,    ##-- number of parallel dtatw-mkindex jobs (chunks split at <pb>; default=$tw->{mkindexJobs} or 1)
  ##
  ##-- mkbx0 data (see DTA::TokWrap::Processor::mkbx0)
  bx0doc  => $bx0doc,   ##-- pre-serialized block-index XML::LibXML::Document
@@ -1482,6 +1604,8 @@ instead of calling this constructor directly.
  ##
  ##-- tokenize data (see DTA::TokWrap::Processor::tokenize, DTA::TokWrap::Processor::tokenize::dummy)
  tokdata0 => $tokdata0,  ##-- tokenizer output data (slurped string)
+ tokenizeJobs => $n,     ##-- number of parallel tokenizer jobs (chunks split at $SB$; default=$tw->{tokenizeJobs} or 1)
+ tokenizeCache => $dir,  ##-- tokenizer output cache directory (default=$tw->{tokenizeCache} or none)
  tokfile0 => $tokfile0,  ##-- tokenizer output file (default="$tmpdir/$outbase.t0"; optional)
  ##
  ##-- post-tokenize data (see DTA::TokWrap::Processor::tokenize1)
@@ -1514,6 +1638,7 @@ instead of calling this constructor directly.
  tcfdoc   => $tcfdoc,     ##-- XML::LibXML::Document representing TCF-encoded data
  tcffile  => $tcffile,    ##-- TCF file
  tcflang  => $lang,       ##-- TCF language attribute (default: 'de')
+ tcfstream => $bool,      ##-- use streaming TCF codecs without XML::LibXML DOMs (default=$tw->{tcfstream} or 0)
  ##
  ##-- tcftokenize data (see DTA::TokWrap::Processor::tcftokenize)
  tcftokdoc => $tcftokdoc,    ##-- XML::LibXML::Document representing tokenized TCF data (== $tcfdoc)
@@ -1579,6 +1704,8 @@ Wrapper for L<$CLASS_OR_OBJECT-E<gt>new()|/new>, with some additional sanity che
 
 "Closes" document $doc, adding profiling information to
 $doc-E<gt>{tw} if present.
+If $doc-E<gt>{tw}{traceEvents} is set, also writes trace events for $doc
+using L<DTA::TokWrap::traceDoc()|DTA::TokWrap/traceDoc>.
 
 Unlinks any temporary files in $doc unless $doc-E<gt>{keeptmp} is true.
 All %$doc keys ending in 'file' are considered 'temporary' files, except:
@@ -1594,6 +1721,17 @@ default values (thus making $doc essentially unuseable).
 Returns list of document keys ending 'file' which are not considered "temporary"
 Used by L<$doc-E<gt>tempfiles()|/tempfiles>.
 
+=item compressSpec
+
+ $spec_or_undef = $doc->compressSpec($filekey);
+
+Returns the output compression specification for $doc-E<gt>{$filekey}
+(see L<DTA::TokWrap::Utils::zspec_parse()|DTA::TokWrap::Utils/zspec_parse>),
+or undef if the file should be written uncompressed.
+Only temporary files listed in L<%ZIO_KEYS|/"Variable: %ZIO_KEYS"> are compressed,
+and only if $doc-E<gt>{compressTmp} is set.
+Compressed files keep their usual names; all readers detect compression transparently.
+
 =item tempfiles
 
  @tempfiles = $doc->tempfiles();
@@ -1690,7 +1828,8 @@ see
 L<DTA::TokWrap::Processor::tokenize::tokenize()|DTA::TokWrap::Processor::tokenize/tokenize>,
 L<DTA::TokWrap::Processor::tokenize::http::tokenize()|DTA::TokWrap::Processor::tokenize::http/tokenize>,
 L<DTA::TokWrap::Processor::tokenize::tomasotath::tokenize()|DTA::TokWrap::Processor::tokenize::tomastotath/tokenize>,
-L<DTA::TokWrap::Processor::tokenize::dummy::tokenize()|DTA::TokWrap::Processor::tokenize::dummy/tokenize>.
+L<DTA::TokWrap::Processor::tokenize::dummy::tokenize()|DTA::TokWrap::Processor::tokenize::dummy/tokenize>,
+L<DTA::TokWrap::Processor::tokenize::fast::tokenize()|DTA::TokWrap::Processor::tokenize::fast/tokenize>.
 
 Default tokenizer subclass is given by package-global $TOKENIZE_CLASS.
 
@@ -1730,6 +1869,21 @@ see L<DTA::TokWrap::Processor::addws::addws()|DTA::TokWrap::Processor::addws/add
 
 see L<DTA::TokWrap::Processor::idsplice::idsplice()|DTA::TokWrap::Processor::idsplice/idsplice>.
 
+=item standoff
+
+ $doc_or_undef = $doc->standoff($standoff);
+ $doc_or_undef = $doc->standoff();
+
+see L<DTA::TokWrap::Processor::standoff::standoff()|DTA::TokWrap::Processor::standoff/standoff>.
+
+=item sosxml, sowxml, soaxml
+
+ $doc_or_undef = $doc->sosxml($standoff);
+ $doc_or_undef = $doc->sowxml($standoff);
+ $doc_or_undef = $doc->soaxml($standoff);
+
+see L<DTA::TokWrap::Processor::standoff|DTA::TokWrap::Processor::standoff>.
+
 =item tcfencode
 
  $doc_or_undef = $doc->tcfencode($tcfencode)
@@ -1931,6 +2085,10 @@ known %opts:
 Saves TCF-encoded document $tcfdoc (default=$doc-E<gt>{tcfdoc}) to $filename_or_fh
 (default=$doc-E<gt>{tcffile}="$doc-E<gt>{outdir}/$doc-E<gt>{outbase}.t.xml"),
 and sets $doc-E<gt>{tcffile_stamp}.
+If $doc-E<gt>{tcfstream} is true and $doc-E<gt>{tcfdoc} is undefined,
+$doc-E<gt>{tcffile} has already been written by the streaming
+L<tcfencode|DTA::TokWrap::Processor::tcfencode> processor,
+and this method does nothing.
 
 =back
 
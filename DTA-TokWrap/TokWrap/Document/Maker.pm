@@ -7,7 +7,10 @@
 package DTA::TokWrap::Document::Maker;
 use DTA::TokWrap::Version;
 use DTA::TokWrap::Document;
-use DTA::TokWrap::Utils qw(:time :files);
+use DTA::TokWrap::Utils qw(:time :files :progs);
+use Scalar::Util qw(blessed refaddr);
+use Storable qw(nstore retrieve);
+use POSIX qw();
 
 ##==============================================================================
 ## Globals
@@ -22,6 +25,7 @@ our @ISA = qw(DTA::TokWrap::Document);
 ##  + additional %args, %$doc:
 ##    ##-- pseudo-make options
 ##    force     => \@keys,  ##-- force re-generation of all dependencies for @keys
+##    makeJobs  => $n,      ##-- generate up to $n independent keys concurrently (default=1; propagated from $doc->{tw})
 ##
 ##    ##-- timestamp data
 ##    "${key}_stamp"   => $stamp,   ##-- timestamp for data keys; see keyStamp() method
@@ -56,6 +60,7 @@ sub init {
     ##-- propagate from $doc->{tw} to $doc, if available & not overridden
     $doc->{force} = $doc->{tw}{force} if (exists($doc->{tw}{force}) && !exists($doc->{force}));
     $doc->{genDummy} = $doc->{tw}{genDummy} if (exists($doc->{tw}{genDummy}) && !exists($doc->{genDummy}));
+    $doc->{makeJobs} = $doc->{tw}{makeJobs} if (exists($doc->{tw}{makeJobs}) && !exists($doc->{makeJobs}));
   }
 
   ##-- init: forced remake
@@ -86,25 +91,22 @@ our %KEYGEN =
    #%DTA::TokWrap::Document::KEYGEN, ##-- inherited defaults
 
    ##-- overrides
+   ##  + file keys are generated from files, as for the -nomake targets of the same name,
+   ##    so that independent keys can be generated in separate processes (see makeKeyDag())
    xmlfile => sub { $_[0]; },
    (map {$_=>'mkindex'} qw(cxfile sxfile txfile)),
    cxdata => 'loadCxFile',
-   bx0doc => 'mkbx0',
-   bxdata => 'mkbx',
-   bxfile  => 'saveBxFile',
-   txtfile => 'saveTxtFile',
-   tokdata => 'tokenize',
-   tokfile => 'saveTokFile',
-   xtokdata => 'tok2xml',
-   xtokdoc  => 'xtokDoc',
-   xtokfile => 'saveXtokFile',
-   sosdoc => 'sosxml',
-   sowdoc => 'sowxml',
-   soadoc => 'soaxml',
-   sosfile => 'saveSosFile',
-   sowfile => 'saveSowFile',
-   soafile => 'saveSoaFile',
+   bx0file => [qw(mkbx0 saveBx0File)],
+   (map {$_=>[qw(loadBx0File mkbx saveBxFile saveTxtFile)]} qw(bxfile txtfile)),
+   tokfile0 => [qw(tokenize0 saveTokFile0)],
+   tokfile1 => [qw(tokenize1 saveTokFile1)],
+   xtokfile => [qw(loadTokFile1 tok2xml txmlanno saveXtokFile)],
+   cwsfile => 'addws',
+   cwstfile => 'idsplice',
+   (map {$_=>'standoff'} qw(sosfile sowfile soafile)),
+   tcffile => [qw(tcfencode saveTcfFile)],
    sofiles => sub { $_[0]{sofiles}=1; },
+   (map {$_=>sub {1}} qw(tokXml standoffXml)),
    all => sub { $_[0]{all}=1; },
   );
 
@@ -127,19 +129,17 @@ BEGIN {
   %KEYDEPS_0 = (
 		xmlfile => [],  ##-- bottom-out here
 		(map {$_ => ['xmlfile']} qw(cxfile txfile sxfile)),
-		bx0doc => ['sxfile'],
-		bxdata => [qw(bx0doc txfile)],
-		(map {$_=>['bxdata']} qw(txtfile bxfile)),
-		tokdata => ['txtfile'],
-		tokfile => ['tokdata'],
 		cxdata => ['cxfile'],
-		xtokdata => [qw(cxdata bxdata tokdata)],
-		xtokfile => ['xtokdata'],
-		xtokdoc => ['xtokdata'],
-		(map {$_=>['xtokdoc']} qw(sowdoc sosdoc soadoc)),
-		(map {($_."file")=>[$_."doc"]} qw(sow sos soa)),
-		sodocs  => [qw(sowdoc sosdoc soadoc)],
+		bx0file => [qw(sxfile txfile)],
+		(map {$_=>[qw(bx0file txfile)]} qw(txtfile bxfile)),
+		tokfile0 => ['txtfile'],
+		tokfile1 => ['tokfile0'],
+		xtokfile => [qw(cxfile bxfile tokfile1)],
+		cwsfile => [qw(xmlfile xtokfile)],
+		cwstfile => [qw(cwsfile xtokfile)],
+		(map {$_=>['xtokfile']} qw(sowfile sosfile soafile)),
 		sofiles => [qw(sowfile sosfile soafile)],
+		tcffile => [qw(xmlfile txtfile)],
 		##
 		##-- Aliases
 		tokXml      => [qw(xtokfile)],
@@ -215,9 +215,9 @@ sub keyStamp {
   return
     #$doc->{"${key}_stamp"} = file_mtime($doc->{$key}) ##-- DANGEROUS with keeptmp=>0 !
     file_mtime($doc->{$key}) ##-- DANGEROUS with keeptmp=>0 !
-      if ($key =~ m/file$/ && defined($doc->{$key}) && -r $doc->{$key});
+      if ($key =~ m/file[01]?$/ && defined($doc->{$key}) && -r $doc->{$key});
   return $doc->{"${key}_stamp"} = timestamp()
-    if ($key !~ m/file$/ && defined($doc->{$key}));
+    if ($key !~ m/file[01]?$/ && defined($doc->{$key}));
   return undef;
   ##--
   #my ($doc,$key,$reqKey) = @_;
@@ -263,18 +263,166 @@ sub genKey {
 }
 
 ## $bool = $doc->makeKey($key)
-## $bool = $doc->makeKey($key,\%queued)
 ##  + conditionally (re-)generate a data key, checking dependencies
+##  + if $doc->{makeJobs} > 1, stale dependencies are first generated by makeKeyDag()
 sub makeKey {
   my ($doc,$key) = @_;
   $doc->vlog($doc->{traceMake},"$doc->{xmlbase}: makeKey($key)") if ($doc->{traceMake});
   return $doc->{$key} if ($doc->keyIsCurrent($key));
+  if (($doc->{makeJobs}||1) > 1 && !$doc->{makeDagActive}) {
+    ##-- parallel: generate the DAG, then do a sequential pass to catch anything left over
+    local $doc->{makeDagActive} = 1;
+    $doc->makeKeyDag($key);
+    return $doc->makeKey($key);
+  }
   foreach ($doc->keyDeps0($key)) {
     $doc->makeKey($_) if (!defined($doc->{"${_}_stamp"}) || !$doc->keyIsCurrent($_));
   }
   return $doc->genKey($key) if (!$doc->keyIsCurrent($key));
 }
 
+##--------------------------------------------------------------
+## Methods: Pseudo-make: Parallel (Re-)generation
+
+## $genid = PACKAGE::genSpecId($gen)
+##  + string identifying generator specification $gen (for merging keys with a common generator)
+sub genSpecId {
+  my $gen = shift;
+  return join(' ', map {"$_"} (UNIVERSAL::isa($gen,'ARRAY') ? @$gen : $gen));
+}
+
+## $doc = $doc->makeKeyDag($key)
+##  + conditionally (re-)generates stale dependencies of $key (and $key itself),
+##    running up to $doc->{makeJobs} independent generators concurrently in forked child processes
+##  + keys whose generators are running are re-checked when their generator finishes;
+##    keys sharing a generator (e.g. sosfile,sowfile,soafile) are generated only once
+##  + child results are passed back via Storable files in $doc->{tmpdir} (see makeFork());
+##    blessed objects (e.g. in-memory XML documents) are NOT passed back:
+##    consumers re-load them from the corresponding files
+##  + on error, running jobs are waited for and an exception is thrown
+sub makeKeyDag {
+  my ($doc,$key) = @_;
+  my $njobs = $doc->{makeJobs} || 1;
+
+  ##-- plan: collect stale keys
+  my (%deps,%rdeps);
+  my @stack = ($key);
+  while (defined(my $k=pop(@stack))) {
+    next if (exists($deps{$k}));
+    $deps{$k} = {};
+    next if ($doc->keyIsCurrent($k));
+    foreach (keyDeps0($k)) {
+      next if (defined($doc->{"${_}_stamp"}) && $doc->keyIsCurrent($_));
+      $deps{$k}{$_} = undef;
+      $rdeps{$_}{$k} = undef;
+      push(@stack,$_);
+    }
+  }
+  $doc->vlog($doc->{traceMake},"$doc->{xmlbase}: makeKeyDag($key): ".scalar(keys %deps)." key(s), $njobs job(s)")
+    if ($doc->{traceMake});
+
+  ##-- execute
+  my %pending = map {($_=>scalar(keys %{$deps{$_}}))} keys(%deps);
+  my @ready   = sort {keycmp($a,$b)} grep {!$pending{$_}} keys(%pending);
+  my (%running,%busy,%waiting,$err);  ##-- %running: ($pid=>\%job), %busy: ($genid=>\%job), %waiting: ($genid=>\@keys)
+  my $done = sub {
+    foreach my $k (@_) {
+      foreach (keys %{$rdeps{$k}||{}}) {
+	push(@ready,$_) if (--$pending{$_}==0);
+      }
+    }
+    @ready = sort {keycmp($a,$b)} @ready;
+  };
+
+  while (@ready || %running) {
+    ##-- start ready jobs
+    while (!$err && @ready && scalar(keys %running) < $njobs) {
+      my $k = shift(@ready);
+      if ($doc->keyIsCurrent($k)) {
+	$done->($k);
+	next;
+      }
+      my $genid = genSpecId(exists($KEYGEN{$k}) ? $KEYGEN{$k} : $k);
+      if (exists($busy{$genid})) {
+	push(@{$waiting{$genid}}, $k);
+	next;
+      }
+      if (!%running && !@ready) {
+	##-- nothing to run in parallel: generate in-process
+	$doc->vlog($doc->{traceMake},"$doc->{xmlbase}: makeKeyDag(): genKey($k)") if ($doc->{traceMake});
+	eval { $doc->genKey($k) or die("genKey($k) failed\n"); };
+	if ($@) { $err = $@; last; }
+	$done->($k);
+	next;
+      }
+      my $job = $doc->makeFork($k);
+      if (!defined($job)) { $err = "fork() failed for key '$k': $!"; last; }
+      $running{$job->{pid}} = $busy{$genid} = { %$job, genid=>$genid };
+    }
+    last if (!%running);
+
+    ##-- reap a job (only our own: the caller may have other children)
+    my ($pid,$status) = waitpid_any(keys %running);
+    my $job = delete($running{$pid});
+    delete($busy{$job->{genid}});
+    my $jerr = $doc->makeCollect($job, $status);
+    if (defined($jerr)) {
+      $err //= $jerr;
+    } elsif (!$err) {
+      $done->($job->{key});
+      push(@ready, @{delete($waiting{$job->{genid}})||[]});
+      @ready = sort {keycmp($a,$b)} @ready;
+    }
+  }
+  $doc->logconfess("makeKeyDag($key): $err") if ($err);
+  return $doc;
+}
+
+## \%job_or_undef = $doc->makeFork($key)
+##  + forks a child process to generate $key, returns \%job=>{key=>$key, pid=>$pid, file=>$stofile}
+##  + the child stores its changed and deleted top-level keys to $job->{file} via Storable::nstore()
+sub makeFork {
+  my ($doc,$key) = @_;
+  my $file = "$doc->{tmpdir}/$doc->{outbase}.make_$key.sto";
+  $doc->vlog($doc->{traceMake},"$doc->{xmlbase}: makeKeyDag(): fork genKey($key)") if ($doc->{traceMake});
+  my $pid = fork();
+  return undef if (!defined($pid));
+  return { key=>$key, pid=>$pid, file=>$file } if ($pid);
+
+  ##-- child
+  my $sig = sub { defined($_[0]) ? (ref($_[0]) ? refaddr($_[0]) : "=$_[0]") : '' };
+  my %before = map {($_=>$sig->($doc->{$_}))} keys(%$doc);
+  eval { $doc->genKey($key) or die("genKey($key) failed\n"); };
+  my $res = { error=>$@ };
+  my ($k,$v);
+  while (($k,$v)=each(%$doc)) {
+    next if (blessed($v));
+    next if (exists($before{$k}) && $sig->($v) eq $before{$k});
+    $res->{set}{$k} = $v;
+  }
+  $res->{del} = [grep {!exists($doc->{$_})} keys(%before)];
+  if (!eval { nstore($res,$file) }) {
+    ##-- fallback: scalars only
+    $res->{set} = { map {ref($res->{set}{$_}) ? qw() : ($_=>$res->{set}{$_})} keys %{$res->{set}} };
+    nstore($res,$file) or POSIX::_exit(255);
+  }
+  POSIX::_exit(0);
+}
+
+## $error_or_undef = $doc->makeCollect(\%job, $waitStatus)
+##  + merges results of a child process forked by makeFork() into $doc
+sub makeCollect {
+  my ($doc,$job,$status) = @_;
+  my $res = -e $job->{file} ? eval { retrieve($job->{file}) } : undef;
+  unlink($job->{file});
+  if (!$res) {
+    return "child process $job->{pid} for key '$job->{key}' failed with exit status ".($status>>8)." (signal ".($status&127).")";
+  }
+  @$doc{keys %{$res->{set}||{}}} = values %{$res->{set}||{}};
+  delete(@$doc{@{$res->{del}||[]}});
+  return $res->{error} ? "genKey($job->{key}): $res->{error}" : undef;
+}
+
 ## $bool = $doc->makeAll()
 ##  + alias for $doc->makeKey('all')
 sub makeAll { return $_[0]->makeKey('all'); }
@@ -349,6 +497,11 @@ L<DTA::TokWrap::Document|DTA::TokWrap::Document>
 subclass which attempts to perform C<make>-like dependency
 tracking on document data keys.
 
+Keys are (mostly) files, generated as for the
+L<DTA::TokWrap::Document|DTA::TokWrap::Document> targets of the same name.
+If the C<makeJobs> option (propagated from $doc-E<gt>{tw}) is greater than 1,
+mutually independent keys are generated concurrently; see L</makeKeyDag>.
+
 =cut
 
 ##----------------------------------------------------------------
@@ -498,9 +651,48 @@ Passes on local \%KEYGEN.
 =item makeKey
 
  $bool = $doc->makeKey($key);
- $bool = $doc->makeKey($key,\%queued)
 
 Conditionally (re-)generate a data key, checking dependencies.
+If $doc-E<gt>{makeJobs} is greater than 1,
+stale dependencies are first (re-)generated by L</makeKeyDag>.
+
+=item genSpecId
+
+ $genid = PACKAGE::genSpecId($gen);
+
+Returns a string identifying the generator specification $gen,
+used to merge keys with a common generator.
+
+=item makeKeyDag
+
+ $doc = $doc->makeKeyDag($key);
+
+Conditionally (re-)generates stale dependencies of $key (and $key itself),
+running up to $doc-E<gt>{makeJobs} mutually independent generators concurrently
+in forked child processes (see L</makeFork>).
+Keys sharing a single generator (e.g. C<sosfile>, C<sowfile>, and C<soafile>)
+are generated only once.
+If only a single key is ready and no other job is running, it is generated in-process.
+
+Only non-blessed top-level document keys are passed back from child processes;
+in particular, in-memory XML documents are not,
+so consumers re-load these from the corresponding files.
+On error, running jobs are waited for and an exception is thrown.
+
+=item makeFork
+
+ \%job_or_undef = $doc->makeFork($key);
+
+Forks a child process to generate $key, returning
+C<\%job = {key=E<gt>$key, pid=E<gt>$pid, file=E<gt>$stofile}>.
+The child stores changed and deleted top-level document keys
+to F<$tmpdir/$outbase.make_$key.sto> using L<Storable|Storable>.
+
+=item makeCollect
+
+ $error_or_undef = $doc->makeCollect(\%job, $waitStatus);
+
+Merges results of a child process forked by L</makeFork> into $doc.
 
 =item makeAll
 
@@ -0,0 +1,908 @@
+## -*- Mode: CPerl -*-
+
+## File: DTA::TokWrap::Pipeline.pm
+## Author: Bryan Jurish <moocow@cpan.org>
+## Description: DTA tokenizer wrappers: pipeline-parallel document processing
+
+package DTA::TokWrap::Pipeline;
+
+use DTA::TokWrap::Version;
+use DTA::TokWrap::Base;
+use DTA::TokWrap::Utils qw(:time :si :stats);
+use IO::Handle;
+use IO::Select;
+use Storable qw(nfreeze thaw);
+use POSIX qw();
+use Carp;
+use strict;
+
+##==============================================================================
+## Constants
+##==============================================================================
+our @ISA = qw(DTA::TokWrap::Base);
+
+## %STAGE_KEYS = ($stage => $genKey, ...)
+##  + DTA::TokWrap::Document::genKey() key for known pipeline stages
+##  + stages not listed here use their own name as key
+our %STAGE_KEYS = (
+		   mkindex   => 'mkindex',
+		   mkbx0     => 'mkbx0',
+		   mkbx      => 'mkbx',
+		   tokenize  => 'tokenize0',
+		   tokenize1 => 'tokenize1',
+		   tok2xml   => 'tok2xml',
+		   addws     => 'addws',
+		   idsplice  => 'idsplice',
+		  );
+
+## %TARGET_STAGES = ($target => \@stages, ...)
+##  + composite targets which are split into pipeline stages
+##  + all other targets are run as a single stage of the same name
+our %TARGET_STAGES;
+BEGIN {
+  my @tei2t = qw(mkindex mkbx0 mkbx tokenize tokenize1);
+  %TARGET_STAGES = (
+		    tei2txt => [qw(mkindex mkbx0 mkbx)],
+		    tei2t => [@tei2t],
+		    tei2txml => [@tei2t, qw(tok2xml)],
+		    tei2spliced => [@tei2t, qw(tok2xml addws idsplice)],
+		    all => [@tei2t, qw(tok2xml addws)],
+		   );
+}
+
+##==============================================================================
+## Constructors etc.
+##==============================================================================
+
+## $pl = CLASS_OR_OBJ->new(%args)
+## %defaults = CLASS->defaults()
+##  + %args, %defaults, %$pl:
+##    (
+##     ##-- user options
+##     tw => $tw,                  ##-- DTA::TokWrap object (required); shared by all workers
+##     docopts => \%docopts,       ##-- options for $tw->open() (default: {})
+##     targets => \@targets,       ##-- targets to build (default=['all']); split into stages by %TARGET_STAGES
+##     workers => \%stage2n,       ##-- number of worker processes per stage name (default: {})
+##     defaultWorkers => $n,       ##-- number of worker processes for stages not in %workers (default=1)
+##     queueSize => $n,            ##-- maximum number of documents queued for or in each stage (default=2)
+##     tokenizeBatch => $n,        ##-- send up to $n documents per tokenize_batch() call in the 'tokenize' stage (default=1)
+##     maxRespawns => $n,          ##-- abort run() if the workers of a stage die unexpectedly more than $n times (default=3)
+##     reportInterval => $secs,    ##-- log queue depths every $secs seconds (default=0: never)
+##     reportLevel => $level,      ##-- log level for stage reports (default='info')
+##     traceLevel => $level,       ##-- log level for per-document stage traces (default=undef: none)
+##     ##
+##     ##-- low-level data
+##     stages => \@stages,         ##-- pipeline stages: [{name,key,nworkers,batch,kids,queue,nbusy,...}, ...]
+##     docs => \@docs,             ##-- documents: [{xmlfile,ntoks,tempfiles,profiles,busy}, ...] (during run() only)
+##     sel => $select,             ##-- IO::Select for worker responses (parent only)
+##     rsp2kid => \%fh2kid,        ##-- worker response handles to worker data (parent only)
+##    )
+sub defaults {
+  return (
+	  tw => undef,
+	  docopts => {},
+	  targets => ['all'],
+	  workers => {},
+	  defaultWorkers => 1,
+	  queueSize => 2,
+	  tokenizeBatch => 1,
+	  maxRespawns => 3,
+	  reportInterval => 0,
+	  reportLevel => 'info',
+	  traceLevel => undef,
+	  ##
+	  stages => [],
+	  docs => [],
+	  sel => undef,
+	  rsp2kid => {},
+	 );
+}
+
+## $pl = $pl->init()
+sub init {
+  my $pl = shift;
+  $pl->logconfess("init(): no DTA::TokWrap object {tw} specified")
+    if (!UNIVERSAL::isa($pl->{tw},'DTA::TokWrap'));
+  $pl->{queueSize} = 1 if (($pl->{queueSize}||0) < 1);
+  $pl->{defaultWorkers} = 1 if (($pl->{defaultWorkers}||0) < 1);
+  $pl->{tokenizeBatch} = 1 if (($pl->{tokenizeBatch}||0) < 1);
+
+  ##-- expand targets to stages
+  my ($nworkers);
+  $pl->{stages} = [
+		   map {
+		     $nworkers = $pl->{workers}{$_} || $pl->{defaultWorkers};
+		     {name=>$_, key=>($STAGE_KEYS{$_} // $_), nworkers=>$nworkers, batch=>1, kids=>[], queue=>[], nbusy=>0,
+		      ndocs=>0, nerrs=>0, nrespawns=>0, busy=>0, qsum=>0, qmax=>0, bsum=>0}
+		   }
+		   map { $TARGET_STAGES{$_} ? @{$TARGET_STAGES{$_}} : $_ }
+		   @{$pl->{targets}}
+		  ];
+  $pl->logconfess("init(): no pipeline stages for targets (".join(' ',@{$pl->{targets}}).")")
+    if (!@{$pl->{stages}});
+  return $pl;
+}
+
+##==============================================================================
+## Methods: top-level
+##==============================================================================
+
+## $nfailed = $pl->run(@xmlfiles)
+##  + forks stage workers, processes @xmlfiles through all stages, and waits for workers to exit
+##  + returns number of documents which could not be processed
+sub run {
+  my ($pl,@xmlfiles) = @_;
+  my $stages = $pl->{stages};
+  my $tw = $pl->{tw};
+  $tw->warm();
+
+  ##-- init: batched tokenization (only if supported by the tokenizer and not overridden by chunking or caching)
+  my $batch = ($pl->{tokenizeBatch} > 1
+	       && UNIVERSAL::can($tw->{tokenize},'tokenize_batch')
+	       && !$tw->{tokenizeCache} && ($tw->{tokenizeJobs}||1) <= 1
+	       ? $pl->{tokenizeBatch} : 1);
+  $_->{batch} = ($_->{key} eq 'tokenize0' ? $batch : 1) foreach (@$stages);
+
+  ##-- init: documents & workers
+  $pl->{docs} = [ map { {xmlfile=>$_, ntoks=>0, tempfiles=>{}, profiles=>[], busy=>0} } @xmlfiles ];
+  $pl->{pending} = [0..$#xmlfiles];
+  $pl->{ndone} = $pl->{nfailed} = 0;
+  $pl->{aborted} = undef;
+  $pl->{sel} = IO::Select->new();
+  $pl->{rsp2kid} = {};
+  $pl->{t0} = $pl->{tlast} = timestamp();
+  foreach my $s (@$stages) {
+    $pl->spawn($s) foreach (1..$s->{nworkers});
+  }
+  $pl->info("running ", scalar(@xmlfiles), " document(s) through ", scalar(@$stages), " stage(s): ",
+	    join(' ', map {"$_->{name}($_->{nworkers})"} @$stages));
+
+  ##-- main loop
+  my $treport = $pl->{t0};
+  my ($timeout,$fh,$kid,$line);
+  while ($pl->{ndone} < @xmlfiles) {
+    1 while ($pl->schedule());
+    $timeout = $pl->{reportInterval} > 0 ? ($treport + $pl->{reportInterval} - timestamp()) : undef;
+    $timeout = 0 if (defined($timeout) && $timeout < 0);
+    foreach $fh ($pl->{sel}->can_read($timeout)) {
+      last if ($pl->{aborted});
+      $pl->tick();
+      $kid = $pl->{rsp2kid}{$fh};
+      ##-- batch responses are written all at once and may already be buffered: read them all
+      do {
+	$line = <$fh>;
+	$pl->finish($kid, $line);
+      } while (defined($line) && @{$kid->{ids}});
+    }
+    if ($pl->{reportInterval} > 0 && timestamp() >= $treport + $pl->{reportInterval}) {
+      $pl->tick();
+      $pl->logStatus($pl->{reportLevel});
+      $treport = timestamp();
+    }
+  }
+  $pl->tick();
+
+  ##-- cleanup: workers exit on EOF
+  foreach $kid (map {@{$_->{kids}}} @$stages) {
+    $kid->{req}->close();
+    $kid->{rsp}->close();
+    waitpid($kid->{pid},0);
+  }
+  $_->{kids} = [] foreach (@$stages);
+  delete(@$pl{qw(sel pending)});
+  $pl->{rsp2kid} = {};
+  $pl->{docs} = [];
+
+  $pl->logReport($pl->{reportLevel});
+  return $pl->{nfailed};
+}
+
+##==============================================================================
+## Methods: parent
+##==============================================================================
+
+## $kid = $pl->spawn(\%stage)
+##  + forks a new worker process for \%stage (parent only)
+sub spawn {
+  my ($pl,$s) = @_;
+  my ($req_r,$req_w,$rsp_r,$rsp_w) = map {IO::Handle->new} (1..4);
+  pipe($req_r,$req_w) && pipe($rsp_r,$rsp_w)
+    or $pl->logconfess("spawn(): pipe() failed for stage '$s->{name}': $!");
+  my $pid = fork();
+  $pl->logconfess("spawn(): fork() failed for stage '$s->{name}': $!") if (!defined($pid));
+  if ($pid == 0) {
+    ##-- child: close parent ends (incl. those of other workers, so that they see EOF), serve, exit without destructors
+    $_->close() foreach ($req_w, $rsp_r, map {($_->{req},$_->{rsp})} map {@{$_->{kids}}} @{$pl->{stages}});
+    $rsp_w->autoflush(1);
+    my $rc = eval { $pl->serve($s, $req_r, $rsp_w); };
+    print STDERR $@ if ($@);
+    POSIX::_exit($rc ? 0 : 1);
+  }
+  $req_r->close();
+  $rsp_w->close();
+  $req_w->autoflush(1);
+  my $kid = {pid=>$pid, stage=>$s, req=>$req_w, rsp=>$rsp_r, ids=>[], t0=>undef};
+  push(@{$s->{kids}}, $kid);
+  $pl->{sel}->add($rsp_r);
+  $pl->{rsp2kid}{$rsp_r} = $kid;
+  return $kid;
+}
+
+## $nactions = $pl->schedule()
+##  + admits pending documents to the first stage and dispatches queued documents to idle workers
+##  + a stage only accepts a document if the queue of the following stage has room for its output
+##  + stages with {batch} > 1 dispatch up to {batch} queued documents to a single worker at once
+sub schedule {
+  my $pl = shift;
+  my $stages = $pl->{stages};
+  my $nacts = 0;
+  $pl->tick();
+
+  ##-- admit
+  while (@{$pl->{pending}} && @{$stages->[0]{queue}} + $stages->[0]{nbusy} < $pl->{queueSize} + $stages->[0]{nworkers}) {
+    push(@{$stages->[0]{queue}}, shift(@{$pl->{pending}}));
+    ++$nacts;
+  }
+
+  ##-- dispatch (downstream stages first)
+  my ($i,$s,$next,$kid,$n,$room);
+  for ($i=$#$stages; $i >= 0; --$i) {
+    ($s,$next) = @$stages[$i,$i+1];
+    while (@{$s->{queue}}) {
+      $n = $s->{batch} < @{$s->{queue}} ? $s->{batch} : scalar(@{$s->{queue}});
+      if ($next) {
+	$room = $pl->{queueSize} + $next->{nworkers} - (@{$next->{queue}} + $next->{nbusy} + $s->{nbusy});
+	$n = $room if ($room < $n);
+      }
+      last if ($n <= 0);
+      last if (!defined($kid = (grep {!@{$_->{ids}}} @{$s->{kids}})[0]));
+      $pl->dispatch($kid, splice(@{$s->{queue}}, 0, $n));
+      ++$nacts;
+    }
+  }
+  return $nacts;
+}
+
+## undef = $pl->dispatch($kid, @docids)
+##  + sends documents @docids to worker $kid as a single request
+sub dispatch {
+  my ($pl,$kid,@ids) = @_;
+  my $s = $kid->{stage};
+  $pl->vlog($pl->{traceLevel}, "$s->{name}: start ", join(' ', map {$pl->{docs}[$_]{xmlfile}} @ids)) if ($pl->{traceLevel});
+  @$kid{qw(ids t0)} = ([@ids], timestamp());
+  $s->{nbusy} += @ids;
+  $kid->{req}->print(join("\t", map {($_, $pl->{docs}[$_]{xmlfile})} @ids), "\n");
+}
+
+## undef = $pl->finish($kid, $responseLine)
+##  + handles a response line from worker $kid; undef $responseLine means that $kid has died
+##  + workers send one response line per document of a (batch) request
+##  + workers which have died are respawned at most $pl->{maxRespawns} times per stage;
+##    after that, the run is aborted (see abort())
+sub finish {
+  my ($pl,$kid,$line) = @_;
+  my $s = $kid->{stage};
+
+  my (@rsp,$giveup);
+  if (!defined($line)) {
+    ##-- worker died: respawn; all of its outstanding documents fail
+    $pl->logwarn("$s->{name}: worker (pid=$kid->{pid}) exited unexpectedly") if (!$pl->{aborted});
+    $pl->{sel}->remove($kid->{rsp});
+    delete $pl->{rsp2kid}{$kid->{rsp}};
+    $_->close() foreach (@$kid{qw(req rsp)});
+    waitpid($kid->{pid},0);
+    my $wstatus = $?;
+    @{$s->{kids}} = grep {$_ ne $kid} @{$s->{kids}};
+    @rsp = map {['ERROR', $_, "worker exited with status $wstatus"]} @{$kid->{ids}};
+    $giveup = !$pl->{aborted} && ++$s->{nrespawns} > $pl->{maxRespawns};
+    $pl->spawn($s) if (!$pl->{aborted} && !$giveup);
+  } else {
+    $line =~ s/\r?\n\z//;
+    @rsp = ([split(/\t/, $line, 3)]);
+  }
+
+  my ($status,$id,$data,$doc,$now,$elapsed);
+  foreach (@rsp) {
+    ($status,$id,$data) = @$_;
+    next if (!defined($id) || !grep {$_ eq $id} @{$kid->{ids}});
+    @{$kid->{ids}} = grep {$_ ne $id} @{$kid->{ids}};
+    $doc = $pl->{docs}[$id];
+    $now = timestamp();
+    $elapsed = $now - $kid->{t0};
+    $kid->{t0} = @{$kid->{ids}} ? $now : undef;
+    --$s->{nbusy};
+    $s->{busy} += $elapsed;
+    $doc->{busy} += $elapsed;
+    $pl->finish_doc($s, $id, $status, $data);
+  }
+  $pl->abort("$s->{name}: workers died $s->{nrespawns} times (maxRespawns=$pl->{maxRespawns})") if ($giveup);
+}
+
+## undef = $pl->finish_doc(\%stage, $docid, $status, $data)
+##  + handles the response of a worker of \%stage for document $docid:
+##    queues the document for the next stage, or cleans up after the last stage or on error
+sub finish_doc {
+  my ($pl,$s,$id,$status,$data) = @_;
+  my $doc = $pl->{docs}[$id];
+
+  if ($status eq 'OK') {
+    ##-- stage done
+    $data = thaw(pack('H*',$data));
+    $doc->{ntoks} = $data->{ntoks} if (($data->{ntoks}||0) > $doc->{ntoks});
+    $doc->{tempfiles}{$_} = undef foreach (@{$data->{tempfiles}});
+    push(@{$doc->{profiles}}, $data->{profile});
+    if ($data->{trace}) {
+      my ($name,$beg,$end) = @{$data->{trace}};
+      $doc->{trace} //= [$name,$beg,$end];
+      $doc->{trace}[1] = $beg if ($beg < $doc->{trace}[1]);
+      $doc->{trace}[2] = $end if ($end > $doc->{trace}[2]);
+    }
+    ++$s->{ndocs};
+    $pl->vlog($pl->{traceLevel}, "$s->{name}: done $doc->{xmlfile}") if ($pl->{traceLevel});
+
+    my $i = (grep {$pl->{stages}[$_] eq $s} (0..$#{$pl->{stages}}))[0];
+    if ($i < $#{$pl->{stages}}) {
+      push(@{$pl->{stages}[$i+1]{queue}}, $id);
+      return;
+    }
+    $pl->merge_profile($doc);
+  } else {
+    ##-- stage failed
+    ++$s->{nerrs};
+    ++$pl->{nfailed};
+    $pl->logwarn("error processing XML file '$doc->{xmlfile}' in stage '$s->{name}': $data");
+  }
+
+  ##-- document done: trace events (spanning all stages; each stage is traced by its worker)
+  my $tw = $pl->{tw};
+  $tw->traceWrite([$tw->traceDocEvents(@{$doc->{trace}}, {xmlfile=>$doc->{xmlfile}, ntoks=>$doc->{ntoks}, nxbytes=>((-s $doc->{xmlfile})||0)})])
+    if ($tw->{traceEvents} && $doc->{trace});
+
+  ##-- document done: cleanup
+  if (!$pl->{tw}{keeptmp}) {
+    foreach (grep {-e $_} keys %{$doc->{tempfiles}}) {
+      $pl->logwarn("failed to unlink $_") if (!unlink($_));
+    }
+  }
+  %$doc = (xmlfile=>$doc->{xmlfile});
+  ++$pl->{ndone};
+}
+
+## undef = $pl->abort($reason)
+##  + aborts the current run(): all unfinished documents fail, and workers which are still busy are terminated
+sub abort {
+  my ($pl,$reason) = @_;
+  $pl->logwarn("aborting: $reason");
+  my ($s,$kid,$id);
+  foreach $s (@{$pl->{stages}}) {
+    foreach $kid (@{$s->{kids}}) {
+      next if (!@{$kid->{ids}});
+      kill('TERM', $kid->{pid});
+      $s->{nbusy} -= @{$kid->{ids}};
+      $pl->finish_doc($s, $_, 'ERROR', "aborted: $reason") foreach (splice(@{$kid->{ids}}, 0));
+      $kid->{t0} = undef;
+    }
+    $pl->finish_doc($s, $_, 'ERROR', "aborted: $reason") foreach (splice(@{$s->{queue}}, 0));
+  }
+  foreach $id (splice(@{$pl->{pending}}, 0)) {
+    ++$pl->{nfailed};
+    ++$pl->{ndone};
+  }
+  $pl->{aborted} = $reason;
+}
+
+## undef = $pl->merge_profile($doc)
+##  + merges per-stage profiling information for $doc into $pl->{tw}{profile}
+##  + token counts for all processors are taken from the tokenizer stage, as for sequential processing
+##  + TOTAL elapsed time is the sum of stage times (i.e. excluding queueing)
+sub merge_profile {
+  my ($pl,$doc) = @_;
+  my $tw = $pl->{tw};
+  my $nxbytes = (-s $doc->{xmlfile}) || 0;
+  my ($stageprof,$key,$src,$dst);
+  foreach $stageprof (@{$doc->{profiles}}) {
+    while (($key,$src) = each %$stageprof) {
+      next if ($key eq '');
+      $dst = $tw->{profile}{$key} //= {};
+      $dst->{ndocs}++;
+      $dst->{ntoks} += $doc->{ntoks};
+      $dst->{nxbytes} += $nxbytes;
+      $dst->{elapsed} += $src->{elapsed}||0;
+      $dst->{laststamp} = $src->{laststamp} if (($src->{laststamp}||0) > ($dst->{laststamp}||0));
+      stats_add(($dst->{cstats} //= {}), $src->{cstats}) if ($src->{cstats});
+    }
+  }
+  $dst = $tw->{profile}{''} //= {};
+  $dst->{ndocs}++;
+  $dst->{ntoks} += $doc->{ntoks};
+  $dst->{nxbytes} += $nxbytes;
+  $dst->{elapsed} += $doc->{busy};
+  $dst->{laststamp} = timestamp();
+}
+
+## undef = $pl->tick()
+##  + updates time-weighted queue-depth and utilisation sums for all stages
+sub tick {
+  my $pl = shift;
+  my $now = timestamp();
+  my $dt  = $now - $pl->{tlast};
+  foreach (@{$pl->{stages}}) {
+    $_->{qsum} += $dt * @{$_->{queue}};
+    $_->{bsum} += $dt * scalar(grep {@{$_->{ids}}} @{$_->{kids}});
+    $_->{qmax}  = @{$_->{queue}} if (@{$_->{queue}} > $_->{qmax});
+  }
+  $pl->{tlast} = $now;
+}
+
+## undef = $pl->logStatus($level)
+##  + logs current queue depth and number of busy workers for each stage
+sub logStatus {
+  my ($pl,$level) = @_;
+  return if (!$level);
+  $pl->vlog($level, sprintf("status: %d/%d doc done after %.1f sec: ", $pl->{ndone}, scalar(@{$pl->{docs}}), timestamp()-$pl->{t0}),
+	    join(', ', map {sprintf("%s q=%d busy=%d/%d", $_->{name}, scalar(@{$_->{queue}}), scalar(grep {@{$_->{ids}}} @{$_->{kids}}), $_->{nworkers})} @{$pl->{stages}}));
+}
+
+## undef = $pl->logReport($level)
+##  + logs per-stage summary: documents, busy time, utilisation, and mean & maximum queue depth
+##  + the stage with the highest utilisation is marked as the bottleneck
+sub logReport {
+  my ($pl,$level) = @_;
+  return if (!$level);
+  my $wall = ($pl->{tlast} - $pl->{t0}) || 1e-6;
+  my @util = map { $_->{bsum} / ($_->{nworkers} * $wall) } @{$pl->{stages}};
+  my $imax = (sort {$util[$b] <=> $util[$a]} (0..$#util))[0];
+  my $logstr = sprintf("Pipeline summary (%.1f sec wall):", $wall);
+  my $format = "\n%14s: %3d wrk, %4d doc, %3d err, %7ssec busy, %5.1f%% util, queue %5.2f avg %3d max%s";
+  my ($i,$s);
+  foreach $i (0..$#{$pl->{stages}}) {
+    $s = $pl->{stages}[$i];
+    $logstr .= sprintf($format,
+		       $s->{name}, $s->{nworkers}, $s->{ndocs}, $s->{nerrs},
+		       sistr($s->{busy}, 'f', '.1'),
+		       100*$util[$i],
+		       $s->{qsum}/$wall, $s->{qmax},
+		       ($i==$imax ? ' <- bottleneck' : ''));
+  }
+  $pl->vlog($level, $logstr);
+}
+
+##==============================================================================
+## Methods: worker
+##==============================================================================
+
+## $bool = $pl->serve(\%stage, $in, $out)
+##  + worker main loop: reads requests "DOCID \t XMLFILE [ \t DOCID \t XMLFILE ]*" from $in until EOF,
+##    writes responses to $out, one line per document:
+##      "OK" "\t" DOCID "\t" HEX(nfreeze(\%result))
+##      "ERROR" "\t" DOCID "\t" MESSAGE
+##  + requests for more than one document are handled by processBatch()
+sub serve {
+  my ($pl,$s,$in,$out) = @_;
+  my ($line,@fields,@ids,@xmlfiles,@results,$result,$i);
+  while (defined($line = <$in>)) {
+    $line =~ s/\r?\n\z//;
+    @fields   = split(/\t/, $line);
+    @ids      = @fields[grep {$_ % 2 == 0} (0..$#fields)];
+    @xmlfiles = @fields[grep {$_ % 2 == 1} (0..$#fields)];
+    if (@ids > 1) {
+      @results = $pl->processBatch($s,@xmlfiles);
+    } else {
+      $result  = eval { $pl->processStage($s,$xmlfiles[0]) };
+      @results = ($result && !$@ ? $result : ($@ || 'unknown error'));
+    }
+    foreach $i (0..$#ids) {
+      if (ref($result = $results[$i])) {
+	$out->print(join("\t", 'OK', $ids[$i], unpack('H*', nfreeze($result))), "\n");
+      } else {
+	(my $msg = ($result || 'unknown error')) =~ s/\s+\z//;
+	$msg =~ s/\s*\n\s*/ /g;
+	$out->print(join("\t", 'ERROR', $ids[$i], $msg), "\n");
+      }
+    }
+  }
+  return 1;
+}
+
+## $str = tracestamp($stamp)
+##  + full-precision string for timestamp $stamp: nfreeze() stores floating-point values as strings
+##    with perl's default precision, which loses the microseconds of trace event timestamps
+sub tracestamp { sprintf('%.17g', $_[0]) }
+
+## \%result = $pl->processStage(\%stage, $xmlfile)
+##  + runs a single stage for $xmlfile; dies on error
+##  + intermediate files are kept for subsequent stages, and returned in \%result for cleanup by the parent
+##  + %result:
+##    (
+##     ntoks => $ntoks,            ##-- $doc->nTokens(), if known
+##     tempfiles => \@tempfiles,   ##-- temporary files generated by this stage
+##     profile => \%profile,       ##-- this stage's contribution to $tw->{profile}
+##     trace => [$name,$beg,$end], ##-- document name and open/close timestamps, if $tw->{traceEvents} is set
+##    )
+sub processStage {
+  my ($pl,$s,$xmlfile) = @_;
+  my $tw = $pl->{tw};
+  local $tw->{profile} = {};
+  my $doc = $tw->open($xmlfile, %{$pl->{docopts}}, traceStage=>$s->{name});
+  $doc->{keeptmp} = 1;
+  my $rc = eval { $doc->genKey($s->{key}) };
+  if (!$rc) {
+    my $err = $@ || "genKey($s->{key}) failed\n";
+    $doc->{keeptmp} = $tw->{keeptmp};
+    $doc->close();
+    die($err);
+  }
+  my %result = (
+		ntoks => ($doc->nTokens() || 0),
+		tempfiles => [do { local $doc->{keeptmp}=0; $doc->tempfiles() }],
+		($tw->{traceEvents} ? (trace=>[$doc->{xmlbase}, tracestamp($doc->{open_stamp})]) : qw()),
+	       );
+  $doc->close() or die("close() failed\n");
+  push(@{$result{trace}}, tracestamp(timestamp())) if ($result{trace});
+  delete $tw->{profile}{''};
+  $result{profile} = $tw->{profile};
+  return \%result;
+}
+
+## @results = $pl->processBatch(\%stage, @xmlfiles)
+##  + runs the 'tokenize' stage for all @xmlfiles with a single $tw->{tokenize}->tokenize_batch() call
+##  + returns one \%result (as for processStage()) or error message per $xmlfile
+sub processBatch {
+  my ($pl,$s,@xmlfiles) = @_;
+  my $tw = $pl->{tw};
+  $pl->logconfess("processBatch(): batch requests are only supported for the 'tokenize' stage")
+    if ($s->{key} ne 'tokenize0');
+
+  ##-- open & tokenize
+  my (@docs,@results,$doc);
+  foreach (@xmlfiles) {
+    $doc = eval { $tw->open($_, %{$pl->{docopts}}, traceStage=>$s->{name}) };
+    $doc->{keeptmp} = 1 if ($doc);
+    push(@docs, $doc);
+    push(@results, $doc ? undef : ($@ || "open() failed\n"));
+  }
+  my $rc  = eval { $tw->{tokenize}->tokenize_batch(grep {defined($_)} @docs) };
+  my $err = $@ || "tokenize_batch() failed\n";
+
+  ##-- save & close
+  my ($i);
+  foreach $i (grep {defined($docs[$_])} (0..$#docs)) {
+    $doc = $docs[$i];
+    local $tw->{profile} = {};
+    if (!$rc || !eval { $doc->saveTokFile0() }) {
+      $results[$i] = $rc ? ($@ || "saveTokFile0() failed\n") : $err;
+      $doc->{keeptmp} = $tw->{keeptmp};
+      $doc->close();
+      next;
+    }
+    my %result = (
+		  ntoks => ($doc->nTokens() || 0),
+		  tempfiles => [do { local $doc->{keeptmp}=0; $doc->tempfiles() }],
+		  ($tw->{traceEvents} ? (trace=>[$doc->{xmlbase}, tracestamp($doc->{open_stamp})]) : qw()),
+		 );
+    if (!$doc->close()) {
+      $results[$i] = "close() failed\n";
+      next;
+    }
+    push(@{$result{trace}}, tracestamp(timestamp())) if ($result{trace});
+    delete $tw->{profile}{''};
+    $result{profile} = $tw->{profile};
+    $results[$i] = \%result;
+  }
+  return @results;
+}
+
+1; ##-- be happy
+
+__END__
+
+##========================================================================
+## POD DOCUMENTATION, auto-generated by podextract.perl, edited
+
+##========================================================================
+## NAME
+=pod
+
+=head1 NAME
+
+DTA::TokWrap::Pipeline - DTA tokenizer wrappers: pipeline-parallel document processing
+
+=cut
+
+##========================================================================
+## SYNOPSIS
+=pod
+
+=head1 SYNOPSIS
+
+ use DTA::TokWrap;
+ use DTA::TokWrap::Pipeline;
+
+ $tw = DTA::TokWrap->new(%opts);
+ $pl = DTA::TokWrap::Pipeline->new(tw=>$tw, targets=>['all'], workers=>{tokenize=>8, mkbx0=>2});
+ $nfailed = $pl->run(@xmlfiles);
+
+=cut
+
+##========================================================================
+## DESCRIPTION
+=pod
+
+=head1 DESCRIPTION
+
+DTA::TokWrap::Pipeline processes a corpus of documents concurrently by splitting
+the requested targets into stages
+(e.g. C<mkindex mkbx0 mkbx tokenize tokenize1 tok2xml addws> for the target C<all>),
+each of which is run by its own pool of forked worker processes.
+Each document passes through the stages in order,
+but different documents may be in different stages at the same time,
+so that e.g. an external tokenizer and the XSL transformations of C<mkbx0>
+are kept busy concurrently.
+
+Between stages, documents are passed on as intermediate files in the temporary directory
+(F<.cx>, F<.sx>, F<.tx>, F<.bx0>, F<.bx>, F<.txt>, F<.t0>, F<.t1>),
+i.e. each stage runs the single-step target of the same name
+as if it had been requested by a separate call to F<dta-tokwrap.perl>.
+The temporary files of each document are removed by the parent process after the last stage
+(unless the L<DTA::TokWrap|DTA::TokWrap> C<keeptmp> option is set).
+Final output is identical to sequential processing.
+
+Queues between stages are bounded:
+a stage only accepts a document if the following stage has room for it,
+so that the number of documents in flight (and their temporary files) stays bounded
+and the slowest stage throttles its predecessors.
+On completion, a per-stage summary reports busy time, utilisation
+(busy time divided by worker count and wall-clock time),
+and mean and maximum queue depth;
+the stage with the highest utilisation is marked as the bottleneck.
+
+If the L<DTA::TokWrap|DTA::TokWrap> C<traceEvents> option is set,
+each worker traces its stage of a document as a C<stage> event on its own track,
+and the parent writes a single C<document> event per file spanning all of its stages
+(see L<DTA::TokWrap/traceDoc>).
+
+The stage executor is only meaningful for non-incremental processing
+(L<DTA::TokWrap::Document|DTA::TokWrap::Document>, not L<DTA::TokWrap::Document::Maker|DTA::TokWrap::Document::Maker>).
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Pipeline: Constants
+=pod
+
+=head2 Constants
+
+=over 4
+
+=item %STAGE_KEYS
+
+ %STAGE_KEYS = ($stage => $genKey, ...)
+
+L<DTA::TokWrap::Document::genKey()|DTA::TokWrap::Document/genKey> key for each known stage;
+stages not listed here use their own name as key.
+
+=item %TARGET_STAGES
+
+ %TARGET_STAGES = ($target => \@stages, ...)
+
+Composite targets which are split into pipeline stages
+(C<all>, C<tei2txt>, C<tei2t>, C<tei2txml>, C<tei2spliced>);
+all other targets are run as a single stage of the same name.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Pipeline: Constructors etc.
+=pod
+
+=head2 Constructors etc.
+
+=over 4
+
+=item new
+
+ $pl = $CLASS_OR_OBJ->new(%args);
+
+%args, %$pl:
+
+ ##-- user options
+ tw => $tw,                  ##-- DTA::TokWrap object (required); shared by all workers
+ docopts => \%docopts,       ##-- options for $tw->open() (default: {})
+ targets => \@targets,       ##-- targets to build (default=['all']); split into stages by %TARGET_STAGES
+ workers => \%stage2n,       ##-- number of worker processes per stage name (default: {})
+ defaultWorkers => $n,       ##-- number of worker processes for stages not in %workers (default=1)
+ queueSize => $n,            ##-- maximum number of documents queued for or in each stage (default=2)
+ tokenizeBatch => $n,        ##-- send up to $n documents per tokenize_batch() call in the 'tokenize' stage (default=1)
+ maxRespawns => $n,          ##-- abort run() if the workers of a stage die unexpectedly more than $n times (default=3)
+ reportInterval => $secs,    ##-- log queue depths every $secs seconds (default=0: never)
+ reportLevel => $level,      ##-- log level for stage reports (default='info')
+ traceLevel => $level,       ##-- log level for per-document stage traces (default=undef: none)
+ ##
+ ##-- low-level data
+ stages => \@stages,         ##-- pipeline stages: [{name,key,nworkers,batch,kids,queue,nbusy,...}, ...]
+ docs => \@docs,             ##-- documents: [{xmlfile,ntoks,tempfiles,profiles,busy}, ...] (during run() only)
+ sel => $select,             ##-- IO::Select for worker responses (parent only)
+ rsp2kid => \%fh2kid,        ##-- worker response handles to worker data (parent only)
+
+A stage with N workers may hold up to C<queueSize>+N documents (queued or in progress).
+
+If C<tokenizeBatch> is greater than 1 and the tokenizer provides a C<tokenize_batch()> method
+(e.g. L<DTA::TokWrap::Processor::tokenize::http|DTA::TokWrap::Processor::tokenize::http>),
+each C<tokenize> worker takes up to C<tokenizeBatch> queued documents at once
+and tokenizes them with a single C<tokenize_batch()> call,
+so that requests for several documents can be in flight concurrently.
+Batching is disabled if the C<tokenizeCache> or C<tokenizeJobs> options of the
+L<DTA::TokWrap|DTA::TokWrap> object are set.
+To keep the batches full, C<queueSize> should be at least C<tokenizeBatch>.
+
+Workers which die unexpectedly (e.g. by a crashing tokenizer) are respawned,
+and their current documents fail.
+If the workers of a single stage die more than C<maxRespawns> times,
+the run is aborted and all remaining documents fail,
+rather than respawning workers for each document of a corpus.
+
+=item defaults
+
+ %defaults = CLASS->defaults();
+
+Static class-dependent defaults.
+
+=item init
+
+ $pl = $pl->init();
+
+Dynamic object-dependent defaults; expands C<targets> to C<stages>.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Pipeline: Methods
+=pod
+
+=head2 Methods
+
+=over 4
+
+=item run
+
+ $nfailed = $pl->run(@xmlfiles);
+
+Calls L<$tw-E<gt>warm()|DTA::TokWrap/warm>, forks all stage workers,
+processes @xmlfiles through all stages, and waits for the workers to exit.
+Errors are logged per document and stage.
+Per-stage profiling information is merged into C<$tw-E<gt>{profile}>
+(see L<DTA::TokWrap::logProfile()|DTA::TokWrap/logProfile>).
+Returns the number of documents which could not be processed.
+
+=item spawn
+
+ $kid = $pl->spawn(\%stage);
+
+Low-level: fork a worker process for \%stage.
+
+=item schedule
+
+ $nactions = $pl->schedule();
+
+Low-level: admit pending documents to the first stage
+and dispatch queued documents to idle workers, downstream stages first.
+
+=item dispatch
+
+ undef = $pl->dispatch($kid, @docids);
+
+Low-level: send one or more documents to a worker as a single request.
+
+=item finish
+
+ undef = $pl->finish($kid, $responseLine);
+
+Low-level: handle a worker response; respawns workers which have died,
+or calls L</abort> if the workers of a stage have died more than C<maxRespawns> times.
+
+=item finish_doc
+
+ undef = $pl->finish_doc(\%stage, $docid, $status, $data);
+
+Low-level: handle the response for a single document:
+queue it for the next stage, or write its trace events and clean up after the last stage or on error.
+
+=item abort
+
+ undef = $pl->abort($reason);
+
+Low-level: abort the current run: all unfinished documents fail,
+and workers which are still busy are sent SIGTERM.
+
+=item merge_profile
+
+ undef = $pl->merge_profile($doc);
+
+Low-level: merge per-stage profiling information for a finished document into C<$tw-E<gt>{profile}>.
+The TOTAL elapsed time is the sum of the document's stage times, excluding time spent in queues.
+
+=item tick
+
+ undef = $pl->tick();
+
+Low-level: update time-weighted queue-depth and utilisation sums.
+
+=item logStatus
+
+ undef = $pl->logStatus($level);
+
+Logs the current queue depth and number of busy workers for each stage;
+called every C<reportInterval> seconds by L</run>.
+
+=item logReport
+
+ undef = $pl->logReport($level);
+
+Logs the per-stage summary; called by L</run> on completion.
+
+=item serve
+
+ $bool = $pl->serve(\%stage, $in, $out);
+
+Low-level: worker main loop.
+
+=item processStage
+
+ \%result = $pl->processStage(\%stage, $xmlfile);
+
+Low-level: run a single stage for $xmlfile in a worker process; dies on error.
+
+=item processBatch
+
+ @results = $pl->processBatch(\%stage, @xmlfiles);
+
+Low-level: run the C<tokenize> stage for all @xmlfiles in a worker process
+with a single call to the tokenizer's C<tokenize_batch()> method
+(see L<DTA::TokWrap::Processor::tokenize::http|DTA::TokWrap::Processor::tokenize::http>).
+Returns a \%result as for L</processStage> or an error message for each $xmlfile.
+
+=back
+
+=cut
+
+##========================================================================
+## END POD DOCUMENTATION, auto-generated by podextract.perl
+
+##======================================================================
+## See Also
+##======================================================================
+
+=pod
+
+=head1 SEE ALSO
+
+L<DTA::TokWrap::Intro(3pm)|DTA::TokWrap::Intro>,
+L<dta-tokwrap.perl(1)|dta-tokwrap.perl>,
+L<DTA::TokWrap::Daemon(3pm)|DTA::TokWrap::Daemon>,
+...
+
+=cut
+
+##======================================================================
+## Footer
+##======================================================================
+
+=pod
+
+=head1 AUTHOR
+
+Bryan Jurish E<lt>moocow@cpan.orgE<gt>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2026 by Bryan Jurish
+
+This package is free software; you can redistribute it and/or modify
+it under the same terms as Perl itself, either Perl version 5.14.2 or,
+at your option, any later version of Perl 5 you may have available.
+
+=cut
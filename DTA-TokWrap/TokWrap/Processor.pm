@@ -8,7 +8,7 @@ package DTA::TokWrap::Processor;
 
 use DTA::TokWrap::Version;
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:time);
+use DTA::TokWrap::Utils qw(:time :stats);
 
 use Carp;
 use strict;
@@ -58,6 +58,36 @@ sub process {
   return $sub ? $sub->($p,$doc) : $doc;
 }
 
+##==============================================================================
+## Methods: C program statistics
+##==============================================================================
+
+## $file_or_undef = $p->statsFile($doc,$prog)
+##  + returns --stats=FILE output filename for C program $prog if $doc->{cstats} or $doc->{tw}{traceEvents} is true, otherwise undef
+sub statsFile {
+  my ($p,$doc,$prog) = @_;
+  return undef if (!$doc->{cstats} && !($doc->{tw} && $doc->{tw}{traceEvents}));
+  return "$doc->{tmpdir}/$doc->{outbase}.$prog.stats.json";
+}
+
+## \%stats_or_undef = $p->statsCollect($doc,$key,$prog,$file)
+##  + loads and removes --stats=FILE output $file, adding it to $doc->{cstatsdata}{$key}{$prog}
+##  + $doc->{cstatsdata} is added to $doc->{tw}{profile} by $doc->close()
+##  + also appends [$key,$prog,$end_stamp,\%stats] to $doc->{cstatsruns} for $doc->{tw}->traceDoc()
+sub statsCollect {
+  my ($p,$doc,$key,$prog,$file) = @_;
+  return undef if (!defined($file) || !-e $file);
+  my $stats = stats_load($file);
+  unlink($file);
+  if (!$stats) {
+    $p->logwarn("could not load statistics for $prog from '$file': $@");
+    return undef;
+  }
+  $stats->{nruns} = 1;
+  push(@{$doc->{cstatsruns}}, [$key,$prog,timestamp(),$stats]);
+  return stats_add(($doc->{cstatsdata}{$key}{$prog} //= {}), $stats);
+}
+
 ##==============================================================================
 ## Methods: Document Processing
 ##==============================================================================
@@ -172,6 +202,35 @@ where $BASENAME = ($CLASS=~s/^.*:://); otherwise just returns $doc (i.e. does no
 
 =cut
 
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor: Methods: C program statistics
+=pod
+
+=head2 Methods: C program statistics
+
+=over 4
+
+=item statsFile
+
+ $file_or_undef = $p->statsFile($doc,$prog);
+
+Returns a temporary C<--stats=FILE> output filename for the C program $prog
+if $doc-E<gt>{cstats} or $doc-E<gt>{tw}{traceEvents} is true, otherwise undef.
+
+=item statsCollect
+
+ \%stats_or_undef = $p->statsCollect($doc,$key,$prog,$file);
+
+Loads and removes C<--stats=FILE> output $file, adding it to $doc-E<gt>{cstatsdata}{$key}{$prog}.
+$doc-E<gt>{cstatsdata} is added to the profiling information of $doc-E<gt>{tw}
+by L<$doc-E<gt>close()|DTA::TokWrap::Document/close>.
+Each individual run is also recorded in $doc-E<gt>{cstatsruns}
+for L<DTA::TokWrap::traceDoc()|DTA::TokWrap/traceDoc>.
+
+=back
+
+=cut
+
 ##========================================================================
 ## END POD DOCUMENTATION, auto-generated by podextract.perl
 =pod
@@ -404,7 +404,12 @@ sub addws {
   if (defined($doc->{"${xtokkey}data"})) {
     $xprs->parse($doc->{"${xtokkey}data"});
   } else {
-    $xprs->parsefile($doc->{"${xtokkey}file"});
+    my $xtokfile = $doc->{"${xtokkey}file"};
+    my $xtokfh   = zopen_file($xtokfile)
+      or $p->logconfess("addws(): open failed for standoff file '$xtokfile': $!");
+    $xprs->parse($xtokfh);
+    $xtokfh->close()
+      or $p->logconfess("addws(): decompression failed for standoff file '$xtokfile'");
   }
 
   ##-- compute //s segments
@@ -350,7 +350,11 @@ sub splice_so {
       $xp_so->parse(\*STDIN);
     } else {
       $p->vlog($p->{traceLevel}, "splice_so(): parse standoff file $opts{so}");
-      $xp_so->parsefile($opts{so});
+      my $fh = zopen_file($opts{so})
+	or $p->logconfess("splice_so(): open failed for standoff file '$opts{so}': $!");
+      $xp_so->parse($fh);
+      $fh->close()
+	or $p->logconfess("splice_so(): decompression failed for standoff file '$opts{so}'");
     }
   } elsif (UNIVERSAL::isa($opts{so},'SCALAR')) {
     $p->vlog($p->{traceLevel}, "splice_so(): parse standoff buffer");
@@ -367,7 +371,11 @@ sub splice_so {
       $xp_base->parse(\*STDIN);
     } else {
       $p->vlog($p->{traceLevel}, "splice_so(): parse base file $opts{base}");
-      $xp_base->parsefile($opts{base});
+      my $fh = zopen_file($opts{base})
+	or $p->logconfess("splice_so(): open failed for base file '$opts{base}': $!");
+      $xp_base->parse($fh);
+      $fh->close()
+	or $p->logconfess("splice_so(): decompression failed for base file '$opts{base}'");
     }
   } elsif (UNIVERSAL::isa($opts{base},'SCALAR')) {
     $p->vlog($p->{traceLevel}, "splice_so(): parse base buffer");
@@ -521,7 +521,7 @@ sub hint_autotune {
   my ($mbx0,$sxbufr,$txfile) = @_;
 
   ##-- buffer txfile
-  my $txfh = IO::File->new("<$txfile")
+  my $txfh = zopen_file($txfile)
     or $mbx0->logconfess("autotune($txfile): could not open txfile '$txfile'");
   $txfh->binmode(':utf8');
   my $txbufr = slurp_fh($txfh)
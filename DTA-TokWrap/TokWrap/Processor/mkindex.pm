@@ -21,6 +21,9 @@ use strict;
 ##==============================================================================
 our @ISA = qw(DTA::TokWrap::Processor);
 
+## $HAVE_XS : true iff DTA::TokWrap::XS (in-process libdtatw bindings) is available
+our $HAVE_XS = eval { require DTA::TokWrap::XS; 1 } ? 1 : 0;
+
 ##==============================================================================
 ## Constructors etc.
 ##==============================================================================
@@ -29,6 +32,7 @@ our @ISA = qw(DTA::TokWrap::Processor);
 ##  + %args:
 ##    mkindex => $path_to_dtatw_mkindex, ##-- default: search
 ##    inplace => $bool,                  ##-- prefer in-place programs for search?
+##    xs => $bool,                       ##-- use DTA::TokWrap::XS if available? (default=1)
 
 ## %defaults = CLASS->defaults()
 sub defaults {
@@ -37,6 +41,7 @@ sub defaults {
 	  $that->SUPER::defaults(),
 	  mkindex=>undef,
 	  inplace=>1,
+	  xs=>1,
 	 );
 }
 
@@ -44,8 +49,9 @@ sub defaults {
 sub init {
   my $mi = shift;
 
-  ##-- search for mkindex program
-  if (!defined($mi->{mkindex})) {
+  ##-- search for mkindex program (unless we're using XS)
+  $mi->{xs} = 0 if (!$HAVE_XS);
+  if (!defined($mi->{mkindex}) && !$mi->{xs}) {
     $mi->{mkindex} = path_prog('dtatw-mkindex',
 			       prepend=>($mi->{inplace} ? ['.','../src'] : undef),
 			       warnsub=>sub {$mi->logconfess(@_)},
@@ -66,6 +72,8 @@ sub init {
 ##    cxfile  => $cxfile,  ##-- output character index filename
 ##    sxfile  => $sxfile,  ##-- output structure index filename
 ##    txfile  => $txfile,  ##-- output structure index filename
+##    mkindexJobs => $n,   ##-- number of parallel dtatw-mkindex jobs (default=1)
+##    compressTmp => $spec, ##-- output compression (see DTA::TokWrap::Document::compressSpec())
 ##    mkindex_stamp0 => $f, ##-- (output) timestamp of operation begin
 ##    mkindex_stamp  => $f, ##-- (output) timestamp of operation end
 ##    cxfile_stamp   => $f, ##-- (output) timetamp of operation end
@@ -81,12 +89,24 @@ sub mkindex {
 
   ##-- sanity check(s)
   $mi = $mi->new if (!ref($mi));
-  $mi->logconfess("mkindex(): no dtatw-mkindex program") if (!$mi->{mkindex});
+  $mi->logconfess("mkindex(): no dtatw-mkindex program") if (!$mi->{mkindex} && !$mi->{xs});
   $mi->logconfess("mkindex(): XML source file not readable") if (!-r $doc->{xmlfile});
 
-  ##-- run program
-  my $rc = runcmd($mi->{mkindex}, @$doc{qw(xmlfile cxfile sxfile txfile)});
-  $mi->logconfess(ref($mi)."::mkindex() mkindex program failed: $!") if ($rc!=0);
+  if ($mi->{xs}) {
+    ##-- run in-process
+    eval { DTA::TokWrap::XS::mkindex(@$doc{qw(xmlfile cxfile sxfile txfile)}, ($doc->{mkindexJobs}||1), $doc->compressSpec('cxfile')); };
+    $mi->logconfess(ref($mi)."::mkindex() DTA::TokWrap::XS::mkindex() failed: $@") if ($@);
+  } else {
+    ##-- run program
+    my $statsfile = $mi->statsFile($doc,'dtatw-mkindex');
+    my $zspec = $doc->compressSpec('cxfile');
+    my $rc = runcmd($mi->{mkindex}, (defined($statsfile) ? "--stats=$statsfile" : qw()),
+		    (defined($zspec) ? "--compress=$zspec" : qw()),
+		    @$doc{qw(xmlfile cxfile sxfile txfile)},
+		    (($doc->{mkindexJobs}||0) > 1 ? $doc->{mkindexJobs} : ()));
+    $mi->logconfess(ref($mi)."::mkindex() mkindex program failed: $!") if ($rc!=0);
+    $mi->statsCollect($doc,'mkindex','dtatw-mkindex',$statsfile);
+  }
   $mi->logconfess(ref($mi)."::mkindex() failed to create output file(s)")
     if ( ($doc->{cxfile} && !-e $doc->{cxfile})
 	 || ($doc->{sxfile} && !-e $doc->{sxfile})
@@ -138,6 +158,8 @@ DTA::TokWrap::Processor::mkindex provides an object-oriented
 L<DTA::TokWrap::Processor|DTA::TokWrap::Processor> wrapper
 around the F<dtatw-mkindex> C program
 for L<DTA::TokWrap::Document|DTA::TokWrap::Document> objects.
+If the optional L<DTA::TokWrap::XS|DTA::TokWrap::XS> module is installed,
+the index is generated in-process instead (see the C<xs> option).
 
 Most users should use the high-level
 L<DTA::TokWrap|DTA::TokWrap> wrapper class
@@ -159,6 +181,10 @@ DTA::TokWrap::Processor::mkindex
 inherits from
 L<DTA::TokWrap::Processor|DTA::TokWrap::Processor>.
 
+=item $HAVE_XS
+
+True iff L<DTA::TokWrap::XS|DTA::TokWrap::XS> could be loaded.
+
 =back
 
 =cut
@@ -181,6 +207,7 @@ Constructor.
 
  mkindex => $path_to_dtatw_mkindex, ##-- default: search
  inplace => $bool,                  ##-- prefer in-place programs for search?
+ xs => $bool,                       ##-- use DTA::TokWrap::XS if available? (default=1)
 
 =item defaults
 
@@ -220,6 +247,8 @@ Relevant %$doc keys:
  cxfile  => $cxfile,   ##-- (output) character index filename
  sxfile  => $sxfile,   ##-- (output) structure index filename
  txfile  => $txfile,   ##-- (output) structure index filename
+ mkindexJobs => $n,    ##-- (input) number of parallel jobs (chunks split at E<lt>pbE<gt>; default=1)
+ compressTmp => $spec, ##-- (input) output compression (see L<DTA::TokWrap::Document::compressSpec()|DTA::TokWrap::Document/compressSpec>)
  ##
  mkindex_stamp0 => $f, ##-- (output) timestamp of operation begin
  mkindex_stamp  => $f, ##-- (output) timestamp of operation end
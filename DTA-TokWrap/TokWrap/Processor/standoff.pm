@@ -2,7 +2,7 @@
 
 ## File: DTA::TokWrap::Processor::standoff
 ## Author: Bryan Jurish <moocow@cpan.org>
-## Description: DTA tokenizer wrappers: t.xml -> (s.xml, w.xml, a.xml) via dtatw-txml2[swa]xml
+## Description: DTA tokenizer wrappers: t.xml -> (s.xml, w.xml, a.xml) via dtatw-txml2so
 
 package DTA::TokWrap::Processor::standoff;
 
@@ -27,9 +27,10 @@ our @ISA = qw(DTA::TokWrap::Processor);
 
 ## $so = CLASS_OR_OBJ->new(%args)
 ##  + %args:
-##    t2w => $path_to_dtatw_txml2wxml, ##-- default: search
-##    t2s => $path_to_dtatw_txml2sxml, ##-- default: search
-##    t2a => $path_to_dtatw_txml2axml, ##-- default: search
+##    t2so => $path_to_dtatw_txml2so,  ##-- one-pass (s,w,a) filter; default: search
+##    t2w => $path_to_dtatw_txml2wxml, ##-- default: search (optional, OBSOLETE)
+##    t2s => $path_to_dtatw_txml2sxml, ##-- default: search (optional, OBSOLETE)
+##    t2a => $path_to_dtatw_txml2axml, ##-- default: search (optional, OBSOLETE)
 ##    inplace => $bool,                ##-- prefer in-place programs for search?
 
 ## %defaults = CLASS->defaults()
@@ -37,6 +38,7 @@ sub defaults {
   my $that = shift;
   return (
 	  $that->SUPER::defaults(),
+	  t2so=>undef,
 	  t2w=>undef,
 	  t2s=>undef,
 	  t2a=>undef,
@@ -49,11 +51,13 @@ sub init {
   my $so = shift;
 
   ##-- search for program(s)
+  ##  + missing programs are only fatal when they are actually needed (see soxml(), standoff())
+  $so->{t2so} = path_prog("dtatw-txml2so", prepend=>($so->{inplace} ? ['.','../src'] : undef))
+    if (!defined($so->{t2so}));
   foreach ('s','w','a') {
     if (!defined($so->{"t2$_"})) {
       $so->{"t2$_"} = path_prog("dtatw-txml2${_}xml",
 				prepend=>($so->{inplace} ? ['.','../src'] : undef),
-				warnsub=>sub {$so->logconfess(@_)},
 			       );
     }
   }
@@ -99,10 +103,66 @@ sub dump_t2a_stylesheet { $_[0]->_xsl->dump_t2a_stylesheet(@_[1..$#_]); }
 ##==============================================================================
 
 ## $doc_or_undef = $CLASS_OR_OBJECT->standoff($doc)
-##  + wrapper for sosxml, sowxml, soaxml
+##  + creates all of sosfile, sowfile, soafile in a single pass over the .t.xml data via dtatw-txml2so
+##  + falls back to sosxml(), sowxml(), soaxml() if dtatw-txml2so is unavailable
+##  + %$doc keys:
+##    xtokdata => $xtokdata, ##-- (input) XML-ified tokenizer output data (string), or:
+##    xtokfile => $xtokfile, ##-- (input) XML-ified tokenizer output file (used if xtokdata is undefined)
+##    so${X}file => $file,   ##-- (output) standoff files, for $X in qw(s w a)
+##    standoff_stamp0 => $f, ##-- (output) timestamp of operation begin
+##    standoff_stamp  => $f, ##-- (output) timestamp of operation end
+##    so${X}xml_stamp => $f, ##-- (output) timestamp of operation end, for $X in qw(s w a)
+##    so${X}file_stamp => $f,##-- (output) timestamp of operation end, for $X in qw(s w a)
 sub standoff {
   my ($so,$doc) = @_;
-  return $so->sosxml($doc) && $so->sowxml($doc) && $so->soaxml($doc);
+  $so = $so->new() if (!ref($so));
+  return $so->sosxml($doc) && $so->sowxml($doc) && $so->soaxml($doc)
+    if (!defined($so->{t2so}));
+
+  $doc->setLogContext();
+  $so->vlog($so->{traceLevel},"standoff()");
+  $doc->{standoff_stamp0} = timestamp();
+
+  ##-- sanity check(s)
+  foreach (qw(s w a)) {
+    $so->logconfess("standoff(): no document key 'so${_}file' defined!")
+      if (!defined($doc->{"so${_}file"}));
+  }
+  $so->runt2so($doc, @$doc{qw(sosfile sowfile soafile)}, $doc->{xmlbase}, basename($doc->{sowfile}));
+
+  $doc->{standoff_stamp} = timestamp(); ##-- stamp
+  $doc->{"so${_}xml_stamp"} = $doc->{"so${_}file_stamp"} = $doc->{standoff_stamp} foreach (qw(s w a));
+  return $doc;
+}
+
+## $doc = $so->runt2so($doc, $sosfile, $sowfile, $soafile, $xmlbase, $sobase)
+##  + low-level wrapper for dtatw-txml2so; empty output filenames suppress the respective output
+##  + reads $doc->{xtokdata} if defined, otherwise $doc->{xtokfile}
+sub runt2so {
+  my ($so,$doc,@args) = @_;
+  my $t2so = $so->{t2so};
+  $so->logconfess("runt2so(): no processor key 't2so' defined!")
+    if (!defined($t2so));
+  my $statsfile = $so->statsFile($doc,'dtatw-txml2so');
+  my $argstr = join(' ', map {"'".($_//'')."'"} @args);
+  my $statsopt = defined($statsfile) ? "'--stats=$statsfile' " : '';
+
+  if (defined($doc->{xtokdata})) {
+    my $cmdfh = opencmd("| '$t2so' $statsopt- $argstr")
+      or $so->logconfess("runt2so(): open failed for pipe to '$t2so': $!");
+    $cmdfh->print($doc->{xtokdata});
+    $cmdfh->close()
+      or $so->logconfess("runt2so(): '$t2so' failed: $!");
+  }
+  elsif (defined($doc->{xtokfile}) && -r $doc->{xtokfile}) {
+    runcmd("'$t2so' $statsopt'$doc->{xtokfile}' $argstr")==0
+      or $so->logconfess("runt2so(): '$t2so' failed: $!");
+  }
+  else {
+    $so->logconfess("runt2so(): neither document key 'xtokdata' nor readable 'xtokfile' defined");
+  }
+  $so->statsCollect($doc,'standoff','dtatw-txml2so',$statsfile);
+  return $doc;
 }
 
 ## $doc_or_undef = $CLASS_OR_OBJECT->soxml($doc,$X,$xmlbase)
@@ -128,21 +188,32 @@ sub soxml {
 
   ##-- sanity check(s)
   $so = $so->new() if (!ref($so));
-  $so->logconfess("$method(): no document key 'xtokdata' defined")
-    if (!$doc->{xtokdata});
-  my $t2x = $so->{"t2${X}"};
-  $so->logconfess("$method(): no processor key 't2${X}' defined!")
-    if (!defined($t2x));
   my $sofile = $doc->{"so${X}file"};
   $so->logconfess("$method(): no document key 'so${X}file' defined!")
     if (!defined($sofile));
-
-  ##-- run command
   $xmlbase = $doc->{xmlbase} if (!defined($xmlbase));
-  my $cmdfh = opencmd("| '$t2x' - '$sofile' '$xmlbase'")
-    or $so->logconfess("${method}(): open failed for pipe to '$t2x': $!");
-  $cmdfh->print($doc->{xtokdata});
-  $cmdfh->close();
+
+  my $t2x = $so->{"t2${X}"};
+  if (!defined($t2x) && defined($so->{t2so})) {
+    ##-- run one-pass filter for this output only
+    $so->runt2so($doc,
+		 ($X eq 's' ? $sofile : ''),
+		 ($X eq 'w' ? $sofile : ''),
+		 ($X eq 'a' ? $sofile : ''),
+		 ($X eq 'w' ? $xmlbase : ''),
+		 ($X eq 'w' ? '' : $xmlbase));
+  }
+  else {
+    ##-- run command
+    $so->logconfess("$method(): no processor key 't2${X}' or 't2so' defined!")
+      if (!defined($t2x));
+    $so->logconfess("$method(): no document key 'xtokdata' defined")
+      if (!$doc->{xtokdata});
+    my $cmdfh = opencmd("| '$t2x' - '$sofile' '$xmlbase'")
+      or $so->logconfess("${method}(): open failed for pipe to '$t2x': $!");
+    $cmdfh->print($doc->{xtokdata});
+    $cmdfh->close();
+  }
 
   $doc->{"${method}_stamp"} = $doc->{"so${X}file_stamp"} = timestamp(); ##-- stamp
   return $doc;
@@ -204,7 +275,7 @@ __END__
 
 =head1 NAME
 
-DTA::TokWrap::Processor::standoff - DTA tokenizer wrappers: t.xml -> (s.xml, w.xml, a.xml) via external filter programs
+DTA::TokWrap::Processor::standoff - DTA tokenizer wrappers: t.xml -> (s.xml, w.xml, a.xml) via external filter program(s)
 
 =cut
 
@@ -221,6 +292,7 @@ DTA::TokWrap::Processor::standoff - DTA tokenizer wrappers: t.xml -> (s.xml, w.x
  $doc_or_undef = $CLASS_OR_OBJECT->sowxml($doc);
  $doc_or_undef = $CLASS_OR_OBJECT->soaxml($doc);
  $doc_or_undef = $CLASS_OR_OBJECT->standoff($doc);
+ $doc = $so->runt2so($doc, $sosfile, $sowfile, $soafile, $xmlbase, $sobase);
  
  ##-- backwards-compatibility
  undef = $so->dump_t2s_stylesheet($filename_or_fh);
@@ -272,9 +344,10 @@ Constructor.
 
 %args, %$so:
 
- t2w => $path_to_dtatw_txml2wxml, ##-- default: search
- t2s => $path_to_dtatw_txml2sxml, ##-- default: search
- t2a => $path_to_dtatw_txml2axml, ##-- default: search
+ t2so => $path_to_dtatw_txml2so,  ##-- one-pass (s,w,a) filter; default: search
+ t2w => $path_to_dtatw_txml2wxml, ##-- default: search (optional, OBSOLETE)
+ t2s => $path_to_dtatw_txml2sxml, ##-- default: search (optional, OBSOLETE)
+ t2a => $path_to_dtatw_txml2axml, ##-- default: search (optional, OBSOLETE)
  inplace => $bool,                ##-- prefer in-place programs for search?
 
 =item defaults
@@ -338,6 +411,34 @@ See L<DTA::TokWrap::Processor::standoff::xsl::dump_t2a_stylesheet()|DTA::TokWrap
 
 =over 4
 
+=item standoff
+
+ $doc_or_undef = $CLASS_OR_OBJECT->standoff($doc);
+
+Generate all of the C<s>-, C<w>-, and C<a>-level standoff files for the
+L<DTA::TokWrap::Document|DTA::TokWrap::Document> object $doc
+in a single pass over the C<.t.xml> data using the C<dtatw-txml2so> program.
+Falls back to L</sosxml>, L</sowxml>, and L</soaxml> if C<dtatw-txml2so> is not available.
+
+Relevant %$doc keys:
+
+ xtokdata    => $xtokdata, ##-- (input) XML-ified tokenizer output data (string), or:
+ xtokfile    => $xtokfile, ##-- (input) XML-ified tokenizer output file (if xtokdata is undefined)
+ so${X}file  => $file,     ##-- (output) standoff files, for $X in qw(s w a)
+ ##
+ standoff_stamp0  => $f,   ##-- (output) timestamp of operation begin
+ standoff_stamp   => $f,   ##-- (output) timestamp of operation end
+ so${X}xml_stamp  => $f,   ##-- (output) timestamp of operation end
+ so${X}file_stamp => $f,   ##-- (output) timestamp of operation end
+
+=item runt2so
+
+ $doc = $so->runt2so($doc, $sosfile, $sowfile, $soafile, $xmlbase, $sobase);
+
+Low-level wrapper for the C<dtatw-txml2so> program.
+Empty output filenames suppress the respective output file.
+Reads C<$doc-E<gt>{xtokdata}> if defined, otherwise C<$doc-E<gt>{xtokfile}>.
+
 =item soxml
 
  $doc_or_undef = $CLASS_OR_OBJECT->soxml($doc,$X,$xmlbase);
@@ -345,6 +446,8 @@ See L<DTA::TokWrap::Processor::standoff::xsl::dump_t2a_stylesheet()|DTA::TokWrap
 Low-level generic standoff formatting method.
 Generate C<$X>-level standoff for the
 L<DTA::TokWrap::Document|DTA::TokWrap::Document> object $doc.
+Uses the dedicated program C<$so-E<gt>{"t2${X}"}> if available,
+otherwise C<dtatw-txml2so> with all other outputs suppressed.
 
 Relevant %$doc keys:
 
@@ -8,8 +8,9 @@ package DTA::TokWrap::Processor::tcfdecode0;
 
 use DTA::TokWrap::Version;  ##-- imports $VERSION, $RCDIR
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:slurp :time :libxml);
+use DTA::TokWrap::Utils qw(:slurp :time :libxml :xmlutils);
 use DTA::TokWrap::Processor;
+use XML::LibXML::Reader;
 
 use Carp;
 use strict;
@@ -55,6 +56,8 @@ sub defaults {
 ## + $doc is a DTA::TokWrap::Document object
 ## + %$doc keys:
 ##    tcfdoc   => $tcfdoc,   ##-- (input) TCF input document
+##    tcffile  => $tcffile,  ##-- (input,streaming) TCF input file, used if {tcfdoc} is undefined and {tcfstream} is true
+##    tcfstream => $bool,    ##-- (input) if true and {tcfdoc} is undefined, pull-parse {tcffile} (see tcfdecode0_stream())
 ##    ##
 ##    tcfxdata => $tcfxdata, ##-- (output) TEI-XML decode0d from TCF
 ##    tcftdata => $tcftdata, ##-- (output) text data decode0d from TCF
@@ -78,6 +81,9 @@ sub tcfdecode0 {
   $dec->vlog($dec->{traceLevel},"tcfdecode0()");
   $doc->{tcfdecode0_stamp0} = timestamp(); ##-- stamp
 
+  ##-- streaming mode: pull-parse {tcffile}
+  return $dec->tcfdecode0_stream($doc) if (!$doc->{tcfdoc} && $doc->{tcfstream});
+
   ##-- sanity check(s)
   $dec->logconfess("tcfdecode0(): no {tcfdoc} defined") if (!$doc->{tcfdoc});
 
@@ -209,6 +215,155 @@ sub tcfdecode0 {
   return $doc;
 }
 
+## $doc_or_undef = $dec->tcfdecode0_stream($doc)
+##  + guts for tcfdecode0() in streaming mode ($doc->{tcfstream} true, $doc->{tcfdoc} undefined)
+##  + pull-parses $doc->{tcffile} with XML::LibXML::Reader, so no DOM is built for the whole document:
+##    - textSource and text layers are expanded one element at a time
+##    - tokens, sentences, lemmas, POStags, and orthography layers are read item-by-item
+##  + output keys are identical to those of tcfdecode0()
+sub tcfdecode0_stream {
+  my ($dec,$doc) = @_;
+
+  ##-- sanity check(s)
+  my $file = $doc->{tcffile};
+  $dec->logconfess("tcfdecode0(): no {tcfdoc} or {tcffile} defined") if (!defined($file));
+  $dec->vlog($dec->{traceLevel},"tcfdecode0(): streaming from $file");
+  my $reader = XML::LibXML::Reader->new((ref($file) ? 'IO' : 'location')=>$file, huge=>1)
+    or $dec->logconfess("tcfdecode0(): could not open TCF file '$file': $!");
+
+  ##-- which layers do we need?
+  my %want = (
+	      textSource => $dec->{decode_tcfx},
+	      text       => $dec->{decode_tcft},
+	      (map {($_=>$dec->{decode_tcfw})} qw(tokens sentences)),
+	      (map {($_=>$dec->{decode_tcfa})} qw(lemmas POStags orthography)),
+	     );
+  $doc->{tcfxdata} = '' if ($dec->{decode_tcfx});
+  $doc->{tcftdata} = '' if ($dec->{decode_tcft});
+
+  ##-- decode0: pull-parse
+  my (@wids,%id2w,$wid, @sents,$sid,$swids, %anno);
+  my ($name,$depth,$layer,$ncorpus);
+  my $rc = $reader->read();
+  while ($rc > 0) {
+    if ($reader->nodeType != XML_READER_TYPE_ELEMENT) {
+      $rc = $reader->read();
+      next;
+    }
+    $name  = $reader->localName;
+    $depth = $reader->depth;
+
+    if ($depth == 0) {
+      ##-- /D-Spin
+      $rc = $reader->read();
+    }
+    elsif ($depth == 1) {
+      ##-- /D-Spin/*: only descend into (the first) TextCorpus
+      $rc = ($name eq 'TextCorpus' && !$ncorpus++ ? $reader->read() : $reader->next());
+    }
+    elsif ($depth == 2) {
+      ##-- /D-Spin/TextCorpus/LAYER
+      $layer = $name;
+      if (!$want{$layer}) {
+	$rc = $reader->next();
+      }
+      elsif ($layer eq 'textSource') {
+	##-- tcfxdata: /D-Spin/TextCorpus/textSource[@type="(application|text)/tei+xml"]
+	$dec->vlog($dec->{traceLevel},"tcfdecode0(): textSource");
+	$doc->{tcfxdata} = $reader->readString()//''
+	  if (($reader->getAttribute('type')//'') =~ m{^(?:text|application)/tei\+xml\b});
+	$rc = $reader->next();
+      }
+      elsif ($layer eq 'text') {
+	##-- tcftdata: /D-Spin/TextCorpus/text
+	$dec->vlog($dec->{traceLevel},"tcfdecode0(): text");
+	$doc->{tcftdata} = $reader->readString()//'';
+	$rc = $reader->next();
+      }
+      else {
+	##-- item-level layer: descend
+	$dec->vlog($dec->{traceLevel},"tcfdecode0(): $layer");
+	$rc = $reader->read();
+      }
+    }
+    elsif ($depth == 3) {
+      ##-- /D-Spin/TextCorpus/LAYER/ITEM
+      if ($layer eq 'tokens' && $name eq 'token') {
+	$wid = $reader->getAttribute('ID') // sprintf("w%x", $#wids);
+	$id2w{$wid} = $reader->readString()//'';
+	push(@wids,$wid);
+      }
+      elsif ($layer eq 'sentences' && $name eq 'sentence') {
+	$sid = $reader->getAttribute('ID') // sprintf("s%x", $#sents);
+	if (!defined($swids=$reader->getAttribute('tokenIDs'))) {
+	  $dec->logwarn("tcfdecode0(): no tokenIDs attribute for sentence #$sid, skipping");
+	} else {
+	  push(@sents, [$sid,$swids]); ##-- resolved below: tokens layer might follow sentences
+	}
+      }
+      elsif ($layer eq 'lemmas' && $name eq 'lemma') {
+	push(@{$anno{lemma}}, [$reader->getAttribute('tokenIDs')//'', $reader->readString()//'']);
+      }
+      elsif ($layer eq 'POStags' && $name eq 'tag') {
+	push(@{$anno{pos}}, [$reader->getAttribute('tokenIDs')//'', $reader->readString()//'']);
+      }
+      elsif ($layer eq 'orthography' && $name eq 'correction' && ($reader->getAttribute('operation')//'') eq 'replace') {
+	push(@{$anno{norm}}, [$reader->getAttribute('tokenIDs')//'', $reader->readString()//'']);
+      }
+      $rc = $reader->next();
+    }
+    else {
+      $rc = $reader->next();
+    }
+  }
+  $dec->logconfess("tcfdecode0(): parse error in TCF file '$file'") if ($rc < 0);
+  $dec->logconfess("tcfdecode0(): no /*/TextCorpus node found in TCF file '$file'") if (!$ncorpus);
+  $reader->close();
+
+  ##-- decode0: tcfxdata, tcftdata: encode
+  foreach (grep {defined($doc->{$_})} qw(tcfxdata tcftdata)) {
+    utf8::encode($doc->{$_}) if (utf8::is_utf8($doc->{$_}));
+  }
+
+  ##-- decode0: tcfwdata
+  if ($dec->{decode_tcfw}) {
+    $dec->logwarn("tcfdecode0(): no TextCorpus/tokens node found in TCF file '$file'") if (!@wids);
+    $dec->vlog($dec->{traceLevel},"tcfdecode0(): tcfwdata");
+    $doc->{tcfwdata} = (@sents
+			? join('', map {($sid=$_->[0]) ; join('', map {$id2w{$_}."\t$sid/$_\n"} split(' ',$_->[1]))."\n"} @sents)
+			: join('', map {$id2w{$_}."\ts0/$_\n"} @wids)."\n");
+    utf8::encode($doc->{tcfwdata}) if (utf8::is_utf8($doc->{tcfwdata}));
+  }
+
+  ##-- decode0: tcfadata
+  if ($dec->{decode_tcfa}) {
+    $dec->vlog($dec->{traceLevel},"tcfdecode0(): tcfadata");
+    my (@ids,%id2a,$id);
+    foreach my $attr (qw(lemma pos norm)) {
+      foreach (@{$anno{$attr}||[]}) {
+	$id = $_->[0];
+	push(@ids,$id) if (!exists($id2a{$id}));
+	$id2a{$id}{$attr} = $_->[1];
+      }
+    }
+    $doc->{tcfadata} = join('',
+			    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n",
+			    "<annotations type=\"att.linguistic\" source=\"tcf\"", (@ids ? ">\n" : "/>\n"),
+			    (map {
+			      $id = $_;
+			      ("  <w id=\"", xmlesc_bytes($id), "\"",
+			       (map {(" $_=\"", xmlesc_bytes($id2a{$id}{$_}), "\"")} grep {exists($id2a{$id}{$_})} qw(lemma pos norm)),
+			       "/>\n")
+			    } @ids),
+			    (@ids ? "</annotations>\n" : qw()),
+			   );
+  }
+
+  ##-- finalize
+  $doc->{tcfdecode0_stamp} = $doc->{tcfxdata_stamp} = $doc->{tcftdata_stamp} = $doc->{tcfwdata_stamp} = $doc->{tcfadata_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
 ##==============================================================================
 ## Utilities
 ##==============================================================================
@@ -365,9 +520,14 @@ L<DTA::TokWrap::Document|DTA::TokWrap::Document> object
 to TCF, storing the result in
 C<$doc-E<gt>{tcfxdata}>, C<$doc-E<gt>{tcftdata}>, and C<$doc-E<gt>{tcfwdata}>.
 
+If C<$doc-E<gt>{tcfdoc}> is undefined and C<$doc-E<gt>{tcfstream}> is true,
+calls L</tcfdecode0_stream> instead.
+
 Relevant %$doc keys:
 
  tcfdoc   => $tcfdoc,   ##-- (input) TCF input document
+ tcffile  => $tcffile,  ##-- (input,streaming) TCF input file, used if {tcfdoc} is undefined and {tcfstream} is true
+ tcfstream => $bool,    ##-- (input) if true and {tcfdoc} is undefined, pull-parse {tcffile}
  ##
  tcfxdata => $tcfxdata, ##-- (output) TEI-XML decode0d from TCF
  tcftdata => $tcftdata, ##-- (output) text data decode0d from TCF
@@ -381,6 +541,19 @@ Relevant %$doc keys:
  tcfwdata_stamp   => $f, ##-- (output) timestamp of operation end
  tcfadata_stamp   => $f, ##-- (output) timestamp of operation end
 
+=item tcfdecode0_stream
+
+ $doc_or_undef = $dec->tcfdecode0_stream($doc);
+
+Streaming guts for L</tcfdecode0>:
+pull-parses C<$doc-E<gt>{tcffile}> with L<XML::LibXML::Reader|XML::LibXML::Reader>
+instead of walking an in-memory DOM.
+The C<textSource> and C<text> layers are expanded one element at a time,
+and the C<tokens>, C<sentences>, C<lemmas>, C<POStags>, and C<orthography>
+layers are read item-by-item, so peak memory usage is bounded by the largest
+single layer element rather than the whole TCF document.
+Output keys are the same as for L</tcfdecode0>.
+
 =back
 
 =cut
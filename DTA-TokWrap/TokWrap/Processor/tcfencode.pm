@@ -8,7 +8,8 @@ package DTA::TokWrap::Processor::tcfencode;
 
 use DTA::TokWrap::Version;  ##-- imports $VERSION, $RCDIR
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:slurp :time :libxml);
+use DTA::TokWrap::Utils qw(:slurp :time :libxml :xmlutils);
+use IO::File;
 use DTA::TokWrap::Processor;
 
 use Carp;
@@ -28,6 +29,7 @@ our @ISA = qw(DTA::TokWrap::Processor);
 ##    (
 ##     tcfVersion => $version,     ##-- attribute value for encoded /D-Spin/@version (default="5")
 ##     tcfTextSourceType => $type, ##-- attribute value for encoded //textSource/@type (default="application/tei+xml; tokenized=0")
+##     tcfBlockSize => $nbytes,    ##-- block size for streaming mode ($doc->{tcfstream}) layer copies (default=1M)
 ##    )
 
 ## %defaults = CLASS_OR_OBJ->defaults()
@@ -37,6 +39,7 @@ sub defaults {
   return (
           tcfVersion => "5",
 	  tcfTextSourceType => 'application/tei+xml; tokenized=0',
+	  tcfBlockSize => (1<<20),
 	 );
 }
 
@@ -56,11 +59,14 @@ sub defaults {
 ##    txtfile => $txtfile, ##-- (input) serialized text file
 ##    txtdata => $txtdata, ##-- (input,alternate) serialized text data
 ##    tcflang => $lang,    ##-- (input) tcf language (default="de")
+##    tcfstream => $bool,  ##-- (input) if true, write {tcffile} directly and don't build {tcfdoc}
 ##    ##
 ##    tcfdoc  => $tcfdoc,   ##-- (output) TCF output document
+##    tcffile => $tcffile,  ##-- (output,streaming) TCF output file
 ##    tcfencode_stamp0 => $f, ##-- (output) timestamp of operation begin
 ##    tcfencode_stamp  => $f, ##-- (output) timestamp of operation end
 ##    tcfdoc_stamp   => $f, ##-- (output) timestamp of operation end
+##    tcffile_stamp  => $f, ##-- (output,streaming) timestamp of operation end
 sub tcfencode {
   my ($enc,$doc) = @_;
   $enc = $enc->new if (!ref($enc));
@@ -70,6 +76,9 @@ sub tcfencode {
   $enc->vlog($enc->{traceLevel},"tcfencode()");
   $doc->{tcfencode_stamp0} = timestamp(); ##-- stamp
 
+  ##-- streaming mode: write TCF directly to {tcffile}
+  return $enc->tcfencode_stream($doc) if ($doc->{tcfstream});
+
   ##-- create TCF document (lifted from DTA::CAB::Format::TCF::putDocument())
   my $xdoc = $doc->{tcfdoc} = XML::LibXML::Document->new("1.0","UTF-8");
   my $xroot = $xdoc->createElement('D-Spin');
@@ -112,10 +121,84 @@ sub tcfencode {
   return $doc;
 }
 
+## $doc_or_undef = $enc->tcfencode_stream($doc)
+##  + guts for tcfencode() in streaming mode ($doc->{tcfstream} true)
+##  + writes TCF directly to $doc->{tcffile} without building an XML::LibXML::Document
+##  + TEI and text layer contents are copied from {xmldata}|{xmlfile} rsp. {txtdata}|{txtfile}
+##    in blocks of $enc->{tcfBlockSize} bytes, so memory usage doesn't depend on document size
+sub tcfencode_stream {
+  my ($enc,$doc) = @_;
+
+  ##-- get output file
+  my $file = $doc->{tcffile} // "$doc->{outdir}/$doc->{outbase}.tcf";
+  $doc->{tcffile} = $file if (!ref($file));
+  $enc->vlog($enc->{traceLevel},"tcfencode(): streaming to $file");
+  my $outfh = ref($file) ? $file : IO::File->new(">$file");
+  $enc->logconfess("tcfencode(): open failed for TCF output file '$file': $!") if (!$outfh);
+  $outfh->binmode() if (!ref($file));
+
+  ##-- header: /D-Spin/MetaData
+  $outfh->print("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n",
+		"<D-Spin xmlns=\"http://www.dspin.de/data\" version=\"", xmlesc_bytes($enc->{tcfVersion}//'0.4'), "\">\n",
+		"<MetaData xmlns=\"http://www.dspin.de/data/metadata\">",
+		(defined($doc->{source}) ? ("<source>", xmlesc_text($doc->{source}), "</source>") : qw()),
+		"</MetaData>\n",
+		"<TextCorpus xmlns=\"http://www.dspin.de/data/textcorpus\" lang=\"", xmlesc_bytes($doc->{tcflang}//'de'), "\">\n",
+	       );
+
+  ##-- TextCorpus/textSource
+  $outfh->print("<textSource", ($enc->{tcfTextSourceType} ? (" type=\"", xmlesc_bytes($enc->{tcfTextSourceType}), "\"") : qw()), ">");
+  $enc->copyEscaped($outfh, \$doc->{xmldata}, $doc->{xmlfile})
+    or $enc->logconfess("tcfencode(): could not copy TEI-XML source file '$doc->{xmlfile}' and {xmldata} key undefined");
+  $outfh->print("</textSource>\n");
+
+  ##-- TextCorpus/text
+  $outfh->print("<text>");
+  $enc->copyEscaped($outfh, \$doc->{txtdata}, $doc->{txtfile})
+    or $enc->logconfess("tcfencode(): could not copy serialized text file '$doc->{txtfile}' and {txtdata} key undefined");
+  $outfh->print("</text>\n");
+
+  ##-- footer
+  $outfh->print("</TextCorpus>\n</D-Spin>\n");
+  if (!ref($file)) {
+    $outfh->close()
+      or $enc->logconfess("tcfencode(): failed to close TCF output file '$file': $!");
+  }
+
+  ##-- finalize
+  delete($doc->{tcfdoc});
+  $doc->{tcfencode_stamp} = $doc->{tcffile_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
 ##==============================================================================
 ## Utilities
 ##==============================================================================
 
+## $bool = $enc->copyEscaped($outfh, \$data, $infile)
+##  + prints XML-escaped character data to $outfh in blocks of $enc->{tcfBlockSize} bytes
+##  + reads from $$data if defined, otherwise from $infile (filename or handle)
+sub copyEscaped {
+  my ($enc,$outfh,$datar,$infile) = @_;
+  my $bs = $enc->{tcfBlockSize} || (1<<20);
+  if (defined($$datar)) {
+    my $len = length($$datar);
+    for (my $off=0; $off < $len; $off += $bs) {
+      $outfh->print(xmlesc_text(substr($$datar,$off,$bs)));
+    }
+    return 1;
+  }
+  return 0 if (!defined($infile));
+  my $infh = ref($infile) ? $infile : zopen_file($infile);
+  return 0 if (!$infh);
+  my ($buf,$nread);
+  while ($nread = $infh->read($buf,$bs)) {
+    $outfh->print(xmlesc_text($buf));
+  }
+  $infh->close() if (!ref($infile));
+  return defined($nread);
+}
+
 1; ##-- be happy
 
 __END__
@@ -219,6 +302,7 @@ L<DTA::TokWrap::Document|DTA::TokWrap::Document> object
 to TCF, storing the result as an
 XML::LibXML::Document in
 C<$doc-E<gt>{tcfdoc}>.
+If C<$doc-E<gt>{tcfstream}> is true, calls L</tcfencode_stream> instead.
 
 Relevant %$doc keys:
 
@@ -226,11 +310,33 @@ Relevant %$doc keys:
  txtfile => $txtfile, ##-- (input) serialized text file
  xmldata => $xmldata, ##-- (input,alternate) source TXT-XML buffer
  txtdata => $txtdata, ##-- (input,alternate) serialized text data
+ tcfstream => $bool,  ##-- (input) if true, write {tcffile} directly and don't build {tcfdoc}
  ##
  tcfdoc  => $tcfdoc,   ##-- (output) TCF output document
+ tcffile => $tcffile,  ##-- (output,streaming) TCF output file
  tcfencode_stamp0 => $f, ##-- (output) timestamp of operation begin
  tcfencode_stamp  => $f, ##-- (output) timestamp of operation end
  tcfdoc_stamp   => $f, ##-- (output) timestamp of operation end
+ tcffile_stamp  => $f, ##-- (output,streaming) timestamp of operation end
+
+=item tcfencode_stream
+
+ $doc_or_undef = $enc->tcfencode_stream($doc);
+
+Streaming guts for L</tcfencode>:
+writes TCF directly to C<$doc-E<gt>{tcffile}> without building an XML::LibXML::Document.
+The C<textSource> and C<text> layer contents are copied from
+C<{xmldata}> or C<{xmlfile}> and C<{txtdata}> or C<{txtfile}>, respectively,
+in blocks of C<$enc-E<gt>{tcfBlockSize}> bytes, so memory usage does not grow with the
+document size.
+The subsequent C<saveTcfFile()> call in the C<tcfencode> target is a no-op in this mode.
+
+=item copyEscaped
+
+ $bool = $enc->copyEscaped($outfh, \$data, $infile);
+
+Prints XML-escaped character data to $outfh block-wise,
+reading from $$data if it is defined or from $infile otherwise.
 
 =back
 
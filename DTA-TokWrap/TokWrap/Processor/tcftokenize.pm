@@ -8,9 +8,10 @@ package DTA::TokWrap::Processor::tcftokenize;
 
 use DTA::TokWrap::Version;  ##-- imports $VERSION, $RCDIR
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:slurp :time :libxml);
+use DTA::TokWrap::Utils qw(:slurp :time :libxml :xmlutils);
 use DTA::TokWrap::Processor;
 use File::Basename qw(basename);
+use IO::File;
 
 use Carp;
 use strict;
@@ -44,12 +45,15 @@ our @ISA = qw(DTA::TokWrap::Processor);
 ## + $doc is a DTA::TokWrap::Document object
 ## + %$doc keys:
 ##    tcfdoc    => $tcfdoc,       ##-- (input) TCF input document with <text> layer
+##    tcffile   => $tcffile,      ##-- (input,streaming) TCF input file, used if {tcfdoc} is undefined and {tcfstream} is true
+##    tcfstream => $bool,         ##-- (input) if true and {tcfdoc} is undefined, write {tcftokfile} directly (see tcftokenize_stream())
 ##    ##
 ##    txtfile   => $txtfile,      ##-- (output,temp) text file used for TCF extraction
 ##    tokdata0  => $tokdata,      ##-- (output,temp) raw tokenization data
 ##    tokdata1  => $tokdata1,     ##-- (output,temp) tweaked tokenization data
 ##    ##
 ##    tcftokdoc => $tcftokdoc,    ##-- (output) output TCF file with <sentences>,<tokens> layers (==$tcfdoc)
+##    tcftokfile => $tcftokfile,  ##-- (output,streaming) output TCF file with <sentences>,<tokens> layers
 ##    tcftokenize_stamp0 => $f,    ##-- (output) timestamp of operation begin
 ##    tcftokenize_stamp  => $f,    ##-- (output) timestamp of operation end
 ##    tcftokdoc_stamp    => $f,    ##-- (output) timestamp of operation end
@@ -64,7 +68,7 @@ sub tcftokenize {
   $doc->{tcftokenize_stamp0} = timestamp(); ##-- stamp
 
   ##-- sanity check(s)
-  $ttok->logconfess("tcftokenize(): no {tcfdoc} defined") if (!defined($doc->{tcfdoc}));
+  $ttok->logconfess("tcftokenize(): no {tcfdoc} defined") if (!defined($doc->{tcfdoc}) && !$doc->{tcfstream});
 
   ##-- ensure text data, file
   $doc->tcfdecode0(undef, decode_tcfx=>0,decode_tcfw=>0,decode_tcft=>1)
@@ -77,6 +81,9 @@ sub tcftokenize {
   $doc->genKey([qw(tokenize tokenize1)])
     or $ttok->logconfess("tcftokenize(): failed to tokenize TCF text layer: $!");
 
+  ##-- streaming mode: splice tokenizer output into {tcftokfile}
+  return $ttok->tcftokenize_stream($doc) if (!defined($doc->{tcfdoc}));
+
   ##-- parse tokenizer output into tcf (no sanity checking)
   my $tcfdoc = $doc->{tcfdoc};
   my $xroot  = $tcfdoc->documentElement;
@@ -123,10 +130,114 @@ sub tcftokenize {
   return $doc;
 }
 
+## $doc_or_undef = $ttok->tcftokenize_stream($doc)
+##  + guts for tcftokenize() in streaming mode ($doc->{tcfstream} true, $doc->{tcfdoc} undefined)
+##  + copies $doc->{tcffile} to $doc->{tcftokfile}, inserting tokens and sentences layers
+##    for $doc->{tokdata1} before the closing TextCorpus tag; no DOM is built for either file
+sub tcftokenize_stream {
+  my ($ttok,$doc) = @_;
+
+  ##-- open files
+  my $infile  = $doc->{tcffile};
+  my $outfile = $doc->{tcftokfile} // "$doc->{outdir}/$doc->{outbase}.tcftok";
+  $doc->{tcftokfile} = $outfile if (!ref($outfile));
+  my $infh = IO::File->new("<$infile")
+    or $ttok->logconfess("tcftokenize(): open failed for TCF input file '$infile': $!");
+  $infh->binmode();
+  my $outfh = ref($outfile) ? $outfile : IO::File->new(">$outfile");
+  $ttok->logconfess("tcftokenize(): open failed for TCF output file '$outfile': $!") if (!$outfh);
+  $outfh->binmode() if (!ref($outfile));
+
+  ##-- find offset of closing TextCorpus tag, searching backwards from end-of-file
+  ##  + each block is scanned once, together with the carried prefix of the following block up to its 1st '>'
+  ##    (a closing tag starting in the current block cannot extend any further)
+  my $size = (-s $infile) || 0;
+  my $bs   = 65536;
+  my ($tailoff,$tailend,$tail,$carry,$gt,$ctoff) = ($size,$size,'','',-1,undef);
+  while ($tailoff > 0 && !defined($ctoff)) {
+    $tailend = $tailoff;
+    $tailoff = $tailoff > $bs ? $tailoff-$bs : 0;
+    $infh->seek($tailoff,0);
+    $infh->read($tail, $tailend-$tailoff);
+    $tail .= $carry;
+    $ctoff = $tailoff + $-[0] if ($tail =~ m{.*\K</(?:[^\s:>]+:)?TextCorpus\s*>}s);
+    $carry = ($gt=index($tail,'>')) >= 0 ? substr($tail,0,$gt+1) : '';
+  }
+  $ttok->logconfess("tcftokenize(): no closing TextCorpus tag found in TCF file '$infile'") if (!defined($ctoff));
+  undef $tail;
+  undef $carry;
+
+  ##-- copy: header (up to closing TextCorpus tag)
+  $infh->seek(0,0);
+  copyBytes($infh,$outfh,$ctoff)
+    or $ttok->logconfess("tcftokenize(): failed to copy TCF data from '$infile': $!");
+
+  ##-- parse tokenizer output into tcf (no sanity checking)
+  open(my $ttfh, "<", \$doc->{tokdata1})
+    or $ttok->logconfess("open failed for tokenizer output buffer: $!");
+  local ($_);
+  my $wi = 0;
+  my $s;
+  my @sents = ($s=[]); ##-- ([$wi_start, $wi_end], ...)
+  $outfh->print("<tokens>\n");
+  while (defined($_=<$ttfh>)) {
+    chomp;
+    if (/^%%/) {
+      next;
+    } elsif (/^$/) {
+      push(@sents,$s=[]);
+      next;
+    }
+    s/\t.*$//; ##-- trim tokenizer output
+    ++$wi;
+    $s->[0] = $wi if (!@$s);
+    $s->[1] = $wi;
+    $outfh->print(sprintf("<token ID=\"w%x\">",$wi), xmlesc_text($_), "</token>\n");
+  }
+  $outfh->print("</tokens>\n");
+
+  ##-- append sentences
+  my $si = 0;
+  $outfh->print("<sentences>\n");
+  foreach (@sents) {
+    next if (!@$_);
+    $outfh->print(sprintf("<sentence ID=\"s%x\" tokenIDs=\"",++$si), join(' ', map {sprintf("w%x",$_)} ($_->[0]..$_->[1])), "\"/>\n");
+  }
+  $outfh->print("</sentences>\n");
+
+  ##-- copy: trailer
+  copyBytes($infh,$outfh,$size-$ctoff)
+    or $ttok->logconfess("tcftokenize(): failed to copy TCF data from '$infile': $!");
+  $infh->close();
+  if (!ref($outfile)) {
+    $outfh->close()
+      or $ttok->logconfess("tcftokenize(): failed to close TCF output file '$outfile': $!");
+  }
+
+  ##-- finalize
+  $ttok->vlog($ttok->{traceLevel},"tcftokenize(): finalize");
+  $doc->{tcftokenize_stamp} = $doc->{tcftokfile_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
 ##==============================================================================
 ## Utilities
 ##==============================================================================
 
+## $bool = copyBytes($infh,$outfh,$nbytes)
+##  + copies $nbytes bytes from $infh to $outfh, block-wise
+sub copyBytes {
+  my ($infh,$outfh,$n) = @_;
+  my ($buf,$nread);
+  while ($n > 0) {
+    $nread = $infh->read($buf, ($n > 65536 ? 65536 : $n));
+    return 0 if (!$nread);
+    $outfh->print($buf) or return 0;
+    $n -= $nread;
+  }
+  return 1;
+}
+
 1; ##-- be happy
 
 __END__
@@ -240,6 +351,21 @@ Relevant %$doc keys:
  tcftokenize_stamp  => $f,   ##-- (output) timestamp of operation end
  tcftokdoc_stamp    => $f,   ##-- (output) timestamp of operation end
 
+If C<$doc-E<gt>{tcfdoc}> is undefined and C<$doc-E<gt>{tcfstream}> is true,
+the text layer is pull-parsed from C<$doc-E<gt>{tcffile}> and the output
+is written by L</tcftokenize_stream>.
+
+=item tcftokenize_stream
+
+ $doc_or_undef = $ttok->tcftokenize_stream($doc);
+
+Streaming guts for L</tcftokenize>:
+copies C<$doc-E<gt>{tcffile}> to C<$doc-E<gt>{tcftokfile}> block-wise,
+inserting C<tokens> and C<sentences> layers for C<$doc-E<gt>{tokdata1}>
+before the closing C<TextCorpus> tag.
+No DOM is built for either file, and the subsequent C<saveTcfTokFile()>
+call in the C<tcf2tok> target is a no-op.
+
 =back
 
 =cut
@@ -21,6 +21,9 @@ use utf8;
 ##==============================================================================
 our @ISA = qw(DTA::TokWrap::Processor);
 
+## $HAVE_XS : true iff DTA::TokWrap::XS (in-process libdtatw bindings) is available
+our $HAVE_XS = eval { require DTA::TokWrap::XS; 1 } ? 1 : 0;
+
 ##==============================================================================
 ## Constructors etc.
 ##==============================================================================
@@ -35,7 +38,9 @@ our @ISA = qw(DTA::TokWrap::Processor);
 ##    txmlextids => $bool,           ##-- if true, attempt to parse "<a>$SID/$WID</a>" pseudo-analyses as IDs (default:true; uses regex hack)
 ##    t2x => $path_to_dtatw_tok2xml, ##-- default: search
 ##    b2xb => $path_to_dtatw_b2xb,   ##-- default: search; 'off' to disable
+##    coords => $bool,               ##-- if true, add //w/@pb, //w/@lb, //w/@bb from .cx data (dtatw-b2xb -coords; default=0)
 ##    inplace => $bool,              ##-- prefer in-place programs for search?
+##    xs => $bool,                   ##-- use DTA::TokWrap::XS if available? (default=1)
 ##    )
 sub defaults {
   my $that = shift;
@@ -51,7 +56,9 @@ sub defaults {
 	  ##-- programs
 	  t2x => undef,
 	  b2xb => undef,
+	  coords => 0,
 	  inplace => 1,
+	  xs => 1,
 	 );
 }
 
@@ -60,7 +67,9 @@ sub defaults {
 sub init {
   my $t2x = shift;
 
-  ##-- search for program(s)
+  ##-- search for program(s) (unless we're using XS)
+  $t2x->{xs} = 0 if (!$HAVE_XS);
+  return $t2x if ($t2x->{xs});
   if (!defined($t2x->{t2x})) {
     $t2x->{t2x} = path_prog('dtatw-tok2xml',
 			    prepend=>($t2x->{inplace} ? ['.','../src'] : undef),
@@ -122,18 +131,36 @@ sub tok2xml {
 
   ##-- run client program(s)
   my ($cmd);
-  if ($t2x->{b2xb} ne 'off') {
+  my $coords = $opts{coords} // $t2x->{coords};
+  my %statsfile = map {($_=>$t2x->statsFile($doc,$_))} qw(dtatw-b2xb dtatw-tok2xml);
+  my %statsopt  = map {($_=>(defined($statsfile{$_}) ? "--stats='$statsfile{$_}' " : ''))} keys(%statsfile);
+  if ($t2x->{xs}) {
+    ##-- in-process: pass tokenizer data as scalars
+    $t2x->vlog($t2x->{traceLevel},"DTA::TokWrap::XS: b2xb | tok2xml");
+    (my $tokdatakey = $tokfilekey) =~ s/file/data/;
+    my $tdatar = defined($doc->{$tokdatakey}) ? \$doc->{$tokdatakey} : slurp_file($doc->{$tokfilekey});
+    eval {
+      my $ttdata = ($t2x->{b2xb}//'') ne 'off' ? DTA::TokWrap::XS::b2xb($$tdatar, @$doc{qw(cxfile bxfile)}, $doc->{$tokfilekey}, ($coords ? 1 : 0)) : $$tdatar;
+      $doc->{$xtokdatakey} = DTA::TokWrap::XS::tok2xml($ttdata, $doc->{xmlbase}, $doc->{$tokfilekey}, ($coords ? 1 : 0));
+    };
+    $t2x->logconfess("tok2xml(): DTA::TokWrap::XS failed: $@") if ($@);
+  }
+  elsif ($t2x->{b2xb} ne 'off') {
     $t2x->vlog($t2x->{traceLevel},"command: $t2x->{b2xb} | $t2x->{t2x}");
-    $cmd = "'$t2x->{b2xb}' '$doc->{$tokfilekey}' '$doc->{cxfile}' '$doc->{bxfile}' - | '$t2x->{t2x}' - - '$doc->{xmlbase}' |";
+    $cmd = ("'$t2x->{b2xb}' $statsopt{'dtatw-b2xb'}".($coords ? "-coords " : '')."'$doc->{$tokfilekey}' '$doc->{cxfile}' '$doc->{bxfile}' -"
+	    ." | '$t2x->{t2x}' $statsopt{'dtatw-tok2xml'}".($coords ? "-coords " : '')."- - '$doc->{xmlbase}' |");
   } else {
     $t2x->vlog($t2x->{traceLevel},"command: $t2x->{t2x}");
-    $cmd = "'$t2x->{t2x}' '$doc->{$tokfilekey}' - '$doc->{xmlbase}' |";
+    $cmd = "'$t2x->{t2x}' $statsopt{'dtatw-tok2xml'}".($coords ? "-coords " : '')."'$doc->{$tokfilekey}' - '$doc->{xmlbase}' |";
+  }
+  if (defined($cmd)) {
+    my $cmdfh = opencmd("$cmd")
+      or $t2x->logconfess("tok2xml(): open failed for pipe '$t2x->{b2xb}'|'$t2x->{t2x}'|: $!");
+    $doc->{$xtokdatakey} = undef;
+    slurp_fh($cmdfh,\$doc->{$xtokdatakey});
+    $cmdfh->close();
+    $t2x->statsCollect($doc,'tok2xml',$_,$statsfile{$_}) foreach (sort keys %statsfile);
   }
-  my $cmdfh = opencmd("$cmd")
-    or $t2x->logconfess("tok2xml(): open failed for pipe '$t2x->{b2xb}'|'$t2x->{t2x}'|: $!");
-  $doc->{$xtokdatakey} = undef;
-  slurp_fh($cmdfh,\$doc->{$xtokdatakey});
-  $cmdfh->close();
 
   ##-- re-sort?
   if ($opts{txmlsort_bysentence}//$t2x->{txmlsort_bysentence}) {
@@ -271,6 +298,9 @@ L<DTA::TokWrap::Processor|DTA::TokWrap::Processor> wrapper
 for converting "raw" CSV-format (.t) low-level tokenizer output
 to a "master" tokenized XML (.t.xml) format,
 for use with L<DTA::TokWrap::Document|DTA::TokWrap::Document> objects.
+If the optional L<DTA::TokWrap::XS|DTA::TokWrap::XS> module is installed,
+conversion runs in-process on perl scalars instead of via external programs
+(see the C<xs> option).
 
 Most users should use the high-level
 L<DTA::TokWrap|DTA::TokWrap> wrapper class
@@ -326,7 +356,9 @@ Constructor.
   txmlextids => $bool,           ##-- if true, attempt to parse "<a>$SID/$WID</a>" pseudo-analyses as IDs (default:true; uses regex hack)
   t2x => $path_to_dtatw_tok2xml, ##-- default: search
   b2xb => $path_to_dtatw_b2xb,   ##-- default: search; 'off' to disable
+  coords => $bool,               ##-- if true, add //w/@pb, //w/@lb, //w/@bb from .cx data (dtatw-b2xb -coords; default=0)
   inplace => $bool,              ##-- prefer in-place programs for search?
+  xs => $bool,                   ##-- use DTA::TokWrap::XS if available? (default=1)
 
 You probably should B<NOT> change any of the default output document
 structure options (unless this is the final module in your
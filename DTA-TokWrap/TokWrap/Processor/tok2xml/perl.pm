@@ -10,6 +10,7 @@ use DTA::TokWrap::Version;
 use DTA::TokWrap::Base;
 use DTA::TokWrap::Utils qw(:progs :libxml :libxslt :slurp :time);
 use DTA::TokWrap::Processor;
+use DTA::TokWrap::CxData qw();
 
 use IO::File;
 use Carp;
@@ -112,7 +113,7 @@ sub tok2xml {
   #$t2x->logconfess("tok2xml(): no tokenizer output data")
 
   ##-- create $tb2ci, $ob2ci index vectors
-  $t2x->txbyte_to_ci($doc->{cxdata});
+  $t2x->txbyte_to_ci($doc->{cxdata}, $t2x->cx_packed($doc));
   $t2x->txtbyte_to_ci($doc->{cxdata}, $doc->{bxdata});
 
   ##-- process tokenizer data
@@ -129,10 +130,24 @@ sub tok2xml {
   return $doc;
 }
 
+## $cxp_or_undef = $t2x->cx_packed($doc)
+##  + DTA::TokWrap::XS::CxData object for $doc->{cxfile} (see DTA::TokWrap::CxData::cx_packed())
+##  + undef if DTA::TokWrap::XS is not available, or if its records don't line up with $doc->{cxdata}
+sub cx_packed {
+  my ($t2x,$doc) = @_;
+  return undef if (!$DTA::TokWrap::CxData::HAVE_XS || !defined($doc->{cxfile}) || ref($doc->{cxfile}) || !-f $doc->{cxfile});
+  my $cxp = eval { DTA::TokWrap::CxData::cx_packed($doc->{cxfile}) };
+  return undef if (!$cxp || !$cxp->size || $cxp->size != scalar(@{$doc->{cxdata}}));
+  return $cxp;
+}
+
 ## \$tb2ci = $t2x->txbyte_to_ci(\@cxdata)
+## \$tb2ci = $t2x->txbyte_to_ci(\@cxdata, $cxp)
 ##  + sets %$t2x keys: tb2ci, ntb, nchr
+##  + if $cxp is a DTA::TokWrap::XS::CxData object (see cx_packed()), .tx offsets are read from
+##    its packed toffv() column instead of the per-record \@cxdata arrays
 sub txbyte_to_ci {
-  my ($t2x,$cx) = @_;
+  my ($t2x,$cx,$cxp) = @_;
 
   ##-- index variables
   my $CX_TOFF = $DTA::TokWrap::Document::CX_TOFF;
@@ -141,10 +156,23 @@ sub txbyte_to_ci {
   my ($ci,$toff,$tlen);
   $t2x->{tb2ci} = '';
   my $tb2cir = \$t2x->{tb2ci};
-  vec($$tb2cir, $cx->[$#$cx][$CX_TOFF]+$cx->[$#$cx][$CX_TLEN], 32) = $#$cx; ##-- initialize  / allocate
-  foreach $ci (0..$#$cx) {
-    ($toff,$tlen) = @{$cx->[$ci]}[$CX_TOFF,$CX_TLEN];
-    substr($$tb2cir, $toff*4, $tlen*4) = pack('N',$ci) x $tlen;
+  if ($cxp) {
+    ##-- packed columns: record $ci covers .tx bytes [toff($ci), toff($ci+1))
+    my ($n,$bits) = ($cxp->size, $cxp->offset_bits);
+    my $toffv     = $cxp->toffv;
+    my $tend      = $cxp->toff($n-1) + $cxp->tlen($n-1);
+    vec($$tb2cir, $tend, 32) = $n-1; ##-- initialize / allocate
+    foreach $ci (0..($n-1)) {
+      $toff = vec($toffv, $ci, $bits);
+      $tlen = ($ci < $n-1 ? vec($toffv, $ci+1, $bits) : $tend) - $toff;
+      substr($$tb2cir, $toff*4, $tlen*4) = pack('N',$ci) x $tlen;
+    }
+  } else {
+    vec($$tb2cir, $cx->[$#$cx][$CX_TOFF]+$cx->[$#$cx][$CX_TLEN], 32) = $#$cx; ##-- initialize  / allocate
+    foreach $ci (0..$#$cx) {
+      ($toff,$tlen) = @{$cx->[$ci]}[$CX_TOFF,$CX_TLEN];
+      substr($$tb2cir, $toff*4, $tlen*4) = pack('N',$ci) x $tlen;
+    }
   }
 
   ##-- properties
@@ -445,11 +473,23 @@ $%t2x keys (temporary, for debugging):
 may implicitly call $doc-E<gt>mkbx(), $doc-E<gt>loadCxFile(), $doc-E<gt>tokenize()
 (but shouldn't!)
 
+=item cx_packed
+
+ $cxp_or_undef = $t2x->cx_packed($doc);
+
+Low-level utility method.
+Returns a L<DTA::TokWrap::XS::CxData|DTA::TokWrap::XS> object for $doc-E<gt>{cxfile}
+(see L<DTA::TokWrap::CxData::cx_packed()|DTA::TokWrap::CxData>),
+or undef if DTA::TokWrap::XS is not available or the file's records don't line up with $doc-E<gt>{cxdata}.
+
 =item txbyte_to_ci
 
  \$tb2ci = $t2x->txbyte_to_ci(\@cxdata);
+ \$tb2ci = $t2x->txbyte_to_ci(\@cxdata, $cxp);
 
 Low-level utility method.
+If $cxp is a DTA::TokWrap::XS::CxData object (see L</cx_packed>),
+.tx byte offsets are read from its packed toffv() column rather than from the per-record @cxdata arrays.
 
 Sets %$t2x keys: tb2ci, ntb, nchr
 
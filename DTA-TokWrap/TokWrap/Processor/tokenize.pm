@@ -8,10 +8,13 @@ package DTA::TokWrap::Processor::tokenize;
 
 use DTA::TokWrap::Version;  ##-- imports $VERSION, $RCDIR
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:progs :slurp :time);
+use DTA::TokWrap::Utils qw(:progs :slurp :time :files);
 use DTA::TokWrap::Processor;
 
 use Encode qw(encode decode);
+use Digest::MD5 qw(md5_hex);
+use File::Path qw(make_path);
+use POSIX qw();
 use Carp;
 use strict;
 
@@ -28,6 +31,15 @@ our $DEFAULT_SUBCLASS = 'auto'; ##-- default subclass
 #our $DEFAULT_SUBCLASS = 'waste';
 #our $DEFAULT_SUBCLASS = 'scanner';
 #our $DEFAULT_SUBCLASS = 'dummy';
+#our $DEFAULT_SUBCLASS = 'fast';
+
+## $CHUNK_MIN
+##  + minimum chunk size (bytes) for tokenize_chunked()
+our $CHUNK_MIN = 65536;
+
+## $CACHE_MOD
+##  + average number of $SB$-delimited sentences per block for tokenize_cached() (see cache_cuts())
+our $CACHE_MOD = 16;
 
 ##==============================================================================
 ## Constructors etc.
@@ -77,10 +89,265 @@ sub tokenize {
 }
 
 
+## $doc_or_undef = DTA::TokWrap::Processor::tokenize::tokenize_chunked($tz,$doc,$njobs)
+## + parallel tokenization wrapper for arbitrary tokenizer (sub-)classes or objects $tz
+## + splits $doc->{txtdata} (or $doc->{txtfile}) into (at most) $njobs chunks immediately after hard
+##   sentence-break hints ($SB$), tokenizes the chunks concurrently in forked child processes via $tz->tokenize(),
+##   and concatenates the outputs with byte offsets shifted by the respective chunk offset
+## + output is identical to serial $tz->tokenize($doc) if $tz respects $SB$ hints
+## + falls back to serial $tz->tokenize($doc) if no useful split could be found
+## + %$doc keys: as for tokenize()
+sub tokenize_chunked {
+  my ($tz,$doc,$njobs) = @_;
+  $doc->setLogContext();
+  $tz = $tz->new() if (!ref($tz));
+  $njobs ||= 1;
+
+  ##-- get text data
+  my $txtbufr = \$doc->{txtdata};
+  if (!defined($$txtbufr)) {
+    $tz->logconfess("tokenize_chunked(): no .txt file defined")
+      if (!defined($doc->{txtfile}));
+    $txtbufr = slurp_file($doc->{txtfile});
+  }
+
+  ##-- find chunk boundaries: immediately after a '$SB$' hint
+  my $txtlen = length($$txtbufr);
+  my $chunksize = $txtlen / $njobs;
+  $chunksize = $CHUNK_MIN if ($chunksize < $CHUNK_MIN);
+  my @cuts = sb_cuts($txtbufr, $chunksize);
+  return $tz->tokenize($doc) if (@cuts < 3); ##-- no split: serial fallback
+
+  $tz->vlog($tz->{traceLevel},"tokenize_chunked(): tokenizing ".(scalar(@cuts)-1)." chunk(s) in parallel");
+  $doc->{tokenize0_stamp0} = timestamp();
+
+  ##-- spawn workers
+  my $tmpbase = ($doc->{tmpdir}||'.').'/'.($doc->{outbase}||'tokenize').".txt";
+  my (@kids,$i);
+  for ($i=0; $i < $#cuts; ++$i) {
+    my $chunk = substr($$txtbufr, $cuts[$i], $cuts[$i+1]-$cuts[$i]);
+    my $kid   = { off=>$cuts[$i], txtfile=>tempbuf(\$chunk, "$tmpbase.${i}_XXXXX") };
+    $kid->{tokfile} = "$kid->{txtfile}.t";
+    $kid->{pid} = fork();
+    if (!defined($kid->{pid})) {
+      $tz->logwarn("tokenize_chunked(): fork() failed: $!");
+      last;
+    }
+    elsif ($kid->{pid}==0) {
+      ##-- child: tokenize chunk into temporary output file, then exit without destructors
+      my $subdoc = bless({%$doc, txtfile=>$kid->{txtfile}, txtdata=>$chunk, tokdata0=>undef}, ref($doc));
+      my $rc = eval { $tz->tokenize($subdoc) && ref2file(\$subdoc->{tokdata0}, $kid->{tokfile}) };
+      print STDERR $@ if ($@);
+      POSIX::_exit($rc ? 0 : 1);
+    }
+    push(@kids,$kid);
+  }
+
+  ##-- collect outputs
+  my ($tokdata,$buf,$nfailed) = ('','',0);
+  foreach $i (0..$#kids) {
+    my $kid = $kids[$i];
+    waitpid($kid->{pid},0);
+    if ($? != 0 || !-e $kid->{tokfile}) {
+      ++$nfailed;
+    } elsif (!$nfailed) {
+      slurp_file($kid->{tokfile}, \$buf);
+      tokdata_append(\$tokdata, \$buf, $kid->{off});
+    }
+    unlink(grep {defined($_) && -e $_} @$kid{qw(txtfile tokfile)});
+  }
+  $tz->logconfess("tokenize_chunked(): $nfailed of ".scalar(@kids)." tokenizer job(s) failed")
+    if ($nfailed);
+  $tz->logconfess("tokenize_chunked(): only ".scalar(@kids)." of ".($#cuts)." tokenizer job(s) started")
+    if (@kids < $#cuts);
+
+  ##-- finalize
+  $doc->{tokdata0} = $tokdata;
+  $doc->{ntoks} = $tz->nTokens(\$doc->{tokdata0});
+  $doc->{tokfile0_stamp} = $doc->{tokenize0_stamp} = $doc->{tokdata0_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
+## $doc_or_undef = DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,$cachedir,$njobs)
+## + caching tokenization wrapper for arbitrary tokenizer (sub-)classes or objects $tz
+## + splits $doc->{txtdata} (or $doc->{txtfile}) into content-defined blocks ending immediately after
+##   $SB$ hints (see cache_cuts()), and looks up the tokenizer output for each block in $cachedir,
+##   keyed by the MD5 digest of $tz->cache_id() and the block text
+## + only uncached blocks are tokenized (in a single call, via tokenize_chunked() if $njobs > 1);
+##   their block-relative output is stored in $cachedir for subsequent documents
+## + output is identical to uncached $tz->tokenize($doc) if $tz respects $SB$ hints
+## + %$doc keys: as for tokenize()
+sub tokenize_cached {
+  my ($tz,$doc,$cachedir,$njobs) = @_;
+  $doc->setLogContext();
+  $tz = $tz->new() if (!ref($tz));
+
+  ##-- get text data
+  my $txtbufr = \$doc->{txtdata};
+  if (!defined($$txtbufr)) {
+    $tz->logconfess("tokenize_cached(): no .txt file defined")
+      if (!defined($doc->{txtfile}));
+    $txtbufr = slurp_file($doc->{txtfile});
+  }
+  $doc->{tokenize0_stamp0} = timestamp();
+
+  ##-- lookup cached blocks
+  my $idkey = md5_hex(bytes_of($tz->cache_id()));
+  my @cuts  = cache_cuts($txtbufr, $CACHE_MOD);
+  my (@blocks,@miss,$blk,$i);
+  for ($i=0; $i < $#cuts; ++$i) {
+    $blk = { off=>$cuts[$i], len=>$cuts[$i+1]-$cuts[$i] };
+    $blk->{key}  = md5_hex($idkey, bytes_of(substr($$txtbufr, $blk->{off}, $blk->{len})));
+    $blk->{data} = cache_get($cachedir, $blk->{key});
+    push(@blocks,$blk);
+    push(@miss,$blk) if (!defined($blk->{data}));
+  }
+  my $hdrkey = md5_hex($idkey, "\0header");
+  my $hdr    = cache_get($cachedir, $hdrkey);
+  $tz->vlog($tz->{traceLevel},"tokenize_cached(): ".(@blocks-@miss)." of ".scalar(@blocks)." block(s) cached");
+
+  if (@miss) {
+    ##-- tokenize uncached blocks as a single text (temporary sub-document must not unlink $doc temp files)
+    my $mtxt = join('', map {substr($$txtbufr, $_->{off}, $_->{len})} @miss);
+    my $mtmp = tempbuf(\$mtxt, ($doc->{tmpdir}||'.').'/'.($doc->{outbase}||'tokenize').".txt.cache_XXXXX");
+    my $subdoc = bless({%$doc, tw=>undef, keeptmp=>1, tokenizeCache=>undef, txtfile=>$mtmp, txtdata=>$mtxt, tokdata0=>undef}, ref($doc));
+    my $rc = $subdoc->tokenize($tz);
+    unlink($mtmp);
+    $tz->logconfess("tokenize_cached(): tokenizer failed for ".scalar(@miss)." uncached block(s)")
+      if (!$rc || !defined($subdoc->{tokdata0}));
+
+    ##-- split output by block: leading header comments
+    my @lines = split(/^/m, $subdoc->{tokdata0});
+    $hdr = '';
+    $hdr .= shift(@lines) while (@lines && $lines[0] =~ /^%%(?!\s*\$[SW]B\$)/);
+    cache_put($cachedir, $hdrkey, \$hdr);
+
+    ##-- split output by block: tokens, with block-relative offsets
+    my ($moff,$j) = (0,0);
+    foreach (@miss) {
+      $_->{moff} = $moff;
+      $_->{data} = '';
+      $moff += $_->{len};
+    }
+    foreach (@lines) {
+      ++$j while ($j < $#miss && /^(?!%%)[^\t\n]*\t([0-9]+) / && $1 >= $miss[$j+1]{moff});
+      s/^((?!%%)[^\t\n]*\t)([0-9]+)(?= )/$1.($2-$miss[$j]{moff})/e;
+      $miss[$j]{data} .= $_;
+    }
+    cache_put($cachedir, $_->{key}, \$_->{data}) foreach (@miss);
+  }
+
+  ##-- assemble output
+  my $tokdata = $hdr // '';
+  foreach $blk (@blocks) {
+    $blk->{data} =~ s/^((?!%%)[^\t\n]*\t)([0-9]+)(?= )/$1.($2+$blk->{off})/mge if ($blk->{off} > 0);
+    $tokdata .= $blk->{data};
+  }
+
+  ##-- finalize
+  $doc->{tokdata0} = $tokdata;
+  $doc->{ntoks} = $tz->nTokens(\$doc->{tokdata0});
+  $doc->{tokfile0_stamp} = $doc->{tokenize0_stamp} = $doc->{tokdata0_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
+## $id = $tz->cache_id()
+##  + tokenizer identity for tokenize_cached(): class name and all defined non-reference options
+##    (except trace options), plus size and modification time of any option value naming an existing file
+##  + subclasses may override this to exclude options which do not affect tokenizer output
+sub cache_id {
+  my $tz = shift;
+  return "$tz" if (!ref($tz));
+  my @id = (ref($tz));
+  my ($val);
+  foreach (sort grep {$_ !~ /^trace/ && $_ ne 'inplace'} keys %$tz) {
+    next if (!defined($val=$tz->{$_}) || ref($val));
+    push(@id, "$_=$val");
+    push(@id, join(':', (stat($val))[7,9])) if ($val ne '' && -f $val);
+  }
+  return join("\t", @id);
+}
+
+
 ##==============================================================================
 ## Utilities
 ##==============================================================================
 
+## @cuts = DTA::TokWrap::Processor::tokenize::cache_cuts(\$txtbuf, $mod)
+##  + returns content-defined block boundaries (0, ..., length($txtbuf)) for tokenize_cached()
+##  + each internal boundary immediately follows a '$SB$' hint for which a checksum over the (at most 64)
+##    preceding bytes is divisible by $mod, so that boundaries depend only on local context
+##    and identical passages in different documents yield identical blocks
+sub cache_cuts {
+  my ($txtbufr,$mod) = @_;
+  my $txtlen = length($$txtbufr);
+  my @cuts   = (0);
+  my ($sbpos,$lo) = (0,0);
+  while (($sbpos = index($$txtbufr, '$SB$', $sbpos)) >= 0) {
+    $lo = $sbpos > 64 ? $sbpos-64 : 0;
+    $sbpos += 4;
+    last if ($sbpos >= $txtlen);
+    push(@cuts, $sbpos) if (($mod||1) <= 1 || unpack('%32C*', substr($$txtbufr, $lo, $sbpos-$lo)) % $mod == 0);
+  }
+  push(@cuts, $txtlen);
+  return @cuts;
+}
+
+## $bytes = DTA::TokWrap::Processor::tokenize::bytes_of($str)
+##  + returns UTF-8 encoded $str if it is a character string, otherwise $str itself
+sub bytes_of {
+  return utf8::is_utf8($_[0]) ? encode('UTF-8',$_[0]) : $_[0];
+}
+
+## $data_or_undef = DTA::TokWrap::Processor::tokenize::cache_get($cachedir, $key)
+##  + returns cached data for $key, or undef if none exists
+sub cache_get {
+  my ($dir,$key) = @_;
+  my $file = "$dir/".substr($key,0,2)."/$key";
+  return undef if (!-f $file);
+  return ${slurp_file($file)};
+}
+
+## $bool = DTA::TokWrap::Processor::tokenize::cache_put($cachedir, $key, \$data)
+##  + stores \$data for $key; atomic w.r.t. concurrent readers and writers
+sub cache_put {
+  my ($dir,$key,$datar) = @_;
+  my $subdir = "$dir/".substr($key,0,2);
+  make_path($subdir) if (!-d $subdir);
+  my $file = "$subdir/$key";
+  return ref2file($datar, "$file.$$") && rename("$file.$$", $file);
+}
+
+## @cuts = DTA::TokWrap::Processor::tokenize::sb_cuts(\$txtbuf, $chunksize)
+##  + returns chunk boundaries (0, ..., length($txtbuf)) s.t. each internal boundary immediately follows
+##    the first '$SB$' hint at least $chunksize bytes after the previous boundary
+##  + returns (0,length($txtbuf)) if no split is possible
+sub sb_cuts {
+  my ($txtbufr,$chunksize) = @_;
+  my $txtlen = length($$txtbufr);
+  my @cuts   = (0);
+  my ($want,$sbpos);
+  for ($want=$chunksize; $want < $txtlen; $want = $cuts[$#cuts]+$chunksize) {
+    last if (($sbpos = index($$txtbufr, '$SB$', $want)) < 0);
+    last if ($sbpos+4 >= $txtlen);
+    push(@cuts, $sbpos+4);
+  }
+  push(@cuts, $txtlen);
+  return @cuts;
+}
+
+## undef = DTA::TokWrap::Processor::tokenize::tokdata_append(\$tokdata, \$chunkdata, $off)
+##  + appends tokenizer output \$chunkdata for a text chunk starting at byte $off to \$tokdata
+##  + if $off > 0, strips leading header comments (but keeps $SB$, $WB$ hints) and shifts token offsets by $off
+sub tokdata_append {
+  my ($dstr,$bufr,$off) = @_;
+  if ($off > 0) {
+    $$bufr =~ s/\A(?:%%(?!\s*\$[SW]B\$)[^\n]*\n)+//;
+    $$bufr =~ s/^((?!%%)[^\t\n]*\t)([0-9]+)(?= )/$1.($2+$off)/mge;
+  }
+  $$dstr .= $$bufr;
+}
+
 ## $ntoks = $tz->nTokens(\$tokdata)
 ##  + get number of tokens in \$tokdata (regex hack)
 sub nTokens {
@@ -160,6 +427,17 @@ L<DTA::TokWrap::Processor|DTA::TokWrap::Processor>.
 Default tokenizer subclass to use for DTA::TokWrap::Processor::tokenize-E<gt>new().
 Default value = 'tomasotath'.
 
+=item $CHUNK_MIN
+
+Minimum chunk size in bytes for L</tokenize_chunked>.
+Default value = 65536.
+
+=item $CACHE_MOD
+
+Average number of C<$SB$>-delimited sentences per cache block for L</tokenize_cached>
+(see L</cache_cuts>).
+Default value = 16.
+
 =back
 
 =cut
@@ -217,6 +495,82 @@ Relevant %$doc keys:
 may implicitly call $doc-E<gt>mkbx() and/or $doc-E<gt>saveTxtFile()
 (but shouldn't).
 
+=item tokenize_chunked
+
+ $doc_or_undef = DTA::TokWrap::Processor::tokenize::tokenize_chunked($tz,$doc,$njobs);
+
+Parallel tokenization wrapper for an arbitrary tokenizer object or class $tz.
+Splits C<$doc-E<gt>{txtdata}> (or C<$doc-E<gt>{txtfile}>) into at most $njobs chunks
+immediately after hard sentence-break hints (C<$SB$>),
+calls C<$tz-E<gt>tokenize()> for each chunk concurrently in a forked child process,
+and concatenates the outputs, shifting byte offsets by the respective chunk offset.
+The result is identical to serial C<$tz-E<gt>tokenize($doc)> whenever the tokenizer respects C<$SB$> hints.
+Falls back to serial tokenization if no split point could be found.
+
+=item tokenize_cached
+
+ $doc_or_undef = DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,$cachedir,$njobs);
+
+Caching tokenization wrapper for an arbitrary tokenizer object or class $tz
+(used for C<dta-tokwrap.perl -tokenize-cache DIR>).
+Splits the document text into blocks ending immediately after C<$SB$> hints (see L</cache_cuts>),
+and looks up the tokenizer output for each block in the directory $cachedir,
+keyed by the MD5 digest of L</cache_id> and the block text.
+Only uncached blocks are passed to the tokenizer
+(all in a single call, via L</tokenize_chunked> if $njobs E<gt> 1),
+and their output is stored in $cachedir with block-relative offsets.
+The result is identical to uncached C<$tz-E<gt>tokenize($doc)> whenever the tokenizer respects C<$SB$> hints.
+Cache entries are never expired: remove $cachedir to reclaim space.
+
+=item cache_id
+
+ $id = $tz->cache_id();
+
+Returns a string identifying tokenizer $tz for L</tokenize_cached>:
+the class name and all defined non-reference options except C<trace*> and C<inplace>,
+plus size and modification time of each option value naming an existing file
+(e.g. the tokenizer program or model),
+so that installing a new tokenizer or model invalidates cached output.
+Subclasses may override this method to ignore options which do not affect tokenizer output.
+
+=item cache_cuts
+
+ @cuts = DTA::TokWrap::Processor::tokenize::cache_cuts(\$txtbuf, $mod);
+
+Returns content-defined block boundaries C<(0, ..., length($txtbuf))> for L</tokenize_cached>.
+Each internal boundary immediately follows a C<$SB$> hint for which a byte checksum
+over the (at most 64) preceding bytes is divisible by $mod,
+so that boundaries depend only on local context and identical passages in different documents
+(or in different versions of the same document) yield identical blocks.
+
+=item cache_get
+
+ $data_or_undef = DTA::TokWrap::Processor::tokenize::cache_get($cachedir, $key);
+
+Returns the cached data for $key, or undef if none exists.
+Cache entries are stored as F<$cachedir/XX/$key>, where XX are the first 2 characters of $key.
+
+=item cache_put
+
+ $bool = DTA::TokWrap::Processor::tokenize::cache_put($cachedir, $key, \$data);
+
+Stores $data for $key via a temporary file and rename(),
+so that concurrent processes sharing $cachedir never see partial entries.
+
+=item sb_cuts
+
+ @cuts = DTA::TokWrap::Processor::tokenize::sb_cuts(\$txtbuf, $chunksize);
+
+Returns chunk boundaries C<(0, ..., length($txtbuf))> for splitting $txtbuf
+into chunks of at least $chunksize bytes, each ending immediately after a C<$SB$> hint.
+
+=item tokdata_append
+
+ undef = DTA::TokWrap::Processor::tokenize::tokdata_append(\$tokdata, \$chunkdata, $off);
+
+Appends tokenizer output $chunkdata for a text chunk starting at byte offset $off to $tokdata.
+For $off E<gt> 0, leading header comments are removed and token offsets are shifted by $off.
+
 =back
 
 =cut
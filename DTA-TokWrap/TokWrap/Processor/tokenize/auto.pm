@@ -75,7 +75,38 @@ sub tokenize {
   my ($ta,$doc) = @_;
   $doc->setLogContext();
   $ta = $ta->new if (!ref($ta));
+  $ta->ensure_tokz();
+  $ta->vlog($ta->{traceLevel},"using tokenizer subclass = ".(ref($ta->{tokz})||$ta->{tokz}));
+  $ta->logconfess("tokenizer subobject {tokz} not defined") if (!defined($ta->{tokz}));
+
+  return $ta->{tokz}->tokenize($doc);
+}
+
+## $doc_or_undef = $ta->tokenize_chunked($doc,$njobs)
+##  + delegates to the underlying tokenizer's tokenize_chunked() method, if any
+sub tokenize_chunked {
+  my ($ta,$doc,$njobs) = @_;
+  $ta = $ta->new if (!ref($ta));
+  $ta->ensure_tokz();
+  $ta->logconfess("tokenizer subobject {tokz} not defined") if (!defined($ta->{tokz}));
+  return (UNIVERSAL::can($ta->{tokz},'tokenize_chunked') || \&DTA::TokWrap::Processor::tokenize::tokenize_chunked)->($ta->{tokz},$doc,$njobs);
+}
 
+## $id = $ta->cache_id()
+##  + delegates to the underlying tokenizer's cache_id() method
+sub cache_id {
+  my $ta = shift;
+  $ta = $ta->new if (!ref($ta));
+  $ta->ensure_tokz();
+  $ta->logconfess("tokenizer subobject {tokz} not defined") if (!defined($ta->{tokz}));
+  return $ta->{tokz}->cache_id();
+}
+
+## $tokz_or_undef = $ta->ensure_tokz()
+##  + selects & instantiates underlying tokenizer object $ta->{tokz} from $ta->{classes} if not already defined
+##  + called implicitly by tokenize(); may be called early to avoid per-document probing in long-running processes
+sub ensure_tokz {
+  my $ta = shift;
   if (!defined($ta->{tokz})) {
     foreach my $class (@{$ta->{classes}}) {
       $ta->vlog($ta->{traceLevel},"trying tokenizer subclass '$class'...");
@@ -106,10 +137,7 @@ sub tokenize {
       last if (!$@ && defined($ta->{tokz}));
     }
   }
-  $ta->vlog($ta->{traceLevel},"using tokenizer subclass = ".(ref($ta->{tokz})||$ta->{tokz}));
-  $ta->logconfess("tokenizer subobject {tokz} not defined") if (!defined($ta->{tokz}));
-
-  return $ta->{tokz}->tokenize($doc);
+  return $ta->{tokz};
 }
 
 
@@ -221,6 +249,23 @@ Dynamic object-dependent defaults.
 
 See L<DTA::TokWrap::Processor::tokenize::tokenize()|DTA::TokWrap::Processor::tokenize/tokenize>.
 
+=item cache_id
+
+ $id = $ta->cache_id();
+
+Delegates to the underlying tokenizer's cache_id() method,
+so that cached tokenizer output is shared with explicit use of the same tokenizer class.
+
+=item ensure_tokz
+
+ $tokz_or_undef = $ta->ensure_tokz();
+
+Selects and instantiates the underlying tokenizer object $ta-E<gt>{tokz}
+from $ta-E<gt>{classes} if it is not already defined.
+Called implicitly by L</tokenize>; long-running processes
+(e.g. L<DTA::TokWrap::Daemon|DTA::TokWrap::Daemon>) may call it once
+up front to avoid probing for tokenizer programs on each request.
+
 =back
 
 =cut
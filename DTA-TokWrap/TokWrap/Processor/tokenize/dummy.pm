@@ -67,8 +67,8 @@ sub init {
 ##    txtfile => $txtfile,  ##-- (input) serialized text file
 ##    tokdata => $tokdata,  ##-- (output) tokenizer output data (string)
 ##    ntoks => $nTokens,    ##-- (output) number of output tokens (regex hack)
-##    tokenize_stamp0 => $f, ##-- (output) timestamp of operation begin
-##    tokenize_stamp  => $f, ##-- (output) timestamp of operation end
+##    tokenize0_stamp0 => $f, ##-- (output) timestamp of operation begin
+##    tokenize0_stamp  => $f, ##-- (output) timestamp of operation end
 ##    tokdata_stamp => $f,   ##-- (output) timestamp of operation end
 ## + may implicitly call $doc->mkbx() and/or $doc->saveTxtFile()
 sub tokenize {
@@ -77,11 +77,11 @@ sub tokenize {
 
   ##-- log, stamp
   $td->vlog($td->{traceLevel},"tokenize()");
-  $doc->{tokenize_stamp0} = timestamp();
+  $doc->{tokenize0_stamp0} = timestamp();
 
   ##-- sanity check(s)
   $td = $td->new if (!ref($td));
-  $td->logconfess("tokenize(): no dtatw-tokenize-dummy program")
+  $td->logconfess("tokenize(): no tokenizer program defined")
     if (!$td->{tokenize});
   $td->logconfess("tokenize(): no .txt file defined")
     if (!defined($doc->{txtfile}));
@@ -0,0 +1,208 @@
+## -*- Mode: CPerl -*-
+
+## File: DTA::TokWrap::Processor::tokenize::fast.pm
+## Author: Bryan Jurish <moocow@cpan.org>
+## Descript: DTA tokenizer wrappers: dtatw-tokenize-fast
+
+package DTA::TokWrap::Processor::tokenize::fast;
+
+use DTA::TokWrap::Version;
+use DTA::TokWrap::Base;
+use DTA::TokWrap::Utils qw(:progs);
+use DTA::TokWrap::Processor::tokenize::dummy;
+
+use Carp;
+use strict;
+
+##==============================================================================
+## Constants
+##==============================================================================
+our @ISA = qw(DTA::TokWrap::Processor::tokenize::dummy);
+
+##==============================================================================
+## Constructors etc.
+##==============================================================================
+
+## $tf = CLASS_OR_OBJ->new(%args)
+##  + %args:
+##    tokenize => $path_to_dtatw_tokenize_fast, ##-- default: search
+##    inplace  => $bool,                        ##-- prefer in-place programs for search?
+
+## %defaults = CLASS->defaults()
+##  + inherited from DTA::TokWrap::Processor::tokenize::dummy
+
+## $tf = $tf->init()
+sub init {
+  my $tf = shift;
+
+  ##-- search for tokenizer program
+  if (!defined($tf->{tokenize})) {
+    $tf->{tokenize} = path_prog('dtatw-tokenize-fast',
+				prepend=>($tf->{inplace} ? ['.','../src'] : undef),
+				warnsub=>sub {$tf->logconfess(@_)},
+			       );
+  }
+
+  return $tf;
+}
+
+##==============================================================================
+## Methods
+##==============================================================================
+
+## $doc_or_undef = $CLASS_OR_OBJECT->tokenize($doc)
+##  + inherited from DTA::TokWrap::Processor::tokenize::dummy
+
+
+1; ##-- be happy
+
+__END__
+##========================================================================
+## POD DOCUMENTATION, auto-generated by podextract.perl, edited
+
+##========================================================================
+## NAME
+=pod
+
+=head1 NAME
+
+DTA::TokWrap::Processor::tokenize::fast - DTA tokenizer wrappers: dtatw-tokenize-fast
+
+=cut
+
+##========================================================================
+## SYNOPSIS
+=pod
+
+=head1 SYNOPSIS
+
+ use DTA::TokWrap::Processor::tokenize::fast;
+ 
+ $tf = DTA::TokWrap::Processor::tokenize::fast->new(%args);
+ $doc_or_undef = $tf->tokenize($doc);
+
+=cut
+
+##========================================================================
+## DESCRIPTION
+=pod
+
+=head1 DESCRIPTION
+
+DTA::TokWrap::Processor::tokenize::fast provides a package-local
+alternative to the "official" low-level tokenizer class
+L<DTA::TokWrap::Processor::tokenize|DTA::TokWrap::Processor::tokenize>
+using the C<dtatw-tokenize-fast> program.
+C<dtatw-tokenize-fast> recognizes the same token types and produces the
+same output format as C<dtatw-tokenize-dummy>, but uses Unicode-aware
+character classes and is considerably faster.
+
+Most users should use the high-level
+L<DTA::TokWrap|DTA::TokWrap> wrapper class
+instead of using this module directly.
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::fast: Constants
+=pod
+
+=head2 Constants
+
+=over 4
+
+=item @ISA
+
+DTA::TokWrap::Processor::tokenize::fast
+inherits from
+L<DTA::TokWrap::Processor::tokenize::dummy|DTA::TokWrap::Processor::tokenize::dummy>.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::fast: Constructors etc.
+=pod
+
+=head2 Constructors etc.
+
+=over 4
+
+=item new
+
+ $tf = $CLASS_OR_OBJ->new(%args);
+
+Constructor.
+
+%args, %$tf:
+
+ tokenize => $path_to_dtatw_tokenize_fast, ##-- default: search
+ inplace  => $bool,                        ##-- prefer in-place programs for search?
+
+=item init
+
+ $tf = $tf->init();
+
+Dynamic object-dependent defaults.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::fast: Methods
+=pod
+
+=head2 Methods
+
+=over 4
+
+=item tokenize
+
+ $doc_or_undef = $CLASS_OR_OBJECT->tokenize($doc);
+
+See L<DTA::TokWrap::Processor::tokenize::dummy::tokenize()|DTA::TokWrap::Processor::tokenize::dummy/tokenize>.
+
+=back
+
+=cut
+
+##========================================================================
+## END POD DOCUMENTATION, auto-generated by podextract.perl
+
+##======================================================================
+## See Also
+##======================================================================
+
+=pod
+
+=head1 SEE ALSO
+
+L<DTA::TokWrap::Intro(3pm)|DTA::TokWrap::Intro>,
+L<dta-tokwrap.perl(1)|dta-tokwrap.perl>,
+...
+
+=cut
+
+##======================================================================
+## Footer
+##======================================================================
+
+=pod
+
+=head1 AUTHOR
+
+Bryan Jurish E<lt>moocow@cpan.orgE<gt>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2026 by Bryan Jurish
+
+This package is free software; you can redistribute it and/or modify
+it under the same terms as Perl itself, either Perl version 5.14.2 or,
+at your option, any later version of Perl 5 you may have available.
+
+=cut
+
+
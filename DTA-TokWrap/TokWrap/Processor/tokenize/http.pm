@@ -8,10 +8,17 @@ package DTA::TokWrap::Processor::tokenize::http;
 
 use DTA::TokWrap::Version;  ##-- imports $VERSION, $RCDIR
 use DTA::TokWrap::Base;
-use DTA::TokWrap::Utils qw(:progs :slurp :time);
+use DTA::TokWrap::Utils qw(:progs :slurp :time :files);
 use DTA::TokWrap::Processor;
 
 use LWP::UserAgent;
+use HTTP::Request::Common qw();
+use IO::Compress::Gzip qw();
+use IO::Handle;
+use IO::Select;
+use File::Temp qw();
+use Time::HiRes qw();
+use POSIX qw(:sys_wait_h);
 
 use Encode qw(encode decode);
 use Carp;
@@ -33,6 +40,12 @@ our @ISA = qw(DTA::TokWrap::Processor::tokenize);
 ##     serverurl => $url,      ##-- server url (default='http://194.95.188.28/dtaos/tok-cgi.perl' [kaskade])
 ##     txtparam  => $param,    ##-- text query parameter (default='t')
 ##     timeout   => $secs,     ##-- user agent timeout (default=300)
+##     keepAlive => $n,        ##-- max number of cached persistent connections per user agent (default=4; 0 disables keep-alive)
+##     gzip      => $bool,     ##-- send gzip-compressed request bodies (Content-Encoding: gzip)? (default=0)
+##     retries   => $n,        ##-- max number of retries for transport errors and HTTP 408, 429, 5xx (default=3)
+##     retryDelay => $secs,    ##-- delay before first retry; doubled for each subsequent retry (default=1)
+##     jobs      => $n,        ##-- max number of requests in flight (default=1)
+##     maxChunk  => $bytes,    ##-- split request text at $SB$ hints into chunks of at most $bytes where possible (default=0: don't)
 ##     ua => $ua,              ##-- low-level underlying LWP::UserAgent
 sub defaults {
   my $that = shift;
@@ -45,6 +58,12 @@ sub defaults {
 	  #serverpars => {},
 	  txtparam  => 't',
 	  timeout   => 300,
+	  keepAlive => 4,
+	  gzip      => 0,
+	  retries   => 3,
+	  retryDelay => 1,
+	  jobs      => 1,
+	  maxChunk  => 0,
 	  @_,
 	 );
 }
@@ -55,8 +74,9 @@ sub init {
 
   ##-- instantiate LWP::UserAgent
   if (!defined($tz->{ua})) {
-      $tz->{ua} = LWP::UserAgent->new(timeout=>$tz->{timeout})
+      $tz->{ua} = LWP::UserAgent->new(timeout=>$tz->{timeout}, keep_alive=>($tz->{keepAlive}||0))
 	or $tz->logconfess("init(): could not create LWP::UserAgent: $!");
+      $tz->{ua}->default_header('Accept-Encoding'=>'gzip');
   }
 
   return $tz;
@@ -76,12 +96,45 @@ sub init {
 ## + may implicitly call $doc->mkbx() and/or $doc->saveTxtFile()
 sub tokenize {
   my ($tz,$doc) = @_;
-  $doc->setLogContext();
+  $tz = $tz->new if (!ref($tz));
+  return $tz->tokenize_docs([$doc],1) && $doc;
+}
+
+## $doc_or_undef = $tz->tokenize_chunked($doc,$njobs)
+## + override for DTA::TokWrap::Processor::tokenize::tokenize_chunked()
+## + splits $doc into (at least) $njobs chunks at $SB$ hints and sends up to max($njobs,$tz->{jobs}) requests
+##   at once over persistent connections, rather than forking a new client for each chunk
+sub tokenize_chunked {
+  my ($tz,$doc,$njobs) = @_;
+  $tz = $tz->new if (!ref($tz));
+  $njobs ||= 1;
+  local $tz->{jobs} = $njobs if ($njobs > ($tz->{jobs}||1));
+  return $tz->tokenize_docs([$doc],$njobs) && $doc;
+}
+
+## $id = $tz->cache_id()
+## + override for DTA::TokWrap::Processor::tokenize::cache_id(): ignores transport options
+sub cache_id {
+  my $tz = shift;
+  return $tz->SUPER::cache_id() if (!ref($tz));
+  local @$tz{qw(timeout keepAlive gzip retries retryDelay jobs maxChunk)} = qw();
+  return $tz->SUPER::cache_id();
+}
 
-  ##-- log, stamp
+## $bool = $tz->tokenize_batch(@docs)
+## + tokenizes all documents in @docs, sending up to $tz->{jobs} requests (chunks of the same or of different documents) at once
+## + sets %$doc keys as for tokenize() for each $doc in @docs
+sub tokenize_batch {
+  my ($tz,@docs) = @_;
   $tz = $tz->new if (!ref($tz));
-  $tz->vlog($tz->{traceLevel},"tokenize()");
-  $doc->{tokenize0_stamp0} = timestamp();
+  return $tz->tokenize_docs(\@docs,1);
+}
+
+## $bool = $tz->tokenize_docs(\@docs,$nsplit)
+## + guts for tokenize(), tokenize_chunked(), tokenize_batch()
+## + splits each document into at least $nsplit chunks (if $nsplit > 1) and at most $tz->{maxChunk} bytes per chunk (if possible)
+sub tokenize_docs {
+  my ($tz,$docs,$nsplit) = @_;
 
   ##-- sanity check(s)
   $tz->logconfess("tokenize(): no LWP::UserAgent (ua) defined")
@@ -90,29 +143,217 @@ sub tokenize {
     if (!$tz->{serverurl});
   $tz->logconfess("tokenize(): no query paramater (txtparm) defined")
     if (!$tz->{txtparam});
-  $tz->logconfess("tokenize(): no .txt file defined")
-    if (!defined($doc->{txtfile}));
-  $tz->logconfess("tokenize(): .txt file '$doc->{txtfile}' not readable")
-    if (!-r $doc->{txtfile});
-
-  ##-- post the tokenization request
-  $tz->vlog($tz->{traceLevel},"tokenize(): url=$tz->{serverurl}?$tz->{txtparam}=...");
-  $doc->{tokdata0} = '';
-  slurp_file($doc->{txtfile},\$doc->{txtdata}) if (!defined($doc->{txtdata}));
+
+  ##-- split documents into request chunks
+  my (@texts,@parts,$doc,@cuts,$i);
+  foreach $doc (@$docs) {
+    $doc->setLogContext();
+    $tz->vlog($tz->{traceLevel},"tokenize()");
+    $doc->{tokenize0_stamp0} = timestamp();
+    if (!defined($doc->{txtdata})) {
+      $tz->logconfess("tokenize(): no .txt file defined")
+	if (!defined($doc->{txtfile}));
+      $tz->logconfess("tokenize(): .txt file '$doc->{txtfile}' not readable")
+	if (!-r $doc->{txtfile});
+      slurp_file($doc->{txtfile},\$doc->{txtdata});
+    }
+    @cuts = $tz->chunk_cuts(\$doc->{txtdata},$nsplit);
+    if (@cuts <= 2) {
+      push(@parts, [$doc, [scalar(@texts), 0]]);
+      push(@texts, \$doc->{txtdata});
+      next;
+    }
+    $tz->vlog($tz->{traceLevel},"tokenize(): split into ".(scalar(@cuts)-1)." chunk(s)");
+    push(@parts, [$doc, map {[scalar(@texts)+$_, $cuts[$_]]} (0..($#cuts-1))]);
+    push(@texts, map { my $chunk=substr($doc->{txtdata}, $cuts[$_], $cuts[$_+1]-$cuts[$_]); \$chunk } (0..($#cuts-1)));
+  }
+
+  ##-- post
+  $tz->vlog($tz->{traceLevel},"tokenize(): url=$tz->{serverurl}?$tz->{txtparam}=... (".scalar(@texts)." request(s))");
+  my $results = $tz->post_all(\@texts);
+
+  ##-- finalize
+  my ($part,$chunk);
+  foreach $part (@parts) {
+    ($doc,my @chunks) = @$part;
+    $doc->{tokdata0} = '';
+    DTA::TokWrap::Processor::tokenize::tokdata_append(\$doc->{tokdata0}, $results->[$_->[0]], $_->[1]) foreach (@chunks);
+    $doc->{ntoks} = $tz->nTokens(\$doc->{tokdata0});
+    $doc->{tokfile0_stamp} = $doc->{tokenize0_stamp} = $doc->{tokdata0_stamp} = timestamp(); ##-- stamp
+  }
+  return 1;
+}
+
+##==============================================================================
+## Methods: low-level
+
+## @cuts = $tz->chunk_cuts(\$txtbuf, $nsplit)
+## + returns chunk boundaries (0, ..., length($txtbuf)) immediately after $SB$ hints:
+##   at least $nsplit chunks if $nsplit > 1 (see DTA::TokWrap::Processor::tokenize::sb_cuts()),
+##   and at most $tz->{maxChunk} bytes per chunk if $tz->{maxChunk} > 0 and suitable hints exist
+sub chunk_cuts {
+  my ($tz,$txtbufr,$nsplit) = @_;
+  my $txtlen = length($$txtbufr);
+  my @cuts0  = (0,$txtlen);
+  if (($nsplit||1) > 1) {
+    my $chunksize = $txtlen / $nsplit;
+    $chunksize = $DTA::TokWrap::Processor::tokenize::CHUNK_MIN if ($chunksize < $DTA::TokWrap::Processor::tokenize::CHUNK_MIN);
+    @cuts0 = DTA::TokWrap::Processor::tokenize::sb_cuts($txtbufr, $chunksize);
+  }
+  my $max = $tz->{maxChunk} || 0;
+  return @cuts0 if ($max <= 4);
+
+  my @cuts = (0);
+  my ($i,$end,$sbpos);
+  for ($i=1; $i <= $#cuts0; ++$i) {
+    $end = $cuts0[$i];
+    while ($end - $cuts[$#cuts] > $max) {
+      ##-- last $SB$ ending within $max bytes, else first $SB$ after that (oversized chunk)
+      $sbpos = rindex($$txtbufr, '$SB$', $cuts[$#cuts]+$max-4);
+      $sbpos = index($$txtbufr, '$SB$', $cuts[$#cuts]+$max) if ($sbpos < $cuts[$#cuts]);
+      last if ($sbpos < 0 || $sbpos+4 >= $end);
+      push(@cuts, $sbpos+4);
+    }
+    push(@cuts, $end);
+  }
+  return @cuts;
+}
+
+## $req = $tz->request(\$txt)
+## + returns an HTTP::Request for tokenizing \$txt
+sub request {
+  my ($tz,$txtr) = @_;
   ##
   ## Wed, 15 May 2013 10:39:23 +0200 moocow
   ## + use multipart/form-data to avoid implicit LF->CR+LF conversion by LWP::UserAgent (HTTP::Request::Common::POST() v6.03 / debian wheezy)
   ## + fixes goofy byte-offset problems using HTTP tokenizer
-  my $rsp = $tz->{ua}->post($tz->{serverurl}, { $tz->{txtparam}=>$doc->{txtdata} }, 'Content-Type'=>'multipart/form-data');
-  $tz->vlog($tz->{traceLevel},"tokenize(): response: ", $rsp ? $rsp->status_line : '(no response)');
+  my $req = HTTP::Request::Common::POST($tz->{serverurl}, { $tz->{txtparam}=>$$txtr }, 'Content-Type'=>'multipart/form-data');
+  if ($tz->{gzip}) {
+    my $gz = '';
+    IO::Compress::Gzip::gzip(\ $req->content => \$gz)
+	or $tz->logconfess("request(): gzip failed: $IO::Compress::Gzip::GzipError");
+    $req->content($gz);
+    $req->header('Content-Encoding'=>'gzip');
+    $req->header('Content-Length'=>length($gz));
+  }
+  return $req;
+}
+
+## \$tokdata = $tz->post(\$txt)
+## + sends a single tokenization request for \$txt, retrying up to $tz->{retries} times with exponential backoff
+## + dies on failure
+sub post {
+  my ($tz,$txtr) = @_;
+  my $req   = $tz->request($txtr);
+  my $delay = $tz->{retryDelay} || 0;
+  my ($rsp,$try,$wait);
+  for ($try=0; 1; ++$try) {
+    $rsp = $tz->{ua}->request($req);
+    $tz->vlog($tz->{traceLevel},"tokenize(): response: ", $rsp ? $rsp->status_line : '(no response)');
+    last if ($rsp && $rsp->is_success);
+    last if ($try >= ($tz->{retries}||0) || ($rsp && $rsp->code !~ /^(?:408|429|5[0-9][0-9])$/));
+    $wait = ($rsp && ($rsp->header('Retry-After')||'') =~ /^([0-9]+)$/ ? $1 : $delay);
+    $tz->logwarn("tokenize(): request to $tz->{serverurl} failed (", ($rsp ? $rsp->status_line : 'no response'), "); retrying in ${wait}s");
+    Time::HiRes::sleep($wait) if ($wait > 0);
+    $delay *= 2;
+  }
   $tz->logconfess("tokenize(): error from server $tz->{serverurl}: ", ($rsp ? $rsp->as_string : '(no response)'))
     if (!$rsp || !$rsp->is_success);
+  return \ $rsp->decoded_content(charset=>'none');
+}
 
-  ##-- finalize
-  $doc->{tokdata0} = $rsp->content;
-  $doc->{ntoks} = $tz->nTokens(\$doc->{tokdata0});
-  $doc->{tokfile0_stamp} = $doc->{tokenize0_stamp} = $doc->{tokdata0_stamp} = timestamp(); ##-- stamp
-  return $doc;
+## \@tokdatarefs = $tz->post_all(\@txtrefs)
+## + posts all requests in @txtrefs, with up to $tz->{jobs} requests in flight
+## + concurrent requests are sent by forked workers, each with its own persistent connection(s),
+##   which are assigned the next pending request as soon as they become idle
+## + dies if any request fails
+sub post_all {
+  my ($tz,$txtrefs) = @_;
+  my $njobs = $tz->{jobs} || 1;
+  $njobs = @$txtrefs if ($njobs > @$txtrefs);
+  return [map {$tz->post($_)} @$txtrefs] if ($njobs <= 1);
+
+  ##-- spawn workers
+  my $tmpdir = File::Temp::tempdir("dtatw_http_XXXXX", TMPDIR=>1, CLEANUP=>1);
+  my ($rep_r,$rep_w);
+  pipe($rep_r,$rep_w) or $tz->logconfess("post_all(): pipe() failed: $!");
+  my (@kids,$kid,$i);
+  foreach $i (0..($njobs-1)) {
+    my ($cmd_r,$cmd_w);
+    pipe($cmd_r,$cmd_w) or $tz->logconfess("post_all(): pipe() failed: $!");
+    my $pid = fork();
+    if (!defined($pid)) {
+      $tz->logwarn("post_all(): fork() failed: $!");
+      last;
+    }
+    elsif ($pid == 0) {
+      ##-- child: fresh connection cache; post each request index read from $cmd_r, then exit without destructors
+      close($_) foreach ($rep_r, $cmd_w, map {$_->{cmd}} @kids);
+      $tz->{ua}->conn_cache({total_capacity=>$tz->{keepAlive}}) if ($tz->{keepAlive});
+      $rep_w->autoflush(1);
+      while (defined(my $j = <$cmd_r>)) {
+	chomp($j);
+	my $rc = eval { ref2file($tz->post($txtrefs->[$j]), "$tmpdir/$j.t") };
+	print STDERR $@ if ($@);
+	syswrite($rep_w, "$i $j ".($rc ? 1 : 0)."\n");
+      }
+      POSIX::_exit(0);
+    }
+    close($cmd_r);
+    $cmd_w->autoflush(1);
+    push(@kids, {pid=>$pid, cmd=>$cmd_w, job=>undef});
+  }
+  close($rep_w);
+  $tz->logconfess("post_all(): could not start any workers") if (!@kids);
+
+  ##-- dispatch: assign the next request to each idle worker
+  my @queue = (0..$#$txtrefs);
+  my $nfailed = 0;
+  my $assign = sub {
+    my $kid = shift;
+    if (@queue && !$nfailed) {
+      $kid->{job} = shift(@queue);
+      $kid->{cmd}->print($kid->{job}, "\n");
+    } else {
+      $kid->{job} = undef;
+      close($kid->{cmd}) if ($kid->{cmd}->opened);
+    }
+  };
+  $assign->($_) foreach (@kids);
+  ##-- responses: read with sysread() into our own buffer, since buffered readline() could swallow
+  ##   several responses at once, leaving $rep_r unreadable for select() while lines are still pending
+  my $sel = IO::Select->new($rep_r);
+  my ($buf,$nread,$ki,$j,$ok) = ('');
+  while (grep {defined($_->{job})} @kids) {
+    if ($sel->can_read(1)) {
+      $nread = sysread($rep_r, $buf, 4096, length($buf));
+      last if (!$nread);
+      while ($buf =~ s/^([^\n]*)\n//) {
+	($ki,$j,$ok) = split(' ',$1);
+	++$nfailed if (!$ok);
+	$assign->($kids[$ki]);
+      }
+    }
+    else {
+      ##-- check for workers which died with a request in flight
+      foreach $kid (grep {defined($_->{job})} @kids) {
+	next if (waitpid($kid->{pid}, WNOHANG) != $kid->{pid});
+	$tz->logwarn("post_all(): worker $kid->{pid} died with status $?");
+	$kid->{pid} = undef;
+	$kid->{job} = undef;
+	++$nfailed;
+      }
+    }
+  }
+  $nfailed += grep {defined($_->{job})} @kids;
+  close($_->{cmd}) foreach (grep {$_->{cmd}->opened} @kids);
+  waitpid($_->{pid},0) foreach (grep {defined($_->{pid})} @kids);
+  close($rep_r);
+
+  ##-- collect results
+  $tz->logconfess("post_all(): ", ($nfailed || @queue), " of ", scalar(@$txtrefs), " request(s) failed")
+    if ($nfailed || @queue);
+  return [map {slurp_file("$tmpdir/$_.t")} (0..$#$txtrefs)];
 }
 
 
@@ -143,6 +384,8 @@ DTA::TokWrap::Processor::tokenize::http - DTA tokenizer wrappers: http: external
  
  $tz = DTA::TokWrap::Processor::tokenize::http->new(%args);
  $doc_or_undef = $tz->tokenize($doc);
+ $doc_or_undef = $tz->tokenize_chunked($doc,$njobs);
+ $bool = $tz->tokenize_batch(@docs);
 
 =cut
 
@@ -155,6 +398,14 @@ DTA::TokWrap::Processor::tokenize::http - DTA tokenizer wrappers: http: external
 This class is currently just a wrapper for the band-aid CGI script
 at http://kaskade.dwds.de/~moocow/opensearch/tok-cgi.perl .
 
+Requests are sent over persistent (keep-alive) connections,
+optionally with gzip-compressed bodies,
+and are retried with exponential backoff on transport errors and
+HTTP 408, 429, and 5xx responses.
+Documents larger than C<maxChunk> bytes are split at C<$SB$> hints,
+and up to C<jobs> requests (chunks of one or more documents) are kept in flight at once
+by forked workers, each holding its own persistent connection.
+
 Most users should use the high-level
 L<DTA::TokWrap|DTA::TokWrap> wrapper class
 instead of using this module directly.
@@ -197,8 +448,17 @@ L<DTA::TokWrap::Processor::tokenize::http|DTA::TokWrap::Processor::tokenize::htt
  serverurl => $url,      ##-- server url (default='http://kaskade.dwds.de/~moocow/opensearch/tok-cgi.perl')
  txtparam  => $param,    ##-- text query parameter (default='t')
  timeout   => $secs,     ##-- user agent timeout (default=300)
+ keepAlive => $n,        ##-- max number of cached persistent connections per user agent (default=4; 0 disables keep-alive)
+ gzip      => $bool,     ##-- send gzip-compressed request bodies (Content-Encoding: gzip)? (default=0)
+ retries   => $n,        ##-- max number of retries for transport errors and HTTP 408, 429, 5xx (default=3)
+ retryDelay => $secs,    ##-- delay before first retry; doubled for each subsequent retry (default=1)
+ jobs      => $n,        ##-- max number of requests in flight (default=1)
+ maxChunk  => $bytes,    ##-- split request text at $SB$ hints into chunks of at most $bytes where possible (default=0: don't)
  ua => $ua,              ##-- low-level underlying LWP::UserAgent
 
+These options may be set from L<dta-tokwrap.perl|dta-tokwrap.perl>
+with e.g. C<-procopt jobs=4 -procopt maxChunk=1048576>.
+
 =item defaults
 
  %defaults = CLASS->defaults();
@@ -221,7 +481,56 @@ Static class-dependent defaults.
 
  $doc_or_undef = $CLASS_OR_OBJECT->tokenize($doc);
 
-See L<DTA::TokWrap::Processor::tokenize::http::tokenize::http()|DTA::TokWrap::Processor::tokenize::http/tokenize>.
+See L<DTA::TokWrap::Processor::tokenize::tokenize()|DTA::TokWrap::Processor::tokenize/tokenize>.
+Splits the document if it is larger than C<maxChunk> bytes.
+
+=item tokenize_chunked
+
+ $doc_or_undef = $tz->tokenize_chunked($doc,$njobs);
+
+Override for L<DTA::TokWrap::Processor::tokenize::tokenize_chunked()|DTA::TokWrap::Processor::tokenize/tokenize_chunked>
+(used for C<dta-tokwrap.perl -tokenize-jobs N>):
+splits $doc into at least $njobs chunks at C<$SB$> hints
+and keeps up to max($njobs,C<jobs>) requests in flight.
+
+=item cache_id
+
+ $id = $tz->cache_id();
+
+Override for L<DTA::TokWrap::Processor::tokenize::cache_id()|DTA::TokWrap::Processor::tokenize/cache_id>
+which ignores the transport options C<timeout>, C<keepAlive>, C<gzip>, C<retries>, C<retryDelay>, C<jobs>, and C<maxChunk>.
+
+=item tokenize_batch
+
+ $bool = $tz->tokenize_batch(@docs);
+
+Tokenizes all documents in @docs, keeping up to C<jobs> requests
+(chunks of the same or of different documents) in flight at once.
+Sets the same %$doc keys as L</tokenize> for each document.
+
+=item chunk_cuts
+
+ @cuts = $tz->chunk_cuts(\$txtbuf, $nsplit);
+
+Low-level: request chunk boundaries for $txtbuf.
+
+=item request
+
+ $req = $tz->request(\$txt);
+
+Low-level: returns an HTTP::Request for tokenizing $txt.
+
+=item post
+
+ \$tokdata = $tz->post(\$txt);
+
+Low-level: sends a single request with retries; dies on failure.
+
+=item post_all
+
+ \@tokdatarefs = $tz->post_all(\@txtrefs);
+
+Low-level: sends all requests in @txtrefs, with up to C<jobs> in flight; dies on failure.
 
 =back
 
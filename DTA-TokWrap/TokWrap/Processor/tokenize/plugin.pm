@@ -0,0 +1,329 @@
+## -*- Mode: CPerl -*-
+
+## File: DTA::TokWrap::Processor::tokenize::plugin.pm
+## Author: Bryan Jurish <moocow@cpan.org>
+## Descript: DTA tokenizer wrappers: in-process tokenizer plugins (dtatw-tokenize-plugin)
+
+package DTA::TokWrap::Processor::tokenize::plugin;
+
+use DTA::TokWrap::Version;
+use DTA::TokWrap::Base;
+use DTA::TokWrap::Utils qw(:progs :slurp :time);
+use DTA::TokWrap::Processor;
+use DTA::TokWrap::Processor::tokenize;
+use File::Spec;
+
+use Carp;
+use strict;
+
+##==============================================================================
+## Constants
+##==============================================================================
+our @ISA = qw(DTA::TokWrap::Processor::tokenize);
+
+## $HAVE_XS : true iff DTA::TokWrap::XS::TokPlugin (in-process plugin host) is available
+our $HAVE_XS = eval { require DTA::TokWrap::XS; DTA::TokWrap::XS::TokPlugin->can('new') } ? 1 : 0;
+
+##==============================================================================
+## Constructors etc.
+##==============================================================================
+
+## $tp = CLASS_OR_OBJ->new(%args)
+##  + %args:
+##    plugin => $plugin,          ##-- plugin NAME or shared object FILE (default='dummy')
+##    pluginOptions => \@opts,    ##-- "KEY=VALUE" plugin options (default=none)
+##    xs => $bool,                ##-- load plugin in-process via DTA::TokWrap::XS if available? (default=1)
+##    tokenize => $path,          ##-- path to dtatw-tokenize-plugin (default: search; used if !xs)
+##    inplace  => $bool,          ##-- prefer in-place programs and plugins for search?
+##  + low-level data:
+##    tp => $tokplugin,           ##-- DTA::TokWrap::XS::TokPlugin object (if xs)
+sub new { return $_[0]->DTA::TokWrap::Processor::new(@_[1..$#_]); }
+
+## %defaults = CLASS->defaults()
+sub defaults {
+  my $that = shift;
+  return (
+	  $that->DTA::TokWrap::Processor::defaults(),
+
+	  plugin=>'dummy',
+	  pluginOptions=>[],
+	  xs=>1,
+	  tokenize=>undef,
+	  inplace=>1,
+	 );
+}
+
+## $tp = $tp->init()
+sub init {
+  my $tp = shift;
+
+  ##-- search for in-place plugin
+  if ($tp->{inplace} && $tp->{plugin} !~ m{/}) {
+    foreach (map {"$_/dtatw-tokplugin-$tp->{plugin}.so"} qw(. ../src)) {
+      next if (!-e $_);
+      $tp->{plugin} = File::Spec->rel2abs($_);
+      last;
+    }
+  }
+
+  ##-- search for dtatw-tokenize-plugin program (unless we're using XS)
+  $tp->{xs} = 0 if (!$HAVE_XS);
+  if (!defined($tp->{tokenize}) && !$tp->{xs}) {
+    $tp->{tokenize} = path_prog('dtatw-tokenize-plugin',
+				prepend=>($tp->{inplace} ? ['.','../src'] : undef),
+				warnsub=>sub {$tp->logconfess(@_)},
+			       );
+  }
+
+  return $tp;
+}
+
+##==============================================================================
+## Methods
+##==============================================================================
+
+## $doc_or_undef = $CLASS_OR_OBJECT->tokenize($doc)
+## + $doc is a DTA::TokWrap::Document object
+## + %$doc keys:
+##    txtfile => $txtfile,    ##-- (input) serialized text file (if txtdata is undefined)
+##    txtdata => $txtdata,    ##-- (input) serialized text data (xs only)
+##    tokdata0 => $tokdata,   ##-- (output) tokenizer output data (string)
+##    tokenize0_stamp  => $f, ##-- (output) timestamp of operation end
+##    tokdata0_stamp => $f,   ##-- (output) timestamp of operation end
+sub tokenize {
+  my ($tp,$doc) = @_;
+  $doc->setLogContext();
+  $tp = $tp->new if (!ref($tp));
+
+  ##-- log, stamp
+  $tp->vlog($tp->{traceLevel},"tokenize()");
+  $doc->{tokenize0_stamp0} = timestamp();
+
+  if ($tp->{xs}) {
+    ##-- in-process plugin
+    my $txtbufr = \$doc->{txtdata};
+    if (!defined($$txtbufr)) {
+      $tp->logconfess("tokenize(): no .txt file defined")
+	if (!defined($doc->{txtfile}));
+      $txtbufr = slurp_file($doc->{txtfile});
+    }
+    $tp->{tp} //= eval { DTA::TokWrap::XS::TokPlugin->new($tp->{plugin}, @{$tp->{pluginOptions}||[]}) }
+      or $tp->logconfess("tokenize(): could not load tokenizer plugin '$tp->{plugin}': $@");
+    $doc->{tokdata0} = ("%% raw tokenizer output generated by ".__PACKAGE__
+			." using plugin ".$tp->{tp}->filename." (".$tp->{tp}->name." version ".$tp->{tp}->version.")\n");
+    $doc->{tokdata0} .= eval { $tp->{tp}->tokenize($$txtbufr) };
+    $tp->logconfess("tokenize(): $@") if ($@);
+  }
+  else {
+    ##-- external program
+    $tp->logconfess("tokenize(): no dtatw-tokenize-plugin program defined")
+      if (!$tp->{tokenize});
+    $tp->logconfess("tokenize(): no .txt file defined")
+      if (!defined($doc->{txtfile}));
+    $tp->logconfess("tokenize(): .txt file '$doc->{txtfile}' not readable")
+      if (!-r $doc->{txtfile});
+
+    my $cmd = join(' ', "'$tp->{tokenize}'", (map {"-o '$_'"} @{$tp->{pluginOptions}||[]}), "'$tp->{plugin}'", "'$doc->{txtfile}'");
+    $doc->{tokdata0} = '';
+    my $cmdfh = opencmd("$cmd |")
+      or $tp->logconfess("tokenize(): open failed for pipe ($cmd |): $!");
+    slurp_fh($cmdfh, \$doc->{tokdata0});
+    $cmdfh->close()
+      or $tp->logconfess("tokenize(): pipe ($cmd |) failed: ".($! || "exit status ".($? >> 8)));
+  }
+
+  ##-- finalize
+  $doc->{ntoks} = $tp->nTokens(\$doc->{tokdata0});
+  $doc->{tokfile0_stamp} = $doc->{tokenize0_stamp} = $doc->{tokdata0_stamp} = timestamp(); ##-- stamp
+  return $doc;
+}
+
+## $id = $tp->cache_id()
+## + override for DTA::TokWrap::Processor::tokenize::cache_id(): includes pluginOptions
+sub cache_id {
+  my $tp = shift;
+  return $tp->SUPER::cache_id() if (!ref($tp));
+  return join("\t", $tp->SUPER::cache_id(), map {"-o $_"} @{$tp->{pluginOptions}||[]});
+}
+
+
+1; ##-- be happy
+
+__END__
+##========================================================================
+## POD DOCUMENTATION, auto-generated by podextract.perl, edited
+
+##========================================================================
+## NAME
+=pod
+
+=head1 NAME
+
+DTA::TokWrap::Processor::tokenize::plugin - DTA tokenizer wrappers: in-process tokenizer plugins
+
+=cut
+
+##========================================================================
+## SYNOPSIS
+=pod
+
+=head1 SYNOPSIS
+
+ use DTA::TokWrap::Processor::tokenize::plugin;
+
+ $tp = DTA::TokWrap::Processor::tokenize::plugin->new(plugin=>'dummy', %args);
+ $doc_or_undef = $tp->tokenize($doc);
+
+=cut
+
+##========================================================================
+## DESCRIPTION
+=pod
+
+=head1 DESCRIPTION
+
+DTA::TokWrap::Processor::tokenize::plugin runs a tokenizer plugin:
+a shared object implementing the C ABI declared in F<dtatwTokPlugin.h>
+(installed as F<$(includedir)/dta-tokwrap/dtatwTokPlugin.h>).
+A plugin exports a single entry point C<dtatw_tokplugin()> returning a descriptor
+with C<init()>, C<tokenize()>, and C<free()> functions;
+C<tokenize()> reports each token (text, byte offset, byte length, analyses)
+and each end-of-sentence to host callbacks.
+
+If the optional L<DTA::TokWrap::XS|DTA::TokWrap::XS> module is installed,
+the plugin is loaded in-process with dlopen() and tokenizes C<$doc-E<gt>{txtdata}> directly,
+without a process boundary or a temporary F<.txt> file.
+Otherwise, the C<dtatw-tokenize-plugin> program is run on C<$doc-E<gt>{txtfile}>.
+Output is the same in both cases.
+
+The package builds a single plugin F<dtatw-tokplugin-dummy.so> (plugin name C<dummy>),
+which wraps the scanner of C<dtatw-tokenize-dummy> and produces identical output.
+
+Most users should use the high-level
+L<DTA::TokWrap|DTA::TokWrap> wrapper class
+instead of using this module directly.
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::plugin: Constants
+=pod
+
+=head2 Constants
+
+=over 4
+
+=item @ISA
+
+DTA::TokWrap::Processor::tokenize::plugin
+inherits from
+L<DTA::TokWrap::Processor::tokenize|DTA::TokWrap::Processor::tokenize>.
+
+=item $HAVE_XS
+
+True iff L<DTA::TokWrap::XS|DTA::TokWrap::XS> with DTA::TokWrap::XS::TokPlugin support could be loaded.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::plugin: Constructors etc.
+=pod
+
+=head2 Constructors etc.
+
+=over 4
+
+=item new
+
+ $tp = $CLASS_OR_OBJ->new(%args);
+
+Constructor.
+
+%args, %$tp:
+
+ plugin => $plugin,          ##-- plugin NAME or shared object FILE (default='dummy')
+ pluginOptions => \@opts,    ##-- "KEY=VALUE" plugin options (default=none)
+ xs => $bool,                ##-- load plugin in-process via DTA::TokWrap::XS if available? (default=1)
+ tokenize => $path,          ##-- path to dtatw-tokenize-plugin (default: search; used if !xs)
+ inplace  => $bool,          ##-- prefer in-place programs and plugins for search?
+
+A plugin NAME is resolved to the file F<dtatw-tokplugin-NAME.so>,
+searched for in F<.> and F<../src> if C<inplace> is true,
+then in the directories listed in the environment variable C<DTATW_PLUGIN_PATH> (colon-separated),
+and finally in the package library directory (F<$(libdir)/dta-tokwrap>).
+
+=item defaults
+
+ %defaults = CLASS->defaults();
+
+Static class-dependent defaults.
+
+=item init
+
+ $tp = $tp->init();
+
+Dynamic object-dependent defaults.
+
+=back
+
+=cut
+
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Processor::tokenize::plugin: Methods
+=pod
+
+=head2 Methods
+
+=over 4
+
+=item tokenize
+
+ $doc_or_undef = $CLASS_OR_OBJECT->tokenize($doc);
+
+See L<DTA::TokWrap::Processor::tokenize::tokenize()|DTA::TokWrap::Processor::tokenize/tokenize>.
+
+=item cache_id
+
+ $id = $tp->cache_id();
+
+Override for L<DTA::TokWrap::Processor::tokenize::cache_id()|DTA::TokWrap::Processor::tokenize/cache_id>
+which includes C<pluginOptions>.
+
+=back
+
+=cut
+
+##========================================================================
+## END POD DOCUMENTATION, auto-generated by podextract.perl
+
+##======================================================================
+## Footer
+##======================================================================
+=pod
+
+=head1 SEE ALSO
+
+L<DTA::TokWrap::Intro(3pm)|DTA::TokWrap::Intro>,
+L<dta-tokwrap.perl(1)|dta-tokwrap.perl>,
+L<DTA::TokWrap::XS(3pm)|DTA::TokWrap::XS>,
+...
+
+=cut
+
+=pod
+
+=head1 AUTHOR
+
+Bryan Jurish E<lt>moocow@cpan.orgE<gt>
+
+=head1 COPYRIGHT AND LICENSE
+
+Copyright (C) 2026 by Bryan Jurish
+
+This package is free software; you can redistribute it and/or modify
+it under the same terms as Perl itself, either Perl version 5.14.2 or,
+at your option, any later version of Perl 5 you may have available.
+
+=cut
@@ -15,6 +15,8 @@ use File::Basename qw(basename dirname);
 use File::Temp qw(tempfile);
 use Cwd; ##-- for abs_path()
 use IO::File;
+use POSIX qw();
+use Scalar::Util qw(looks_like_number);
 use Exporter;
 use Carp;
 use strict;
@@ -27,15 +29,16 @@ our @ISA = qw(Exporter DTA::TokWrap::Logger);
 our @EXPORT = qw();
 our %EXPORT_TAGS = (
 		    files => [qw(file_mtime file_is_newer  file_try_open abs_path str2file ref2file)],
-		    slurp => [qw(slurp_file slurp_fh tempbuf)],
-		    progs => ['path_prog','runcmd','runcmd_noout','opencmd','$TRACE_RUNCMD'],
+		    slurp => [qw(slurp_file slurp_fh tempbuf zfile_format zopen_file zcreate_file zspec_parse)],
+		    progs => ['path_prog','runcmd','runcmd_noout','opencmd','waitpid_any','$TRACE_RUNCMD'],
 		    libxml => [qw(libxml_parser)],
-		    xmlutils => [qw(xmlesc xmlesc_bytes)],
+		    xmlutils => [qw(xmlesc xmlesc_bytes xmlesc_text)],
 		    libxslt => [qw(xsl_stylesheet)],
 		    time => [qw(timestamp)],
 		    si => [qw(sistr)],
 		    numeric => [qw(sistr pctstr)],
 		    diff => [qw(gdiff2)],
+		    stats => [qw(stats_load stats_add)],
 		   );
 $EXPORT_TAGS{all} = [map {@$_} values(%EXPORT_TAGS)];
 our @EXPORT_OK = @{$EXPORT_TAGS{all}};
@@ -123,6 +126,25 @@ sub opencmd {
   return IO::File->new($cmd);
 }
 
+## ($pid,$status) = PACKAGE::waitpid_any(@pids)
+##  + blocks until one of the child processes @pids has exited, and returns its pid and wait status ($?)
+##  + unlike waitpid(-1,0), never reaps any other child of the calling process
+##  + returns ($pid,-1) for a $pid which is not (or no longer) a child of the calling process
+##  + returns (-1,-1) if @pids is empty
+sub waitpid_any {
+  my @pids = @_;
+  my ($pid,$rc);
+  while (@pids) {
+    foreach $pid (@pids) {
+      $rc = waitpid($pid, POSIX::WNOHANG());
+      return ($pid,$?) if ($rc == $pid);
+      return ($pid,-1) if ($rc < 0);
+    }
+    Time::HiRes::sleep(0.05);
+  }
+  return (-1,-1);
+}
+
 ##==============================================================================
 ## Utils: XML::LibXML
 ##==============================================================================
@@ -243,12 +265,132 @@ sub xmlesc_bytes {
   return $esc;
 }
 
+## $escaped_bytes = xmlesc_text($str)
+##  + like xmlesc_bytes(), but only escapes characters significant in XML character data
+##    ('&', '<', '>', and CR), so that newlines and tabs survive literally
+##  + output $escaped_bytes will be utf8-encoded bytes
+sub xmlesc_text {
+  my $esc = $_[0];
+  $esc =~ s|\&|\&amp;|sg;
+  $esc =~ s|\<|\&lt;|sg;
+  $esc =~ s|\>|\&gt;|sg;
+  $esc =~ s|\r|\&#13;|sg;
+  utf8::encode($esc) if (utf8::is_utf8($esc));
+  return $esc;
+}
+
 ##==============================================================================
 ## Utils: I/O: slurp
 ##==============================================================================
 
+## %ZIO_PROGS
+##  + external decompressors for zopen_file(), keyed by format; values are ($prog,@args)
+our %ZIO_PROGS = (gzip=>[qw(gzip -dc)], zstd=>[qw(zstd -dcq)]);
+
+## $fmt = PACKAGE::zfile_format($filename)
+##  + returns compression format of $filename as detected by magic number: 'gzip', 'zstd', or '' for none
+##  + only regular files are inspected; returns '' for '-', pipes, and unreadable files
+sub zfile_format {
+  my $file = shift;
+  return '' if ($file eq '-' || !-f $file);
+  my $fh = IO::File->new("<$file") or return '';
+  $fh->binmode();
+  my $magic = '';
+  $fh->read($magic,4);
+  $fh->close();
+  return ($magic =~ /^\x{1f}\x{8b}/ ? 'gzip'
+	  : ($magic eq "\x{28}\x{b5}\x{2f}\x{fd}" ? 'zstd'
+	     : ''));
+}
+
+## $fh_or_undef = PACKAGE::zopen_file($filename)
+##  + opens $filename for binary reading, transparently decompressing gzip and zstd input
+##  + compression is detected by magic number (regular files only; other files are opened as-is)
+##  + compressed input is read from a `gzip -dc` or `zstd -dcq` child process (see %ZIO_PROGS),
+##    so decompression runs in parallel with the caller; gzip falls back to IO::Uncompress::Gunzip
+##  + returns undef on open failure with $! set; close() of the returned handle is false if decompression failed
+sub zopen_file {
+  my $file = shift;
+  my $fmt  = zfile_format($file);
+  if (!$fmt) {
+    my $fh = IO::File->new("<$file") or return undef;
+    $fh->binmode();
+    return $fh;
+  }
+
+  my ($prog,@args) = @{$ZIO_PROGS{$fmt}};
+  my $progpath = path_prog($prog);
+  if (!$progpath && $fmt eq 'gzip') {
+    require IO::Uncompress::Gunzip;
+    return IO::Uncompress::Gunzip->new($file, MultiStream=>1, Transparent=>0);
+  }
+  confess(__PACKAGE__, "::zopen_file(): no '$prog' program found for $fmt-compressed file '$file'") if (!$progpath);
+  __PACKAGE__->vlog($TRACE_RUNCMD,"zopen_file(): ", join(' ', $progpath, @args, '--', $file)) if ($TRACE_RUNCMD);
+  open(my $fh, '-|', $progpath, @args, '--', $file) or return undef;
+  binmode($fh);
+  return $fh;
+}
+
+## %ZIO_WPROGS
+##  + external compressors for zcreate_file(), keyed by format; values are ($prog,@args)
+our %ZIO_WPROGS = (gzip=>[qw(gzip -c)], zstd=>[qw(zstd -cq)]);
+
+## ($fmt,$level) = PACKAGE::zspec_parse($spec)
+##  + parses a compression specification "FORMAT[:LEVEL]" as for dtatw-mkindex --compress=SPEC
+##  + FORMAT is one of 'zstd', 'gzip', or 'none'; returns $fmt='' for no compression
+##  + confess()es on unknown FORMAT
+sub zspec_parse {
+  my ($fmt,$level) = split(/:/, ($_[0]//''), 2);
+  $fmt = lc($fmt//'');
+  $fmt = '' if ($fmt eq 'none' || $fmt eq 'raw');
+  $fmt = 'gzip' if ($fmt eq 'gz');
+  $fmt = 'zstd' if ($fmt eq 'zst');
+  confess(__PACKAGE__, "::zspec_parse(): unknown compression format in '$_[0]' (expected one of zstd, gzip, none)")
+    if ($fmt ne '' && !exists($ZIO_WPROGS{$fmt}));
+  return ($fmt, (defined($level) && $level ne '' ? $level : undef));
+}
+
+## $fh_or_undef = PACKAGE::zcreate_file($filename,$spec)
+##  + opens $filename for binary writing, compressing output according to $spec (see zspec_parse())
+##  + compressed output is written by a `gzip -c` or `zstd -cq` child process (see %ZIO_WPROGS);
+##    gzip falls back to IO::Compress::Gzip
+##  + returns undef on open failure with $! set; close() of the returned handle is false if compression failed
+sub zcreate_file {
+  my ($file,$spec) = @_;
+  my ($fmt,$level) = zspec_parse($spec);
+  if ($fmt eq '') {
+    my $fh = IO::File->new(">$file") or return undef;
+    $fh->binmode();
+    return $fh;
+  }
+
+  my ($prog,@args) = @{$ZIO_WPROGS{$fmt}};
+  my $progpath = path_prog($prog);
+  if (!$progpath && $fmt eq 'gzip') {
+    require IO::Compress::Gzip;
+    return IO::Compress::Gzip->new($file, (defined($level) ? (-Level=>$level) : qw()));
+  }
+  confess(__PACKAGE__, "::zcreate_file(): no '$prog' program found for $fmt-compressed file '$file'") if (!$progpath);
+  push(@args, "-$level") if (defined($level));
+  __PACKAGE__->vlog($TRACE_RUNCMD,"zcreate_file(): ", join(' ', $progpath, @args), " > $file") if ($TRACE_RUNCMD);
+
+  my $outfh = IO::File->new(">$file") or return undef;
+  my $pid = open(my $fh, '|-');
+  return undef if (!defined($pid));
+  if (!$pid) {
+    ##-- child: compress STDIN to $file
+    open(STDOUT, '>&', $outfh) or POSIX::_exit(126);
+    { exec($progpath, @args); }
+    POSIX::_exit(127);
+  }
+  $outfh->close();
+  binmode($fh);
+  return $fh;
+}
+
 ## \$txtbuf = PACKAGE::slurp_file($filename_or_fh)
 ## \$txtbuf = PACKAGE::slurp_file($filename_or_fh,\$txtbuf)
+##  + compressed files are decompressed transparently (see zopen_file())
 BEGIN { *slurp_fh = \&slurp_file; }
 sub slurp_file {
   my ($file,$bufr) = @_;
@@ -258,13 +400,15 @@ sub slurp_file {
   }
   my $fh = $file;
   if (!ref($file)) {
-    $fh = IO::File->new("<$file")
+    $fh = zopen_file($file)
       or confess(__PACKAGE__, "::slurp_file(): open failed for file '$file': $!");
-    $fh->binmode();
   }
   local $/=undef;
   $$bufr = <$fh>;
-  $fh->close if (!ref($file));
+  if (!ref($file)) {
+    $fh->close()
+      or confess(__PACKAGE__, "::slurp_file(): read failed for file '$file': ", ($? ? ("decompressor exit status ".($? >> 8)) : $!));
+  }
   return $bufr;
 }
 
@@ -443,6 +587,41 @@ sub pctstr {
   return sprintf("%d %s (%.2f%%)", $n, $label, ($total==0 ? 'nan' : (100.0*$n/$total)));
 }
 
+##==============================================================================
+## Utils: C program statistics
+##==============================================================================
+
+## \%stats_or_undef = stats_load($jsonfile)
+##  + loads JSON statistics as written by the --stats=FILE option of the dtatw-* C programs
+sub stats_load {
+  my $file = shift;
+  require JSON::PP;
+  return eval { JSON::PP::decode_json(${slurp_file($file)}) };
+}
+
+## \%dst = stats_add(\%dst, \%src)
+##  + recursively adds numeric values in \%src to \%dst
+##  + keys matching /^max/ are merged by maximum; non-numeric values are copied
+sub stats_add {
+  my ($dst,$src) = @_;
+  $dst = {} if (!defined($dst));
+  my ($key,$val);
+  while (($key,$val)=each(%$src)) {
+    if (ref($val) eq 'HASH') {
+      stats_add(($dst->{$key} //= {}), $val);
+    }
+    elsif (!looks_like_number($val)) {
+      $dst->{$key} = $val;
+    }
+    elsif ($key =~ /^max/) {
+      $dst->{$key} = $val if (!defined($dst->{$key}) || $dst->{$key} < $val);
+    }
+    else {
+      $dst->{$key} += $val;
+    }
+  }
+  return $dst;
+}
 
 ##==============================================================================
 ## Utils: Misc
@@ -582,6 +761,16 @@ Known %opts:
 Just a wrapper for system() with optional logging
 via L<DTA::TokWrap::Logger|DTA::TokWrap::Logger>.
 
+=item waitpid_any
+
+ ($pid,$status) = DTA::TokWrap::Utils::waitpid_any(@pids);
+
+Blocks until one of the child processes @pids has exited,
+and returns its pid and wait status ($?).
+Unlike C<waitpid(-1,0)>, never reaps any other child process of the caller.
+Returns ($pid,-1) for a $pid which is not a child of the caller,
+and (-1,-1) if @pids is empty.
+
 =back
 
 =cut
@@ -668,6 +857,50 @@ The following are exported by the C<:slurp> tag:
  \$txtbuf = DTA::TokWrap::Utils::slurp_file($filename_or_fh,\$txtbuf)
 
 Slurp an entire file into a string.
+If $filename_or_fh is a filename, gzip- and zstd-compressed files are decompressed transparently
+(see L<zopen_file|/zopen_file>).
+
+=item zfile_format
+
+ $fmt = DTA::TokWrap::Utils::zfile_format($filename);
+
+Returns the compression format of $filename as detected by magic number:
+C<'gzip'>, C<'zstd'>, or the empty string for uncompressed files.
+Only regular files are inspected.
+
+=item zopen_file
+
+ $fh_or_undef = DTA::TokWrap::Utils::zopen_file($filename);
+
+Open $filename for binary reading, transparently decompressing gzip and zstd input.
+Compression is detected by magic number for regular files.
+Compressed input is read from an external decompressor child process
+(C<gzip -dc> or C<zstd -dcq>, see C<%ZIO_PROGS>), so decompression runs in parallel with the caller;
+if no C<gzip> program is found, L<IO::Uncompress::Gunzip|IO::Uncompress::Gunzip> is used instead.
+Returns undef on open failure.  C<close()> on the returned handle returns false if decompression failed.
+
+=item zspec_parse
+
+ ($fmt,$level) = DTA::TokWrap::Utils::zspec_parse($spec);
+
+Parse a compression specification C<FORMAT[:LEVEL]> as accepted by the C<--compress=SPEC>
+option of the F<dtatw-mkindex> and F<dtatw-tok2xml> programs,
+where FORMAT is one of C<zstd>, C<gzip>, or C<none>.
+Returns $fmt='' if no compression was requested,
+and $level=undef if no LEVEL was specified.
+
+=item zcreate_file
+
+ $fh_or_undef = DTA::TokWrap::Utils::zcreate_file($filename,$spec);
+
+Open $filename for binary writing, compressing output according to $spec
+(see L<zspec_parse|/zspec_parse>).
+Compressed output is written by an external compressor child process
+(C<gzip -c> or C<zstd -cq>, see C<%ZIO_WPROGS>);
+if no C<gzip> program is found, L<IO::Compress::Gzip|IO::Compress::Gzip> is used instead.
+Output written this way is readable by L<zopen_file|/zopen_file> and by the C utilities,
+but unlike that of the C utilities, zstd output carries no seek table.
+Returns undef on open failure.  C<close()> on the returned handle returns false if compression failed.
 
 =back
 
@@ -776,6 +1009,36 @@ Returns an SI string for numeric value $val.
 
 =cut
 
+##----------------------------------------------------------------
+## DESCRIPTION: DTA::TokWrap::Utils: Utils: C program statistics
+=pod
+
+=head2 Utils: C program statistics
+
+The following are exported by the C<:stats> tag:
+
+=over 4
+
+=item stats_load
+
+ \%stats_or_undef = stats_load($jsonfile);
+
+Loads JSON statistics as written by the C<--stats=FILE> option of the C<dtatw-*> C programs,
+e.g. C<dtatw-mkindex>, C<dtatw-b2xb>, C<dtatw-tok2xml>, and C<dtatw-txml2so>.
+Returns undef (and sets C<$@>) on error.
+
+=item stats_add
+
+ \%dst = stats_add(\%dst, \%src);
+
+Recursively adds numeric values in \%src to \%dst.
+Keys matching C</^max/> (e.g. C<maxrss_kb>) are merged by maximum,
+and non-numeric values are simply copied.
+
+=back
+
+=cut
+
 ##========================================================================
 ## END POD DOCUMENTATION, auto-generated by podextract.perl
 =pod
@@ -0,0 +1,180 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use IO::Socket::INET;
+use IO::Uncompress::Gunzip qw();
+use File::Temp qw();
+use POSIX qw();
+use strict;
+
+BEGIN {
+  plan skip_all => 'LWP::UserAgent not available'
+    if (!eval { require LWP::UserAgent; require HTTP::Request::Common; 1 });
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Processor::tokenize::http');
+}
+
+##======================================================================
+## stand-in tokenizer server
+
+## $tokdata = fake_tokenize($txt) : whitespace tokenizer, tokenizer output format
+sub fake_tokenize {
+  my $txt = shift;
+  my $out = "%% fake tokenizer\n";
+  $out .= "$1\t".($-[1])." ".length($1)."\n" while ($txt =~ /(\S+)/g);
+  return $out;
+}
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $logfile = "$tmpdir/server.log";
+my $srv = IO::Socket::INET->new(LocalAddr=>'127.0.0.1', LocalPort=>0, Listen=>16, ReuseAddr=>1)
+  or die("could not create server socket: $!");
+my $url = "http://127.0.0.1:".$srv->sockport."/tokenize";
+
+sub srv_log {
+  open(my $fh, '>>', $logfile) or die("open failed for $logfile: $!");
+  print $fh @_, "\n";
+  close($fh);
+}
+
+my $nsync = 0;
+sub srv_handle {
+  my $conn = shift;
+  srv_log("conn");
+  my ($line,%hdr,$body,$txt,$status,$out);
+  while (defined($line = <$conn>)) {
+    %hdr = qw();
+    while (defined(my $h = <$conn>)) {
+      last if ($h =~ /^\r?\n\z/);
+      $hdr{lc($1)} = $2 if ($h =~ /^([^:]+):\s*(.*?)\r?\n\z/);
+    }
+    $body = '';
+    read($conn, $body, $hdr{'content-length'}) if ($hdr{'content-length'});
+    if (($hdr{'content-encoding'}||'') eq 'gzip') {
+      my $raw = $body;
+      IO::Uncompress::Gunzip::gunzip(\$raw => \$body);
+      srv_log("gzip");
+    }
+    ($txt) = ($body =~ /name="t"[^\n]*\r?\n\r?\n(.*)\r\n--[^\r\n]*--\r?\n?\z/s);
+    $txt //= '';
+    if ($txt =~ /SYNC([0-9]+)/) {
+      ##-- barrier: hold the response until $1 such requests have arrived, so that they all finish together
+      my $n = $1;
+      open(my $fh, '>', "$tmpdir/sync.$$.".(++$nsync)); close($fh);
+      for (my $i=0; $i < 1000 && glob("$tmpdir/sync.*") < $n; ++$i) {
+	select(undef,undef,undef,0.01);
+      }
+      srv_log("sync");
+    }
+    if ($txt =~ /RETRYME/ && !-e "$tmpdir/retried") {
+      open(my $fh, '>', "$tmpdir/retried"); close($fh);
+      ($status,$out) = ("503 Service Unavailable", "try again\n");
+      srv_log("503");
+    } else {
+      ($status,$out) = ("200 OK", fake_tokenize($txt));
+      srv_log("req");
+    }
+    print $conn ("HTTP/1.1 $status\r\n",
+		 "Content-Type: text/plain\r\n",
+		 "Content-Length: ", length($out), "\r\n",
+		 "\r\n",
+		 $out);
+    $conn->flush();
+  }
+}
+
+my $srvpid = fork();
+die("fork failed: $!") if (!defined($srvpid));
+if ($srvpid == 0) {
+  $SIG{CHLD} = 'IGNORE';
+  while (my $conn = $srv->accept()) {
+    my $pid = fork();
+    if (defined($pid) && $pid == 0) {
+      srv_handle($conn);
+      POSIX::_exit(0);
+    }
+    close($conn);
+  }
+  POSIX::_exit(0);
+}
+close($srv);
+
+## %counts = srv_counts()
+sub srv_counts {
+  my %counts = qw();
+  open(my $fh, '<', $logfile) or return %counts;
+  chomp, ++$counts{$_} while (<$fh>);
+  return %counts;
+}
+sub srv_reset { unlink($logfile, glob("$tmpdir/sync.*")); }
+
+##======================================================================
+## tests
+
+my @txts = map {
+  my $i = $_;
+  join('', map {"w${i}_$_ ".($_ % 7 == 0 ? "\$SB\$\n" : '')} (1..(50*$i)))
+} (1..4);
+my @docs = map {DTA::TokWrap::Document->new(xmlfile=>"doc$_.xml", txtdata=>$txts[$_])} (0..$#txts);
+my $tz;
+
+##-- single document, single request
+srv_reset();
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0);
+ok($tz->tokenize($docs[0]), "tokenize: single");
+is($docs[0]{tokdata0}, fake_tokenize($txts[0]), "tokenize: single: output");
+is($docs[0]{ntoks}, scalar(() = $txts[0] =~ /\S+/g), "tokenize: single: ntoks");
+
+##-- oversized documents are split at $SB$, chunks sent concurrently (gzip)
+srv_reset();
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0, maxChunk=>256, jobs=>3, gzip=>1);
+ok($tz->tokenize($docs[3]), "tokenize: maxChunk");
+is($docs[3]{tokdata0}, fake_tokenize($txts[3]), "tokenize: maxChunk: output");
+my %counts = srv_counts();
+cmp_ok($counts{req}, '>', 1, "tokenize: maxChunk: split into multiple requests");
+is($counts{gzip}, $counts{req}, "tokenize: maxChunk: gzip request bodies");
+cmp_ok($counts{conn}, '<=', 3, "tokenize: maxChunk: at most 3 connections");
+
+##-- batch, serial: one persistent connection
+srv_reset();
+$_->{tokdata0} = undef foreach (@docs);
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0, maxChunk=>512, jobs=>1);
+ok($tz->tokenize_batch(@docs), "tokenize_batch: serial");
+is_deeply([map {$_->{tokdata0}} @docs], [map {fake_tokenize($_)} @txts], "tokenize_batch: serial: output");
+%counts = srv_counts();
+is($counts{conn}, 1, "tokenize_batch: serial: keep-alive");
+
+##-- batch, concurrent
+srv_reset();
+$_->{tokdata0} = undef foreach (@docs);
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0, maxChunk=>512, jobs=>4);
+ok($tz->tokenize_batch(@docs), "tokenize_batch: concurrent");
+is_deeply([map {$_->{tokdata0}} @docs], [map {fake_tokenize($_)} @txts], "tokenize_batch: concurrent: output");
+
+##-- batch, concurrent: all responses arrive at once (must not hang on buffered responses)
+srv_reset();
+my @sdocs = map {DTA::TokWrap::Document->new(xmlfile=>"sync$_.xml", txtdata=>"SYNC4 w$_ x$_\n")} (1..4);
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0, jobs=>4);
+my $rc = eval {
+  local $SIG{ALRM} = sub { die("timeout\n") };
+  alarm(30);
+  my $rc = $tz->tokenize_batch(@sdocs);
+  alarm(0);
+  $rc;
+};
+ok($rc, "tokenize_batch: simultaneous responses") or diag($@);
+is_deeply([map {$_->{tokdata0}} @sdocs], [map {fake_tokenize($_->{txtdata})} @sdocs], "tokenize_batch: simultaneous responses: output");
+%counts = srv_counts();
+is($counts{sync}, 4, "tokenize_batch: simultaneous responses: 4 requests");
+
+##-- retry on 503
+srv_reset();
+my $rdoc = DTA::TokWrap::Document->new(xmlfile=>"retry.xml", txtdata=>"RETRYME please\n");
+$tz = DTA::TokWrap::Processor::tokenize::http->new(serverurl=>$url, retryDelay=>0, retries=>2);
+ok($tz->tokenize($rdoc), "tokenize: retry");
+is($rdoc->{tokdata0}, fake_tokenize($rdoc->{txtdata}), "tokenize: retry: output");
+%counts = srv_counts();
+is($counts{503}, 1, "tokenize: retry: one 503 response");
+
+kill('TERM', $srvpid);
+waitpid($srvpid, 0);
+done_testing();
@@ -0,0 +1,60 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXSLT not available'
+    if (!eval { require XML::LibXML; require XML::LibXSLT; 1 });
+  plan skip_all => 'dtatw-txml2so not built'
+    if (!grep {-x "$_/dtatw-txml2so"} split(/:/,$ENV{PATH}));
+  use_ok('DTA::TokWrap::Processor::standoff::xsl');
+}
+
+##======================================================================
+## fixture: tokenizer output as XML
+
+my $txml = <<'EOX';
+<?xml version="1.0" encoding="UTF-8"?>
+<sentences xml:base="test1.xml">
+ <s xml:id="s1" pn="p1">
+  <w xml:id="w1" t="Hallo" b="0 5" c="c1 c2 c3 c4 c5" xb="10 5"><a>[$ABBREV]</a><a>foo &amp; bar</a></w>
+  <w xml:id="w2" t="Welt" b="6 4" c="c7 c8 c9 c10"><toka><a>[$WORD]</a></toka></w>
+  <w xml:id="w3" t="." b="10 1" c="c11"/>
+ </s>
+ <!-- comment -->
+ <s xml:id="s2" pn="p2">
+  <w xml:id="w4" t="&quot;Ja&lt;&quot;" b="12 5" c="c13 c14 c15 c16 c17"/>
+  <w xml:id="w5" t="&#x17f;o" b="18 3" c="c18 c19"><a>&#x17f;&lt;</a></w>
+ </s>
+</sentences>
+EOX
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $tfile  = "$tmpdir/test1.t.xml";
+open(my $fh, '>', $tfile) or die("open failed for $tfile: $!");
+print $fh $txml;
+close($fh);
+
+##======================================================================
+## dtatw-txml2so vs. XSL stylesheets
+
+my $sobase = 'test1.w.xml';
+is(system('dtatw-txml2so', $tfile, map({"$tmpdir/c.$_.xml"} qw(s w a)), 'test1.xml', $sobase), 0, 'dtatw-txml2so');
+
+my $xsl    = DTA::TokWrap::Processor::standoff::xsl->new();
+my $parser = XML::LibXML->new();
+my $xslt   = XML::LibXSLT->new();
+my $tdoc   = $parser->parse_string($txml);
+my %base   = (s=>$sobase, w=>'test1.xml', a=>$sobase);
+foreach my $X (qw(s w a)) {
+  my $method = "t2${X}_stylestr";
+  my $style  = $xslt->parse_stylesheet($parser->parse_string($xsl->$method()));
+  my $want   = $style->transform($tdoc, xmlbase=>"'$base{$X}'");
+  my $got    = $parser->parse_file("$tmpdir/c.$X.xml");
+  is($got->toStringC14N, $want->toStringC14N, "$X.xml identical to XSL output");
+}
+
+done_testing();
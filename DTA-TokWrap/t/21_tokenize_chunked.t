@@ -0,0 +1,57 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'dtatw-tokenize-dummy not built'
+    if (!grep {-x "$_/dtatw-tokenize-dummy"} split(/:/,$ENV{PATH}));
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Processor::tokenize::dummy');
+}
+
+##======================================================================
+## fixture: hinted .txt data
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $txt = join('', map {
+  "Satz $_ hat W\x{f6}rter, Zahlen wie ".($_*17)." und Abk. usw. am Ende. \$SB\$\n"
+  .($_ % 5 == 0 ? "Ein getrenn-\nter Satz ohne Hinweis\n" : '')
+} (1..400));
+utf8::encode($txt);
+my $txtfile = "$tmpdir/chunks.txt";
+open(my $fh, '>', $txtfile) or die("open failed for $txtfile: $!");
+print $fh $txt;
+close($fh);
+
+##======================================================================
+## tests
+
+local $DTA::TokWrap::Processor::tokenize::CHUNK_MIN = 1024;
+my $tz = DTA::TokWrap::Processor::tokenize::dummy->new();
+
+my $doc0 = DTA::TokWrap::Document->new(xmlfile=>"$tmpdir/chunks.xml", tmpdir=>$tmpdir, txtfile=>$txtfile);
+ok($tz->tokenize($doc0), "tokenize: serial");
+cmp_ok($doc0->{ntoks}, '>', 0, "tokenize: serial: ntoks");
+
+cmp_ok(scalar(DTA::TokWrap::Processor::tokenize::sb_cuts(\$txt, length($txt)/7)), '>=', 8, "sb_cuts: 7 chunks");
+
+foreach my $njobs (2,3,7) {
+  my $doc = DTA::TokWrap::Document->new(xmlfile=>"$tmpdir/chunks.xml", tmpdir=>$tmpdir, txtfile=>$txtfile);
+  ok($tz->tokenize_chunked($doc,$njobs), "tokenize_chunked: njobs=$njobs");
+  is($doc->{tokdata0}, $doc0->{tokdata0}, "tokenize_chunked: njobs=$njobs: output identical to serial");
+  is($doc->{ntoks}, $doc0->{ntoks}, "tokenize_chunked: njobs=$njobs: ntoks");
+}
+
+##-- no $SB$ hints: serial fallback
+my $doc1 = DTA::TokWrap::Document->new(xmlfile=>"$tmpdir/chunks.xml", tmpdir=>$tmpdir, txtdata=>"kein Hinweis hier\n");
+$doc1->{txtfile} = "$tmpdir/nohint.txt";
+open($fh, '>', $doc1->{txtfile}) or die("open failed for $doc1->{txtfile}: $!");
+print $fh $doc1->{txtdata};
+close($fh);
+ok($tz->tokenize_chunked($doc1,4), "tokenize_chunked: no hints");
+is(scalar(grep {!/^%%/ && /\S/} split(/\n/,$doc1->{tokdata0})), 3, "tokenize_chunked: no hints: serial fallback");
+
+done_testing();
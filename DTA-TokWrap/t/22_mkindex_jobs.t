@@ -0,0 +1,86 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'dtatw-mkindex not built'
+    if (!grep {-x "$_/dtatw-mkindex"} split(/:/,$ENV{PATH}));
+}
+
+##======================================================================
+## fixture: TEI-like document with <pb> split points
+
+## $xml = fixture_xml($npages)
+sub fixture_xml {
+  my $npages = shift;
+  my $xml = qq{<?xml version="1.0" encoding="UTF-8"?>\n}
+    .qq{<TEI xmlns="http://www.tei-c.org/ns/1.0"><teiHeader><title>Kopf &amp; <pb n="h"/>Titel</title></teiHeader>\n}
+    .qq{<text><body>\n};
+  my $cid = 0;
+  foreach my $pg (1..$npages) {
+    $xml .= qq{<pb facs="#f$pg" n="$pg"/>\n<div n="$pg"><p>};
+    foreach my $ln (1..6) {
+      my $txt = "Zeile $ln der Seite $pg mit W\x{f6}rtern &lt;&amp;&gt; und \x{17f}chrift";
+      if ($pg % 3 == 0) {
+        ##-- explicit <c> elements, some with bboxes
+        $txt =~ s{(&[a-z]+;|.)}{
+          ++$cid;
+          ($cid % 2
+           ? qq{<c xml:id="c$cid" ulx="$cid" uly="$pg" lrx="}.($cid+9).qq{" lry="}.($pg+20).qq{">$1</c>}
+           : qq{<c xml:id="c$cid">$1</c>})
+        }ge;
+      }
+      $xml .= $txt.($ln % 4 == 0 ? "<!-- note <pb/> -->" : '').($ln == 5 ? "<![CDATA[<pb/> raw]]>" : '')."<lb/>\n";
+    }
+    $xml .= qq{<note place="foot">Fu\x{df}note $pg</note>} if ($pg % 5 == 0);
+    $xml .= "</p></div>\n";
+  }
+  $xml .= "</body></text></TEI>\n";
+  utf8::encode($xml);
+  return $xml;
+}
+
+## $data = slurp($file)
+sub slurp {
+  local $/ = undef;
+  open(my $fh, '<:raw', $_[0]) or die("open failed for $_[0]: $!");
+  return <$fh>;
+}
+
+my $tmpdir  = File::Temp::tempdir(CLEANUP=>1);
+my $xmlfile = "$tmpdir/jobs.xml";
+open(my $fh, '>:raw', $xmlfile) or die("open failed for $xmlfile: $!");
+print $fh fixture_xml(40);
+close($fh);
+
+##======================================================================
+## tests
+
+## %out = mkindex($njobs, @opts)
+sub mkindex {
+  my ($njobs,@opts) = @_;
+  my $base = "$tmpdir/jobs.$njobs";
+  my $rc = system('dtatw-mkindex', "--stats=$base.json", @opts, $xmlfile, "$base.cx", "$base.sx", "$base.tx", $njobs);
+  my ($nchunks) = (slurp("$base.json") =~ /"chunks":(\d+)/);
+  return (rc=>$rc, nchunks=>$nchunks, map {($_=>slurp("$base.$_"))} qw(cx sx tx));
+}
+
+my %serial = mkindex(1);
+is($serial{rc}, 0, "mkindex: serial");
+cmp_ok(length($serial{$_}), '>', 0, "mkindex: serial: non-empty .$_") foreach (qw(cx sx tx));
+
+foreach my $njobs (2,3,8) {
+  my %par = mkindex($njobs);
+  is($par{rc}, 0, "mkindex: njobs=$njobs");
+  is($par{nchunks}, $njobs, "mkindex: njobs=$njobs: split into $njobs chunks");
+  ok($par{$_} eq $serial{$_}, "mkindex: njobs=$njobs: .$_ identical to serial") foreach (qw(cx sx tx));
+}
+
+my %sync = mkindex(4, '--sync-output');
+is($sync{rc}, 0, "mkindex: njobs=4 --sync-output");
+ok($sync{$_} eq $serial{$_}, "mkindex: njobs=4 --sync-output: .$_ identical to serial") foreach (qw(cx sx tx));
+
+done_testing();
@@ -0,0 +1,65 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our $scriptdir = "$FindBin::Bin/../../scripts";
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'dtatw-get-ddc-attrs.perl prerequisites not available'
+    if (!eval { require XML::LibXML; require XML::LibXSLT; require XML::Parser; require Unicruft; require Algorithm::BinarySearch::Vec; 1 });
+  foreach (qw(dtatw-get-ddc-attrs dtatw-mkindex dtatw-tokenize-dummy dtatw-tok2xml)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap');
+}
+
+##======================================================================
+## fixtures: generated documents, run through tei2txml
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $tw = DTA::TokWrap->new(tmpdir=>$tmpdir, outdir=>$tmpdir, keeptmp=>1, tokenizeClass=>'dummy');
+my @docs;
+foreach my $preset (qw(mixed ocr)) {
+  my $xmlfile = "$tmpdir/$preset.xml";
+  is(system("'$^X' '$scriptdir/dtatw-generate-bench.perl' -preset=$preset -size=48K > '$xmlfile'"), 0, "$preset: generate");
+  my $doc = $tw->open($xmlfile);
+  ok($doc && $doc->genKey('tei2txml'), "$preset: tei2txml");
+  push(@docs, $doc);
+}
+
+## \@w_attrs = w_attrs($ddcfile)
+##  + list of attribute hashes for all //w in $ddcfile
+sub w_attrs {
+  my $xdoc = XML::LibXML->new->parse_file($_[0]);
+  return [map { +{map {($_->nodeName=>$_->value)} $_->attributes} } $xdoc->findnodes('//w')];
+}
+
+##======================================================================
+## tests
+
+## C program refuses to silently drop //w/@u
+my $doc = $docs[0];
+isnt(system("dtatw-get-ddc-attrs -cx '$doc->{cxfile}' -sx '$doc->{sxfile}' -o /dev/null '$doc->{xtokfile}' 2>/dev/null"), 0,
+     "dtatw-get-ddc-attrs: requires -noxlit");
+
+my @perlinc = map {"-I$_"} grep {!ref($_)} @INC;
+foreach $doc (@docs) {
+  my $base = $doc->{outbase};
+  foreach my $opts ('', '-bbox -xpp', '-nopage -norend -ws') {
+    my @opts = ('-noxlit', split(' ',$opts));
+    my @io   = ('-cx'=>$doc->{cxfile}, '-sx'=>$doc->{sxfile});
+    is(system($^X, @perlinc, "$scriptdir/dtatw-get-ddc-attrs.perl", @opts, @io, '-o'=>"$tmpdir/$base.perl.xml", $doc->{xtokfile}),
+       0, "$base @opts: perl");
+    is(system('dtatw-get-ddc-attrs', @opts, @io, '-o'=>"$tmpdir/$base.c.xml", $doc->{xtokfile}),
+       0, "$base @opts: C");
+    my ($want,$got) = map {w_attrs("$tmpdir/$base.$_.xml")} qw(perl c);
+    cmp_ok(scalar(@$want), '>', 0, "$base @opts: non-empty");
+    is_deeply($got, $want, "$base @opts: //w attributes identical");
+  }
+}
+
+done_testing();
@@ -0,0 +1,85 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use IO::Socket::UNIX;
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXSLT not available'
+    if (!eval { require XML::LibXML; require XML::LibXSLT; 1 });
+  plan skip_all => 'dtatw-mkindex not built'
+    if (!grep {-x "$_/dtatw-mkindex"} split(/:/,$ENV{PATH}));
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Daemon');
+}
+
+##======================================================================
+## fixture
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $xmlfile = "$tmpdir/daemon.xml";
+open(my $fh, '>', $xmlfile) or die("open failed for $xmlfile: $!");
+print $fh (qq{<?xml version="1.0" encoding="UTF-8"?>\n}
+	   .qq{<TEI xmlns="http://www.tei-c.org/ns/1.0"><text><body>\n}
+	   .join('', map {qq{<pb n="$_"/>\n<p>Seite $_ mit ein paar W&#246;rtern.<lb/>\nUnd noch eine Zeile.</p>\n}} (1..5))
+	   .qq{</body></text></TEI>\n});
+close($fh);
+
+## @responses = request(@lines)
+sub request {
+  my $sock = IO::Socket::UNIX->new(Peer=>"$tmpdir/d.sock", Type=>SOCK_STREAM)
+    or die("could not connect to $tmpdir/d.sock: $!");
+  $sock->autoflush(1);
+  $sock->print(map {"$_\n"} @_);
+  $sock->shutdown(1);
+  my @rsp = map {chomp; [split(/\t/,$_,3)]} <$sock>;
+  $sock->close();
+  return @rsp;
+}
+
+##======================================================================
+## daemon
+
+my $pid = fork();
+die("fork failed: $!") if (!defined($pid));
+if ($pid == 0) {
+  my $tw = DTA::TokWrap->new(tmpdir=>$tmpdir, outdir=>$tmpdir, keeptmp=>1, tokenizeClass=>'dummy');
+  DTA::TokWrap::Daemon->new(tw=>$tw,
+			    socket=>"$tmpdir/d.sock",
+			    workers=>1,
+			    connRequests=>2,
+			    targets=>['mkindex'],
+			    allowOpts=>[@DTA::TokWrap::Daemon::DEFAULT_ALLOW_OPTS,'tmpdir'],
+			   )->run();
+  POSIX::_exit(0);
+}
+for (my $i=0; $i < 200 && !-S "$tmpdir/d.sock"; ++$i) { select(undef,undef,undef,0.05); }
+
+##======================================================================
+## tests
+
+ok(-S "$tmpdir/d.sock", "socket created");
+is((stat("$tmpdir/d.sock"))[2] & 07777, 0600, "socket mode 0600");
+
+mkdir("$tmpdir/req");
+my @rsp = request("$xmlfile\tmkindex\ttmpdir=$tmpdir/req\tkeeptmp=1");
+is(scalar(@rsp), 1, "allowed options: 1 response");
+is($rsp[0][0], 'OK', "allowed options: OK") or diag(join("\t",@{$rsp[0]||[]}));
+ok(-s "$tmpdir/req/daemon.cx", "allowed options: .cx file in requested tmpdir");
+
+@rsp = request("$xmlfile\tmkindex\toutdir=$tmpdir/req");
+is($rsp[0][0], 'ERROR', "disallowed option: ERROR");
+like($rsp[0][2], qr/\boutdir\b/, "disallowed option: message names the key");
+
+@rsp = request(map {"$xmlfile\tmkindex"} (1..3));
+is(scalar(@rsp), 2, "connRequests: connection closed after 2 requests");
+is(scalar(grep {$_->[0] eq 'OK'} @rsp), 2, "connRequests: answered requests OK");
+
+kill('TERM', $pid);
+waitpid($pid,0);
+is($?, 0, "daemon exit status");
+ok(!-e "$tmpdir/d.sock", "socket removed at shutdown");
+
+done_testing();
@@ -0,0 +1,115 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXSLT not available'
+    if (!eval { require XML::LibXML; require XML::LibXSLT; 1 });
+  plan skip_all => 'dtatw-tokenize-dummy not built'
+    if (!grep {-x "$_/dtatw-tokenize-dummy"} split(/:/,$ENV{PATH}));
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Pipeline');
+  use_ok('DTA::TokWrap::Processor::tokenize::dummy');
+}
+
+##======================================================================
+## batch tokenizer: logs the number of documents per tokenize_batch() call
+
+package DTA::TokWrap::Test::BatchTokenizer;
+our @ISA = qw(DTA::TokWrap::Processor::tokenize::dummy);
+sub tokenize_batch {
+  my ($tz,@docs) = @_;
+  open(my $fh, '>>', $tz->{batchlog}) or die("open failed for $tz->{batchlog}: $!");
+  print $fh scalar(@docs), "\n";
+  close($fh);
+  $tz->tokenize($_) or return 0 foreach (@docs);
+  return 1;
+}
+
+## crashing tokenizer: worker processes die on every document
+package DTA::TokWrap::Test::CrashTokenizer;
+our @ISA = qw(DTA::TokWrap::Processor::tokenize::dummy);
+sub tokenize { POSIX::_exit(1); }
+
+package main;
+use POSIX qw();
+
+##======================================================================
+## fixture: .txt files for the 'tokenize' stage
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my (@xmlfiles);
+foreach my $i (1..7) {
+  my $base = "$tmpdir/doc$i";
+  push(@xmlfiles, "$base.xml");
+  foreach (["$base.xml", qq{<?xml version="1.0"?>\n<TEI><text><p>Dokument $i</p></text></TEI>\n}],
+	   ["$base.txt", join('', map {"Satz $_ von Dokument $i hat ".($_*$i)." W\x{f6}rter. \$SB\$\n"} (1..(10*$i)))])
+    {
+      open(my $fh, '>:utf8', $_->[0]) or die("open failed for $_->[0]: $!");
+      print $fh $_->[1];
+      close($fh);
+    }
+}
+
+## \%base2t0 = tokenize_pipeline(%opts)
+##  + %opts: Pipeline options, and tokenizer=>$tz
+sub tokenize_pipeline {
+  my %opts = @_;
+  my $tw = DTA::TokWrap->new(tmpdir=>$tmpdir, outdir=>$tmpdir, keeptmp=>1, tokenizeClass=>'dummy');
+  $tw->{tokenize} = delete($opts{tokenizer}) || DTA::TokWrap::Test::BatchTokenizer->new(batchlog=>"$tmpdir/batch.log");
+  unlink("$tmpdir/batch.log");
+  my $pl = DTA::TokWrap::Pipeline->new(tw=>$tw, targets=>['tokenize'], reportLevel=>undef, %opts);
+  my $nfailed = $pl->run(@xmlfiles);
+  return $pl if (UNIVERSAL::isa($tw->{tokenize},'DTA::TokWrap::Test::CrashTokenizer'));
+  is($nfailed, 0, "pipeline(".join(',',map {"$_=$opts{$_}"} sort keys %opts)."): no failures");
+  my %t0 = qw();
+  foreach (@xmlfiles) {
+    (my $t0file = $_) =~ s/\.xml$/.t0/;
+    local $/ = undef;
+    open(my $fh, '<', $t0file) or next;
+    $t0{$t0file} = <$fh>;
+    close($fh);
+    unlink($t0file);
+  }
+  return \%t0;
+}
+
+## @sizes = batch_sizes()
+sub batch_sizes {
+  open(my $fh, '<', "$tmpdir/batch.log") or return qw();
+  return map {chomp; $_} <$fh>;
+}
+
+##======================================================================
+## tests
+
+my $t0_serial = tokenize_pipeline();
+is(scalar(keys %$t0_serial), scalar(@xmlfiles), "serial: all .t0 files written");
+is_deeply([batch_sizes()], [], "serial: tokenize_batch() not used");
+
+my $t0_batch = tokenize_pipeline(tokenizeBatch=>3, queueSize=>3);
+is_deeply($t0_batch, $t0_serial, "tokenizeBatch=3: output identical to serial");
+my @sizes = batch_sizes();
+cmp_ok(eval join('+',0,@sizes), '<=', scalar(@xmlfiles), "tokenizeBatch=3: no document tokenized twice");
+ok(!grep({$_ > 3} @sizes), "tokenizeBatch=3: batch size bounded");
+ok(grep({$_ > 1} @sizes), "tokenizeBatch=3: some batches have more than one document");
+
+my $t0_batch2 = tokenize_pipeline(tokenizeBatch=>4, queueSize=>4, workers=>{tokenize=>2});
+is_deeply($t0_batch2, $t0_serial, "tokenizeBatch=4, 2 workers: output identical to serial");
+
+##-- crashing workers: respawn limit
+{
+  local $SIG{ALRM} = sub { die("timeout\n") };
+  alarm(60);
+  my $pl = eval { tokenize_pipeline(tokenizer=>DTA::TokWrap::Test::CrashTokenizer->new(), maxRespawns=>2, workers=>{tokenize=>2}) };
+  alarm(0);
+  ok($pl, "maxRespawns=2: run() terminates") or diag($@);
+  is($pl && $pl->{nfailed}, scalar(@xmlfiles), "maxRespawns=2: all documents failed");
+  is($pl && $pl->{stages}[0]{nrespawns}, 3, "maxRespawns=2: aborted after 3 worker deaths");
+  ok($pl && $pl->{aborted}, "maxRespawns=2: aborted");
+}
+
+done_testing();
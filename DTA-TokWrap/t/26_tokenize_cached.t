@@ -0,0 +1,98 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'dtatw-tokenize-dummy not built'
+    if (!grep {-x "$_/dtatw-tokenize-dummy"} split(/:/,$ENV{PATH}));
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Processor::tokenize::dummy');
+}
+
+##======================================================================
+## counting tokenizer: records the length of each text it tokenizes
+
+package DTA::TokWrap::Test::CountingTokenizer;
+our @ISA = qw(DTA::TokWrap::Processor::tokenize::dummy);
+our @TOKENIZED = qw();
+sub tokenize {
+  my ($tz,$doc) = @_;
+  push(@TOKENIZED, length($doc->{txtdata} // ${DTA::TokWrap::Utils::slurp_file($doc->{txtfile})}));
+  return $tz->SUPER::tokenize($doc);
+}
+package main;
+
+##======================================================================
+## fixture: hinted .txt data
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## $doc = txtdoc($name,$txt)
+sub txtdoc {
+  my ($name,$txt) = @_;
+  utf8::encode($txt) if (utf8::is_utf8($txt));
+  my $txtfile = "$tmpdir/$name.txt";
+  open(my $fh, '>', $txtfile) or die("open failed for $txtfile: $!");
+  print $fh $txt;
+  close($fh);
+  return DTA::TokWrap::Document->new(xmlfile=>"$tmpdir/$name.xml", tmpdir=>$tmpdir, txtfile=>$txtfile);
+}
+
+my @sents = map {
+  "Satz $_ hat W\x{f6}rter, Zahlen wie ".($_*17)." und Abk. usw. am Ende. \$SB\$\n"
+  .($_ % 5 == 0 ? "Ein getrenn-\nter Satz ohne Hinweis\n" : '')
+} (1..400);
+my $txt  = join('', @sents);
+my $txt2 = join('', @sents[0..199], "Ein ganz neuer Satz mitten im Text. \$SB\$\n", @sents[200..$#sents]);
+
+##======================================================================
+## tests
+
+my $tz = DTA::TokWrap::Test::CountingTokenizer->new();
+my $cachedir = "$tmpdir/cache";
+
+my $doc0 = txtdoc('plain', $txt);
+ok($tz->tokenize($doc0), "tokenize: uncached");
+
+cmp_ok(scalar(DTA::TokWrap::Processor::tokenize::cache_cuts(\$txt, $DTA::TokWrap::Processor::tokenize::CACHE_MOD)), '>', 4,
+       "cache_cuts: multiple blocks");
+
+@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED = qw();
+my $doc = txtdoc('cold', $txt);
+ok(DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,$cachedir), "tokenize_cached: cold cache");
+is($doc->{tokdata0}, $doc0->{tokdata0}, "tokenize_cached: cold cache: output identical to uncached");
+is($doc->{ntoks}, $doc0->{ntoks}, "tokenize_cached: cold cache: ntoks");
+is(scalar(@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED), 1, "tokenize_cached: cold cache: single tokenizer call");
+
+@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED = qw();
+$doc = txtdoc('warm', $txt);
+ok(DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,$cachedir), "tokenize_cached: warm cache");
+is($doc->{tokdata0}, $doc0->{tokdata0}, "tokenize_cached: warm cache: output identical to uncached");
+is(scalar(@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED), 0, "tokenize_cached: warm cache: tokenizer not called");
+
+##-- edited document: only the changed block(s) are tokenized
+my $doc2 = txtdoc('edited0', $txt2);
+ok($tz->tokenize($doc2), "tokenize: edited, uncached");
+@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED = qw();
+$doc = txtdoc('edited', $txt2);
+ok(DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,$cachedir), "tokenize_cached: edited");
+is($doc->{tokdata0}, $doc2->{tokdata0}, "tokenize_cached: edited: output identical to uncached");
+is(scalar(@DTA::TokWrap::Test::CountingTokenizer::TOKENIZED), 1, "tokenize_cached: edited: single tokenizer call");
+cmp_ok($DTA::TokWrap::Test::CountingTokenizer::TOKENIZED[0], '<', length($txt2)/2, "tokenize_cached: edited: only changed block(s) tokenized");
+
+##-- chunked tokenization of uncached blocks
+{
+  local $DTA::TokWrap::Processor::tokenize::CHUNK_MIN = 1024;
+  $doc = txtdoc('chunked', $txt);
+  ok(DTA::TokWrap::Processor::tokenize::tokenize_cached($tz,$doc,"$tmpdir/cache.chunked",3), "tokenize_cached: njobs=3");
+  is($doc->{tokdata0}, $doc0->{tokdata0}, "tokenize_cached: njobs=3: output identical to uncached");
+}
+
+##-- tokenizer options are part of the cache key
+isnt(DTA::TokWrap::Test::CountingTokenizer->new(foo=>'bar')->cache_id, $tz->cache_id, "cache_id: depends on options");
+is(DTA::TokWrap::Test::CountingTokenizer->new(traceLevel=>'info')->cache_id, $tz->cache_id, "cache_id: ignores trace options");
+
+done_testing();
@@ -0,0 +1,116 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use Time::HiRes qw();
+use strict;
+
+BEGIN {
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Document::Maker');
+}
+
+##======================================================================
+## fake generators: write output file(s) and log "KEY PID T0 T1" to $LOG
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $LOG = "$tmpdir/gen.log";
+our %DELAY = qw();
+
+## \&gen = fakegen(@keys)
+##  + generator for all of @keys (i.e. a shared generator if @keys > 1)
+sub fakegen {
+  my @keys = @_;
+  return sub {
+    my $doc = shift;
+    my $t0 = Time::HiRes::time();
+    Time::HiRes::sleep($DELAY{$keys[0]}) if ($DELAY{$keys[0]});
+    foreach (@keys) {
+      open(my $fh, '>', $doc->{$_}) or die("open failed for $doc->{$_}: $!");
+      print $fh "$_\n";
+      close($fh);
+    }
+    open(my $fh, '>>', $LOG) or die("open failed for $LOG: $!");
+    printf $fh "%s %d %.6f %.6f\n", join(',',@keys), $$, $t0, Time::HiRes::time();
+    close($fh);
+    return 1;
+  };
+}
+
+## @entries = genlog()
+##  + returns [$keys,$pid,$t0,$t1] for each generator call since the last call
+sub genlog {
+  open(my $fh, '<', $LOG) or return qw();
+  my @entries = map {chomp; [split(' ',$_)]} <$fh>;
+  close($fh);
+  unlink($LOG);
+  return @entries;
+}
+
+my $KEYGEN = \%DTA::TokWrap::Document::Maker::KEYGEN;
+@$KEYGEN{qw(cxfile sxfile txfile)} = (fakegen(qw(cxfile sxfile txfile))) x 3;
+@$KEYGEN{qw(bxfile txtfile)} = (fakegen(qw(bxfile txtfile))) x 2;
+@$KEYGEN{qw(sosfile sowfile soafile)} = (fakegen(qw(sosfile sowfile soafile))) x 3;
+@$KEYGEN{qw(bx0file tokfile0 tokfile1 xtokfile cwsfile tcffile)} = map {fakegen($_)} qw(bx0file tokfile0 tokfile1 xtokfile cwsfile tcffile);
+
+##-- test-only key with two independent branches
+$DTA::TokWrap::Document::Maker::KEYDEPS_0{branches} = [qw(tokfile0 tcffile)];
+$DTA::TokWrap::Document::Maker::KEYDEPS{branches} = [DTA::TokWrap::Document::Maker::keyDeps(qw(tokfile0 tcffile)), qw(tokfile0 tcffile)];
+$KEYGEN->{branches} = sub { $_[0]{branches}=1 };
+
+## $doc = newdoc($makeJobs)
+sub newdoc {
+  return DTA::TokWrap::Document::Maker->new(xmlfile=>"$tmpdir/make.xml", outdir=>$tmpdir, tmpdir=>$tmpdir, makeJobs=>$_[0]);
+}
+
+open(my $fh, '>', "$tmpdir/make.xml") or die("open failed for $tmpdir/make.xml: $!");
+print $fh qq{<?xml version="1.0"?>\n<TEI><text><p>x</p></text></TEI>\n};
+close($fh);
+
+##======================================================================
+## tests
+
+##-- 'all': each generator runs once; cwsfile is not part of 'all'
+my $doc = newdoc(2);
+ok($doc->makeKey('all'), "makeKey(all), makeJobs=2");
+my @log = genlog();
+is_deeply([sort map {$_->[0]} @log],
+	  [sort qw(cxfile,sxfile,txfile bx0file bxfile,txtfile tokfile0 tokfile1 xtokfile sosfile,sowfile,soafile)],
+	  "makeKey(all): each generator called once");
+ok(!-e $doc->{cwsfile}, "makeKey(all): cwsfile not generated");
+ok(-e $doc->{$_}, "makeKey(all): $_ generated") foreach (qw(xtokfile sosfile sowfile soafile));
+
+$doc = newdoc(2);
+ok($doc->makeKey('all'), "makeKey(all): up to date");
+is_deeply([map {$_->[0]} genlog()], [], "makeKey(all): up to date: no generator called");
+
+##-- stale intermediate: only dependents are regenerated
+Time::HiRes::sleep(0.05);
+utime(undef, undef, $doc->{tokfile1});
+$doc = newdoc(2);
+ok($doc->makeKey('all'), "makeKey(all): stale tokfile1");
+is_deeply([sort map {$_->[0]} genlog()], [sort qw(xtokfile sosfile,sowfile,soafile)],
+	  "makeKey(all): stale tokfile1: only dependents regenerated");
+
+##-- independent branches run concurrently; unrelated children of the caller are not reaped
+unlink(map {$doc->{$_}} qw(tokfile0 tcffile));
+@DELAY{qw(tokfile0 tcffile)} = (0.5, 0.5);
+my $other = fork();
+die("fork failed: $!") if (!defined($other));
+POSIX::_exit(0) if (!$other);
+Time::HiRes::sleep(0.1);
+$doc = newdoc(2);
+ok($doc->makeKey('branches'), "makeKey(branches), makeJobs=2");
+my %log = map {($_->[0]=>$_)} genlog();
+ok($log{tokfile0} && $log{tcffile}, "makeKey(branches): both branches generated");
+isnt($log{tokfile0}[1], $log{tcffile}[1], "makeKey(branches): branches generated in different processes");
+ok($log{tokfile0}[2] < $log{tcffile}[3] && $log{tcffile}[2] < $log{tokfile0}[3], "makeKey(branches): branches generated concurrently");
+is(waitpid($other,0), $other, "makeKey(branches): unrelated child process not reaped");
+
+##-- sequential
+unlink(map {$doc->{$_}} qw(tokfile0 tcffile));
+$doc = newdoc(1);
+ok($doc->makeKey('branches'), "makeKey(branches), makeJobs=1");
+%log = map {($_->[0]=>$_)} genlog();
+ok($log{tokfile0}[1] == $$ && $log{tcffile}[1] == $$, "makeKey(branches), makeJobs=1: generated in-process");
+
+done_testing();
@@ -0,0 +1,46 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our $scriptdir = "$FindBin::Bin/../../scripts";
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXSLT not available'
+    if (!eval { require XML::LibXSLT; 1 });
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap');
+}
+
+##======================================================================
+## tests: <c>-wrapping (with or without bboxes) must not change tokenization
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my $tw = DTA::TokWrap->new(tmpdir=>$tmpdir, outdir=>$tmpdir, tokenizeClass=>'dummy');
+
+## $ntoks_or_undef = ntoks($base, @generator_opts)
+sub ntoks {
+  my ($base,@opts) = @_;
+  my $xmlfile = "$tmpdir/$base.xml";
+  return undef if (system($^X, "$scriptdir/dtatw-generate-bench.perl", @opts, '-pages=6', "-output=$xmlfile") != 0);
+  my $doc = $tw->open($xmlfile);
+  return undef if (!$doc || !$doc->genKey('tei2t'));
+  return $doc->nTokens();
+}
+
+my $plain = ntoks('plain', '-preset=plain');
+cmp_ok($plain, '>', 0, "plain: ntoks");
+foreach my $preset (qw(cdense ocr lbpb notes formula mixed)) {
+  my $want = ntoks("$preset.noc", "-preset=$preset", '-c-ratio=0', '-bbox-ratio=0');
+  cmp_ok($want, '>', 0, "$preset: ntoks without <c>");
+  is(ntoks($preset, "-preset=$preset"), $want, "$preset: ntoks");
+}
+is(ntoks('plain.c', '-preset=plain', '-c-ratio=1'), $plain, "plain -c-ratio=1: ntoks");
+is(ntoks('plain.bbox', '-preset=plain', '-c-ratio=1', '-bbox-ratio=1'), $plain, "plain -c-ratio=1 -bbox-ratio=1: ntoks");
+
+done_testing();
@@ -0,0 +1,126 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our $scriptdir = "$FindBin::Bin/../../scripts";
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy dtatw-tok2xml)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap::Utils', qw(:slurp :progs));
+}
+
+##======================================================================
+## fixture: generated document, larger than a single zio buffer and zstd frame (1MiB)
+
+my $tmpdir  = File::Temp::tempdir(CLEANUP=>1);
+my $xmlfile = "$tmpdir/zio.xml";
+is(system($^X, "$scriptdir/dtatw-generate-bench.perl", '-preset=mixed', '-size=4M', "-output=$xmlfile"), 0, "generate");
+
+## $data = slurp($file)
+##  + transparently decompressed (see DTA::TokWrap::Utils::slurp_file())
+sub slurp {
+  return ${slurp_file($_[0])};
+}
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## %out = mkindex($base, $infile, @opts_and_njobs)
+##  + runs dtatw-mkindex, returns (rc=>$rc, cx=>$cxfile, sx=>$sxfile, tx=>$txfile)
+sub mkindex {
+  my ($base,$infile,@args) = @_;
+  my @opts  = grep {/^--/} @args;
+  my @njobs = grep {!/^--/} @args;
+  my %out   = map {($_=>"$tmpdir/$base.$_")} qw(cx sx tx);
+  $out{rc}  = system("dtatw-mkindex @opts '$infile' '$out{cx}' '$out{sx}' '$out{tx}' @njobs 2>/dev/null");
+  return %out;
+}
+
+## $rc = zcompress($fmt, $infile, $outfile, $append)
+##  + compresses $infile to $outfile with an external program; returns -1 if none was found
+our %zprogs = (gzip=>[qw(gzip -c)], zstd=>[qw(zstd -cq)]);
+sub zcompress {
+  my ($fmt,$infile,$outfile,$append) = @_;
+  my ($prog,@args) = @{$zprogs{$fmt}};
+  my $path = path_prog($prog) or return -1;
+  return system(join(' ', map {"'$_'"} $path, @args)." < '$infile' ".($append ? '>>' : '>')." '$outfile'");
+}
+
+my %raw = mkindex('raw', $xmlfile, '--sync-output');
+is($raw{rc}, 0, "mkindex: raw");
+my %want = map {($_=>slurp($raw{$_}))} qw(cx sx tx);
+cmp_ok(length($want{cx}), '>', (1<<20), "mkindex: raw: .cx larger than 1MiB");
+
+##-- reference tokenizer output (.t) and tok2xml output (.xml)
+my $tfile = "$tmpdir/raw.t";
+is(system("dtatw-tokenize-dummy '$raw{tx}' > '$tfile'"), 0, "tokenize: raw");
+is(system('dtatw-tok2xml', $tfile, "$tmpdir/raw.t.xml", 'zio.xml'), 0, "tok2xml: raw");
+my $want_txml = slurp("$tmpdir/raw.t.xml");
+
+##======================================================================
+## tests: writer threads (uncompressed)
+
+foreach my $njobs (1,4) {
+  my %out = mkindex("async.$njobs", $xmlfile, $njobs);
+  is($out{rc}, 0, "mkindex: njobs=$njobs, async");
+  ok(slurp($out{$_}) eq $want{$_}, "mkindex: njobs=$njobs, async: .$_ identical to raw") foreach (qw(cx sx tx));
+}
+
+##======================================================================
+## tests: compressed input & output, per format
+
+foreach my $fmt (qw(gzip zstd)) {
+ SKIP: {
+    ##-- compressed xml input: single member/frame, and concatenated members/frames split at an arbitrary offset
+    skip("no $fmt program found", 1) if (zcompress($fmt, $xmlfile, "$tmpdir/zio.$fmt.xml") != 0);
+    my %sup = mkindex("supported.$fmt", "$tmpdir/zio.$fmt.xml");
+    skip("$fmt input not supported by this build", 1) if ($sup{rc} != 0);
+
+    my $xml  = slurp($xmlfile);
+    my $half = int(length($xml)/2) + 17;
+    spew("$tmpdir/half1.xml", substr($xml,0,$half));
+    spew("$tmpdir/half2.xml", substr($xml,$half));
+    zcompress($fmt, "$tmpdir/half$_.xml", "$tmpdir/zio.$fmt.multi.xml", 1) foreach (1,2);
+    foreach my $infile ("$tmpdir/zio.$fmt.xml", "$tmpdir/zio.$fmt.multi.xml") {
+      my $label = ($infile =~ /multi/ ? "multi-member $fmt" : $fmt);
+      is(zfile_format($infile), $fmt, "$label input: $fmt-compressed");
+      foreach my $njobs (1,4) {
+	my %out = mkindex("in.$fmt.$njobs", $infile, $njobs);
+	is($out{rc}, 0, "mkindex: $label input: njobs=$njobs");
+	ok(slurp($out{$_}) eq $want{$_}, "mkindex: $label input: njobs=$njobs: .$_ identical to raw") foreach (qw(cx sx tx));
+      }
+    }
+
+    ##-- compressed output, with and without writer threads
+    foreach my $opts ("--compress=$fmt", "--compress=$fmt:3", "--compress=$fmt --sync-output") {
+      foreach my $njobs (1,4) {
+	my %out = mkindex("out.$fmt.$njobs", $xmlfile, split(' ',$opts), $njobs);
+	is($out{rc}, 0, "mkindex $opts: njobs=$njobs");
+	foreach (qw(cx sx tx)) {
+	  is(zfile_format($out{$_}), $fmt, "mkindex $opts: njobs=$njobs: .$_ is $fmt-compressed");
+	  ok(slurp($out{$_}) eq $want{$_}, "mkindex $opts: njobs=$njobs: .$_ round-trip");
+	}
+      }
+    }
+
+    ##-- tok2xml: compressed input & output
+    is(zcompress($fmt, $tfile, "$tmpdir/$fmt.t"), 0, "$fmt: compress .t");
+    is(system('dtatw-tok2xml', "$tmpdir/$fmt.t", "$tmpdir/$fmt.t.raw.xml", 'zio.xml'), 0, "tok2xml: $fmt-compressed input");
+    ok(slurp("$tmpdir/$fmt.t.raw.xml") eq $want_txml, "tok2xml: $fmt-compressed input: output identical to raw");
+    is(system('dtatw-tok2xml', "--compress=$fmt", $tfile, "$tmpdir/$fmt.t.xml", 'zio.xml'), 0, "tok2xml --compress=$fmt");
+    is(zfile_format("$tmpdir/$fmt.t.xml"), $fmt, "tok2xml --compress=$fmt: output is $fmt-compressed");
+    ok(slurp("$tmpdir/$fmt.t.xml") eq $want_txml, "tok2xml --compress=$fmt: round-trip");
+  }
+}
+
+done_testing();
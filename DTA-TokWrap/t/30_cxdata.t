@@ -0,0 +1,109 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-cx2dat)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap::CxData', qw(:all));
+}
+
+##======================================================================
+## fixture: <c> elements with and without bounding boxes, <pb> elements, and large gaps in xml offsets
+
+## $xml = fixture_xml($npages)
+##  + bboxes move forwards and backwards (deltas of either sign), and include 0 and 2^32-2
+##    (2^32-1 is reserved for "no bbox", see dtatwMkindex.c)
+sub fixture_xml {
+  my $npages = shift;
+  my $xml = qq{<?xml version="1.0" encoding="UTF-8"?>\n<TEI><text><body>\n};
+  my ($x,$y) = (0,0);
+  srand(4711);
+  foreach my $pg (1..$npages) {
+    $xml .= qq{<pb facs="#f}.sprintf("%04d",$pg).qq{"/>\n<p>};
+    $y = 100;
+    foreach my $ln (1..12) {
+      $x  = ($ln % 5 == 0 ? 4294967294-1000 : 100);
+      $y += ($ln % 7 == 0 ? -50 : 45);
+      foreach my $ch (split(//, "Zeile $ln, Seite $pg")) {
+	my $w = 5 + int(rand(20));
+	if (rand() < 0.2) {
+	  $xml .= qq{<c>$ch</c>};
+	} elsif ($ch eq ' ' && rand() < 0.5) {
+	  $xml .= qq{<c ulx="0" uly="0" lrx="0" lry="0"> </c>};
+	} else {
+	  $xml .= qq{<c ulx="$x" uly="$y" lrx="}.($x+$w).qq{" lry="}.($y+30).qq{">$ch</c>};
+	}
+	$x += $w + 2;
+      }
+      $xml .= ($ln % 4 == 0 ? "<!-- ".('x' x (1<<17))." -->" : '')."<lb/>\n";
+    }
+    $xml .= "</p>\n";
+  }
+  $xml .= "</body></text></TEI>\n";
+  return $xml;
+}
+
+my $tmpdir  = File::Temp::tempdir(CLEANUP=>1);
+my $xmlfile = "$tmpdir/cx.xml";
+my $xml     = fixture_xml(12);
+open(my $fh, '>:raw', $xmlfile) or die("open failed for $xmlfile: $!");
+print $fh $xml;
+close($fh);
+
+##-- expected <c> records: [$xoff, @bbox_or_empty], in document order
+my @want = qw();
+while ($xml =~ /<c\b([^>]*)>/g) {
+  my ($xoff,$attrs) = ($-[0],$1);
+  my %a = ($attrs =~ /(\w+)="([0-9]+)"/g);
+  push(@want, [$xoff, (exists($a{ulx}) ? @a{qw(ulx uly lrx lry)} : qw())]);
+}
+
+##======================================================================
+## tests
+
+foreach my $njobs (1,3) {
+  my $cxfile = "$tmpdir/cx.$njobs.cx";
+  is(system('dtatw-mkindex', $xmlfile, $cxfile, '', '', $njobs), 0, "mkindex: njobs=$njobs");
+
+  ##-- header
+  open($fh, '<:raw', $cxfile) or die("open failed for $cxfile: $!");
+  my $hdr = cx_get_header($fh);
+  close($fh);
+  ok(cx_check_header($hdr), "njobs=$njobs: header");
+  my $varint = cx_header_varint($hdr) ? 1 : 0;
+  note("njobs=$njobs: ", ($varint ? "varint" : "legacy"), " .cx file (version_min=$hdr->{version_min})");
+
+  ##-- perl reader
+  my $cxdata = cx_slurp($cxfile);
+  my @cx     = grep {($_->[$CX_FLAGS] & $cxfTypeMask) == $cxrChar} @$cxdata;
+  my @got    = map {[$_->[$CX_XOFF], (($_->[$CX_FLAGS] & $cxfHasAttrs) ? @$_[$CX_ATTRS..($CX_ATTRS+3)] : qw())]} @cx;
+  is_deeply(\@got, \@want, "njobs=$njobs: perl: <c> offsets and bboxes round-trip");
+  is(scalar(grep {$_->[$CX_FLAGS] & $cxfBboxDelta} @cx),
+     ($varint ? scalar(grep {@$_ > 1} @want) : 0),
+     "njobs=$njobs: perl: ".($varint ? "all" : "no")." bboxes delta-coded");
+  is_deeply([map {$_->[$CX_ATTR_FACS]} grep {($_->[$CX_FLAGS] & $cxfTypeMask) == $cxrPb} @$cxdata],
+	    [1..12], "njobs=$njobs: perl: <pb> \@facs");
+
+  ##-- C reader (dtatw-cx2dat)
+  my @dump = map {[split(/\t/,$_)]} grep {!/^%%/ && /\S/} split(/\n/, `dtatw-cx2dat '$cxfile'`);
+  is($?, 0, "njobs=$njobs: cx2dat");
+  is_deeply([map {[$_->[1], ($_->[6] ? ($_->[6] =~ /[0-9]+/g) : qw())]} grep {$_->[0] eq 'c'} @dump],
+	    \@want, "njobs=$njobs: cx2dat: <c> offsets and bboxes round-trip");
+
+  ##-- XS reader (column-packed)
+ SKIP: {
+    skip("DTA::TokWrap::XS not available", 2) if (!$HAVE_XS);
+    my $cxp = cx_packed($cxfile);
+    is($cxp->size, scalar(@$cxdata), "njobs=$njobs: xs: size");
+    is_deeply([map {$cxp->record($_)} (0..($cxp->size-1))], $cxdata, "njobs=$njobs: xs: records identical to perl");
+  }
+}
+
+done_testing();
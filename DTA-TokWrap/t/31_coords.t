@@ -0,0 +1,112 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our $scriptdir = "$FindBin::Bin/../../scripts";
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy dtatw-b2xb dtatw-tok2xml dtatw-get-ddc-attrs)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap::Utils', qw(:slurp));
+}
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## \@w = w_attrs($xmlfile_or_stringref)
+##  + list of attribute hashes for all //w in $xmlfile_or_stringref
+sub w_attrs {
+  my $xml = ref($_[0]) ? ${$_[0]} : ${slurp_file($_[0])};
+  return [map { +{/(\w+)="([^"]*)"/g} } ($xml =~ /<w\b([^>]*)>/g)];
+}
+
+## $xmlfile = tok2xml($base, @tok2xml_opts)
+##  + runs 'dtatw-tok2xml @tok2xml_opts $tmpdir/$base.tt $tmpdir/$base.t.xml'
+sub tok2xml {
+  my ($base,@opts) = @_;
+  is(system('dtatw-tok2xml', @opts, "$tmpdir/$base.tt", "$tmpdir/$base.t.xml", $base), 0, "$base: tok2xml @opts");
+  return "$tmpdir/$base.t.xml";
+}
+
+##======================================================================
+## tests: tok2xml -coords (hand-made .tt input)
+
+spew("$tmpdir/tt.tt",
+     join('', map {join("\t", @$_)."\n"}
+	  ['foo', '0 3~10+3', '$PB=2', '$LB=7', '$BB=1|2|3|4'],
+	  ['bar', '4 3~14+3', '$PB=2', '$PB=3', 'NN'],
+	  ['baz', '8 3~18+3'],
+	 ));
+my ($w);
+$w = w_attrs(tok2xml('tt'));
+ok(!grep({exists($_->{pb}) || exists($_->{lb}) || exists($_->{bb})} @$w), "tt: no coordinate attributes without -coords");
+like(${slurp_file("$tmpdir/tt.t.xml")}, qr{<a>\$PB=2</a><a>\$LB=7</a>}, "tt: coordinate columns kept as analyses without -coords");
+
+$w = w_attrs(tok2xml('tt', '-coords'));
+is_deeply([map {[@$_{qw(pb lb bb)}]} @$w], [[2,7,'1|2|3|4'], [2,undef,undef], [undef,undef,undef]], "tt -coords: attributes");
+my $txml = ${slurp_file("$tmpdir/tt.t.xml")};
+unlike($txml, qr{<w\b[^>]*\bpb="[^"]*"[^>]*\bpb=}, "tt -coords: no duplicate attributes");
+like($txml, qr{<a>\$PB=3</a><a>NN</a>}, "tt -coords: repeated coordinate column kept as analysis");
+
+##======================================================================
+## tests: dtatw-b2xb -coords | dtatw-tok2xml -coords vs. dtatw-get-ddc-attrs -bbox
+
+##-- generated document with <pb> and <c> bboxes
+my $base = "$tmpdir/ocr";
+is(system($^X, "$scriptdir/dtatw-generate-bench.perl", '-preset=ocr', '-size=48K', '-pages=4', "-output=$base.xml"), 0, "ocr: generate");
+is(system('dtatw-mkindex', "$base.xml", "$base.cx", "$base.sx", "$base.tx"), 0, "ocr: mkindex");
+
+##-- trivial block index: a single block spanning the whole .tx file (.txt = .tx), so we don't need dtatw-mkbx (XSLT)
+my ($xlen,$tlen) = map {-s $_} ("$base.xml", "$base.tx");
+spew("$base.bx", "%% single block\nblock\tTEI\t0\t$xlen\t0\t$tlen\t0\t$tlen\n");
+is(system("dtatw-tokenize-dummy '$base.tx' > '$base.t'"), 0, "ocr: tokenize");
+is(system('dtatw-b2xb', '-coords', "$base.t", "$base.cx", "$base.bx", "$tmpdir/coords.tt"), 0, "ocr: b2xb -coords");
+is(system('dtatw-b2xb', "$base.t", "$base.cx", "$base.bx", "$tmpdir/plain.tt"), 0, "ocr: b2xb");
+my $got = w_attrs(tok2xml('coords', '-coords'));
+tok2xml('plain');
+is(system('dtatw-get-ddc-attrs', qw(-noxlit -bbox -cx), "$base.cx", '-sx'=>"$base.sx", '-o'=>"$tmpdir/ddc.xml", "$tmpdir/plain.t.xml"),
+   0, "ocr: get-ddc-attrs -bbox");
+my $want = w_attrs("$tmpdir/ddc.xml");
+
+cmp_ok(scalar(@$got), '>', 100, "ocr: non-empty");
+is(scalar(@$got), scalar(@$want), "ocr: same number of words");
+is_deeply([map {[@$_{qw(id pb lb)}]} @$got], [map {[@$_{qw(id pb lb)}]} @$want], "ocr: \@pb, \@lb identical");
+ok(scalar(grep {$_->{pb} > 1} @$want), "ocr: multiple pages");
+
+##-- @bb: get-ddc-attrs splits bboxes at line- and column-breaks ("BOX_BOX..."), b2xb writes their union
+## $bb = bb_union($ddc_bb)
+sub bb_union {
+  my @boxes = map {[split(/\|/,$_)]} grep {$_ ne ''} split(/_/, $_[0]);
+  return '' if (!@boxes);
+  my @u = @{shift(@boxes)};
+  foreach (@boxes) {
+    $u[0] = $_->[0] if ($_->[0] < $u[0]);
+    $u[1] = $_->[1] if ($_->[1] < $u[1]);
+    $u[2] = $_->[2] if ($_->[2] > $u[2]);
+    $u[3] = $_->[3] if ($_->[3] > $u[3]);
+  }
+  return join('|', @u);
+}
+is_deeply([map {$_->{bb}} @$got], [map {bb_union($_->{bb})} @$want], "ocr: \@bb identical (modulo line-breaks)");
+ok(scalar(grep {($_->{bb}//'') =~ /_/} @$want), "ocr: some words span line-breaks");
+
+##-- XS bindings
+SKIP: {
+  skip("DTA::TokWrap::XS not available", 1) if (!eval { require DTA::TokWrap::XS; 1 });
+  my $ttdata = DTA::TokWrap::XS::b2xb(${slurp_file("$base.t")}, "$base.cx", "$base.bx", "$base.t", 1);
+  my $xsw    = w_attrs(\ DTA::TokWrap::XS::tok2xml($ttdata, 'coords', undef, 1));
+  is_deeply($xsw, $got, "ocr: XS b2xb + tok2xml: //w attributes identical");
+}
+
+done_testing();
@@ -0,0 +1,117 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use Config;
+use strict;
+
+our $srcdir    = "$FindBin::Bin/../../src";
+our $scriptdir = "$FindBin::Bin/../../scripts";
+our ($plugin);
+BEGIN {
+  $ENV{PATH} = "$srcdir:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy dtatw-tokenize-plugin dtatw-tokplugin-dummy.so)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  ($plugin) = grep {-x $_} map {"$_/dtatw-tokplugin-dummy.so"} split(/:/,$ENV{PATH});
+  use_ok('DTA::TokWrap::Utils', qw(:slurp));
+}
+our $HAVE_XS = eval { require DTA::TokWrap::XS; DTA::TokWrap::XS::TokPlugin->can('new') } ? 1 : 0;
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## $tdata = noheader($tdata)
+##  + removes "%%" header comments
+sub noheader {
+  (my $tdata = shift) =~ s/^%%[^\n]*\n//mg;
+  return $tdata;
+}
+
+## $tdata = tokenize_prog($prog_and_args, $txtdata)
+##  + runs `$prog_and_args TXTFILE` on $txtdata, returns output without header comments
+our $nfiles = 0;
+sub tokenize_prog {
+  my ($cmd,$txt) = @_;
+  my $txtfile = "$tmpdir/in".(++$nfiles).".txt";
+  spew($txtfile, $txt);
+  my $out = `$cmd '$txtfile'`;
+  die("$cmd failed: $?") if ($? != 0);
+  return noheader($out);
+}
+
+##======================================================================
+## fixtures
+
+my @texts = (
+	     "Hallo Welt. Wie geht's?\n\nNeuer Absatz: 3.14, z.B. \"quoted\" -- und \$SB\$ mehr.\n",
+	     "Kr\x{c3}\x{a4}uter und \x{c5}\x{bf}pa\x{c3}\x{9f} (mit Umlauten)!\n",
+	     "",
+	     "x",
+	    );
+
+##-- generated document text (.tx)
+my $xmlfile = "$tmpdir/gen.xml";
+is(system($^X, "$scriptdir/dtatw-generate-bench.perl", '-preset=mixed', '-size=64K', "-output=$xmlfile"), 0, "generate");
+is(system('dtatw-mkindex', $xmlfile, "$tmpdir/gen.cx", "$tmpdir/gen.sx", "$tmpdir/gen.tx"), 0, "mkindex");
+push(@texts, ${slurp_file("$tmpdir/gen.tx")});
+
+my @want = map {tokenize_prog('dtatw-tokenize-dummy', $_)} @texts;
+cmp_ok(length($want[$#want]), '>', 1000, "dtatw-tokenize-dummy: non-trivial output");
+
+##======================================================================
+## tests: dtatw-tokenize-plugin
+
+foreach (0..$#texts) {
+  is(tokenize_prog("dtatw-tokenize-plugin '$plugin'", $texts[$_]), $want[$_], "dtatw-tokenize-plugin: text $_ (".length($texts[$_])." bytes)");
+}
+
+##======================================================================
+## tests: DTA::TokWrap::XS::TokPlugin
+
+SKIP: {
+  skip("DTA::TokWrap::XS::TokPlugin not available", 2*@texts+3) if (!$HAVE_XS);
+  my $tp = DTA::TokWrap::XS::TokPlugin->new($plugin);
+  ok($tp, "xs: new");
+  is($tp->name, 'dummy', "xs: name");
+
+  ##-- repeated calls on a single instance: forwards and backwards
+  foreach my $i ((0..$#texts), reverse(0..$#texts)) {
+    is(noheader($tp->tokenize($texts[$i])), $want[$i], "xs: tokenize(): text $i (".length($texts[$i])." bytes)");
+  }
+  is($tp->tokenize(''), '', "xs: tokenize(''): empty output");
+}
+
+##======================================================================
+## tests: ABI version mismatch
+
+SKIP: {
+  ##-- build a minimal plugin claiming DTATW_TOKPLUGIN_ABI+1
+  my $badc  = "$tmpdir/badabi.c";
+  my $badso = "$tmpdir/dtatw-tokplugin-badabi.so";
+  spew($badc, <<'EOF');
+#include "dtatwTokPlugin.h"
+static const dtatwTokPlugin badabi_plugin = { DTATW_TOKPLUGIN_ABI+1, 0, "badabi", "0", NULL, NULL, NULL };
+const dtatwTokPlugin *dtatw_tokplugin(void) { return &badabi_plugin; }
+EOF
+  skip("could not compile test plugin with $Config{cc}", 3)
+    if (system("$Config{cc} $Config{cccdlflags} -shared -I'$srcdir' -o '$badso' '$badc' 2>/dev/null") != 0);
+
+  my $out = `dtatw-tokenize-plugin '$badso' /dev/null 2>&1`;
+  isnt($?, 0, "dtatw-tokenize-plugin: ABI mismatch: non-zero exit status");
+  like($out, qr/ABI version [0-9]+, expected [0-9]+/, "dtatw-tokenize-plugin: ABI mismatch: message");
+
+  skip("DTA::TokWrap::XS::TokPlugin not available", 1) if (!$HAVE_XS);
+  eval { DTA::TokWrap::XS::TokPlugin->new($badso) };
+  like($@, qr/ABI version [0-9]+, expected [0-9]+/, "xs: ABI mismatch: croak()s");
+}
+
+done_testing();
@@ -0,0 +1,130 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXML (with XML::LibXML::Reader) not available'
+    if (!eval { require XML::LibXML; require XML::LibXML::Reader; 1 });
+  foreach (qw(dtatw-tokenize-dummy)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap');
+}
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## $str = canon($xmlfile)
+##  + canonical XML for $xmlfile, ignoring formatting whitespace
+sub canon {
+  my $xdoc = XML::LibXML->new(keep_blanks=>0, huge=>1)->parse_file($_[0]);
+  return $xdoc->documentElement->toStringC14N();
+}
+
+## $str = xmlesc($str)
+sub xmlesc {
+  (my $s = shift) =~ s/&/&amp;/g;
+  $s =~ s/</&lt;/g;
+  $s =~ s/>/&gt;/g;
+  return $s;
+}
+
+##======================================================================
+## fixtures
+
+##-- TEI source & serialized text (as for tcfencode input)
+my $txt = ("Hallo Welt. Wie geht's?\n\n"
+	   ."Eins & zwei <drei> \"vier\" Kr\x{c3}\x{a4}uter und \x{c5}\x{bf}pa\x{c3}\x{9f}.\n\n"
+	   .join('', map {"Satz Nummer $_ hat ein paar W\x{c3}\x{b6}rter.\n"} (1..200)));
+my $xml = ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<TEI><text><body>\n"
+	   .join('', map {"<p>".xmlesc($_)."</p>\n"} grep {$_ ne ''} split(/\n\n/, $txt))
+	   ."</body></text></TEI>\n");
+spew("$tmpdir/doc.xml", $xml);
+spew("$tmpdir/doc.txt", $txt);
+
+##-- hand-written TCF input with a namespace-prefixed TextCorpus (and a comment in its tail)
+spew("$tmpdir/ptcf.tcf",
+     "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+     ."<D-Spin xmlns=\"http://www.dspin.de/data\" version=\"0.4\">\n"
+     ."<MetaData xmlns=\"http://www.dspin.de/data/metadata\"/>\n"
+     ."<tc:TextCorpus xmlns:tc=\"http://www.dspin.de/data/textcorpus\" lang=\"de\">\n"
+     ."<tc:text>".xmlesc($txt)."</tc:text>\n"
+     ."<!-- end of text -->\n"
+     ."</tc:TextCorpus   >\n"
+     ."</D-Spin>\n");
+
+##======================================================================
+## subs
+
+## $tw = tw($mode)
+##  + $mode is 'dom' or 'stream'
+sub tw {
+  my $mode = shift;
+  my $dir  = "$tmpdir/$mode";
+  mkdir($dir) if (!-d $dir);
+  return DTA::TokWrap->new(outdir=>$dir, tmpdir=>$dir, keeptmp=>1, tokenizeClass=>'dummy', tcfstream=>($mode eq 'stream' ? 1 : 0));
+}
+
+## \%data = tcfsplit($tw, $mode, $label, $tcffile)
+##  + decodes $tcffile with tcfdecode0, returns {tcfxdata=>..., tcftdata=>..., tcfwdata=>...}
+sub tcfsplit {
+  my ($tw,$mode,$label,$tcffile) = @_;
+  my $doc = $tw->open($tcffile, tcffile=>$tcffile, outbase=>"$label.split");
+  ok($doc && $doc->genKey('tcfsplit'), "$mode: $label: tcfsplit");
+  return { map {($_=>$doc->{$_})} qw(tcfxdata tcftdata tcfwdata) };
+}
+
+##======================================================================
+## tests
+
+my (%tcffile,%tokfile,%split,%psplit,%ptokfile);
+foreach my $mode (qw(dom stream)) {
+  my $tw = tw($mode);
+
+  ##-- tcfencode
+  my $doc = $tw->open("$tmpdir/doc.xml", txtfile=>"$tmpdir/doc.txt", outbase=>'doc');
+  ok($doc && $doc->genKey('tcfencode'), "$mode: tcfencode");
+  $tcffile{$mode} = $doc->{tcffile};
+  ok(-s $tcffile{$mode}, "$mode: tcfencode: non-empty output");
+
+  ##-- tcftokenize
+  my $tdoc = $tw->open($tcffile{$mode}, tcffile=>$tcffile{$mode}, outbase=>'doc.tok', tcftokfile=>"$tmpdir/$mode/doc.tcftok");
+  ok($tdoc && $tdoc->genKey('tcf2tok'), "$mode: tcftokenize");
+  $tokfile{$mode} = $tdoc->{tcftokfile};
+
+  ##-- tcfdecode0
+  $split{$mode} = tcfsplit($tw, $mode, 'doc', $tokfile{$mode});
+  is($split{$mode}{tcftdata}, $txt, "$mode: tcfdecode0: tcftdata round-trip");
+  like($split{$mode}{tcfwdata}, qr/^Hallo\ts1\/w1\n/, "$mode: tcfdecode0: tcfwdata");
+
+  ##-- namespace-prefixed TextCorpus
+  my $pdoc = $tw->open("$tmpdir/ptcf.tcf", tcffile=>"$tmpdir/ptcf.tcf", outbase=>'ptcf', tcftokfile=>"$tmpdir/$mode/ptcf.tcftok");
+  ok($pdoc && $pdoc->genKey('tcf2tok'), "$mode: prefixed TextCorpus: tcftokenize");
+  $ptokfile{$mode} = $pdoc->{tcftokfile};
+  my $pxdoc = XML::LibXML->new(huge=>1)->parse_file($ptokfile{$mode});
+  ok($pxdoc->findnodes('/*/*[local-name()="TextCorpus"]/*[local-name()="tokens"]/*[local-name()="token"]')->size > 0,
+     "$mode: prefixed TextCorpus: tokens layer inside TextCorpus");
+  $psplit{$mode} = tcfsplit($tw, $mode, 'ptcf', $ptokfile{$mode});
+  is($psplit{$mode}{tcftdata}, $txt, "$mode: prefixed TextCorpus: tcftdata");
+}
+
+##-- dom vs. stream
+is(canon($tcffile{stream}), canon($tcffile{dom}), "tcfencode: stream vs. dom: canonical .tcf identical");
+is(canon($tokfile{stream}), canon($tokfile{dom}), "tcftokenize: stream vs. dom: canonical .tcftok identical");
+is_deeply($split{stream}, $split{dom}, "tcfdecode0: stream vs. dom: tcfxdata, tcftdata, tcfwdata identical");
+is(canon($ptokfile{stream}), canon($ptokfile{dom}), "prefixed TextCorpus: tcftokenize: stream vs. dom: canonical .tcftok identical");
+is_deeply($psplit{stream}, $psplit{dom}, "prefixed TextCorpus: tcfdecode0: stream vs. dom: tcfxdata, tcftdata, tcfwdata identical");
+is($psplit{stream}{tcfwdata}, $split{stream}{tcfwdata}, "prefixed TextCorpus: same tokens as unprefixed");
+
+done_testing();
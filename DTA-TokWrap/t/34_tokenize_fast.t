@@ -0,0 +1,101 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use FindBin;
+use strict;
+
+our $scriptdir = "$FindBin::Bin/../../scripts";
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy dtatw-tokenize-fast)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('DTA::TokWrap::Utils', qw(:slurp));
+}
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+
+## undef = spew($file,$data)
+sub spew {
+  open(my $fh, '>:raw', $_[0]) or die("open failed for $_[0]: $!");
+  print $fh $_[1];
+  close($fh) or die("close failed for $_[0]: $!");
+}
+
+## $tdata = tokenize($prog, $txtdata)
+##  + runs `$prog TXTFILE` on $txtdata, returns output without "%%" header comments
+our $nfiles = 0;
+sub tokenize {
+  my ($prog,$txt) = @_;
+  my $txtfile = "$tmpdir/in".(++$nfiles).".txt";
+  spew($txtfile, $txt);
+  my $out = `$prog '$txtfile'`;
+  die("$prog failed: $?") if ($? != 0);
+  $out =~ s/^%%[^\n]*\n//mg;
+  return $out;
+}
+
+##======================================================================
+## tests: ASCII input (output identical to dtatw-tokenize-dummy)
+
+my @texts = (
+	     "",
+	     "x",
+	     "Hallo Welt. Wie geht's?\n\nNeuer Absatz:  3.14, z.B. \"quoted\" -- und \$SB\$ mehr.\n",
+	     "Prof. Dr. Mabuse ging um 12.30 Uhr (ca. 1/2 Stunde) nach Nr. 7b, XIV. Bezirk; dann 1.000.000,- Mark!\n",
+	     "Zeilen-\numbruch und Binde- strich, ,,Anfuehrung`` und ''so'' oder `so' ... ___ ----\n",
+	     "Sonder#zeichen #foo# a-## b- #x c-# #d e- # \n##f g-\n\n# \$WB\$zwei\$TB\$drei \$SBx \$XY\$ 3. 4a 5# [i] {ii} <iii>\n",
+	     "tab\tand\r\nCRLF\fform feed\x{0b}vtab  trailing   \n\n\n",
+	    );
+
+##-- generated document text (.tx), reduced to ASCII
+my $xmlfile = "$tmpdir/gen.xml";
+is(system($^X, "$scriptdir/dtatw-generate-bench.perl", '-preset=mixed', '-size=64K', "-output=$xmlfile"), 0, "generate");
+is(system('dtatw-mkindex', $xmlfile, "$tmpdir/gen.cx", "$tmpdir/gen.sx", "$tmpdir/gen.tx"), 0, "mkindex");
+(my $gentx = ${slurp_file("$tmpdir/gen.tx")}) =~ s/[^\x{00}-\x{7f}]//g;
+push(@texts, $gentx);
+
+##-- random ASCII strings over a token-relevant alphabet
+srand(4711);
+my @alphabet = (split(//, "aAbZIVXLCMdi019.,;:!?-_'`\"#\$/()& \t\n"), '$SB$', '$WB$', 'Prof.', 'Dr.', "-\n", "\n\n");
+foreach (1..8) {
+  push(@texts, join('', map {$alphabet[int(rand(@alphabet))]} (1..2048)));
+}
+
+foreach (0..$#texts) {
+  my $want = tokenize('dtatw-tokenize-dummy', $texts[$_]);
+  my $got  = tokenize('dtatw-tokenize-fast', $texts[$_]);
+  ok($got eq $want, "ascii: text $_ (".length($texts[$_])." bytes): output identical to dtatw-tokenize-dummy")
+    or diag("want:\n$want\ngot:\n$got");
+}
+
+##======================================================================
+## tests: non-ASCII input (unicode-aware character classes)
+
+my @utf8 = (
+	    ##-- umlauts and long-s are letters
+	    ["Kr\x{c3}\x{a4}uter und \x{c5}\x{bf}pa\x{c3}\x{9f}\n",
+	     "Kr\x{c3}\x{a4}uter\t0 8\nund\t9 3\n\x{c5}\x{bf}pa\x{c3}\x{9f}\t13 6\n\n"],
+	    ["\x{c3}\x{a4}. \x{c3}\x{a4}\x{c3}\x{b6}. 3\x{c3}\x{a4}\n",
+	     "\x{c3}\x{a4}.\t0 3\t\$ABBR\n\x{c3}\x{a4}\x{c3}\x{b6}.\t4 5\t\$ABBR\n3\x{c3}\x{a4}\t10 3\t\$CARDSUFFIX\n\n"],
+	    ["Gr\x{c3}\x{bc}\x{c3}\x{9f}-\nGott \x{c5}\x{bf}o-\n\x{c5}\x{bf}o\n",
+	     "Gr\x{c3}\x{bc}\x{c3}\x{9f}Gott\t0 12\n\x{c5}\x{bf}o\x{c5}\x{bf}o\t13 8\n\n"],
+
+	    ##-- typographic quotes are $QUOTE
+	    ["\x{e2}\x{80}\x{9e}Hallo\x{e2}\x{80}\x{9c} \x{c2}\x{bb}Ja\x{c2}\x{ab} \x{e2}\x{80}\x{9a}a\x{e2}\x{80}\x{98} \x{e2}\x{80}\x{99}\n",
+	     join('',
+		  "\x{e2}\x{80}\x{9e}\t0 3\t\$QUOTE\n", "Hallo\t3 5\n", "\x{e2}\x{80}\x{9c}\t8 3\t\$QUOTE\n",
+		  "\x{c2}\x{bb}\t12 2\t\$QUOTE\n", "Ja\t14 2\n", "\x{c2}\x{ab}\t16 2\t\$QUOTE\n",
+		  "\x{e2}\x{80}\x{9a}\t19 3\t\$QUOTE\n", "a\t22 1\n", "\x{e2}\x{80}\x{98}\t23 3\t\$QUOTE\n",
+		  "\x{e2}\x{80}\x{99}\t27 3\t\$QUOTE\n", "\n",
+		 )],
+	   );
+
+foreach (0..$#utf8) {
+  my ($txt,$want) = @{$utf8[$_]};
+  is(tokenize('dtatw-tokenize-fast', $txt), $want, "utf8: text $_: dtatw-tokenize-fast");
+}
+
+done_testing();
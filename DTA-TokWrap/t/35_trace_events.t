@@ -0,0 +1,123 @@
+##-*- Mode: CPerl -*-
+use Test::More;
+use File::Temp qw();
+use File::Basename qw(basename);
+use FindBin;
+use strict;
+
+BEGIN {
+  $ENV{PATH} = "$FindBin::Bin/../../src:$ENV{PATH}";
+  plan skip_all => 'XML::LibXSLT not available'
+    if (!eval { require XML::LibXML; require XML::LibXSLT; 1 });
+  foreach (qw(dtatw-mkindex dtatw-tokenize-dummy)) {
+    my $prog = $_;
+    plan skip_all => "$prog not built"
+      if (!grep {-x "$_/$prog"} split(/:/,$ENV{PATH}));
+  }
+  use_ok('JSON::PP');
+  use_ok('DTA::TokWrap');
+  use_ok('DTA::TokWrap::Pipeline');
+}
+
+##======================================================================
+## fixture: .xml and .txt files for the 'mkindex' and 'tokenize' stages
+
+my $tmpdir = File::Temp::tempdir(CLEANUP=>1);
+my @targets = qw(mkindex tokenize);
+my (@xmlfiles);
+foreach my $i (1..2) {
+  my $base = "$tmpdir/doc$i";
+  push(@xmlfiles, "$base.xml");
+  foreach (["$base.xml", qq{<?xml version="1.0"?>\n<TEI><text><p>Dokument $i</p></text></TEI>\n}],
+	   ["$base.txt", join('', map {"Satz $_ von Dokument $i hat ".($_*$i)." W\x{f6}rter. \$SB\$\n"} (1..(10*$i)))])
+    {
+      open(my $fh, '>:utf8', $_->[0]) or die("open failed for $_->[0]: $!");
+      print $fh $_->[1];
+      close($fh);
+    }
+}
+
+## $tw = tw($label)
+##  + new DTA::TokWrap object writing trace events to "$tmpdir/$label.json"
+sub tw {
+  return DTA::TokWrap->new(tmpdir=>$tmpdir, outdir=>$tmpdir, keeptmp=>1, tokenizeClass=>'dummy', traceEvents=>"$tmpdir/$_[0].json");
+}
+
+## \@events = check_trace($label)
+##  + parses "$tmpdir/$label.json" and runs common checks
+sub check_trace {
+  my $label  = shift;
+  my $file   = "$tmpdir/$label.json";
+  my $events = eval {
+    open(my $fh, '<:raw', $file) or die("open failed for $file: $!");
+    local $/ = undef;
+    JSON::PP->new->utf8->decode(<$fh>);
+  };
+  ok(ref($events) eq 'ARRAY', "$label: trace file parses as JSON array") or diag($@);
+  $events = [] if (ref($events) ne 'ARRAY');
+
+  ##-- one document event per file
+  my @docs = grep {$_->{ph} eq 'X' && $_->{cat} eq 'document'} @$events;
+  is_deeply([sort map {$_->{name}} @docs], [sort map {basename($_)} @xmlfiles], "$label: one document event per file");
+  is_deeply([sort map {$_->{args}{xmlfile}} @docs], [sort @xmlfiles], "$label: document events: args.xmlfile");
+  ok(!grep({!($_->{args}{ntoks} > 0 && $_->{args}{nxbytes} == -s $_->{args}{xmlfile})} @docs),
+     "$label: document events: args.ntoks, args.nxbytes");
+
+  ##-- every X event has numeric ts, dur; every pid has a process name
+  my @x = grep {$_->{ph} eq 'X'} @$events;
+  ok(!grep({!(defined($_->{ts}) && defined($_->{dur}) && $_->{ts} =~ /^[0-9]+$/ && $_->{dur} =~ /^[0-9]+$/)} @x),
+     "$label: complete events have ts, dur");
+  my %pnames = map {($_->{pid}=>1)} grep {$_->{ph} eq 'M' && $_->{name} eq 'process_name'} @$events;
+  ok(!grep({!$pnames{$_->{pid}}} @$events), "$label: all processes named");
+  is($events->[$#$events]{ph}, 'M', "$label: closed by traceClose()");
+
+  ##-- counters: final totals over all processes
+  my (%tokens);
+  $tokens{$_->{pid}} = $_->{args}{ntoks} foreach (grep {$_->{ph} eq 'C' && $_->{name} eq 'tokens'} @$events);
+  is(eval join('+',0,values %tokens), eval join('+',0,map {$_->{args}{ntoks}} @docs), "$label: token counters sum to document totals");
+
+  ##-- processor events: nested in the (document or stage) event for the same document and process
+  my @procs = grep {$_->{cat} eq 'processor'} @x;
+  my %procnames = map {($_->{name}=>1)} @procs;
+  ok($procnames{mkindex} && $procnames{tokenize0}, "$label: processor events for mkindex, tokenize0");
+  my @outer = grep {$_->{cat} eq 'document' || $_->{cat} eq 'stage'} @x;
+  my @unnested = grep {
+    my $p = $_;
+    !grep {$_->{pid}==$p->{pid} && $_->{name} eq $p->{args}{doc} && $_->{ts} <= $p->{ts} && $p->{ts}+$p->{dur} <= $_->{ts}+$_->{dur}} @outer
+  } @procs;
+  ok(!@unnested, "$label: processor events nested in their document") or diag(JSON::PP->new->canonical->encode(\@unnested));
+
+  return $events;
+}
+
+##======================================================================
+## tests: serial
+
+my $tw = tw('serial');
+foreach my $xmlfile (@xmlfiles) {
+  my $doc = $tw->open($xmlfile);
+  ok($doc && $doc->genKey('mkindex') && $doc->genKey('tokenize0') && $doc->close(), "serial: $xmlfile");
+}
+$tw->traceClose();
+my $serial = check_trace('serial');
+ok(!grep({$_->{cat} && $_->{cat} eq 'stage'} @$serial), "serial: no stage events");
+
+##======================================================================
+## tests: DTA::TokWrap::Pipeline
+
+$tw = tw('pipeline');
+my $pl = DTA::TokWrap::Pipeline->new(tw=>$tw, targets=>\@targets, reportLevel=>undef, workers=>{tokenize=>2});
+is($pl->run(@xmlfiles), 0, "pipeline: no failures");
+$tw->traceClose();
+my $pipeline = check_trace('pipeline');
+
+##-- one stage event per document and stage, in the worker processes; documents span their stages
+my @stages = grep {$_->{ph} eq 'X' && $_->{cat} eq 'stage'} @$pipeline;
+is_deeply([sort map {"$_->{name}:$_->{args}{stage}"} @stages],
+	  [sort map {my $f=basename($_); map {"$f:$_"} @targets} @xmlfiles], "pipeline: one stage event per document and stage");
+my %docs  = map {($_->{name}=>$_)} grep {$_->{ph} eq 'X' && $_->{cat} eq 'document'} @$pipeline;
+ok(!grep({$_->{pid} == $docs{$_->{name}}{pid}} @stages), "pipeline: stage events written by workers");
+ok(!grep({my $d=$docs{$_->{name}}; !($d->{ts} <= $_->{ts} && $_->{ts}+$_->{dur} <= $d->{ts}+$d->{dur})} @stages),
+   "pipeline: document events span their stages");
+
+done_testing();
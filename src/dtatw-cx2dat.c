@@ -7,8 +7,8 @@
  */
 
 cxStoredRecord cxr;
-uint32_t xmlOffset = 0; //-- current xml byte offset
-uint32_t txOffset = 0; //-- current tx-file offset
+ByteOffset xmlOffset = 0; //-- current xml byte offset
+ByteOffset txOffset = 0; //-- current tx-file offset
 
 //-- suppress gcc warnings of the form "ignoring return value of `fread', declared with attribute warn_unused_result [-Wunused-result]"
 #pragma GCC diagnostic ignored "-Wunused-result"
@@ -80,14 +80,14 @@ void dump_record(FILE *f, const cxStoredRecord *cxr, FILE *f_tx)
   if (!f) return;
   txbuf[0] = '\0';
   if (f_tx && cxr->tlen) {
-    fseek(f_tx, txOffset, SEEK_SET);
+    fseeko(f_tx, txOffset, SEEK_SET);
     fread(txbuf, 1, cxr->tlen, f_tx);
     txbuf[cxr->tlen] = '\0';
   }
-  fprintf(f, "%s\t%u\t%hhu\t%u\t%hhu\t%s",
+  fprintf(f, "%s\t%" ByteOffsetF "\t%hhu\t%" ByteOffsetF "\t%hhu\t%s",
 	  cxTypeNames[(cxr->flags&cxfTypeMask)],
-	  (uint)cxr->xoff, cxr->xlen,
-	  (uint)txOffset, cxr->tlen,
+	  cxr->xoff, cxr->xlen,
+	  txOffset, cxr->tlen,
 	  dump_text((char*)txbuf,(int)cxr->tlen));
 
   //-- attrs
@@ -113,6 +113,8 @@ int main(int argc, char **argv)
   FILE *f_tx = NULL;   //-- input tx-file (optional)
   FILE *f_out = stdout;  //-- output tab-separated cx-file (optional)
   cxHeader hdr;
+  int typ, varint;
+  uint32_t bbox[4] = {0,0,0,0};
 
   //-- initialize: globals
   prog = file_basename(NULL,argv[0],"",-1,0);
@@ -166,12 +168,14 @@ int main(int argc, char **argv)
   }
 
   //-- get & dump header
-  cx_get_header(f_cx, filename_cx, &hdr);
+  if (!cx_get_header(f_cx, filename_cx, &hdr)) exit(1);
   dump_header(f_out, &hdr, argc, argv);
   if (!cx_check_header(&hdr,filename_cx)) exit(1);
 
   //-- churn cx-records
-  while (f_cx && !feof(f_cx) && cx_get_record(f_cx, &cxr, xmlOffset) != cxrEOF) {
+  varint = cx_header_varint(&hdr);
+  while (f_cx && !feof(f_cx) && (typ = cx_get_record(f_cx, &cxr, xmlOffset, varint, bbox)) != cxrEOF) {
+    if (typ < 0) exit(1);
     dump_record(f_out, &cxr, f_tx);
     xmlOffset = cxr.xoff + cxr.xlen;
     txOffset += cxr.tlen;
@@ -0,0 +1,1409 @@
+#include "dtatwCommon.h"
+#include "dtatwExpat.h"
+#include "dtatwUtf8.h"
+#include "dtatwCxPacked.h"
+#include "dtatwZio.h"
+
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/*======================================================================
+ * Globals
+ */
+
+//-- constants (hacks; keep in sync with dtatw-get-ddc-attrs.perl)
+#define PAGE_BOTTOM_Y   50001
+#define PAGE_TOP_Y      1
+#define MAX_FORMULA_PIX 1024  //-- any formula bboxes higher than MAX_FORMULA_PIX are chucked
+#define MIN_FORMULA_PIX 100   //-- formula bboxes shorter than MIN_FORMULA_PIX are extended
+#define NOKEY ((ByteOffset)-1)
+
+//-- selection (command-line options, as for dtatw-get-ddc-attrs.perl)
+int keep_ws      = 0;  //-- whether to keep word text-internal whitespace
+int do_page      = 1;
+int do_line      = 1;
+int do_rendition = 1;
+int do_xcontext  = 1;
+int do_xpath     = 1;
+int do_xppath    = 0;
+int do_bbox      = 0;
+int do_wsep      = 1;
+int do_keep_c    = 1;
+int do_keep_b    = 1;
+int do_keep_xb   = 1;
+int do_unicruft  = 1;  //-- //w/@u: not supported, must be disabled with -noxlit
+int foreign      = 0;  //-- "foreign" (non-dta) mode?
+const char *formula_text = ""; //-- output text for //formula elements ("": no change)
+int ignored_opt  = 0;  //-- dummy for dtatw-get-ddc-attrs.perl options without effect here
+
+//-- rendition list delimiters (foreign mode: "", "", ":")
+const char *rend_left  = "|";
+const char *rend_right = "|";
+const char *rend_sep   = "|";
+
+//-- verbosity levels
+#define VL_WARN     1
+#define VL_INFO     2
+#define VL_PROGRESS 3
+int verbose = VL_WARN;
+
+//-- warnings
+int warn_on_empty_clist = 1;  //-- warn on empty //c list for //w?
+int warn_on_empty_blist = 1;  //-- warn on empty sx-block list for //w?
+int warn_on_bad_facs    = 1;  //-- warn on missing pb/@facs?
+#define MAX_WARNINGS 10
+
+typedef enum {
+  wkPbBadFacs = 0,
+  wkPbNoFacs,
+  wkEmptyXb,
+  wkEmptyClist,
+  wkEmptyBlist,
+  wkNKinds
+} WarnKind;
+unsigned n_warnings[wkNKinds];
+
+//-- filenames (for messages)
+const char *txmlfile = "-";
+const char *cxfile   = NULL;
+const char *sxfile   = NULL;
+
+/*======================================================================
+ * Utils: strings
+ */
+
+//-- DdcBuf: growable string buffer
+typedef struct {
+  char  *s;      //-- NUL-terminated string data
+  size_t len;    //-- string length
+  size_t alloc;  //-- allocated size
+} DdcBuf;
+
+//--------------------------------------------------------------
+static void buf_reserve(DdcBuf *b, size_t len)
+{
+  if (len+1 <= b->alloc) return;
+  b->alloc = (len+1 < 2*b->alloc ? 2*b->alloc : len+1);
+  if (b->alloc < 64) b->alloc = 64;
+  b->s = (char*)realloc(b->s, b->alloc);
+  assert2(b->s != NULL, "realloc failed");
+}
+
+//--------------------------------------------------------------
+static inline void buf_clear(DdcBuf *b)
+{
+  buf_reserve(b,0);
+  b->len  = 0;
+  b->s[0] = '\0';
+}
+
+//--------------------------------------------------------------
+static void buf_appendn(DdcBuf *b, const char *s, size_t len)
+{
+  buf_reserve(b, b->len+len);
+  memcpy(b->s+b->len, s, len);
+  b->len += len;
+  b->s[b->len] = '\0';
+}
+
+//--------------------------------------------------------------
+static inline void buf_append(DdcBuf *b, const char *s)
+{
+  buf_appendn(b, s, strlen(s));
+}
+
+//--------------------------------------------------------------
+// bool = perl_true(s)
+//  + emulates perl boolean context for strings: undef, "", and "0" are false
+static inline int perl_true(const char *s)
+{
+  return s && *s && !(s[0]=='0' && s[1]=='\0');
+}
+
+//--------------------------------------------------------------
+// bool = perl_isspace(c)
+//  + perl \s for unicode strings
+static inline int perl_isspace(uint32_t c)
+{
+  return ((c >= 0x09 && c <= 0x0d) || c == 0x20 || c == 0x85 || c == 0xa0 || c == 0x1680
+	  || (c >= 0x2000 && c <= 0x200a) || c == 0x2028 || c == 0x2029 || c == 0x202f
+	  || c == 0x205f || c == 0x3000);
+}
+
+//--------------------------------------------------------------
+// bool = perl_isword(c)
+//  + perl \w for ASCII
+static inline int perl_isword(char c)
+{
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+//-- DdcToken: (pointer,length) substring, for sorting
+typedef struct {
+  const char *s;
+  size_t len;
+} DdcToken;
+
+//-- DdcTokens: growable token list
+typedef struct {
+  DdcToken *data;
+  size_t len;
+  size_t alloc;
+} DdcTokens;
+
+//--------------------------------------------------------------
+static void tokens_push(DdcTokens *tl, const char *s, size_t len)
+{
+  if (tl->len >= tl->alloc) {
+    tl->alloc = tl->alloc ? 2*tl->alloc : 64;
+    tl->data  = (DdcToken*)realloc(tl->data, tl->alloc*sizeof(DdcToken));
+    assert2(tl->data != NULL, "realloc failed");
+  }
+  tl->data[tl->len].s   = s;
+  tl->data[tl->len].len = len;
+  ++tl->len;
+}
+
+//--------------------------------------------------------------
+// tokens_split(tl,s)
+//  + appends whitespace-separated tokens of s to tl, as perl split(' ',$s)
+static void tokens_split(DdcTokens *tl, const char *s)
+{
+  const char *t;
+  if (!s) return;
+  for (;;) {
+    while (*s && isspace((unsigned char)*s)) ++s;
+    if (!*s) break;
+    for (t=s; *t && !isspace((unsigned char)*t); ++t) ;
+    tokens_push(tl, s, t-s);
+    s = t;
+  }
+}
+
+//--------------------------------------------------------------
+static int token_cmp(const void *av, const void *bv)
+{
+  const DdcToken *a = (const DdcToken*)av, *b = (const DdcToken*)bv;
+  int cmp = memcmp(a->s, b->s, (a->len < b->len ? a->len : b->len));
+  if (cmp) return cmp;
+  return (a->len < b->len ? -1 : (a->len > b->len ? 1 : 0));
+}
+
+//--------------------------------------------------------------
+// tokens_luniq(tl)
+//  + sorts and de-duplicates tl in-place, as perl luniq() (string sort)
+static void tokens_luniq(DdcTokens *tl)
+{
+  size_t i, j;
+  if (tl->len < 2) return;
+  qsort(tl->data, tl->len, sizeof(DdcToken), token_cmp);
+  for (i=1, j=0; i < tl->len; ++i) {
+    if (token_cmp(&tl->data[i], &tl->data[j]) != 0) tl->data[++j] = tl->data[i];
+  }
+  tl->len = j+1;
+}
+
+//--------------------------------------------------------------
+// tokens_join(tl, sep, dst)
+//  + appends tokens joined by sep to dst
+static void tokens_join(const DdcTokens *tl, const char *sep, DdcBuf *dst)
+{
+  size_t i;
+  for (i=0; i < tl->len; ++i) {
+    if (i > 0) buf_append(dst, sep);
+    buf_appendn(dst, tl->data[i].s, tl->data[i].len);
+  }
+}
+
+/*======================================================================
+ * .cx data
+ */
+
+//-- DdcChar: logical character (.cx record with tlen > 0)
+typedef struct {
+  ByteOffset xoff; //-- xml byte offset
+  uint32_t pb;     //-- page: pb/@facs (or 1-based <pb> index) of most recent <pb>
+  uint32_t lb;     //-- line number on current page
+  int32_t  bb[4];  //-- bbox (ulx,uly,lrx,lry); -1 for undefined
+  uchar    typ;    //-- cxRecordType
+} DdcChar;
+
+DdcChar   *chars  = NULL;  //-- logical characters, in document order
+ByteOffset nchars = 0;     //-- number of logical characters
+
+//--------------------------------------------------------------
+// load_cx(filename)
+//  + populates chars[], nchars
+static void load_cx(const char *filename)
+{
+  cxPacked cxp;
+  dtatwError err;
+  ByteOffset i, pn = 0;
+  uint32_t pb = 0, lb = 0;
+  DdcChar *c;
+  uchar typ;
+  int j;
+
+  memset(&cxp,0,sizeof(cxp));
+  memset(&err,0,sizeof(err));
+  if (cxPackedLoadFile(&cxp, filename, &err) != 0) dtatw_die(&err);
+
+  chars = (DdcChar*)malloc((cxp.len ? cxp.len : 1)*sizeof(DdcChar));
+  assert2(chars != NULL, "malloc failed");
+  for (i=0; i < cxp.len; ++i) {
+    typ = cxp.flags[i] & cxfTypeMask;
+    if (cxp.tlen[i] > 0) {
+      //-- text element: treat it as a logical character
+      c = &chars[nchars++];
+      c->xoff = cxp.xoff[i];
+      c->typ  = typ;
+      c->pb   = pb;
+      c->lb   = lb;
+      for (j=0; j < 4; ++j) c->bb[j] = -1;
+      if (cxp.flags[i] & cxfHasAttrs) {
+	if (typ == cxrChar) { for (j=0; j < 4; ++j) c->bb[j] = (int32_t)cxp_attr(&cxp,i,j); }
+	else if (typ == cxrPb) { c->bb[0] = (int32_t)cxp_attr(&cxp,i,0); }
+      }
+      if (typ == cxrLb) ++lb;
+    }
+    else if (typ == cxrPb) {
+      ++pn;
+      if (cxp.flags[i] & cxfHasAttrs) {
+	pb = cxp_attr(&cxp,i,0);
+	if (pb == 0xffffffff && warn_on_bad_facs && ++n_warnings[wkPbBadFacs] <= MAX_WARNINGS)
+	  fprintf(stderr, "%s: %s: WARNING: invalid @facs for %" PRIuMAX "-th <pb> from %s record number %" PRIuMAX "\n",
+		  prog, txmlfile, (uintmax_t)pn, filename, (uintmax_t)nchars);
+      } else {
+	if (warn_on_bad_facs && ++n_warnings[wkPbNoFacs] <= MAX_WARNINGS)
+	  fprintf(stderr, "%s: %s: WARNING: no @facs attribute for %" PRIuMAX "-th <pb> at %s record number %" PRIuMAX "\n",
+		  prog, txmlfile, (uintmax_t)pn, filename, (uintmax_t)nchars);
+	pb = pn;
+      }
+      lb = 1;
+    }
+    //-- neither text-carrier nor <pb/>: silently ignore
+  }
+
+  cxPackedFree(&cxp);
+}
+
+//--------------------------------------------------------------
+// cn = chars_find(xoff)
+//  + index of first character with xoff==xoff, or NOKEY (cf. Algorithm::BinarySearch::Vec::vbsearch())
+static ByteOffset chars_find(ByteOffset xoff)
+{
+  ByteOffset lo = 0, hi = nchars, mid;
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (chars[mid].xoff < xoff) lo = mid+1;
+    else                        hi = mid;
+  }
+  return (lo < nchars && chars[lo].xoff == xoff) ? lo : NOKEY;
+}
+
+/*======================================================================
+ * .sx data
+ */
+
+//-- SxNode: element node from .sx file
+typedef struct {
+  char *name;       //-- element name
+  int   parent;     //-- index of parent node (-1 for root)
+  int   group;      //-- index of same-named sibling group in sx_groups[]
+  unsigned nth;     //-- 1-based position among same-named siblings
+  char *rendition;  //-- @rendition (or NULL)
+  char *type;       //-- @type (or NULL)
+  char *place;      //-- @place (or NULL)
+  char *xp;         //-- (memo) trimmed xpath (without []-indices)
+  char *xpp;        //-- (memo) untrimmed xpath (with []-indices)
+  char *xr;         //-- (memo) rendition list of node and its ancestors
+  char *xc;         //-- (memo) structural context list of node and its ancestors
+} SxNode;
+
+//-- SxGroup: set of same-named siblings (for libxml-style xpath []-indices)
+typedef struct {
+  const char *name; //-- element name
+  unsigned n;       //-- number of siblings seen so far
+  int next;         //-- next group for same parent (-1 for none)
+} SxGroup;
+
+//-- SxBlock: text block (.sx //c[@n]); properties are those of the parent node
+typedef struct {
+  ByteOffset xoff;
+  ByteOffset xlen;
+  int node;         //-- index of parent node
+  ByteOffset order; //-- document order (for stable sort)
+} SxBlock;
+
+SxNode  *sx_nodes  = NULL;  int sx_nnodes  = 0, sx_anodes  = 0;
+SxGroup *sx_groups = NULL;  int sx_ngroups = 0, sx_agroups = 0;
+SxBlock *sx_blocks = NULL;  ByteOffset sx_nblocks = 0, sx_ablocks = 0;
+
+//-- SxParseData: .sx parse state
+typedef struct {
+  int *stack;       //-- stack[depth] = index of open node (stack[0] = -1: document)
+  int *groups;      //-- groups[depth] = head of child-group list for stack[depth]
+  int depth;        //-- current depth
+  int alloc;        //-- allocated stack size
+} SxParseData;
+
+//--------------------------------------------------------------
+// ci = sx_group(pd, name)
+//  + gets or creates child-group for name under current parent
+static int sx_group(SxParseData *pd, const char *name)
+{
+  int gi;
+  for (gi=pd->groups[pd->depth]; gi >= 0; gi=sx_groups[gi].next) {
+    if (strcmp(sx_groups[gi].name,name)==0) return gi;
+  }
+  if (sx_ngroups >= sx_agroups) {
+    sx_agroups = sx_agroups ? 2*sx_agroups : 256;
+    sx_groups  = (SxGroup*)realloc(sx_groups, sx_agroups*sizeof(SxGroup));
+    assert2(sx_groups != NULL, "realloc failed");
+  }
+  gi = sx_ngroups++;
+  sx_groups[gi].name = NULL;  //-- set by caller (points into node name)
+  sx_groups[gi].n    = 0;
+  sx_groups[gi].next = pd->groups[pd->depth];
+  pd->groups[pd->depth] = gi;
+  return gi;
+}
+
+//--------------------------------------------------------------
+static void sx_cb_start(SxParseData *pd, const XML_Char *name, const XML_Char **attrs)
+{
+  const XML_Char *n;
+  SxNode *nod;
+  int ni, gi;
+
+  //-- block: //c[@n] with non-empty tx data
+  if (strcmp(name,"c")==0 && (n = get_attr("n",attrs)) && perl_true(n) && pd->depth > 0) {
+    size_t nlen = strlen(n);
+    if (!(n[nlen-1]=='0' && (nlen==1 || !perl_isword(n[nlen-2])))) {
+      char *tail;
+      SxBlock *blk;
+      if (sx_nblocks >= sx_ablocks) {
+	sx_ablocks = sx_ablocks ? 2*sx_ablocks : 1024;
+	sx_blocks  = (SxBlock*)realloc(sx_blocks, sx_ablocks*sizeof(SxBlock));
+	assert2(sx_blocks != NULL, "realloc failed");
+      }
+      blk = &sx_blocks[sx_nblocks];
+      blk->xoff  = strtoull(n, &tail, 10);
+      blk->xlen  = strtoull(tail, NULL, 10);
+      blk->node  = pd->stack[pd->depth];
+      blk->order = sx_nblocks++;
+    }
+  }
+
+  //-- allocate node
+  if (sx_nnodes >= sx_anodes) {
+    sx_anodes = sx_anodes ? 2*sx_anodes : 1024;
+    sx_nodes  = (SxNode*)realloc(sx_nodes, sx_anodes*sizeof(SxNode));
+    assert2(sx_nodes != NULL, "realloc failed");
+  }
+  ni  = sx_nnodes++;
+  nod = &sx_nodes[ni];
+  memset(nod,0,sizeof(SxNode));
+  nod->name      = strdup(name);
+  nod->parent    = pd->stack[pd->depth];
+  gi = sx_group(pd, name);
+  if (!sx_groups[gi].name) sx_groups[gi].name = nod->name;
+  nod->group     = gi;
+  nod->nth       = ++sx_groups[gi].n;
+  if ((n = get_attr("rendition",attrs))) nod->rendition = strdup(n);
+  if ((n = get_attr("type",attrs)))      nod->type      = strdup(n);
+  if ((n = get_attr("place",attrs)))     nod->place     = strdup(n);
+
+  //-- push
+  if (pd->depth+2 >= pd->alloc) {
+    pd->alloc  = 2*pd->alloc;
+    pd->stack  = (int*)realloc(pd->stack,  pd->alloc*sizeof(int));
+    pd->groups = (int*)realloc(pd->groups, pd->alloc*sizeof(int));
+    assert2(pd->stack != NULL && pd->groups != NULL, "realloc failed");
+  }
+  ++pd->depth;
+  pd->stack[pd->depth]  = ni;
+  pd->groups[pd->depth] = -1;
+}
+
+//--------------------------------------------------------------
+static void sx_cb_end(SxParseData *pd, const XML_Char *name)
+{
+  --pd->depth;
+}
+
+//--------------------------------------------------------------
+// bool = sx_is_xcontext(name)
+//  + descendants of these elements get marked in their 'xc' attribute
+static int sx_is_xcontext(const char *name)
+{
+  static const char *xcontext_elts[] = {
+    "text","front","body","back","head","foot","end","argument","hi","cit","fw","lg","stage","speaker","formula","table",
+    //"left", //-- DISABLED 2018-11-06 (mantis #31734)
+    NULL
+  };
+  int i;
+  for (i=0; xcontext_elts[i]; ++i) {
+    if (strcmp(name,xcontext_elts[i])==0) return 1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// sx_node_props(ni)
+//  + computes (memoized) block properties xp, xpp, xr, xc for node ni
+static void sx_node_props(int ni)
+{
+  SxNode *nod = &sx_nodes[ni];
+  DdcBuf path, tmp;
+  const char **vals;
+  size_t nvals, nrend = 0;
+  int ai, depth = 0;
+  char *s, *d;
+
+  if (nod->xpp) return;
+  memset(&path,0,sizeof(path));
+  memset(&tmp,0,sizeof(tmp));
+  for (ai=ni; ai >= 0; ai=sx_nodes[ai].parent) ++depth;
+  vals = (const char**)malloc(depth*sizeof(const char*));
+  assert2(vals != NULL, "malloc failed");
+
+  //-- xpp: xpath with libxml-style []-indices (only if there are same-named siblings)
+  {
+    int *chain = (int*)malloc(depth*sizeof(int));
+    int i = depth;
+    char ibuf[32];
+    assert2(chain != NULL, "malloc failed");
+    for (ai=ni; ai >= 0; ai=sx_nodes[ai].parent) chain[--i] = ai;
+    buf_clear(&path);
+    for (i=0; i < depth; ++i) {
+      SxNode *an = &sx_nodes[chain[i]];
+      buf_append(&path, "/");
+      buf_append(&path, an->name);
+      if (sx_groups[an->group].n > 1) {
+	sprintf(ibuf, "[%u]", an->nth);
+	buf_append(&path, ibuf);
+      }
+    }
+    free(chain);
+  }
+  nod->xpp = strdup(path.s);
+
+  //-- xp: without []-indices, and with initial m(^/(?:TEI(?:\.[0-9])?/)?(?:text/)?) removed
+  for (s=d=path.s; *s; ) {
+    if (*s == '[') {
+      char *t = s+1;
+      while (*t >= '0' && *t <= '9') ++t;
+      if (t > s+1 && *t == ']') { s = t+1; continue; }
+    }
+    *d++ = *s++;
+  }
+  *d = '\0';
+  s = path.s;
+  if (*s == '/') {
+    ++s;
+    if (strncmp(s,"TEI",3)==0) {
+      char *t = s+3;
+      if (t[0]=='.' && t[1] >= '0' && t[1] <= '9') t += 2;
+      if (*t == '/') s = t+1;
+    }
+    if (strncmp(s,"text/",5)==0) s += 5;
+  }
+  nod->xp = strdup(s);
+
+  //-- xr: renditions of node and its ancestors
+  for (nvals=0, ai=ni; ai >= 0; ai=sx_nodes[ai].parent) {
+    if (perl_true(sx_nodes[ai].rendition)) vals[nvals++] = sx_nodes[ai].rendition;
+  }
+  //-- ... luniq() on whole attribute values, then join(' ')
+  {
+    DdcTokens tl;
+    memset(&tl,0,sizeof(tl));
+    for (nrend=0; nrend < nvals; ++nrend) tokens_push(&tl, vals[nrend], strlen(vals[nrend]));
+    tokens_luniq(&tl);
+    buf_clear(&tmp);
+    tokens_join(&tl, " ", &tmp);
+    nod->xr = strdup(tmp.s);
+    if (tl.data) free(tl.data);
+  }
+
+  //-- xc: structural context
+  buf_clear(&tmp);
+  {
+    DdcTokens tl;
+    DdcBuf ctx;
+    size_t i;
+    memset(&tl,0,sizeof(tl));
+    memset(&ctx,0,sizeof(ctx));
+    buf_clear(&ctx);
+    for (ai=ni; ai >= 0; ai=sx_nodes[ai].parent) {
+      SxNode *an = &sx_nodes[ai];
+      if (strcmp(an->name,"note")==0) {
+	buf_append(&ctx, "note_");
+	buf_append(&ctx, perl_true(an->place) ? an->place : "other");
+	buf_appendn(&ctx, "", 1);
+      }
+      else if (strcmp(an->name,"div")==0) {
+	buf_append(&ctx, "div_");
+	buf_append(&ctx, perl_true(an->type) ? an->type : "other");
+	buf_appendn(&ctx, "", 1);
+      }
+      else if (sx_is_xcontext(an->name)) {
+	buf_append(&ctx, an->name);
+	buf_appendn(&ctx, "", 1);
+      }
+    }
+    //-- ctx.s now holds NUL-separated values
+    for (i=0; i < ctx.len; i += strlen(ctx.s+i)+1) tokens_push(&tl, ctx.s+i, strlen(ctx.s+i));
+    tokens_luniq(&tl);
+    tokens_join(&tl, " ", &tmp);
+    nod->xc = strdup(tmp.s);
+    if (tl.data) free(tl.data);
+    free(ctx.s);
+  }
+
+  free(vals);
+  free(path.s);
+  free(tmp.s);
+}
+
+//--------------------------------------------------------------
+static int sx_block_cmp(const void *av, const void *bv)
+{
+  const SxBlock *a = (const SxBlock*)av, *b = (const SxBlock*)bv;
+  if (a->xoff  != b->xoff)  return a->xoff  < b->xoff  ? -1 : 1;
+  if (a->xlen  != b->xlen)  return a->xlen  < b->xlen  ? -1 : 1;
+  if (a->order != b->order) return a->order < b->order ? -1 : 1;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// load_sx(filename)
+//  + populates sx_nodes[], sx_blocks[]
+static void load_sx(const char *filename)
+{
+  SxParseData pd;
+  XML_Parser xp;
+  FILE *f;
+  ByteOffset i;
+
+  if (!(f = fopen(filename,"rb"))) {
+    fprintf(stderr, "%s: open failed for .sx-file `%s': %s\n", prog, filename, strerror(errno));
+    exit(1);
+  }
+  memset(&pd,0,sizeof(pd));
+  pd.alloc  = 64;
+  pd.stack  = (int*)malloc(pd.alloc*sizeof(int));
+  pd.groups = (int*)malloc(pd.alloc*sizeof(int));
+  assert2(pd.stack != NULL && pd.groups != NULL, "malloc failed");
+  pd.stack[0]  = -1;
+  pd.groups[0] = -1;
+
+  if (!(xp = XML_ParserCreate("UTF-8"))) {
+    fprintf(stderr, "%s: XML_ParserCreate failed\n", prog);
+    exit(1);
+  }
+  XML_SetUserData(xp, &pd);
+  XML_SetElementHandler(xp, (XML_StartElementHandler)sx_cb_start, (XML_EndElementHandler)sx_cb_end);
+  expat_parse_file(xp, f, filename);
+  XML_ParserFree(xp);
+  fclose(f);
+  free(pd.stack);
+  free(pd.groups);
+
+  //-- sort block-list; compute block properties
+  qsort(sx_blocks, sx_nblocks, sizeof(SxBlock), sx_block_cmp);
+  for (i=0; i < sx_nblocks; ++i) sx_node_props(sx_blocks[i].node);
+}
+
+//--------------------------------------------------------------
+// bi = sx_find(xoff)
+//  + least index of a block with xoff==xoff if one exists,
+//    otherwise greatest index of a block with xoff < xoff, otherwise NOKEY
+//  + cf. Algorithm::BinarySearch::Vec::vbsearch_lb()
+static ByteOffset sx_find(ByteOffset xoff)
+{
+  ByteOffset lo = 0, hi = sx_nblocks, mid;
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (sx_blocks[mid].xoff < xoff) lo = mid+1;
+    else                            hi = mid;
+  }
+  if (lo < sx_nblocks && sx_blocks[lo].xoff == xoff) return lo;
+  return lo > 0 ? lo-1 : NOKEY;
+}
+
+//--------------------------------------------------------------
+// s = sx_block_prop(bi, which)
+static inline SxNode *sx_block_node(ByteOffset bi)
+{
+  return &sx_nodes[sx_blocks[bi].node];
+}
+
+/*======================================================================
+ * .t.xml: merge
+ */
+
+//-- DdcAttrs: output attribute list for current //w
+#define DDC_MAX_ATTRS 64
+typedef struct {
+  const char *name[DDC_MAX_ATTRS];
+  const char *val[DDC_MAX_ATTRS];
+  int n;
+} DdcAttrs;
+
+//--------------------------------------------------------------
+// attrs_set(al,name,val)
+//  + sets attribute value in-place if name is already present, otherwise appends (as libxml setAttribute())
+static void attrs_set(DdcAttrs *al, const char *name, const char *val)
+{
+  int i;
+  for (i=0; i < al->n; ++i) {
+    if (strcmp(al->name[i],name)==0) { al->val[i] = val; return; }
+  }
+  if (al->n >= DDC_MAX_ATTRS) {
+    fprintf(stderr, "%s: too many attributes for //w\n", prog);
+    exit(2);
+  }
+  al->name[al->n] = name;
+  al->val[al->n]  = val;
+  ++al->n;
+}
+
+//--------------------------------------------------------------
+static void attrs_remove(DdcAttrs *al, const char *name)
+{
+  int i, j;
+  for (i=j=0; i < al->n; ++i) {
+    if (strcmp(al->name[i],name)==0) continue;
+    al->name[j] = al->name[i];
+    al->val[j]  = al->val[i];
+    ++j;
+  }
+  al->n = j;
+}
+
+//--------------------------------------------------------------
+static const char *attrs_get(const DdcAttrs *al, const char *name)
+{
+  int i;
+  for (i=0; i < al->n; ++i) {
+    if (strcmp(al->name[i],name)==0) return al->val[i];
+  }
+  return NULL;
+}
+
+//-- TxmlData: .t.xml parse state
+typedef struct {
+  XML_Parser xp;        //-- expat parser
+  const char *buf;      //-- input buffer (copied verbatim except for //w start-tags)
+  ByteOffset copied;    //-- buf[0..copied-1] has already been written
+  FILE *f_out;          //-- output file (NULL for claim pass)
+  int pass;             //-- 1: claim characters (cn2wn) only, 2: compute & write attributes
+  ByteOffset wi;        //-- index of current //w
+  uint32_t *cn2wn;      //-- cn2wn[cn]: index of last //w claiming character cn
+  DdcBuf prev_b;        //-- @b of previous //w
+  int have_prev;        //-- true iff there was a previous //w
+  //-- temporaries
+  ByteOffset *cns;      //-- character indices for current //w
+  ByteOffset  ncns, acns;
+  ByteOffset *bis;      //-- bis[k]: block index for cns[k] (or NOKEY)
+  ByteOffset  abis;
+  DdcBuf t, ws, xr, xc, pb, lb, bb;
+  DdcTokens tl;
+} TxmlData;
+
+//--------------------------------------------------------------
+static void td_push_cn(TxmlData *td, ByteOffset cn)
+{
+  if (td->ncns >= td->acns) {
+    td->acns = td->acns ? 2*td->acns : 64;
+    td->cns  = (ByteOffset*)realloc(td->cns, td->acns*sizeof(ByteOffset));
+    assert2(td->cns != NULL, "realloc failed");
+  }
+  td->cns[td->ncns++] = cn;
+}
+
+//--------------------------------------------------------------
+// xb2cns(td, xb)
+//  + populates td->cns[] from //w/@xb = "XOFF+XLEN ..."
+static void xb2cns(TxmlData *td, const char *xb)
+{
+  const char *s, *t;
+  ByteOffset xoff, xend, cn;
+  td->ncns = 0;
+  if (!xb) return;
+  for (s=xb; *s; ) {
+    //-- /\b([0-9]+)\+([0-9]+)/g
+    if (!isdigit((unsigned char)*s) || (s > xb && perl_isword(s[-1]))) { ++s; continue; }
+    for (t=s; isdigit((unsigned char)*t); ++t) ;
+    if (t[0] != '+' || !isdigit((unsigned char)t[1])) { s = t; continue; }
+    xoff = strtoull(s, NULL, 10);
+    xend = xoff + strtoull(t+1, (char**)&t, 10);
+    if (xend == xoff) xend = xoff+1; //-- formulae have xlen==0
+    for (cn=chars_find(xoff); cn != NOKEY && cn < nchars && chars[cn].xoff < xend; ++cn) {
+      td_push_cn(td, cn);
+    }
+    s = t;
+  }
+}
+
+//--------------------------------------------------------------
+// td_bboxes(td, dst)
+//  + appends word bounding boxes for td->cns[] to dst (see dtatw-get-ddc-attrs.perl bboxes())
+static void td_bboxes(TxmlData *td, DdcBuf *dst)
+{
+  int32_t wbb[4];
+  const int32_t *cbb = NULL;
+  uint32_t pb0;
+  ByteOffset k;
+  int have_wbb = 0, nbb = 0;
+  char tmp[64];
+
+  if (!td->ncns) return;
+  pb0 = chars[td->cns[0]].pb;
+  for (k=0; k <= td->ncns; ++k) {
+    if (k < td->ncns) {
+      if (chars[td->cns[k]].pb != pb0) continue;
+      cbb = chars[td->cns[k]].bb;
+      if (cbb[0] < 0 || cbb[1] < 0 || cbb[2] < 0 || cbb[3] < 0) continue; //-- skip //c bboxes with bad values
+    }
+    if (k == td->ncns || !have_wbb || cbb[2] < wbb[0] || cbb[3] < wbb[1]) {
+      //-- initial bbox, or (character:RIGHT << word:LEFT: line-break), or (character:BOTTOM >> word:TOP: column-break)
+      if (have_wbb) {
+	sprintf(tmp, "%s%d|%d|%d|%d", (nbb++ ? "_" : ""), wbb[0], wbb[1], wbb[2], wbb[3]);
+	buf_append(dst, tmp);
+      }
+      if (k == td->ncns) break;
+      memcpy(wbb, cbb, sizeof(wbb));
+      have_wbb = 1;
+    }
+    else {
+      //-- extend current word bbox
+      if (cbb[0] < wbb[0]) wbb[0] = cbb[0];
+      if (cbb[1] < wbb[1]) wbb[1] = cbb[1];
+      if (cbb[2] > wbb[2]) wbb[2] = cbb[2];
+      if (cbb[3] > wbb[3]) wbb[3] = cbb[3];
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// line_y(td, pb,lb, cn0, want_max, &y)
+//  + scans characters on page pb, line lb near cn0 (see dtatw-get-ddc-attrs.perl clist_byline()),
+//    considering only claimed cxrChar records
+//  + if want_max, *y is the maximum @lry, otherwise the minimum @uly (ignoring negative values; -1 if none)
+//  + returns the number of claimed cxrChar records on the line
+static ByteOffset line_y(TxmlData *td, uint32_t pb, int64_t lb, ByteOffset cn0, int want_max, double *y)
+{
+  ByteOffset cn, n = 0;
+  const DdcChar *c;
+  int32_t v;
+  int have_y = 0;
+
+  //-- stupid linear scan: backwards until cn <= FIRST_CHAR(pb,lb)
+  for (cn=cn0; cn > 0 && cn < nchars; --cn) {
+    c = &chars[cn];
+    if (c->pb < pb || (c->pb == pb && (int64_t)c->lb < lb)) break;
+  }
+
+  //-- stupid linear scan: forwards until cn >= LAST_CHAR(pb,lb)
+  for ( ; cn < nchars; ++cn) {
+    c = &chars[cn];
+    if (c->pb == pb && (int64_t)c->lb == lb && c->typ == cxrChar && td->cn2wn[cn]) {
+      ++n;
+      v = want_max ? c->bb[3] : c->bb[1];
+      if (v >= 0 && (!have_y || (want_max ? v > *y : v < *y))) {
+	*y = v;
+	have_y = 1;
+      }
+    }
+    if (c->pb > pb || (c->pb == pb && (int64_t)c->lb > lb)) break;
+  }
+
+  if (!have_y) *y = -1;
+  return n;
+}
+
+//--------------------------------------------------------------
+static inline double ddc_fabs(double x) { return x < 0 ? -x : x; }
+
+//--------------------------------------------------------------
+// td_formula_bbox(td, dst)
+//  + appends line-based bbox guess for formula //w with characters td->cns[] to dst
+//  + reproduces the heuristics of dtatw-get-ddc-attrs.perl apply_ddc_attrs() pass 2 exactly
+static void td_formula_bbox(TxmlData *td, const char *wid, DdcBuf *dst)
+{
+  const DdcChar *c0 = &chars[td->cns[0]];
+  double yprev, ynext, growby;
+  ByteOffset nprev, nnext;
+  char tmp[64];
+
+  //-- get line bbox (min,max) from characters on surrounding line(s)
+  nprev = line_y(td, c0->pb, (int64_t)c0->lb-1, td->cns[0], 1, &yprev);
+  nnext = line_y(td, c0->pb, (int64_t)c0->lb+1, td->cns[0], 0, &ynext);
+
+  //-- defaults
+  if (yprev <= 0) yprev = -1;
+  if (ynext <= 0) ynext = -1;
+
+  //-- maximum bbox size hack
+  if (ynext >= 0 && yprev >= 0 && ddc_fabs(ynext-yprev) > MAX_FORMULA_PIX) {
+    yprev = ynext = -1;
+  }
+
+  //-- top/bottom of page
+  if (yprev >= 0 && (ynext < 0 || !nnext)) {
+    ynext = PAGE_BOTTOM_Y;
+  }
+  else if (ynext >= 0 && (yprev < 0 || !nprev)) {
+    yprev = PAGE_TOP_Y;
+  }
+
+  //-- bbox sanity condition
+  if (ynext >= 0 && yprev >= 0 && ynext < yprev) {
+    double ytmp = yprev;
+    yprev = ynext;
+    ynext = ytmp;
+  }
+
+  //-- minimum-height check
+  if (yprev >= 0 && ynext >= 0 && ddc_fabs(ynext-yprev) < MIN_FORMULA_PIX) {
+    growby = (MIN_FORMULA_PIX - ddc_fabs(ynext-yprev))/2;
+    yprev -= growby;
+    ynext += growby;
+  }
+
+  //-- ensure integer (perl int() truncates towards zero)
+  yprev = (double)(long)(yprev-0.5);
+  ynext = (double)(long)(ynext+0.5);
+
+  if (verbose >= VL_WARN && yprev < 0 && ynext < 0)
+    fprintf(stderr, "%s: %s: WARNING: could not guess bbox for formula //w#%s at line %lu\n",
+	    prog, txmlfile, (wid ? wid : "-"), (unsigned long)XML_GetCurrentLineNumber(td->xp));
+
+  sprintf(tmp, "-1|%.0f|-1|%.0f", yprev, ynext);
+  buf_append(dst, tmp);
+}
+
+//--------------------------------------------------------------
+// split_b(b, &off, &len)
+//  + emulates ($off,$len) = split(' ', $b, 2) with perl numeric conversion; returns number of fields
+static int split_b(const char *b, double *off, double *len)
+{
+  const char *s = b;
+  int n = 0;
+  *off = *len = 0;
+  if (!b) return 0;
+  while (*s && isspace((unsigned char)*s)) ++s;
+  if (!*s) return 0;
+  *off = strtod(s, NULL);
+  ++n;
+  while (*s && !isspace((unsigned char)*s)) ++s;
+  while (*s && isspace((unsigned char)*s)) ++s;
+  if (*s) {
+    *len = strtod(s, NULL);
+    ++n;
+  }
+  return n;
+}
+
+//--------------------------------------------------------------
+// apply_word(td, al)
+//  + computes DDC attributes for current //w, modifying al
+static void apply_word(TxmlData *td, DdcAttrs *al)
+{
+  const char *wid, *xb, *b, *wtxt;
+  ByteOffset k, bi, bmin = NOKEY;
+  int w_is_formula, nb = 0;
+  char tmp[64];
+
+  //-- get id (...and ensure it's in the raw '//w/@id' attribute and not 'xml:id')
+  if (!(wid = attrs_get(al,"id"))) {
+    int i;
+    for (i=0; i < al->n; ++i) {
+      if (strcmp(al->name[i],"xml:id")==0) { al->name[i] = "id"; wid = al->val[i]; break; }
+    }
+  }
+
+  //-- get xml byte-range
+  xb = attrs_get(al,"xb");
+  if (!perl_true(xb)) {
+    xb = "";
+    if (verbose >= VL_WARN && ++n_warnings[wkEmptyXb] <= MAX_WARNINGS)
+      fprintf(stderr, "%s: %s: WARNING: no xml byte-range attribute @xb for //w#%s at line %lu\n",
+	      prog, txmlfile, (wid ? wid : "-"), (unsigned long)XML_GetCurrentLineNumber(td->xp));
+  }
+
+  //-- get cx records
+  xb2cns(td, xb);
+  if (*xb && !td->ncns && warn_on_empty_clist && verbose >= VL_WARN && ++n_warnings[wkEmptyClist] <= MAX_WARNINGS)
+    fprintf(stderr, "%s: %s: WARNING: no cx-list for //w#%s [@xb=\"%s\"] at line %lu\n",
+	    prog, txmlfile, (wid ? wid : "-"), xb, (unsigned long)XML_GetCurrentLineNumber(td->xp));
+
+  //-- get sx records
+  if (td->ncns > td->abis) {
+    td->abis = td->ncns;
+    td->bis  = (ByteOffset*)realloc(td->bis, td->abis*sizeof(ByteOffset));
+    assert2(td->bis != NULL, "realloc failed");
+  }
+  for (k=0; k < td->ncns; ++k) {
+    bi = td->bis[k] = sx_find(chars[td->cns[k]].xoff);
+    if (bi == NOKEY) continue;
+    ++nb;
+    //-- @blks is sorted by perl luniq() as strings, so $blks[0] is the lexicographically least index
+    if (bmin == NOKEY || bi != bmin) {
+      char s1[32], s2[32];
+      sprintf(s1, "%" PRIuMAX, (uintmax_t)bi);
+      sprintf(s2, "%" PRIuMAX, (uintmax_t)bmin);
+      if (bmin == NOKEY || strcmp(s1,s2) < 0) bmin = bi;
+    }
+  }
+  if (td->ncns && !nb && warn_on_empty_blist && verbose >= VL_WARN && ++n_warnings[wkEmptyBlist] <= MAX_WARNINGS)
+    fprintf(stderr, "%s: %s: WARNING: no sx-block-list for //w#%s [@xb=\"%s\"] at line %lu\n",
+	    prog, txmlfile, (wid ? wid : "-"), xb, (unsigned long)XML_GetCurrentLineNumber(td->xp));
+
+  //-- compute & assign: whitespace-separation (wsep: does whitespace precede this word?)
+  b = attrs_get(al,"b");
+  if (do_wsep) {
+    double off, len, poff = 0, plen = 0;
+    if (split_b(perl_true(b) ? b : "", &off, &len) < 1) off = -1;
+    if (td->have_prev) split_b(perl_true(td->prev_b.s) ? td->prev_b.s : "", &poff, &plen);
+    buf_clear(&td->ws);
+    buf_append(&td->ws, (off == poff+plen ? "0" : "1"));
+    attrs_set(al, "ws", td->ws.s);
+  }
+  buf_clear(&td->prev_b);
+  if (b) buf_append(&td->prev_b, b);
+  td->have_prev = 1;
+
+  //-- detect: formula
+  w_is_formula = (td->ncns && chars[td->cns[0]].typ == cxrFormula);
+
+  //-- get text
+  wtxt = attrs_get(al,"t");
+  if (!perl_true(wtxt)) wtxt = attrs_get(al,"text");
+  if (!perl_true(wtxt)) wtxt = "";
+
+  //-- compute & assign: formula text
+  buf_clear(&td->t);
+  if (*formula_text && w_is_formula) {
+    wtxt = formula_text;
+    buf_append(&td->t, wtxt);
+    attrs_set(al, "t", td->t.s);
+  }
+
+  //-- compute & assign: whitespace-bashing
+  if (!keep_ws) {
+    int i = 0, i0, nsubst = 0;
+    int len = strlen(wtxt);
+    uint32_t c;
+    DdcBuf tb;
+    memset(&tb,0,sizeof(tb));
+    buf_clear(&tb);
+    while (i < len) {
+      i0 = i;
+      c  = u8_nextchar(wtxt, &i);
+      if (perl_isspace(c)) { buf_appendn(&tb, "_", 1); ++nsubst; }
+      else                 { buf_appendn(&tb, wtxt+i0, i-i0); }
+    }
+    if (nsubst) {
+      buf_clear(&td->t);
+      buf_appendn(&td->t, tb.s, tb.len);
+      attrs_set(al, "t", td->t.s);
+    }
+    free(tb.s);
+  }
+
+  //-- compute & assign: rendition (undef -> '-')
+  if (do_rendition) {
+    int has_head = 0;
+    td->tl.len = 0;
+    for (k=0; k < td->ncns; ++k) {
+      if (td->bis[k] != NOKEY) tokens_split(&td->tl, sx_block_node(td->bis[k])->xr);
+    }
+    tokens_luniq(&td->tl);
+    for (k=0; k < td->tl.len; ++k) {
+      if (td->tl.data[k].len > 0 && td->tl.data[k].s[0] == '#') { ++td->tl.data[k].s; --td->tl.data[k].len; }
+    }
+    if (foreign) {
+      //-- include 'head' context for non-DTA rendition lists
+      DdcTokens xtl;
+      memset(&xtl,0,sizeof(xtl));
+      for (k=0; k < td->ncns && !has_head; ++k) {
+	if (td->bis[k] == NOKEY) continue;
+	xtl.len = 0;
+	tokens_split(&xtl, sx_block_node(td->bis[k])->xc);
+	for (bi=0; bi < xtl.len; ++bi) {
+	  if (xtl.data[bi].len == 4 && strncmp(xtl.data[bi].s,"head",4)==0) { has_head = 1; break; }
+	}
+      }
+      if (xtl.data) free(xtl.data);
+      if (has_head) tokens_push(&td->tl, "head", 4);
+    }
+    buf_clear(&td->xr);
+    tokens_join(&td->tl, rend_sep, &td->xr);
+    if (perl_true(td->xr.s)) {
+      DdcBuf tb;
+      memset(&tb,0,sizeof(tb));
+      buf_clear(&tb);
+      buf_append(&tb, rend_left);
+      buf_appendn(&tb, td->xr.s, td->xr.len);
+      buf_append(&tb, rend_right);
+      free(td->xr.s);
+      td->xr = tb;
+    } else {
+      buf_clear(&td->xr);
+      buf_append(&td->xr, "-");
+    }
+    attrs_set(al, "xr", td->xr.s);
+  }
+
+  //-- compute & assign: structural context: xcontext (undef -> '-')
+  if (do_xcontext) {
+    td->tl.len = 0;
+    for (k=0; k < td->ncns; ++k) {
+      if (td->bis[k] != NOKEY) tokens_split(&td->tl, sx_block_node(td->bis[k])->xc);
+    }
+    tokens_luniq(&td->tl);
+    buf_clear(&td->xc);
+    if (td->tl.len) {
+      buf_append(&td->xc, "|");
+      tokens_join(&td->tl, "|", &td->xc);
+      buf_append(&td->xc, "|");
+    } else {
+      buf_append(&td->xc, "-");
+    }
+    attrs_set(al, "xc", td->xc.s);
+  }
+
+  //-- compute & assign: xpath (undef -> '/..' (== empty node set))
+  if (do_xpath) {
+    attrs_set(al, "xp", (bmin != NOKEY ? sx_block_node(bmin)->xp : "/.."));
+  }
+
+  //-- compute & assign: xppath (undef -> '/..' (== empty node set))
+  if (do_xppath) {
+    attrs_set(al, "xpp", (bmin != NOKEY ? sx_block_node(bmin)->xpp : "/.."));
+  }
+
+  //-- compute & assign: page (undef -> -1; non-empty @cs only)
+  if (do_page) {
+    buf_clear(&td->pb);
+    if (td->ncns) sprintf(tmp, "%" PRIu32, chars[td->cns[0]].pb);
+    else strcpy(tmp, "-1");
+    buf_append(&td->pb, tmp);
+    attrs_set(al, "pb", td->pb.s);
+  }
+
+  //-- compute & assign: line (undef -> -1; non-empty @cs only)
+  if (do_line) {
+    buf_clear(&td->lb);
+    if (td->ncns) sprintf(tmp, "%" PRIu32, chars[td->cns[0]].lb);
+    else strcpy(tmp, "-1");
+    buf_append(&td->lb, tmp);
+    attrs_set(al, "lb", td->lb.s);
+  }
+
+  //-- compute & assign: bbox (undef -> ''; non-empty @cs only; formulae: guess from surrounding lines)
+  if (do_bbox && td->ncns) {
+    buf_clear(&td->bb);
+    if (w_is_formula) td_formula_bbox(td, wid, &td->bb);
+    else              td_bboxes(td, &td->bb);
+    attrs_set(al, "bb", td->bb.s);
+  }
+
+  //-- remove 'c','b','xb' attributes if requested
+  if (!do_keep_c) {
+    attrs_remove(al, "c");
+    attrs_remove(al, "cs");
+  }
+  if (!do_keep_b)  attrs_remove(al, "b");
+  if (!do_keep_xb) attrs_remove(al, "xb");
+}
+
+//--------------------------------------------------------------
+static void td_cb_start(TxmlData *td, const XML_Char *name, const XML_Char **attrs)
+{
+  DdcAttrs al;
+  ByteOffset start, len, k;
+  int i;
+
+  if (strcmp(name,"w") != 0) return;
+
+  if (td->pass == 1) {
+    //-- claim pass: record //c claims only
+    xb2cns(td, get_attr("xb",attrs));
+    for (k=0; k < td->ncns; ++k) td->cn2wn[td->cns[k]] = (uint32_t)td->wi;
+    ++td->wi;
+    return;
+  }
+
+  //-- copy input up to current start-tag
+  start = XML_GetCurrentByteIndex(td->xp);
+  len   = XML_GetCurrentByteCount(td->xp);
+  if (start > td->copied) fwrite(td->buf+td->copied, 1, start-td->copied, td->f_out);
+  td->copied = start+len;
+
+  //-- compute attributes
+  al.n = 0;
+  for (i=0; attrs[i]; i += 2) attrs_set(&al, attrs[i], attrs[i+1]);
+  apply_word(td, &al);
+  ++td->wi;
+
+  //-- write modified start-tag
+  fputc('<', td->f_out);
+  fputs(name, td->f_out);
+  for (i=0; i < al.n; ++i) {
+    fprintf(td->f_out, " %s=\"", al.name[i]);
+    put_escaped_str(td->f_out, al.val[i], -1);
+    fputc('"', td->f_out);
+  }
+  fputs((len >= 2 && td->buf[start+len-2]=='/' ? "/>" : ">"), td->f_out);
+}
+
+//--------------------------------------------------------------
+// txml_parse(td, buf,buflen)
+static void txml_parse(TxmlData *td, const char *buf, ByteOffset buflen)
+{
+  dtatwError err;
+  memset(&err,0,sizeof(err));
+  if (!(td->xp = XML_ParserCreate("UTF-8"))) {
+    fprintf(stderr, "%s: XML_ParserCreate failed\n", prog);
+    exit(1);
+  }
+  XML_SetUserData(td->xp, td);
+  XML_SetStartElementHandler(td->xp, (XML_StartElementHandler)td_cb_start);
+  td->buf    = buf;
+  td->copied = 0;
+  td->wi     = 0;
+  if (expat_try_parse_string(td->xp, buf, (int)buflen, txmlfile, &err) != 0) dtatw_die(&err);
+  if (td->f_out && td->copied < buflen) fwrite(buf+td->copied, 1, buflen-td->copied, td->f_out);
+  XML_ParserFree(td->xp);
+  td->xp = NULL;
+}
+
+/*======================================================================
+ * MAIN
+ */
+
+//-- boolean options: -NAME, -noNAME
+typedef struct {
+  const char *name;
+  int *var;
+} DdcBoolOpt;
+
+static DdcBoolOpt bool_opts[] = {
+  {"whitespace",&keep_ws},     {"ws",&keep_ws},
+  {"page",&do_page},           {"pb",&do_page},        {"p",&do_page},
+  {"line",&do_line},           {"lb",&do_line},        {"l",&do_line},
+  {"rendition",&do_rendition}, {"rend",&do_rendition}, {"xr",&do_rendition}, {"r",&do_rendition},
+  {"xcontext",&do_xcontext},   {"context",&do_xcontext}, {"xcon",&do_xcontext}, {"con",&do_xcontext}, {"xc",&do_xcontext},
+  {"xpath",&do_xpath},         {"path",&do_xpath},     {"xp",&do_xpath},
+  {"xppath",&do_xppath},       {"ppath",&do_xppath},   {"xpp",&do_xppath},
+  {"coordinates",&do_bbox},    {"coords",&do_bbox},    {"coord",&do_bbox},     {"c",&do_bbox},
+  {"bboxes",&do_bbox},         {"bbox",&do_bbox},      {"bb",&do_bbox},        {"b",&do_bbox},
+  {"word-separation",&do_wsep}, {"word-sep",&do_wsep}, {"wsep",&do_wsep},      {"sep",&do_wsep},
+  {"keep-c",&do_keep_c},       {"keepc",&do_keep_c},   {"kc",&do_keep_c},
+  {"keep-b",&do_keep_b},       {"keepb",&do_keep_b},   {"kb",&do_keep_b},
+  {"keep-xb",&do_keep_xb},     {"keepxb",&do_keep_xb}, {"kxb",&do_keep_xb},
+  {"unicruft",&do_unicruft},   {"cruft",&do_unicruft}, {"u",&do_unicruft},
+  {"transliterate",&do_unicruft}, {"xlit",&do_unicruft}, {"xl",&do_unicruft},
+  //-- XML::LibXML parser options: ignored (input is copied verbatim)
+  {"keep-blanks",&ignored_opt}, {"blanks",&ignored_opt},
+  {"external-dtd",&ignored_opt}, {"ext-dtd",&ignored_opt}, {"edtd",&ignored_opt}, {"dtd",&ignored_opt},
+  {"format",&ignored_opt},     {"f",&ignored_opt},
+  {NULL,NULL}
+};
+
+static void usage(void)
+{
+  fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+  fprintf(stderr, "Usage:\n");
+  fprintf(stderr, " %s [OPTIONS] -noxlit TXMLFILE\n", prog);
+  fprintf(stderr, " + TXMLFILE : tokenized XML file (.t.xml)\n");
+  fprintf(stderr, " + OPTIONS (cf. dtatw-get-ddc-attrs.perl; -noOPT negates boolean OPT):\n");
+  fprintf(stderr, "   -help              # this help message\n");
+  fprintf(stderr, "   -verbose LEVEL     # verbosity level (default=%d)\n", VL_WARN);
+  fprintf(stderr, "   -quiet             # alias for -verbose=0\n");
+  fprintf(stderr, "   -cx CXFILE         # input .cx file (default=TXMLFILE:.t.xml=.cx)\n");
+  fprintf(stderr, "   -sx SXFILE         # input .sx file (default=CXFILE:.cx=.sx)\n");
+  fprintf(stderr, "   -output OUTFILE    # output file (default=- (stdout))\n");
+  fprintf(stderr, "   -ws                # keep whitespace in //w/@t (default=don't)\n");
+  fprintf(stderr, "   -page  , -line     # extract //w/@pb, //w/@lb (default=do)\n");
+  fprintf(stderr, "   -rend  , -xcon     # extract //w/@xr, //w/@xc (default=do)\n");
+  fprintf(stderr, "   -xpath , -xppath   # extract //w/@xp (default=do), //w/@xpp (default=don't)\n");
+  fprintf(stderr, "   -bbox              # extract //w/@bb (default=don't; implies -page -line)\n");
+  fprintf(stderr, "   -wsep              # extract //w/@ws (default=do)\n");
+  fprintf(stderr, "   -keep-c, -keep-b, -keep-xb  # keep existing //w/@c+@cs, //w/@b, //w/@xb (default=keep)\n");
+  fprintf(stderr, "   -formula-text TEXT # output text for //formula elements (default='' (no change))\n");
+  fprintf(stderr, "   -foreign , -dta    # non-DTA (foreign) or DTA mode (default=-dta)\n");
+  fprintf(stderr, "   -noxlit            # don't extract //w/@u (required: unicruft transliteration is not supported)\n");
+  fprintf(stderr, " + output is identical to that of dtatw-get-ddc-attrs.perl -noxlit\n");
+}
+
+//--------------------------------------------------------------
+// s = guess_filename(src, suff, newsuff)
+//  + returns src with suffix suff replaced by newsuff, or NULL if src doesn't end in suff
+static char *guess_filename(const char *src, const char *suff, const char *newsuff)
+{
+  size_t len = strlen(src), slen = strlen(suff);
+  char *dst;
+  if (len < slen || strcmp(src+len-slen,suff) != 0) return NULL;
+  dst = (char*)malloc(len-slen+strlen(newsuff)+1);
+  assert2(dst != NULL, "malloc failed");
+  memcpy(dst, src, len-slen);
+  strcpy(dst+len-slen, newsuff);
+  return dst;
+}
+
+int main(int argc, char **argv)
+{
+  const char *outfile = "-";
+  FILE *f_in = stdin, *f_out = stdout;
+  char *buf = NULL;
+  ByteOffset buflen = 0;
+  off_t fsize;
+  int mapped = 0;
+  TxmlData td;
+  int argi;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+  memset(&td,0,sizeof(td));
+  memset(n_warnings,0,sizeof(n_warnings));
+
+  //-- command-line: options
+  for (argi=1; argi < argc && argv[argi][0]=='-' && argv[argi][1]; ++argi) {
+    char optbuf[64], *opt = optbuf;
+    const char *arg = NULL, *eq;
+    int negate = 0, i;
+
+    //-- split "-OPT=VALUE" (Getopt::Long syntax)
+    strncpy(optbuf, argv[argi]+(argv[argi][1]=='-' ? 2 : 1), sizeof(optbuf)-1);
+    optbuf[sizeof(optbuf)-1] = '\0';
+    if ((eq = strchr(optbuf,'='))) {
+      optbuf[eq-optbuf] = '\0';
+      arg = strchr(argv[argi],'=')+1;
+    }
+#define DDC_OPT_ARG() \
+    if (!arg) { \
+      if (argi+1 >= argc) { fprintf(stderr, "%s: option `%s' requires an argument\n", prog, argv[argi]); exit(1); } \
+      arg = argv[++argi]; \
+    }
+
+    if (strcmp(opt,"help")==0 || strcmp(opt,"h")==0) { usage(); exit(0); }
+    else if (strcmp(opt,"quiet")==0 || strcmp(opt,"q")==0) { verbose = 0; continue; }
+    else if (strcmp(opt,"foreign")==0 || strcmp(opt,"nodta")==0) { foreign = 1; warn_on_bad_facs = 0; continue; }
+    else if (strcmp(opt,"dta")==0 || strcmp(opt,"noforeign")==0) { foreign = 0; warn_on_bad_facs = 1; continue; }
+    else if (strcmp(opt,"verbose")==0 || strcmp(opt,"v")==0) { DDC_OPT_ARG(); verbose = atoi(arg); continue; }
+    else if (strcmp(opt,"cxfile")==0 || strcmp(opt,"cxf")==0 || strcmp(opt,"cx")==0) { DDC_OPT_ARG(); cxfile = arg; continue; }
+    else if (strcmp(opt,"sxfile")==0 || strcmp(opt,"sxf")==0 || strcmp(opt,"sx")==0) { DDC_OPT_ARG(); sxfile = arg; continue; }
+    else if (strcmp(opt,"output")==0 || strcmp(opt,"out")==0 || strcmp(opt,"o")==0) { DDC_OPT_ARG(); outfile = arg; continue; }
+    else if (strcmp(opt,"formula-text")==0 || strcmp(opt,"ft")==0) { DDC_OPT_ARG(); formula_text = arg; continue; }
+#undef DDC_OPT_ARG
+
+    if (strncmp(opt,"no",2)==0) { negate = 1; opt += 2; }
+    for (i=0; bool_opts[i].name; ++i) {
+      if (strcmp(opt,bool_opts[i].name)==0) { *bool_opts[i].var = !negate; break; }
+    }
+    if (!bool_opts[i].name) {
+      fprintf(stderr, "%s: unknown option `%s'\n", prog, argv[argi]);
+      usage();
+      exit(1);
+    }
+  }
+
+  //-- command-line: arguments
+  if (argi < argc) txmlfile = argv[argi];
+  if (!cxfile || !*cxfile) {
+    if (!(cxfile = guess_filename(txmlfile, ".t.xml", ".cx"))) {
+      fprintf(stderr, "%s: could not guess CX_FILE for T_XML_FILE=%s\n", prog, txmlfile);
+      usage();
+      exit(1);
+    }
+  }
+  if (!sxfile || !*sxfile) {
+    if (!(sxfile = guess_filename(cxfile, ".cx", ".sx"))) {
+      fprintf(stderr, "%s: could not guess SX_FILE for CX_FILE=%s\n", prog, cxfile);
+      usage();
+      exit(1);
+    }
+  }
+
+  //-- sanity checks
+  if (do_unicruft) {
+    //-- dtatw-get-ddc-attrs.perl writes //w/@u by default: don't silently produce different output
+    fprintf(stderr, "%s: unicruft transliteration (//w/@u) is not supported; use -noxlit to omit it\n", prog);
+    exit(1);
+  }
+  if (do_bbox) do_page = do_line = 1;
+  if (foreign) { rend_left = ""; rend_right = ""; rend_sep = ":"; }
+
+  //-- load .sx, .cx
+  load_sx(sxfile);
+  if (verbose >= VL_INFO)
+    fprintf(stderr, "%s: loaded %" PRIuMAX " block record(s) from '%s'\n", prog, (uintmax_t)sx_nblocks, sxfile);
+  load_cx(cxfile);
+  if (verbose >= VL_INFO)
+    fprintf(stderr, "%s: loaded %" PRIuMAX " character record(s) from '%s'\n", prog, (uintmax_t)nchars, cxfile);
+
+  //-- load .t.xml (mmap()ed if possible: it is parsed twice for -bbox)
+  if (strcmp(txmlfile,"-")!=0 && !(f_in = fopen(txmlfile,"rb"))) {
+    fprintf(stderr, "%s: open failed for input .t.xml file `%s': %s\n", prog, txmlfile, strerror(errno));
+    exit(1);
+  }
+  fsize = (f_in == stdin ? -1 : file_size(f_in));
+  if (fsize > 0 && zio_sniff(f_in) != zioRaw) {
+    //-- compressed .t.xml (see dtatwZio.h): decompress into memory
+    dtatwError err;
+    memset(&err, 0, sizeof(err));
+    buflen = zio_fslurp(f_in, txmlfile, &buf, &err);
+    if (!buf) dtatw_die(&err);
+  }
+#if HAVE_SYS_MMAN_H
+  else if (fsize > 0 && (buf = (char*)mmap(NULL, fsize, PROT_READ, MAP_PRIVATE, fileno(f_in), 0)) != MAP_FAILED) {
+    buflen = fsize;
+    mapped = 1;
+  }
+#endif
+  else {
+    buf = NULL;
+    buflen = file_slurp(f_in, &buf, 0);
+  }
+
+  //-- open output file
+  if (strcmp(outfile,"-")!=0 && !(f_out = fopen(outfile,"wb"))) {
+    fprintf(stderr, "%s: open failed for output file `%s': %s\n", prog, outfile, strerror(errno));
+    exit(1);
+  }
+
+  //-- pass 1: claim characters (formula bbox heuristics consider only claimed characters on surrounding lines)
+  td.cn2wn = (uint32_t*)calloc((nchars ? nchars : 1), sizeof(uint32_t));
+  assert2(td.cn2wn != NULL, "calloc failed");
+  if (do_bbox) {
+    td.pass  = 1;
+    td.f_out = NULL;
+    txml_parse(&td, buf, buflen);
+  }
+
+  //-- pass 2: compute attributes & dump
+  td.pass  = 2;
+  td.f_out = f_out;
+  txml_parse(&td, buf, buflen);
+  if (verbose >= VL_INFO)
+    fprintf(stderr, "%s: processed %" PRIuMAX " word(s) from '%s'\n", prog, (uintmax_t)td.wi, txmlfile);
+
+  //-- cleanup
+#if HAVE_SYS_MMAN_H
+  if (mapped) munmap(buf, buflen);
+  else
+#endif
+  if (buf) free(buf);
+  if (f_in != stdin) fclose(f_in);
+  if (f_out != stdout) fclose(f_out);
+  else fflush(f_out);
+
+  return 0;
+}
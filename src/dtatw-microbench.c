@@ -0,0 +1,653 @@
+#include "dtatwCommon.h"
+#include "dtatwUtf8.h"
+#include <time.h>
+
+/*======================================================================
+ * Globals
+ */
+
+//-- options
+static size_t      mb_size   = 1<<20; //-- approximate number of operations (records, characters, bytes) per trial
+static int         mb_trials = 10;    //-- number of timed trials per kernel
+static int         mb_warmup = 2;     //-- number of untimed warm-up trials per kernel
+static uint32_t    mb_seed   = 42;    //-- random seed for generated data
+static const char *mb_filter = NULL;  //-- only run kernels whose name contains this substring (NULL: all)
+static int         mb_simd   = U8_SIMD_AUTO; //-- SIMD level for u8_decoden(), u8_validate()
+
+//-- mb_sink: accumulates kernel results, so the compiler can't optimize the kernels away
+static volatile uint64_t mb_sink = 0;
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// mb_rand()
+//  + xorshift32 pseudo-random generator: reproducible across platforms for a given seed
+static uint32_t mb_rstate = 42;
+static inline uint32_t mb_rand(void)
+{
+  mb_rstate ^= mb_rstate << 13;
+  mb_rstate ^= mb_rstate >> 17;
+  mb_rstate ^= mb_rstate << 5;
+  return mb_rstate;
+}
+
+//-- mb_randn(n): pseudo-random integer in [0,n)
+static inline uint32_t mb_randn(uint32_t n) { return mb_rand() % n; }
+
+//--------------------------------------------------------------
+// mb_now()
+//  + monotonic time in seconds
+static double mb_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+//--------------------------------------------------------------
+// mb_tmpfile()
+//  + temporary stdio stream for the cx & packed-integer kernels (as for real .cx files)
+static FILE *mb_tmpfile(void)
+{
+  FILE *f = tmpfile();
+  if (!f) {
+    fprintf(stderr, "%s: tmpfile() failed: %s\n", prog, strerror(errno));
+    exit(3);
+  }
+  return f;
+}
+
+/*======================================================================
+ * Data: text
+ */
+
+//-- mb_text: generated UTF-8 text (mb_size bytes, NUL-terminated)
+static char   *mb_text   = NULL;
+static size_t  mb_textlen = 0;
+static size_t  mb_nchars  = 0;
+
+//-- mb_text_chars[]: character distribution for generated text, roughly as for DTA sources
+//   + mostly ASCII, some 2-byte (umlauts, long-s, combining e), few 3-byte (quotes, dashes) and 4-byte characters
+static const uint32_t mb_text_chars[] = {
+  'e','e','e','n','n','i','i','s','s','r','r','a','t','d','h','u','l','c','g','m','o','b','w','f','k','z',
+  'D','S','E','G',',','.',' ',' ',' ',' ',' ',' ',' ',
+  0xe4 /* a-umlaut */, 0xf6 /* o-umlaut */, 0xfc /* u-umlaut */, 0xdf /* sharp-s */,
+  0x17f /* long-s */, 0x17f, 0x364 /* combining e */,
+  0x201e /* low-9 quote */, 0x2014 /* em-dash */,
+  0x1d11e /* musical symbol (4 bytes) */,
+};
+#define MB_TEXT_NCHARS (sizeof(mb_text_chars)/sizeof(mb_text_chars[0]))
+
+//--------------------------------------------------------------
+static void mb_text_setup(void)
+{
+  size_t alloc = mb_size + 8;
+  if (mb_text) return;
+  mb_text = (char*)malloc(alloc);
+  assert(mb_text != NULL /* malloc failed */);
+  mb_textlen = 0;
+  mb_nchars  = 0;
+  while (mb_textlen + 4 < mb_size) {
+    mb_textlen += u8_wc_toutf8(mb_text+mb_textlen, mb_text_chars[mb_randn(MB_TEXT_NCHARS)]);
+    ++mb_nchars;
+  }
+  mb_text[mb_textlen] = '\0';
+}
+
+/*======================================================================
+ * Kernels: UTF-8
+ */
+
+//--------------------------------------------------------------
+// u8_nextcharn: decode mb_text
+static size_t mb_u8_nextcharn_run(size_t *nops)
+{
+  int i = 0, len = (int)mb_textlen;
+  uint64_t sum = 0;
+  while (i < len) {
+    sum += u8_nextcharn(mb_text, len, &i);
+  }
+  mb_sink += sum;
+  *nops = mb_nchars;
+  return mb_textlen;
+}
+
+//--------------------------------------------------------------
+// u8_wc_toutf8: encode decoded mb_text
+static uint32_t *mb_wcs = NULL;
+static char     *mb_u8buf = NULL;
+
+static void mb_u8_wc_toutf8_setup(void)
+{
+  int i = 0;
+  size_t wi = 0;
+  mb_text_setup();
+  mb_wcs   = (uint32_t*)malloc(mb_nchars*sizeof(uint32_t));
+  mb_u8buf = (char*)malloc(4*mb_nchars+4);
+  assert(mb_wcs != NULL && mb_u8buf != NULL /* malloc failed */);
+  while (i < (int)mb_textlen) {
+    mb_wcs[wi++] = u8_nextcharn(mb_text, (int)mb_textlen, &i);
+  }
+}
+
+static size_t mb_u8_wc_toutf8_run(size_t *nops)
+{
+  size_t wi, len=0;
+  for (wi=0; wi < mb_nchars; wi++) {
+    len += u8_wc_toutf8(mb_u8buf+len, mb_wcs[wi]);
+  }
+  mb_sink += (unsigned char)mb_u8buf[len/2];
+  *nops = mb_nchars;
+  return len;
+}
+
+static void mb_u8_wc_toutf8_teardown(void)
+{
+  free(mb_wcs);
+  free(mb_u8buf);
+  mb_wcs = NULL;
+  mb_u8buf = NULL;
+}
+
+//--------------------------------------------------------------
+// u8_decoden: bulk-decode mb_text in blocks of 256 characters (as for dtatw-mkindex)
+static size_t mb_u8_decoden_run(size_t *nops)
+{
+  uint32_t wcs[256];
+  uchar    lens[256];
+  int i = 0, len = (int)mb_textlen, nerrs = 0;
+  size_t n = 0;
+  while (i < len) {
+    n += u8_decoden(mb_text, len, &i, wcs, lens, 256, &nerrs);
+    mb_sink += wcs[0];
+  }
+  mb_sink += nerrs;
+  *nops = n;
+  return mb_textlen;
+}
+
+//--------------------------------------------------------------
+// u8_validate: validate mb_text
+static size_t mb_u8_validate_run(size_t *nops)
+{
+  mb_sink += u8_validate(mb_text, (int)mb_textlen);
+  *nops = mb_textlen;
+  return mb_textlen;
+}
+
+/*======================================================================
+ * Kernels: XML escapes
+ */
+
+//--------------------------------------------------------------
+// put_escaped_str: escape text with occasional markup-significant characters to /dev/null
+static char *mb_xtext = NULL;
+static FILE *mb_devnull = NULL;
+
+static void mb_put_escaped_str_setup(void)
+{
+  static const char specials[] = "&<>\"'\n";
+  size_t i;
+  mb_text_setup();
+  mb_xtext = strdup(mb_text);
+  assert(mb_xtext != NULL /* strdup failed */);
+  for (i=0; i < mb_textlen; i++) {
+    if ((mb_xtext[i]&0x80)==0 && mb_randn(200)==0)
+      mb_xtext[i] = specials[mb_randn(sizeof(specials)-1)];
+  }
+  if (!(mb_devnull = fopen("/dev/null","wb"))) {
+    fprintf(stderr, "%s: open failed for /dev/null: %s\n", prog, strerror(errno));
+    exit(3);
+  }
+}
+
+static size_t mb_put_escaped_str_run(size_t *nops)
+{
+  put_escaped_str(mb_devnull, mb_xtext, (int)mb_textlen);
+  fflush(mb_devnull);
+  *nops = mb_textlen;
+  return mb_textlen;
+}
+
+static void mb_put_escaped_str_teardown(void)
+{
+  fclose(mb_devnull);
+  free(mb_xtext);
+  mb_devnull = NULL;
+  mb_xtext = NULL;
+}
+
+/*======================================================================
+ * Kernels: TAB-separated parsing
+ */
+
+//--------------------------------------------------------------
+// next_tab_z: split tokenizer output ("TEXT\tOFF LEN[\tANALYSIS...]" lines) into fields
+static char  *mb_tt0 = NULL;   //-- pristine tokenizer output
+static char  *mb_tt  = NULL;   //-- working copy (modified by next_tab_z())
+static size_t mb_ttlen = 0;
+static size_t mb_ttfields = 0;
+
+static void mb_next_tab_z_setup(void)
+{
+  static const char *analyses[] = {"[$WORD]", "[$ABBREV]", "[$.]", "[$,]", "[XY]"};
+  size_t alloc = mb_size + 256, off = 0;
+  mb_tt0 = (char*)malloc(alloc);
+  mb_tt  = (char*)malloc(alloc);
+  assert(mb_tt0 != NULL && mb_tt != NULL /* malloc failed */);
+  mb_ttlen = 0;
+  mb_ttfields = 0;
+  while (mb_ttlen + 128 < mb_size) {
+    int wlen = 1+mb_randn(12), i;
+    for (i=0; i < wlen; i++) mb_tt0[mb_ttlen++] = 'a'+mb_randn(26);
+    mb_ttlen += sprintf(mb_tt0+mb_ttlen, "\t%u %d", (unsigned)off, wlen);
+    mb_ttfields += 2;
+    off += wlen+1;
+    if (mb_randn(2)==0) {
+      mb_ttlen += sprintf(mb_tt0+mb_ttlen, "\t%s", analyses[mb_randn(5)]);
+      ++mb_ttfields;
+    }
+    mb_tt0[mb_ttlen++] = '\n';
+    if (mb_randn(12)==0) mb_tt0[mb_ttlen++] = '\n'; //-- end of sentence
+  }
+  mb_tt0[mb_ttlen] = '\0';
+}
+
+static void mb_next_tab_z_prepare(void)
+{
+  memcpy(mb_tt, mb_tt0, mb_ttlen+1);
+}
+
+static size_t mb_next_tab_z_run(size_t *nops)
+{
+  char *s = mb_tt, *end = mb_tt + mb_ttlen;
+  size_t nfields = 0;
+  while (s < end) {
+    s = next_tab_z(s);
+    ++s;
+    ++nfields;
+  }
+  mb_sink += nfields;
+  *nops = nfields;
+  return mb_ttlen;
+}
+
+static void mb_next_tab_z_teardown(void)
+{
+  free(mb_tt0);
+  free(mb_tt);
+  mb_tt0 = mb_tt = NULL;
+}
+
+/*======================================================================
+ * Kernels: .cx records
+ */
+
+//-- mb_cxr[]: generated stored cx records
+static cxStoredRecord *mb_cxr = NULL;
+static size_t mb_ncxr = 0;
+static FILE  *mb_cxf = NULL;
+static long   mb_cxflen = 0;
+
+//--------------------------------------------------------------
+// mb_cxr_setup()
+//  + generates mb_size cx records: mostly plain characters, some <c> elements with bounding boxes
+//    (left-to-right, top-to-bottom, as for OCR output), a <lb> every ~50 characters and a <pb> every ~2000 characters
+static void mb_cxr_setup(void)
+{
+  size_t i;
+  uint32_t xoff = 0, facs = 1, bx = 0, by = 0;
+  mb_ncxr = mb_size;
+  mb_cxr = (cxStoredRecord*)calloc(mb_ncxr, sizeof(cxStoredRecord));
+  assert(mb_cxr != NULL /* calloc failed */);
+  for (i=0; i < mb_ncxr; i++) {
+    cxStoredRecord *r = &mb_cxr[i];
+    uint32_t x = mb_randn(2000);
+    if (x == 0) {
+      r->flags = cxrPb | cxfHasXmlOffset | cxfHasAttrs;
+      r->xlen  = 0;
+      r->attrs[0] = ++facs;
+      xoff += 24;
+    } else if (x < 40) {
+      r->flags = cxrLb | cxfHasXmlOffset;
+      r->xlen  = 0;
+      xoff += 6;
+    } else if (x < 300) {
+      //-- <c> element with bbox
+      r->flags = cxrChar | cxfHasXmlOffset | cxfHasTxtLength | cxfHasAttrs | (CX_VARINT ? cxfBboxDelta : 0);
+      r->xlen  = 1+mb_randn(2);
+      r->tlen  = r->xlen;
+      bx += 10 + mb_randn(20);
+      if (bx > 2000) { bx = mb_randn(100); by = (by + 40 + mb_randn(10)) % 3000; }
+      r->attrs[0] = bx;
+      r->attrs[1] = by + mb_randn(4);
+      r->attrs[2] = bx + 8 + mb_randn(20);
+      r->attrs[3] = by + 30 + mb_randn(8);
+      xoff += 40;
+    } else {
+      r->flags = cxrChar;
+      r->xlen  = (x < 400 ? 2 : 1);
+      r->tlen  = r->xlen;
+    }
+    r->xoff = xoff;
+    xoff += r->xlen;
+  }
+  mb_cxf = mb_tmpfile();
+}
+
+static void mb_cxr_teardown(void)
+{
+  if (mb_cxf) fclose(mb_cxf);
+  free(mb_cxr);
+  mb_cxf = NULL;
+  mb_cxr = NULL;
+}
+
+//--------------------------------------------------------------
+// cx_put_record: write mb_cxr[] to a temporary file
+static size_t mb_cx_put_record_run(size_t *nops)
+{
+  size_t i;
+  ByteOffset xoff = 0;
+  uint32_t bbox[4] = {0,0,0,0};
+  rewind(mb_cxf);
+  for (i=0; i < mb_ncxr; i++) {
+    cx_put_record(mb_cxf, &mb_cxr[i], xoff, bbox);
+    xoff = mb_cxr[i].xoff + mb_cxr[i].xlen;
+  }
+  fflush(mb_cxf);
+  mb_cxflen = ftell(mb_cxf);
+  *nops = mb_ncxr;
+  return (size_t)mb_cxflen;
+}
+
+//--------------------------------------------------------------
+// cx_get_record: read back records written by cx_put_record()
+static void mb_cx_get_record_setup(void)
+{
+  size_t nops;
+  mb_cxr_setup();
+  mb_cx_put_record_run(&nops);
+}
+
+static size_t mb_cx_get_record_run(size_t *nops)
+{
+  cxStoredRecord r;
+  ByteOffset xoff = 0;
+  uint32_t bbox[4] = {0,0,0,0};
+  size_t n = 0;
+  rewind(mb_cxf);
+  while (cx_get_record(mb_cxf, &r, xoff, CX_VARINT, bbox) != cxrEOF) {
+    xoff = r.xoff + r.xlen;
+    ++n;
+  }
+  mb_sink += xoff;
+  *nops = n;
+  return (size_t)mb_cxflen;
+}
+
+/*======================================================================
+ * Kernels: packed integers
+ */
+
+//--------------------------------------------------------------
+// get_packed_w: decode BER-compressed integers (perl pack('w'))
+//  + distribution as for offset deltas: mostly < 2^7, some < 2^14, few large
+static size_t mb_nw = 0;
+static long   mb_wlen = 0;
+
+static void mb_get_packed_w_setup(void)
+{
+  size_t i;
+  mb_nw = mb_size;
+  mb_cxf = mb_tmpfile();
+  for (i=0; i < mb_nw; i++) {
+    uint32_t x = mb_randn(100);
+    put_packed_w(mb_cxf, x < 85 ? mb_randn(1<<7) : (x < 98 ? mb_randn(1<<14) : mb_rand()));
+  }
+  fflush(mb_cxf);
+  mb_wlen = ftell(mb_cxf);
+}
+
+static size_t mb_get_packed_w_run(size_t *nops)
+{
+  size_t i;
+  uint64_t sum = 0;
+  rewind(mb_cxf);
+  for (i=0; i < mb_nw; i++) {
+    sum += get_packed_w(mb_cxf);
+  }
+  mb_sink += sum;
+  *nops = mb_nw;
+  return (size_t)mb_wlen;
+}
+
+static void mb_get_packed_w_teardown(void)
+{
+  fclose(mb_cxf);
+  mb_cxf = NULL;
+}
+
+/*======================================================================
+ * Kernels: .cx + .bx indexing
+ */
+
+static cxData         mb_cxd;
+static bxData         mb_bxd;
+static Offset2CxIndex mb_txb2cx;
+
+//--------------------------------------------------------------
+// mb_cxd_setup()
+//  + generates mb_size loaded cx records with contiguous .tx offsets
+static void mb_cxd_setup(void)
+{
+  size_t i;
+  ByteOffset toff = 0;
+  cxDataInit(&mb_cxd, mb_size);
+  for (i=0; i < mb_size; i++) {
+    cxRecord cx;
+    uint32_t x = mb_randn(50);
+    memset(&cx, 0, sizeof(cx));
+    cx.typ  = (x == 0 ? cxrLb : cxrChar);
+    cx.xoff = toff;
+    cx.xlen = cx.tlen = (x == 0 ? 0 : (x < 5 ? 2 : 1));
+    cx.toff = toff;
+    toff += cx.tlen;
+    cxDataPush(&mb_cxd, &cx);
+  }
+}
+
+//--------------------------------------------------------------
+// tx2cxIndex: build .tx-byte -> cx-record lookup vector
+static size_t mb_tx2cxIndex_run(size_t *nops)
+{
+  Offset2CxIndex idx = {NULL,0};
+  tx2cxIndex(&idx, &mb_cxd);
+  mb_sink += (uintptr_t)idx.data[idx.len/2];
+  *nops = idx.len;
+  Offset2CxIndexFree(&idx);
+  return *nops * sizeof(cxRecord*);
+}
+
+static void mb_cxd_teardown(void)
+{
+  cxDataFree(&mb_cxd);
+}
+
+//--------------------------------------------------------------
+// txt2cxIndex: build .txt-byte -> cx-record lookup vector from .bx blocks
+//  + text blocks of ~200 bytes, with a 2-byte hint pseudo-block (no cx records) after every 10th block
+static void mb_txt2cxIndex_setup(void)
+{
+  ByteOffset ntxb, toff = 0, otoff = 0;
+  size_t bi;
+  mb_cxd_setup();
+  mb_txb2cx.data = NULL;
+  mb_txb2cx.len  = 0;
+  tx2cxIndex(&mb_txb2cx, &mb_cxd);
+  ntxb = mb_txb2cx.len;
+  bxDataInit(&mb_bxd, 0);
+  for (bi=0; toff < ntxb; bi++) {
+    bxRecord bx;
+    memset(&bx, 0, sizeof(bx));
+    if (bi % 10 == 9) {
+      bx.otoff = otoff;
+      bx.otlen = 2;
+      bx.toff  = toff;
+    } else {
+      bx.toff  = toff;
+      bx.tlen  = 100 + mb_randn(200);
+      if (bx.toff + bx.tlen > ntxb) bx.tlen = ntxb - bx.toff;
+      bx.otoff = otoff;
+      bx.otlen = bx.tlen;
+      toff += bx.tlen;
+    }
+    otoff += bx.otlen;
+    bxDataPush(&mb_bxd, &bx);
+  }
+}
+
+static size_t mb_txt2cxIndex_run(size_t *nops)
+{
+  Offset2CxIndex idx = {NULL,0};
+  txt2cxIndex(&idx, &mb_bxd, &mb_txb2cx);
+  mb_sink += (uintptr_t)idx.data[idx.len/2];
+  *nops = idx.len;
+  Offset2CxIndexFree(&idx);
+  return *nops * sizeof(cxRecord*);
+}
+
+static void mb_txt2cxIndex_teardown(void)
+{
+  bxDataFree(&mb_bxd);
+  Offset2CxIndexFree(&mb_txb2cx);
+  mb_cxd_teardown();
+}
+
+/*======================================================================
+ * Kernel table
+ */
+
+// mbKernel: a single microbenchmark
+typedef struct {
+  const char *name;                //-- kernel name
+  void   (*setup)(void);           //-- generate input data (untimed; may be NULL)
+  void   (*prepare)(void);         //-- reset input data before each trial (untimed; may be NULL)
+  size_t (*run)(size_t *nops);     //-- run one trial: returns number of bytes processed, sets *nops
+  void   (*teardown)(void);        //-- free input data (may be NULL)
+} mbKernel;
+
+static const mbKernel mb_kernels[] = {
+  {"cx_put_record",   mb_cxr_setup,             NULL, mb_cx_put_record_run,   mb_cxr_teardown},
+  {"cx_get_record",   mb_cx_get_record_setup,   NULL, mb_cx_get_record_run,   mb_cxr_teardown},
+  {"u8_nextcharn",    mb_text_setup,            NULL, mb_u8_nextcharn_run,    NULL},
+  {"u8_decoden",      mb_text_setup,            NULL, mb_u8_decoden_run,      NULL},
+  {"u8_validate",     mb_text_setup,            NULL, mb_u8_validate_run,     NULL},
+  {"u8_wc_toutf8",    mb_u8_wc_toutf8_setup,    NULL, mb_u8_wc_toutf8_run,    mb_u8_wc_toutf8_teardown},
+  {"put_escaped_str", mb_put_escaped_str_setup, NULL, mb_put_escaped_str_run, mb_put_escaped_str_teardown},
+  {"next_tab_z",      mb_next_tab_z_setup,      mb_next_tab_z_prepare, mb_next_tab_z_run, mb_next_tab_z_teardown},
+  {"tx2cxIndex",      mb_cxd_setup,             NULL, mb_tx2cxIndex_run,      mb_cxd_teardown},
+  {"txt2cxIndex",     mb_txt2cxIndex_setup,     NULL, mb_txt2cxIndex_run,     mb_txt2cxIndex_teardown},
+  {"get_packed_w",    mb_get_packed_w_setup,    NULL, mb_get_packed_w_run,    mb_get_packed_w_teardown},
+  {NULL, NULL, NULL, NULL, NULL}
+};
+
+/*======================================================================
+ * Driver
+ */
+
+static int mb_cmp_double(const void *a, const void *b)
+{
+  double da = *(const double*)a, db = *(const double*)b;
+  return (da < db ? -1 : (da > db ? 1 : 0));
+}
+
+//--------------------------------------------------------------
+// mb_run_kernel(k)
+//  + runs mb_warmup untimed and mb_trials timed trials of kernel k, and prints a result line to stdout
+static void mb_run_kernel(const mbKernel *k)
+{
+  double *times = (double*)malloc(mb_trials*sizeof(double));
+  double t0, tmin, tmed;
+  size_t nbytes = 0, nops = 0;
+  int i;
+  assert(times != NULL /* malloc failed */);
+
+  mb_rstate = mb_seed ? mb_seed : 42;
+  if (k->setup) k->setup();
+  for (i=0; i < mb_warmup; i++) {
+    if (k->prepare) k->prepare();
+    k->run(&nops);
+  }
+  for (i=0; i < mb_trials; i++) {
+    if (k->prepare) k->prepare();
+    t0 = mb_now();
+    nbytes = k->run(&nops);
+    times[i] = mb_now() - t0;
+  }
+  if (k->teardown) k->teardown();
+
+  qsort(times, mb_trials, sizeof(double), mb_cmp_double);
+  tmin = times[0];
+  tmed = times[mb_trials/2];
+  printf("%-16s %10lu %12lu %10.3f %10.3f %9.3f %9.3f\n",
+	 k->name, (unsigned long)nops, (unsigned long)nbytes,
+	 nops > 0 ? 1e9*tmin/nops : 0.0,
+	 nops > 0 ? 1e9*tmed/nops : 0.0,
+	 tmin > 0 ? nbytes/tmin/1e9 : 0.0,
+	 tmed > 0 ? nbytes/tmed/1e9 : 0.0);
+  fflush(stdout);
+  free(times);
+}
+
+/*======================================================================
+ * MAIN
+ */
+int main(int argc, char **argv)
+{
+  const mbKernel *k;
+  int i;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+
+  //-- command-line
+  for (i=1; i < argc; i++) {
+    if (strcmp(argv[i],"-s")==0 && i+1 < argc)       mb_size   = strtoul(argv[++i],NULL,0);
+    else if (strcmp(argv[i],"-n")==0 && i+1 < argc)  mb_trials = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-w")==0 && i+1 < argc)  mb_warmup = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-S")==0 && i+1 < argc)  mb_seed   = strtoul(argv[++i],NULL,0);
+    else if (strcmp(argv[i],"-k")==0 && i+1 < argc)  mb_filter = argv[++i];
+    else if (strcmp(argv[i],"-u")==0 && i+1 < argc)  mb_simd   = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+      fprintf(stderr, "Usage:\n");
+      fprintf(stderr, " + %s [-s SIZE] [-n TRIALS] [-w WARMUP] [-S SEED] [-k KERNEL] [-u SIMD]\n", prog);
+      fprintf(stderr, " + SIZE   : operations (records, characters, bytes) per trial; default=%lu\n", (unsigned long)mb_size);
+      fprintf(stderr, " + TRIALS : number of timed trials per kernel; default=%d\n", mb_trials);
+      fprintf(stderr, " + WARMUP : number of untimed warm-up trials per kernel; default=%d\n", mb_warmup);
+      fprintf(stderr, " + SEED   : random seed for generated data; default=%u\n", (unsigned)mb_seed);
+      fprintf(stderr, " + KERNEL : only run kernels whose name contains KERNEL; default=all\n");
+      fprintf(stderr, " + SIMD   : UTF-8 SIMD level (0:scalar, 1:sse4, 2:avx2, -1:auto); default=auto\n");
+      fprintf(stderr, " + output : ns/op and GB/s for the fastest (min) and median (med) trial of each kernel\n");
+      exit(1);
+    }
+  }
+  if (mb_size < 1024) mb_size = 1024;
+  if (mb_trials < 1) mb_trials = 1;
+  if (mb_warmup < 0) mb_warmup = 0;
+
+  //-- guts
+  mb_simd = u8_simd_init((u8SimdLevel)mb_simd);
+  printf("#%s: size=%lu trials=%d warmup=%d seed=%u simd=%s\n",
+	 prog, (unsigned long)mb_size, mb_trials, mb_warmup, (unsigned)mb_seed, u8_simd_name((u8SimdLevel)mb_simd));
+  printf("#%-15s %10s %12s %10s %10s %9s %9s\n", "kernel", "ops", "bytes", "ns/op:min", "ns/op:med", "GB/s:min", "GB/s:med");
+  for (k=mb_kernels; k->name; k++) {
+    if (mb_filter && !strstr(k->name, mb_filter)) continue;
+    mb_run_kernel(k);
+  }
+
+  return 0;
+}
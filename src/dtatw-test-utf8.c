@@ -0,0 +1,315 @@
+#include "dtatwCommon.h"
+#include "dtatwUtf8.h"
+#include <stdarg.h>
+
+/*======================================================================
+ * Globals
+ */
+
+static int ut_verbose = 0;  //-- print a line for each check?
+static int ut_nchecks = 0;  //-- number of buffers checked at the current level
+static int ut_nfail   = 0;  //-- number of failed checks (all levels)
+
+#define UT_BUFSIZE 4096
+#define UT_MAXFAIL 16       //-- only report this many failures in detail
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// ut_rand()
+//  + xorshift32 pseudo-random generator (as for dtatw-microbench)
+static uint32_t ut_rstate = 42;
+static inline uint32_t ut_rand(void)
+{
+  ut_rstate ^= ut_rstate << 13;
+  ut_rstate ^= ut_rstate >> 17;
+  ut_rstate ^= ut_rstate << 5;
+  return ut_rstate;
+}
+
+//-- ut_randn(n): pseudo-random integer in [0,n)
+static inline uint32_t ut_randn(uint32_t n) { return ut_rand() % n; }
+
+//--------------------------------------------------------------
+// len = ut_encode(buf,cp)
+//  + naive UTF-8 encoder (no checks: encodes surrogates and code points > U+10FFFF too)
+static int ut_encode(uchar *buf, uint32_t cp)
+{
+  if (cp < 0x80)    { buf[0]=cp; return 1; }
+  if (cp < 0x800)   { buf[0]=0xC0|(cp>>6);  buf[1]=0x80|(cp&0x3F); return 2; }
+  if (cp < 0x10000) { buf[0]=0xE0|(cp>>12); buf[1]=0x80|((cp>>6)&0x3F); buf[2]=0x80|(cp&0x3F); return 3; }
+  buf[0]=0xF0|((cp>>18)&0x07); buf[1]=0x80|((cp>>12)&0x3F); buf[2]=0x80|((cp>>6)&0x3F); buf[3]=0x80|(cp&0x3F);
+  return 4;
+}
+
+//--------------------------------------------------------------
+// len = ut_ref_decode1(u,n,&cp)
+//  + reference decoder, written independently of dtatwUtf8.c: decode by lead byte,
+//    then reject overlong forms, surrogates and code points > U+10FFFF by value
+//  + returns byte length, or 0 if u[0:n] doesn't start with a valid sequence
+static int ut_ref_decode1(const uchar *u, int n, uint32_t *cp)
+{
+  static const uint32_t minval[5] = {0, 0, 0x80, 0x800, 0x10000};
+  int len, k;
+  uint32_t c;
+  if (u[0] < 0x80) { *cp = u[0]; return 1; }
+  else if ((u[0] & 0xE0)==0xC0) { len=2; c = u[0]&0x1F; }
+  else if ((u[0] & 0xF0)==0xE0) { len=3; c = u[0]&0x0F; }
+  else if ((u[0] & 0xF8)==0xF0) { len=4; c = u[0]&0x07; }
+  else return 0;
+  if (n < len) return 0;
+  for (k=1; k < len; k++) {
+    if ((u[k] & 0xC0) != 0x80) return 0;
+    c = (c<<6) | (u[k]&0x3F);
+  }
+  if (c < minval[len] || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) return 0;
+  *cp = c;
+  return len;
+}
+
+//--------------------------------------------------------------
+// ut_fail(label,buf,len,fmt,...)
+static void ut_fail(const char *label, const uchar *buf, int len, const char *fmt, ...)
+{
+  va_list ap;
+  int k;
+  if (++ut_nfail > UT_MAXFAIL) return;
+  fprintf(stderr, "%s: FAILED: %s: ", prog, label);
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fprintf(stderr, "\n%s:   buffer (%d bytes):", prog, len);
+  for (k=0; k < len && k < 96; k++) fprintf(stderr, " %02x", buf[k]);
+  fprintf(stderr, "%s\n", (k < len ? " ..." : ""));
+}
+
+/*======================================================================
+ * Checks
+ */
+
+//--------------------------------------------------------------
+// ut_check(label,buf,len)
+//  + checks u8_validate() and u8_decoden() (for several block sizes) on buf[0:len] against the reference decoder
+static void ut_check(const char *label, const uchar *buf, int len)
+{
+  static const int maxcs[] = {1, 7, 16, 33, 256, UT_BUFSIZE};
+  static uint32_t ref_wcs[UT_BUFSIZE], wcs[UT_BUFSIZE];
+  static uchar    ref_lens[UT_BUFSIZE], lens[UT_BUFSIZE];
+  int ref_n = 0, ref_nerrs = 0, ref_bad = -1;
+  int i, k, m, n, nerrs;
+  uint32_t cp;
+
+  //-- reference
+  for (i=0; i < len; i += ref_lens[ref_n++]) {
+    if ((k = ut_ref_decode1(buf+i, len-i, &cp))) {
+      ref_wcs[ref_n]  = cp;
+      ref_lens[ref_n] = k;
+    } else {
+      ref_wcs[ref_n]  = U8_REPLACEMENT_CHAR;
+      ref_lens[ref_n] = 1;
+      if (ref_bad < 0) ref_bad = i;
+      ++ref_nerrs;
+    }
+  }
+  ++ut_nchecks;
+
+  //-- u8_validate()
+  if ((k = u8_validate((const char*)buf, len)) != ref_bad)
+    ut_fail(label, buf, len, "u8_validate() returned %d, expected %d", k, ref_bad);
+
+  //-- u8_decoden()
+  for (m=0; m < (int)(sizeof(maxcs)/sizeof(maxcs[0])); m++) {
+    memset(lens, 0, sizeof(lens));
+    for (i=0, n=0, nerrs=0; i < len; ) {
+      k = u8_decoden((const char*)buf, len, &i, wcs+n, lens+n, maxcs[m], &nerrs);
+      if (k <= 0 || k > maxcs[m]) break;
+      n += k;
+    }
+    if (i != len || n != ref_n) {
+      ut_fail(label, buf, len, "u8_decoden(maxc=%d): decoded %d characters / %d bytes, expected %d / %d", maxcs[m], n, i, ref_n, len);
+      continue;
+    }
+    if (nerrs != ref_nerrs)
+      ut_fail(label, buf, len, "u8_decoden(maxc=%d): nerrs=%d, expected %d", maxcs[m], nerrs, ref_nerrs);
+    for (k=0; k < n; k++) {
+      if (wcs[k] != ref_wcs[k] || lens[k] != ref_lens[k]) {
+	ut_fail(label, buf, len, "u8_decoden(maxc=%d): character %d: got U+%04X (%d bytes), expected U+%04X (%d bytes)",
+		maxcs[m], k, (uint)wcs[k], (int)lens[k], (uint)ref_wcs[k], (int)ref_lens[k]);
+	break;
+      }
+    }
+  }
+  if (ut_verbose) fprintf(stderr, "%s: checked %s (%d bytes)\n", prog, label, len);
+}
+
+//--------------------------------------------------------------
+// len = ut_valid_text(buf,maxlen,pascii)
+//  + fills buf with random valid UTF-8 of at most maxlen bytes: ASCII runs and 2-, 3- and 4-byte characters,
+//    the latter at all alignments; pascii is the percentage of ASCII characters
+static int ut_valid_text(uchar *buf, int maxlen, int pascii)
+{
+  static const uint32_t ranges[][2] = {
+    {0x80, 0x7FF}, {0x800, 0xD7FF}, {0xE000, 0xFFFF}, {0x10000, 0x10FFFF},
+    {0xE4, 0xE4}, {0x17F, 0x17F}, {0x201E, 0x201E}, {0xFFFD, 0xFFFD}, {0x10FFFF, 0x10FFFF}
+  };
+  const int nranges = sizeof(ranges)/sizeof(ranges[0]);
+  int len = 0, r;
+  uint32_t cp;
+  while (len+4 <= maxlen) {
+    if ((int)ut_randn(100) < pascii) {
+      cp = 0x20 + ut_randn(0x5F);
+    } else {
+      r  = ut_randn(nranges);
+      cp = ranges[r][0] + ut_randn(ranges[r][1]-ranges[r][0]+1);
+    }
+    len += ut_encode(buf+len, cp);
+  }
+  return len;
+}
+
+//--------------------------------------------------------------
+// ut_run()
+//  + runs all checks at the current SIMD level
+static void ut_run(void)
+{
+  //-- invalid sequences: overlongs, surrogates, > U+10FFFF, stray continuation & invalid lead bytes,
+  //   truncated sequences (followed by ASCII, or at end-of-buffer)
+  static const struct { const char *name; int len; uchar bytes[4]; } bad[] = {
+    {"overlong/2:C0",      2, {0xC0,0x80}},
+    {"overlong/2:C1",      2, {0xC1,0xBF}},
+    {"overlong/3:E0.80",   3, {0xE0,0x80,0x80}},
+    {"overlong/3:E0.9F",   3, {0xE0,0x9F,0xBF}},
+    {"overlong/4:F0.80",   4, {0xF0,0x80,0x80,0x80}},
+    {"overlong/4:F0.8F",   4, {0xF0,0x8F,0xBF,0xBF}},
+    {"surrogate:D800",     3, {0xED,0xA0,0x80}},
+    {"surrogate:DFFF",     3, {0xED,0xBF,0xBF}},
+    {"range:110000",       4, {0xF4,0x90,0x80,0x80}},
+    {"range:F5",           4, {0xF5,0x80,0x80,0x80}},
+    {"range:F7",           4, {0xF7,0xBF,0xBF,0xBF}},
+    {"lead:F8",            1, {0xF8}},
+    {"lead:FE",            1, {0xFE}},
+    {"lead:FF",            1, {0xFF}},
+    {"stray:80",           1, {0x80}},
+    {"stray:BF",           1, {0xBF}},
+    {"stray:80.80",        2, {0x80,0x80}},
+    {"truncated/2:C3",     1, {0xC3}},
+    {"truncated/3:E2",     1, {0xE2}},
+    {"truncated/3:E2.82",  2, {0xE2,0x82}},
+    {"truncated/4:F0",     1, {0xF0}},
+    {"truncated/4:F0.9F",  2, {0xF0,0x9F}},
+    {"truncated/4:F4.8F.BF", 3, {0xF4,0x8F,0xBF}},
+    {"cont:E2.41",         2, {0xE2,0x41}},
+    {"cont:F0.9F.41",      3, {0xF0,0x9F,0x41}},
+    {"cont:C3.C3",         2, {0xC3,0xC3}},
+    {NULL, 0, {0}}
+  };
+  static const int edges[] = {16, 32, 48, 64, 96, 128};
+  static const int pasciis[] = {0, 10, 50, 90, 99, 100};
+  static uchar buf[UT_BUFSIZE];
+  char label[256];
+  int b, e, d, len, bg, i;
+
+  //-- valid text: short and long buffers, mostly-ASCII to ASCII-free
+  for (i=0; i < 2000; i++) {
+    int pascii = pasciis[i%6];
+    len = ut_valid_text(buf, 1 + ut_randn(i < 1000 ? 160 : UT_BUFSIZE), pascii);
+    sprintf(label, "valid text #%d (%d%% ASCII)", i, pascii);
+    ut_check(label, buf, len);
+  }
+
+  //-- valid text: multibyte characters straddling block edges
+  for (e=0; e < (int)(sizeof(edges)/sizeof(edges[0])); e++) {
+    for (d=1; d <= 3; d++) {
+      static const uint32_t cps[] = {0xE4, 0x201E, 0x1F600};
+      for (b=0; b < 3; b++) {
+	int clen = b+2;
+	if (d >= clen) continue;
+	memset(buf, 'a', edges[e]+8);
+	ut_encode(buf+edges[e]-d, cps[b]);
+	sprintf(label, "valid U+%04X at block edge %d-%d", (uint)cps[b], edges[e], d);
+	ut_check(label, buf, edges[e]+8);
+	ut_check(label, buf, edges[e]-d+clen);
+      }
+    }
+  }
+
+  //-- invalid sequences: at every offset around each block edge, on ASCII and non-ASCII backgrounds,
+  //   followed by more text and at end-of-buffer
+  for (b=0; bad[b].name; b++) {
+    for (e=0; e < (int)(sizeof(edges)/sizeof(edges[0])); e++) {
+      for (d=-4; d <= 4; d++) {
+	int off = edges[e]+d;
+	for (bg=0; bg < 2; bg++) {
+	  if (bg==0) memset(buf, 'x', off+64);
+	  else {
+	    //-- non-ASCII background: "ä" (2 bytes) / "„" (3 bytes) mix, padded with ASCII to off
+	    for (i=0; i+3 <= off; ) i += ut_encode(buf+i, (i%5 ? 0xE4 : 0x201E));
+	    while (i < off+64) buf[i++] = 'y';
+	  }
+	  memcpy(buf+off, bad[b].bytes, bad[b].len);
+	  sprintf(label, "invalid %s at %d%+d (%s background)", bad[b].name, edges[e], d, (bg ? "non-ASCII" : "ASCII"));
+	  ut_check(label, buf, off+64);
+	  sprintf(label, "invalid %s at %d%+d at end-of-buffer (%s background)", bad[b].name, edges[e], d, (bg ? "non-ASCII" : "ASCII"));
+	  ut_check(label, buf, off+bad[b].len);
+	}
+      }
+    }
+  }
+
+  //-- random bytes: biased towards lead and boundary bytes
+  for (i=0; i < 20000; i++) {
+    static const uchar interesting[] = {0x00,0x41,0x7F,0x80,0x8F,0x90,0x9F,0xA0,0xBF,0xC0,0xC1,0xC2,0xDF,
+					0xE0,0xE1,0xEC,0xED,0xEE,0xEF,0xF0,0xF1,0xF3,0xF4,0xF5,0xFF};
+    int j;
+    len = 1 + ut_randn(i < 18000 ? 80 : 600);
+    for (j=0; j < len; j++) {
+      switch (ut_randn(4)) {
+      case 0:  buf[j] = 0x20 + ut_randn(0x5F); break;
+      case 1:  buf[j] = ut_randn(256); break;
+      default: buf[j] = interesting[ut_randn(sizeof(interesting))]; break;
+      }
+    }
+    sprintf(label, "random bytes #%d", i);
+    ut_check(label, buf, len);
+  }
+}
+
+/*======================================================================
+ * MAIN
+ */
+int main(int argc, char **argv)
+{
+  int level, got;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+
+  //-- command-line
+  if (argc > 1 && strcmp(argv[1],"-v")==0) ut_verbose = 1;
+  else if (argc > 1) {
+    fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, " + %s [-v]\n", prog);
+    fprintf(stderr, " + checks u8_validate() and u8_decoden() at each available SIMD level against a reference decoder\n");
+    fprintf(stderr, " + exit status is 0 iff all checks pass (for 'make check')\n");
+    exit(1);
+  }
+
+  //-- guts
+  for (level=U8_SIMD_SCALAR; level <= U8_SIMD_AVX2; level++) {
+    if ((got = u8_simd_init((u8SimdLevel)level)) != level) {
+      printf("SKIP: %s: not supported (using %s)\n", u8_simd_name((u8SimdLevel)level), u8_simd_name((u8SimdLevel)got));
+      continue;
+    }
+    ut_rstate  = 42;
+    ut_nchecks = 0;
+    got        = ut_nfail;
+    ut_run();
+    printf("%s: %s: %d buffers checked, %d failure(s)\n",
+	   (ut_nfail==got ? "PASS" : "FAIL"), u8_simd_name((u8SimdLevel)level), ut_nchecks, ut_nfail-got);
+  }
+
+  return ut_nfail ? 1 : 0;
+}
@@ -525,7 +525,9 @@ char *yytext;
  * User C Header
  */
 #include "dtatwCommon.h"
+#include "dtatwTokPlugin.h"
 #include <stdio.h>
+#include <limits.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
@@ -552,7 +554,7 @@ static int yywrap(void);
 /*======================================================================
  * Rules
  */
-#line 556 "dtatw-tokenize-dummy.c"
+#line 558 "dtatw-tokenize-dummy.c"
 
 #define INITIAL 0
 #define ATEOF 1
@@ -771,10 +773,10 @@ YY_DECL
 		}
 
 	{
-#line 58 "dtatw-tokenize-dummy.l"
+#line 60 "dtatw-tokenize-dummy.l"
 
 
-#line 778 "dtatw-tokenize-dummy.c"
+#line 780 "dtatw-tokenize-dummy.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -834,111 +836,111 @@ do_action:	/* This label is used only to access EOF actions. */
 case 1:
 /* rule 1 can match eol */
 YY_RULE_SETUP
-#line 60 "dtatw-tokenize-dummy.l"
+#line 62 "dtatw-tokenize-dummy.l"
 { thebyte += yyleng; /* (mostly) ignore */ }
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 62 "dtatw-tokenize-dummy.l"
+#line 64 "dtatw-tokenize-dummy.l"
 { thebyte += yyleng; print_eos(); }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 63 "dtatw-tokenize-dummy.l"
+#line 65 "dtatw-tokenize-dummy.l"
 { thebyte += yyleng; }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 65 "dtatw-tokenize-dummy.l"
+#line 67 "dtatw-tokenize-dummy.l"
 { print_token("$ROMAN\t$ABBR"); thebyte += yyleng; }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 67 "dtatw-tokenize-dummy.l"
+#line 69 "dtatw-tokenize-dummy.l"
 { print_token("$FRACTION"); thebyte += yyleng; }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 68 "dtatw-tokenize-dummy.l"
+#line 70 "dtatw-tokenize-dummy.l"
 { print_token("$CARDPUNCT"); thebyte += yyleng; }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 69 "dtatw-tokenize-dummy.l"
+#line 71 "dtatw-tokenize-dummy.l"
 { print_token("$CARDSUFFIX"); thebyte += yyleng; }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 70 "dtatw-tokenize-dummy.l"
+#line 72 "dtatw-tokenize-dummy.l"
 { print_token("$CARDSEPS"); thebyte += yyleng; }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 71 "dtatw-tokenize-dummy.l"
+#line 73 "dtatw-tokenize-dummy.l"
 { print_token("$CARD");   thebyte += yyleng; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 73 "dtatw-tokenize-dummy.l"
+#line 75 "dtatw-tokenize-dummy.l"
 { print_token("$QUOTE"); thebyte += yyleng; }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 74 "dtatw-tokenize-dummy.l"
+#line 76 "dtatw-tokenize-dummy.l"
 { print_token("$PUNCT"); thebyte += yyleng; }
 	YY_BREAK
 case 12:
 /* rule 12 can match eol */
 YY_RULE_SETUP
-#line 76 "dtatw-tokenize-dummy.l"
+#line 78 "dtatw-tokenize-dummy.l"
 { print_token(NULL); thebyte += yyleng; }
 	YY_BREAK
 case 13:
 /* rule 13 can match eol */
 YY_RULE_SETUP
-#line 77 "dtatw-tokenize-dummy.l"
+#line 79 "dtatw-tokenize-dummy.l"
 { print_token(NULL); thebyte += yyleng; }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 79 "dtatw-tokenize-dummy.l"
+#line 81 "dtatw-tokenize-dummy.l"
 { print_token("$ABBR"); thebyte += yyleng; }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 80 "dtatw-tokenize-dummy.l"
+#line 82 "dtatw-tokenize-dummy.l"
 { print_token(NULL); thebyte += yyleng; }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 82 "dtatw-tokenize-dummy.l"
+#line 84 "dtatw-tokenize-dummy.l"
 { print_token("$."); thebyte += yyleng; }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 83 "dtatw-tokenize-dummy.l"
+#line 85 "dtatw-tokenize-dummy.l"
 { print_token("$,"); thebyte += yyleng; }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 84 "dtatw-tokenize-dummy.l"
+#line 86 "dtatw-tokenize-dummy.l"
 { print_token("$PUNCT"); thebyte += yyleng; }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 86 "dtatw-tokenize-dummy.l"
+#line 88 "dtatw-tokenize-dummy.l"
 { print_token(NULL); thebyte += yyleng; }
 	YY_BREAK
 case YY_STATE_EOF(INITIAL):
-#line 88 "dtatw-tokenize-dummy.l"
+#line 90 "dtatw-tokenize-dummy.l"
 { print_eos(); BEGIN(ATEOF); }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 90 "dtatw-tokenize-dummy.l"
+#line 92 "dtatw-tokenize-dummy.l"
 ECHO;
 	YY_BREAK
-#line 942 "dtatw-tokenize-dummy.c"
+#line 944 "dtatw-tokenize-dummy.c"
 case YY_STATE_EOF(ATEOF):
 	yyterminate();
 
@@ -1939,7 +1941,7 @@ void yyfree (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 90 "dtatw-tokenize-dummy.l"
+#line 92 "dtatw-tokenize-dummy.l"
 
 
 /*<<EOF>> { print_eos(); }*/
@@ -1948,37 +1950,49 @@ void yyfree (void * ptr )
  * User C Code
  */
 
+//-- token & EOS callbacks: tokenizer output to yyout (program) or host callbacks (plugin)
+static const dtatwTokPluginCallbacks *tok_cb = NULL;
+static int    tok_status = 0;     //-- nonzero if a callback aborted tokenization (-1: out of memory)
+static char  *tok_text = NULL;    //-- normalized token text
+static size_t tok_text_alloc = 0;
+
 static void print_eos(void)
 {
   if (lastWasEOS) return;
-  fputc('\n',yyout);
+  if (tok_status == 0) tok_status = tok_cb->eos(tok_cb->data);
   lastWasEOS = 1;
 }
 
 static void print_token(const char *typ)
 {
   int i;
+  size_t n = 0;
+  if ((size_t)yyleng >= tok_text_alloc) {
+    char *text = (char*)realloc(tok_text, yyleng+256);
+    if (!text) { tok_status = -1; return; }
+    tok_text = text;
+    tok_text_alloc = yyleng+256;
+  }
   for (i=0; i < yyleng; i++) {
     if (yytext[i]=='-') {
       if (i+1 < yyleng && (yytext[i+1]=='\n' || yytext[i+1]=='\r')) {
 	i++;
       } else {
-	fputc('-',yyout);
+	tok_text[n++] = '-';
       }
     }
     else if (yytext[i]=='\n' || yytext[i]=='\r') {
       ;
     }
     else if (isspace(yytext[i])) {
-      fputc('_', yyout);
+      tok_text[n++] = '_';
     }
     else {
-      fputc(yytext[i],yyout);
+      tok_text[n++] = yytext[i];
     }
   }
-  fprintf(yyout, "\t%"ByteOffsetF" %d", thebyte, yyleng);
-  if (typ != NULL) { fputc('\t',yyout); fputs(typ,yyout); }
-  fputc('\n',yyout);
+  tok_text[n] = '\0';
+  if (tok_status == 0) tok_status = tok_cb->token(tok_cb->data, tok_text, n, thebyte, yyleng, typ);
   lastWasEOS = 0;
 
   //-- check for EOS
@@ -1992,8 +2006,30 @@ static int yywrap(void)
   return 1;
 }
 
+#ifndef DTATW_TOKPLUGIN
+/*----------------------------------------------------------------------
+ * dtatw-tokenize-dummy program
+ */
+
+static int tt_token(void *data, const char *text, size_t textlen, uint64_t off, uint64_t len, const char *typ)
+{
+  fwrite(text, 1, textlen, yyout);
+  fprintf(yyout, "\t%"ByteOffsetF" %d", (ByteOffset)off, (int)len);
+  if (typ != NULL) { fputc('\t',yyout); fputs(typ,yyout); }
+  fputc('\n',yyout);
+  return 0;
+}
+
+static int tt_eos(void *data)
+{
+  fputc('\n',yyout);
+  return 0;
+}
+
 int main(int argc, char **argv)
 {
+  static const dtatwTokPluginCallbacks tt_cb = { NULL, tt_token, tt_eos };
+
   //-- usage
   if (argc <= 1 || strcmp(argv[1],"-h")==0 || strcmp(argv[1],"--help")==0) {
     fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
@@ -2024,7 +2060,76 @@ int main(int argc, char **argv)
   fprintf(yyout, "%%%% raw tokenizer output generated by %s (%s version %s)\n", *argv, PACKAGE, PACKAGE_VERSION);
 
   //-- guts
+  tok_cb = &tt_cb;
   yylex();
+  if (tok_status < 0) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    exit(2);
+  }
   return 0;
 }
 
+#else /* DTATW_TOKPLUGIN */
+/*----------------------------------------------------------------------
+ * dtatw-tokplugin-dummy.so plugin (see dtatwTokPlugin.h)
+ *  + flex scanner state is global: all instances share a single scanner (not DTATW_TOKPLUGIN_REENTRANT)
+ */
+
+static int dummy_instance = 0;
+
+static void *dummy_init(int nopts, const char *const *opts, char *errbuf)
+{
+  if (nopts > 0) {
+    snprintf(errbuf, DTATW_TOKPLUGIN_ERRLEN, "unknown option `%s' (dummy tokenizer takes no options)", opts[0]);
+    return NULL;
+  }
+  ++dummy_instance;
+  return &dummy_instance;
+}
+
+static int dummy_tokenize(void *tok, const char *buf, size_t len, const dtatwTokPluginCallbacks *cb, char *errbuf)
+{
+  YY_BUFFER_STATE yybuf;
+  if (len > INT_MAX) {
+    snprintf(errbuf, DTATW_TOKPLUGIN_ERRLEN, "input buffer too large (%lu bytes)", (unsigned long)len);
+    return -1;
+  }
+  tok_cb     = cb;
+  tok_status = 0;
+  thebyte    = 0;
+  lastWasEOS = 1;
+  yybuf = yy_scan_bytes(buf, (int)len);
+  BEGIN(INITIAL);
+  yylex();
+  yy_delete_buffer(yybuf);
+  tok_cb = NULL;
+  if (tok_status < 0) {
+    snprintf(errbuf, DTATW_TOKPLUGIN_ERRLEN, "out of memory");
+  }
+  return tok_status;
+}
+
+static void dummy_free(void *tok)
+{
+  if (--dummy_instance > 0) return;
+  if (tok_text) free(tok_text);
+  tok_text = NULL;
+  tok_text_alloc = 0;
+}
+
+static const dtatwTokPlugin dummy_plugin = {
+  DTATW_TOKPLUGIN_ABI,
+  0,
+  "dummy",
+  PACKAGE_VERSION,
+  dummy_init,
+  dummy_tokenize,
+  dummy_free
+};
+
+const dtatwTokPlugin *dtatw_tokplugin(void)
+{
+  return &dummy_plugin;
+}
+
+#endif /* DTATW_TOKPLUGIN */
@@ -0,0 +1,510 @@
+/*
+ * File: dtatw-tokenize-fast.c
+ * Description: fast UTF-8 aware replacement for dtatw-tokenize-dummy
+ *  + same token types and output format as dtatw-tokenize-dummy.l, but:
+ *    - character classes are unicode-aware (via compile-time table dtatwUniClass.h)
+ *    - hand-written longest-match scanner (flex semantics: longest match wins, earlier rule breaks ties)
+ *    - buffered output
+ */
+
+#include "dtatwCommon.h"
+#include "dtatwUniClass.h"
+
+/*======================================================================
+ * Globals
+ */
+
+//-- output buffer
+#define OUTBUF_SIZE 65536
+static char   outbuf[OUTBUF_SIZE];
+static size_t outlen = 0;
+static FILE  *f_out  = NULL;
+
+static int lastWasEOS = 1;
+static ByteOffset ntoks = 0;
+
+/*======================================================================
+ * Utils: output
+ */
+
+static inline void out_flush(void)
+{
+  if (outlen && fwrite(outbuf, 1, outlen, f_out) != outlen) {
+    fprintf(stderr, "%s: write failed: %s\n", prog, strerror(errno));
+    exit(2);
+  }
+  outlen = 0;
+}
+
+static inline void out_char(char c)
+{
+  if (outlen >= OUTBUF_SIZE) out_flush();
+  outbuf[outlen++] = c;
+}
+
+static inline void out_bytes(const char *s, size_t len)
+{
+  if (outlen+len >= OUTBUF_SIZE) out_flush();
+  if (len >= OUTBUF_SIZE) {
+    if (fwrite(s, 1, len, f_out) != len) {
+      fprintf(stderr, "%s: write failed: %s\n", prog, strerror(errno));
+      exit(2);
+    }
+    return;
+  }
+  memcpy(outbuf+outlen, s, len);
+  outlen += len;
+}
+
+//-- decimal digit pairs "00".."99" for out_uint()
+static const char digitPairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static inline void out_uint(ByteOffset u)
+{
+  char tmp[24];
+  int  i = 24;
+  while (u >= 100) {
+    int r = (int)(u % 100);
+    u /= 100;
+    tmp[--i] = digitPairs[2*r+1];
+    tmp[--i] = digitPairs[2*r];
+  }
+  if (u >= 10) {
+    tmp[--i] = digitPairs[2*u+1];
+    tmp[--i] = digitPairs[2*u];
+  } else {
+    tmp[--i] = '0' + (char)u;
+  }
+  out_bytes(tmp+i, 24-i);
+}
+
+/*======================================================================
+ * Utils: character classes
+ */
+
+//--------------------------------------------------------------
+// cls = uclass(p,end,&len)
+//  + decodes a single UTF-8 character at p, returning its UC_* class bits
+//  + *len is set to the character length in bytes (invalid bytes are single characters of class 0)
+static inline int uclass(const uchar *p, const uchar *end, int *len)
+{
+  uint32_t cp;
+  if (*p < 0x80) {
+    *len = 1;
+    return uniclass_stage2[0][*p];
+  }
+  else if ((*p & 0xe0)==0xc0 && p+1 < end && (p[1]&0xc0)==0x80) {
+    *len = 2;
+    cp = ((uint32_t)(p[0]&0x1f)<<6) | (p[1]&0x3f);
+  }
+  else if ((*p & 0xf0)==0xe0 && p+2 < end && (p[1]&0xc0)==0x80 && (p[2]&0xc0)==0x80) {
+    *len = 3;
+    cp = ((uint32_t)(p[0]&0x0f)<<12) | ((uint32_t)(p[1]&0x3f)<<6) | (p[2]&0x3f);
+  }
+  else if ((*p & 0xf8)==0xf0 && p+3 < end && (p[1]&0xc0)==0x80 && (p[2]&0xc0)==0x80 && (p[3]&0xc0)==0x80) {
+    *len = 4;
+    return 0; //-- non-BMP: treat as generic word character
+  }
+  else {
+    *len = 1;
+    return 0;
+  }
+  return uniclass_bmp(cp);
+}
+
+//--------------------------------------------------------------
+// n = span_in(p,end,mask)
+//  + length in bytes of longest prefix of p whose characters all have some class bit in mask
+static inline size_t span_in(const uchar *p, const uchar *end, int mask)
+{
+  const uchar *s = p;
+  int len;
+  while (s < end && (uclass(s,end,&len) & mask)) s += len;
+  return s-p;
+}
+
+//--------------------------------------------------------------
+// n = span_notin(p,end,mask)
+//  + length in bytes of longest prefix of p whose characters have no class bit in mask
+static inline size_t span_notin(const uchar *p, const uchar *end, int mask)
+{
+  const uchar *s = p;
+  int len;
+  while (s < end && !(uclass(s,end,&len) & mask)) s += len;
+  return s-p;
+}
+
+//--------------------------------------------------------------
+// n = span_digits(p,end)
+static inline size_t span_digits(const uchar *p, const uchar *end)
+{
+  const uchar *s = p;
+  while (s < end && *s >= '0' && *s <= '9') ++s;
+  return s-p;
+}
+
+//--------------------------------------------------------------
+// n = span_byte(p,end,c)
+static inline size_t span_byte(const uchar *p, const uchar *end, uchar c)
+{
+  const uchar *s = p;
+  while (s < end && *s == c) ++s;
+  return s-p;
+}
+
+/*======================================================================
+ * Scanner
+ *  + rules and priorities correspond 1:1 to those in dtatw-tokenize-dummy.l
+ */
+
+typedef enum {
+  tr_SPACE = 0,
+  tr_SENTBREAK,
+  tr_WORDBREAK,
+  tr_ROMAN,
+  tr_FRACTION,
+  tr_CARDPUNCT,
+  tr_CARDSUFFIX,
+  tr_CARDSEPS,
+  tr_CARD,
+  tr_QUOTE,
+  tr_PUNCTS,
+  tr_HYPH_NL,
+  tr_HYPH_SP,
+  tr_ABBR,
+  tr_ALPHA,
+  tr_EOS,
+  tr_COMMA,
+  tr_PUNCT,
+  tr_WORD,
+  tr_NRULES
+} TokRule;
+
+//-- rule types (NULL for none)
+static const char *ruleTypes[tr_NRULES] = {
+  NULL,                 //-- SPACE (ignored)
+  NULL,                 //-- SENTBREAK (ignored, forces EOS)
+  NULL,                 //-- WORDBREAK (ignored)
+  "$ROMAN\t$ABBR",      //-- ROMAN
+  "$FRACTION",          //-- FRACTION
+  "$CARDPUNCT",         //-- CARDPUNCT
+  "$CARDSUFFIX",        //-- CARDSUFFIX
+  "$CARDSEPS",          //-- CARDSEPS
+  "$CARD",              //-- CARD
+  "$QUOTE",             //-- QUOTE
+  "$PUNCT",             //-- PUNCTS
+  NULL,                 //-- HYPH_NL
+  NULL,                 //-- HYPH_SP
+  "$ABBR",              //-- ABBR
+  NULL,                 //-- ALPHA
+  "$.",                 //-- EOS
+  "$,",                 //-- COMMA
+  "$PUNCT",             //-- PUNCT
+  NULL                  //-- WORD
+};
+
+#define ALPHA_MASK (UC_ALPHA|UC_HASH)
+#define SPACE_MASK (UC_SPACE|UC_HASH)
+#define PUNCT_MASK (UC_PUNCT|UC_HASH)
+#define ROMAN_MASK (UC_ROMAN|UC_HASH)
+
+//-- TRY(rule,len): accept match (rule,len) if it is longer than the current best
+#define TRY(r,n) if ((n) > best_len) { best_len = (n); best_rule = (r); }
+
+//--------------------------------------------------------------
+// len = scan_hyph(p,end,a,sepmask)
+//  + scans {ALPHA}+\-{SEP}+{ALPHA}+ given initial alpha-span length a
+//  + '#' is in both {SPACE} and {ALPHA}, so {ALPHA}+ may begin inside the separator span
+static inline size_t scan_hyph(const uchar *p, const uchar *end, size_t a, int sepmask)
+{
+  const uchar *q, *qend, *t;
+  size_t a2;
+  if (a==0 || p+a >= end || p[a] != '-') return 0;
+  q    = p+a+1;
+  qend = q + span_in(q, end, sepmask);
+  if (qend==q) return 0;
+  a2 = span_in(qend, end, ALPHA_MASK);
+
+  //-- trailing '#'-run of separator span (after at least one separator character) starts {ALPHA}+
+  for (t=qend; t > q+1 && t[-1]=='#'; --t) ;
+  if (t < qend || a2 > 0) return (qend-p) + a2;
+
+  //-- backtrack: {ALPHA}+ is the last inner '#'-run, ending at a non-'#' separator character
+  for (t=qend-1; t > q+1; --t) {
+    if (t[-1]=='#' && *t != '#') return t-p;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// rule = scan_token(p,end,&len)
+//  + finds longest match at p (p < end)
+static TokRule scan_token(const uchar *p, const uchar *end, size_t *lenp)
+{
+  TokRule best_rule = tr_WORD;
+  size_t  best_len  = 0;
+  int     c0len;
+  int     c0 = uclass(p,end,&c0len);
+  size_t  n, w0 = 0;
+
+  //-- SPACE
+  if (c0 & SPACE_MASK) { TRY(tr_SPACE, (size_t)c0len); }
+
+  //-- SENTBREAK, WORDBREAK
+  if (*p=='$' && p+4 <= end && p[3]=='$') {
+    if (p[1]=='S' && p[2]=='B') { TRY(tr_SENTBREAK, 4); }
+    else if ((p[1]=='W' || p[1]=='T') && p[2]=='B') { TRY(tr_WORDBREAK, 4); }
+  }
+
+  //-- ROMAN: {ROMAN_DIGIT}+\.?
+  if (c0 & ROMAN_MASK) {
+    n = span_in(p,end,ROMAN_MASK);
+    if (p+n < end && p[n]=='.') ++n;
+    TRY(tr_ROMAN, n);
+  }
+
+  //-- numeric rules
+  if (c0 & UC_DIGIT) {
+    size_t d = span_digits(p,end), d2;
+    int    clen;
+    //-- FRACTION: {DIGIT}+\/{DIGIT}+
+    if (p+d < end && p[d]=='/' && (d2=span_digits(p+d+1,end)) > 0) { TRY(tr_FRACTION, d+1+d2); }
+    //-- CARDPUNCT: {DIGIT}+{PUNCT}
+    if (p+d < end && (uclass(p+d,end,&clen) & PUNCT_MASK)) { TRY(tr_CARDPUNCT, d+clen); }
+    //-- CARDSUFFIX: {DIGIT}+{ALPHA}+
+    if ((n = span_in(p+d,end,ALPHA_MASK)) > 0) { TRY(tr_CARDSUFFIX, d+n); }
+  }
+
+  //-- CARDSEPS: ({DIGIT}*[,\.]{DIGIT}+)+
+  if ((c0 & UC_DIGIT) || *p==',' || *p=='.') {
+    const uchar *q = p;
+    size_t d, d2;
+    for (;;) {
+      d = span_digits(q,end);
+      if (q+d < end && (q[d]==',' || q[d]=='.') && (d2=span_digits(q+d+1,end)) > 0) q += d+1+d2;
+      else break;
+    }
+    if (q > p) { TRY(tr_CARDSEPS, (size_t)(q-p)); }
+  }
+
+  //-- CARD: {DIGIT}+
+  if (c0 & UC_DIGIT) { TRY(tr_CARD, span_digits(p,end)); }
+
+  //-- QUOTE: (,,)|(``)|(\'\')|`|\'|\" (+ unicode quotation marks)
+  if (*p==',' || *p=='`' || *p=='\'') {
+    TRY(tr_QUOTE, (p+1 < end && p[1]==p[0] ? 2 : (*p==',' ? 0 : 1)));
+  }
+  else if (*p=='"') { TRY(tr_QUOTE, 1); }
+  else if (c0 & UC_QUOTE) { TRY(tr_QUOTE, (size_t)c0len); }
+
+  //-- PUNCTS: (\-+)|(\_+)|(\.\.+)
+  if (*p=='-' || *p=='_') { TRY(tr_PUNCTS, span_byte(p,end,*p)); }
+  else if (*p=='.' && (n=span_byte(p,end,'.')) > 1) { TRY(tr_PUNCTS, n); }
+
+  //-- alphabetic rules
+  if (c0 & ALPHA_MASK) {
+    size_t a = span_in(p,end,ALPHA_MASK);
+    //-- '#'-free alphabetic prefix is also a prefix of WORD (avoids re-scanning)
+    if (!memchr(p,'#',a)) w0 = a;
+    //-- HYPH_NL: {ALPHA}+\-{NEWLINE}+{ALPHA}+
+    if ((n = scan_hyph(p,end,a,UC_NL)) > 0) { TRY(tr_HYPH_NL, n); }
+    //-- HYPH_SP: {ALPHA}+\-{SPACE}+{ALPHA}+
+    if ((n = scan_hyph(p,end,a,SPACE_MASK)) > 0) { TRY(tr_HYPH_SP, n); }
+
+    //-- ABBR: (Prof|Dr|[[:alpha:]]|([[:alpha:]][[:alpha:]]))\.
+    if (p+5 <= end && memcmp(p,"Prof.",5)==0) { TRY(tr_ABBR, 5); }
+    else if (p+3 <= end && memcmp(p,"Dr.",3)==0) { TRY(tr_ABBR, 3); }
+    else if ((c0 & (UC_ALPHA|UC_HASH))==UC_ALPHA) {
+      int c1len;
+      const uchar *q = p+c0len;
+      if (q < end && *q=='.') { TRY(tr_ABBR, (size_t)(c0len+1)); }
+      else if (q < end && (uclass(q,end,&c1len) & (UC_ALPHA|UC_HASH))==UC_ALPHA && q+c1len < end && q[c1len]=='.') {
+	TRY(tr_ABBR, (size_t)(c0len+c1len+1));
+      }
+    }
+
+    //-- ALPHA: {ALPHA}+
+    TRY(tr_ALPHA, a);
+  }
+
+  //-- single-character punctuation
+  if (*p=='.' || *p=='!' || *p=='?') { TRY(tr_EOS, 1); }
+  else if (*p==',' || *p==':' || *p==';') { TRY(tr_COMMA, 1); }
+  else if (c0 & PUNCT_MASK) { TRY(tr_PUNCT, (size_t)c0len); }
+
+  //-- WORD: [^[:punct:][:digit:][:space:]]+
+  if (!(c0 & (UC_PUNCT|UC_DIGIT|UC_SPACE))) {
+    TRY(tr_WORD, w0+span_notin(p+w0,end,UC_PUNCT|UC_DIGIT|UC_SPACE));
+  }
+
+  //-- fallback (should never happen)
+  if (best_len==0) { best_rule = tr_WORD; best_len = c0len; }
+
+  *lenp = best_len;
+  return best_rule;
+}
+
+/*======================================================================
+ * Output
+ */
+
+static inline void print_eos(void)
+{
+  if (lastWasEOS) return;
+  out_char('\n');
+  lastWasEOS = 1;
+}
+
+//--------------------------------------------------------------
+// print_token(p,end,len,off,typ,literal)
+//  + as for dtatw-tokenize-dummy: drops hyphen+linebreak and linebreaks, maps other whitespace to '_'
+//  + if literal is true, token text is known to contain no whitespace and is copied verbatim
+static void print_token(const uchar *p, const uchar *end, size_t len, ByteOffset off, const char *typ, int literal)
+{
+  const uchar *s, *tend = p+len;
+  int clen, cls;
+  if (literal) out_bytes((const char*)p, len);
+  else for (s=p; s < tend; s += clen) {
+    if (*s < 0x80) {
+      clen = 1;
+      if (*s=='-') {
+	if (s+1 < tend && (s[1]=='\n' || s[1]=='\r')) ++clen;
+	else out_char('-');
+      }
+      else if (*s=='\n' || *s=='\r') ;
+      else if (*s==' ' || (*s >= '\t' && *s <= '\r')) out_char('_');
+      else out_char(*s);
+    }
+    else {
+      cls = uclass(s,end,&clen);
+      if (cls & UC_SPACE) out_char('_');
+      else out_bytes((const char*)s, clen);
+    }
+  }
+  out_char('\t');
+  out_uint(off);
+  out_char(' ');
+  out_uint(len);
+  if (typ) { out_char('\t'); out_bytes(typ, strlen(typ)); }
+  out_char('\n');
+  lastWasEOS = 0;
+  ++ntoks;
+
+  //-- check for EOS
+  if (len==1 && (*p=='.' || *p=='?' || *p=='!')) print_eos();
+}
+
+//--------------------------------------------------------------
+static void tokenize_buffer(const uchar *buf, size_t buflen)
+{
+  const uchar *p = buf, *end = buf+buflen;
+  size_t len;
+  TokRule rule;
+
+  while (p < end) {
+    rule = scan_token(p,end,&len);
+    switch (rule) {
+    case tr_SPACE:
+    case tr_WORDBREAK:
+      break;
+    case tr_SENTBREAK:
+      print_eos();
+      break;
+    default:
+      //-- only the hyphenation rules can match whitespace
+      print_token(p,end,len,(ByteOffset)(p-buf),ruleTypes[rule], (rule != tr_HYPH_NL && rule != tr_HYPH_SP));
+      break;
+    }
+    p += len;
+  }
+  print_eos();
+}
+
+/*======================================================================
+ * MAIN
+ */
+int main(int argc, char **argv)
+{
+  char *filename_in  = "-";
+  char *filename_out = "-";
+  FILE *f_in = stdin;
+  char *buf = NULL;
+  size_t buflen = 0, bufalloc = 0, nread;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+  dtatw_stats_getopt(&argc, argv);
+  f_out = stdout;
+
+  //-- command-line: usage
+  if (argc <= 1 || strcmp(argv[1],"-h")==0 || strcmp(argv[1],"--help")==0) {
+    fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, " + %s [--stats=FILE] INFILE [OUTFILE]\n", prog);
+    fprintf(stderr, " + INFILE  : serialized UTF-8 text file to tokenize\n");
+    fprintf(stderr, " + OUTFILE : tokenizer output (moot 'medium-rare' format)\n");
+    fprintf(stderr, " + \"-\" may be used in place of any filename to indicate standard (in|out)put\n");
+    fprintf(stderr, "%s", " + --stats=FILE : write runtime statistics as JSON to FILE (\"-\" for stderr)\n");
+    exit(1);
+  }
+  //-- command-line: input file
+  if (argc > 1) {
+    filename_in = argv[1];
+    if (strcmp(filename_in,"-")!=0 && !(f_in=fopen(filename_in,"rb"))) {
+      fprintf(stderr, "%s: open failed for input file '%s': %s\n", prog, filename_in, strerror(errno));
+      exit(1);
+    }
+  }
+  //-- command-line: output file
+  if (argc > 2) {
+    filename_out = argv[2];
+    if (strcmp(filename_out,"-")!=0 && !(f_out=fopen(filename_out,"wb"))) {
+      fprintf(stderr, "%s: open failed for output file '%s': %s\n", prog, filename_out, strerror(errno));
+      exit(1);
+    }
+  }
+
+  //-- slurp input (works for pipes too)
+  do {
+    if (buflen+FILE_BUFSIZE > bufalloc) {
+      bufalloc = 2*bufalloc + FILE_BUFSIZE;
+      buf = (char*)realloc(buf, bufalloc);
+      assert2(buf != NULL, "realloc failed");
+    }
+    nread = fread(buf+buflen, 1, FILE_BUFSIZE, f_in);
+    buflen += nread;
+  } while (nread > 0);
+  if (ferror(f_in)) {
+    fprintf(stderr, "%s: read error on input file '%s': %s\n", prog, filename_in, strerror(errno));
+    exit(2);
+  }
+
+  //-- write header comment to outfile
+  fprintf(f_out, "%%%% raw tokenizer output generated by %s (%s version %s)\n", argv[0], PACKAGE, PACKAGE_VERSION);
+
+  //-- guts
+  dtatw_stats_begin("token_loop");
+  tokenize_buffer((const uchar*)buf, buflen);
+  dtatw_stats_end("token_loop");
+  dtatw_stats_begin("flush");
+  out_flush();
+  fflush(f_out);
+  dtatw_stats_end("flush");
+  if (dtatw_stats.filename) {
+    dtatwError err;
+    dtatw_stats_add("bytes_in", "txt", buflen);
+    dtatw_stats_stream("bytes_out", "t", f_out);
+    dtatw_stats_add("counts", "tokens", ntoks);
+    if (dtatw_stats_write(&err) != 0) dtatw_die(&err);
+  }
+
+  //-- cleanup
+  if (buf) free(buf);
+  if (f_in && f_in != stdin) fclose(f_in);
+  if (f_out && f_out != stdout) fclose(f_out);
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * File: dtatw-tokenize-plugin.c
+ * Description: run an in-process tokenizer plugin (see dtatwTokPlugin.h) on a text file
+ *  + output format is that of dtatw-tokenize-dummy
+ */
+
+#include "dtatwCommon.h"
+#include "dtatwTokHost.h"
+
+/*======================================================================
+ * Globals
+ */
+
+#define MAX_OPTS 64
+
+/*======================================================================
+ * MAIN
+ */
+int main(int argc, char **argv)
+{
+  char *plugin = NULL;
+  char *filename_in  = "-";
+  char *filename_out = "-";
+  FILE *f_in  = stdin;
+  FILE *f_out = stdout;
+  const char *opts[MAX_OPTS];
+  int nopts = 0;
+  char *buf = NULL;
+  size_t buflen = 0, bufalloc = 0, nread;
+  TokHost th;
+  dtatwError err;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+  memset(&err,0,sizeof(err));
+  dtatw_stats_getopt(&argc, argv);
+
+  //-- command-line: options
+  while (argc > 1 && argv[1][0]=='-' && argv[1][1]) {
+    if ((strcmp(argv[1],"-o")==0 || strcmp(argv[1],"-option")==0) && argc > 2) {
+      if (nopts >= MAX_OPTS) {
+	fprintf(stderr, "%s: too many plugin options (max=%d)\n", prog, MAX_OPTS);
+	exit(1);
+      }
+      opts[nopts++] = argv[2];
+      ++argv;
+      --argc;
+    } else if (strcmp(argv[1],"-h")==0 || strcmp(argv[1],"--help")==0) {
+      argc = 1;
+      break;
+    } else {
+      fprintf(stderr, "%s: unknown option `%s'\n", prog, argv[1]);
+      exit(1);
+    }
+    ++argv;
+    --argc;
+  }
+
+  //-- command-line: usage
+  if (argc <= 1) {
+    fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, " + %s [--stats=FILE] [-o KEY=VALUE ...] PLUGIN [INFILE [OUTFILE]]\n", prog);
+    fprintf(stderr, " + -o KEY=VALUE : pass option KEY=VALUE to the plugin (may be repeated)\n");
+    fprintf(stderr, " + PLUGIN  : plugin shared object FILE (containing a '/'), or plugin NAME\n");
+    fprintf(stderr, "             (loads %sNAME%s from $%s or %s)\n",
+	    TOKHOST_PREFIX, TOKHOST_SUFFIX, TOKHOST_PATH_ENV, "the package library directory");
+    fprintf(stderr, " + INFILE  : serialized UTF-8 text file to tokenize\n");
+    fprintf(stderr, " + OUTFILE : tokenizer output (moot 'medium-rare' format)\n");
+    fprintf(stderr, " + \"-\" may be used in place of any filename to indicate standard (in|out)put\n");
+    fprintf(stderr, "%s", " + --stats=FILE : write runtime statistics as JSON to FILE (\"-\" for stderr)\n");
+    exit(1);
+  }
+  plugin = argv[1];
+
+  //-- command-line: input file
+  if (argc > 2) {
+    filename_in = argv[2];
+    if (strcmp(filename_in,"-")!=0 && !(f_in=fopen(filename_in,"rb"))) {
+      fprintf(stderr, "%s: open failed for input file '%s': %s\n", prog, filename_in, strerror(errno));
+      exit(1);
+    }
+  }
+  //-- command-line: output file
+  if (argc > 3) {
+    filename_out = argv[3];
+    if (strcmp(filename_out,"-")!=0 && !(f_out=fopen(filename_out,"wb"))) {
+      fprintf(stderr, "%s: open failed for output file '%s': %s\n", prog, filename_out, strerror(errno));
+      exit(1);
+    }
+  }
+
+  //-- load plugin
+  if (tokhost_open(&th, plugin, nopts, opts, &err) != 0) dtatw_die(&err);
+
+  //-- slurp input (works for pipes too)
+  do {
+    if (buflen+FILE_BUFSIZE > bufalloc) {
+      bufalloc = 2*bufalloc + FILE_BUFSIZE;
+      buf = (char*)realloc(buf, bufalloc);
+      assert2(buf != NULL, "realloc failed");
+    }
+    nread = fread(buf+buflen, 1, FILE_BUFSIZE, f_in);
+    buflen += nread;
+  } while (nread > 0);
+  if (ferror(f_in)) {
+    fprintf(stderr, "%s: read error on input file '%s': %s\n", prog, filename_in, strerror(errno));
+    exit(2);
+  }
+
+  //-- write header comment to outfile
+  fprintf(f_out, "%%%% raw tokenizer output generated by %s (%s version %s) using plugin %s (%s version %s)\n",
+	  argv[0], PACKAGE, PACKAGE_VERSION, th.filename, th.plugin->name, th.plugin->version);
+
+  //-- guts
+  dtatw_stats_begin("token_loop");
+  if (tokhost_write(&th, buf, buflen, f_out, &err) != 0) dtatw_die(&err);
+  dtatw_stats_end("token_loop");
+  dtatw_stats_begin("flush");
+  fflush(f_out);
+  dtatw_stats_end("flush");
+  dtatw_stats_add("bytes_in", "txt", buflen);
+  dtatw_stats_stream("bytes_out", "t", f_out);
+  dtatw_stats_add("counts", "tokens", th.ntoks);
+  if (dtatw_stats_write(&err) != 0) dtatw_die(&err);
+
+  //-- cleanup
+  tokhost_close(&th);
+  if (buf) free(buf);
+  if (f_in && f_in != stdin) fclose(f_in);
+  if (f_out && f_out != stdout) fclose(f_out);
+
+  return 0;
+}
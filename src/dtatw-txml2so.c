@@ -0,0 +1,326 @@
+#include "dtatwCommon.h"
+#include "dtatwExpat.h"
+
+/*======================================================================
+ * Globals
+ */
+
+//-- output element states (for deferred closing of start-tags)
+typedef enum {
+  soNone = 0,   //-- no element open
+  soOpen,       //-- start-tag written, but not yet closed with '>'
+  soContent     //-- start-tag closed, element has content
+} SoState;
+
+typedef struct {
+  XML_Parser xp;        //-- expat parser
+  FILE *f_s;            //-- output .s.xml file (or NULL)
+  FILE *f_w;            //-- output .w.xml file (or NULL)
+  FILE *f_a;            //-- output .a.xml file (or NULL)
+  const char *sbase;    //-- root @xml:base for .s.xml and .a.xml files
+  const char *wbase;    //-- root @xml:base for .w.xml file (NULL: copy from input)
+  unsigned depth;       //-- current element depth
+  unsigned s_depth;     //-- depth of currently open <s> (0 if none)
+  unsigned w_depth;     //-- depth of currently open <w> (0 if none)
+  unsigned a_depth;     //-- depth of currently open <w>/<a> (0 if none)
+  SoState  s_state;     //-- state of current .s.xml <s> element
+  SoState  sw_state;    //-- state of current .s.xml <w> element
+  SoState  aw_state;    //-- state of current .a.xml <w> element
+  SoState  aa_state;    //-- state of current .a.xml <a> element
+  ByteOffset n_s;       //-- number of sentences processed
+  ByteOffset n_w;       //-- number of tokens processed
+} ParseData;
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// so_content(f,state)
+//  + ensures that the current output element start-tag (if any) is closed
+static inline
+void so_content(FILE *f, SoState *state)
+{
+  if (f && *state==soOpen) fputc('>',f);
+  if (*state==soOpen) *state = soContent;
+}
+
+//--------------------------------------------------------------
+// so_end(f,state,name)
+//  + closes current output element (if any)
+static inline
+void so_end(FILE *f, SoState *state, const char *name)
+{
+  if (f) {
+    if      (*state==soOpen)    fputs("/>",f);
+    else if (*state==soContent) fprintf(f,"</%s>",name);
+  }
+  *state = soNone;
+}
+
+//--------------------------------------------------------------
+// put_so_attr(f,name,val)
+//  + writes attribute name="val" (with leading space) if val is non-NULL
+static inline
+void put_so_attr(FILE *f, const char *name, const char *val)
+{
+  if (!val) return;
+  fprintf(f," %s=\"",name);
+  put_escaped_str(f,val,-1);
+  fputc('"',f);
+}
+
+//--------------------------------------------------------------
+// put_so_root(f,name,base)
+//  + writes XML header and root start-tag
+static inline
+void put_so_root(FILE *f, const char *name, const char *base)
+{
+  if (!f) return;
+  fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n",f);
+  fprintf(f,"<%s",name);
+  put_so_attr(f,"xml:base",base);
+  fputc('>',f);
+}
+
+/*======================================================================
+ * Handlers
+ */
+
+//--------------------------------------------------------------
+void cb_start(ParseData *data, const XML_Char *name, const XML_Char **attrs)
+{
+  const XML_Char *id;
+  int i;
+
+  ++data->depth;
+
+  //-- root element: write output headers
+  if (data->depth==1) {
+    if (!data->wbase) data->wbase = get_attr("xml:base",attrs);
+    put_so_root(data->f_s, "sentences", data->sbase);
+    put_so_root(data->f_w, "tokens", data->wbase);
+    put_so_root(data->f_a, "tokens", data->sbase);
+    return;
+  }
+
+  //-- a: token analysis (direct children of <w> only)
+  if (data->w_depth && data->depth==data->w_depth+1 && strcmp(name,"a")==0) {
+    data->a_depth = data->depth;
+    if (data->f_a) {
+      so_content(data->f_a, &data->aw_state);
+      fputs("<a",data->f_a);
+      for (i=0; attrs[i]; i += 2) put_so_attr(data->f_a, attrs[i], attrs[i+1]);
+    }
+    data->aa_state = soOpen;
+    return;
+  }
+
+  //-- s: sentence
+  if (strcmp(name,"s")==0) {
+    if (data->s_depth) so_content(data->f_s, &data->s_state);
+    data->s_depth = data->depth;
+    data->s_state = soOpen;
+    if (data->f_s) {
+      fputs("<s",data->f_s);
+      put_so_attr(data->f_s, "xml:id", get_xmlid(attrs));
+    }
+    ++data->n_s;
+    return;
+  }
+
+  //-- w: token
+  if (strcmp(name,"w")==0 && !data->w_depth) {
+    const XML_Char *cids = get_attr("c",attrs);
+    id = get_xmlid(attrs);
+    data->w_depth = data->depth;
+    ++data->n_w;
+
+    //-- .s.xml: <w ref="#ID"/>
+    if (data->f_s) {
+      if (data->s_depth) so_content(data->f_s, &data->s_state);
+      fputs("<w ref=\"#",data->f_s);
+      if (id) put_escaped_str(data->f_s,id,-1);
+      fputc('"',data->f_s);
+    }
+    data->sw_state = soOpen;
+
+    //-- .w.xml: <w xml:id="ID" t="TEXT"><c ref="#CID"/>...</w>
+    //   + one <c> per space-separated item of @c, exactly as the old t2w stylesheet
+    if (data->f_w) {
+      const XML_Char *cp = cids ? cids : "";
+      const XML_Char *sp;
+      fputs("<w",data->f_w);
+      put_so_attr(data->f_w, "xml:id", id);
+      put_so_attr(data->f_w, "t", get_attr("t",attrs));
+      fputc('>',data->f_w);
+      for (;;) {
+	sp = strchr(cp,' ');
+	fputs("<c ref=\"#",data->f_w);
+	put_escaped_str(data->f_w, cp, (sp ? (int)(sp-cp) : -1));
+	fputs("\"/>",data->f_w);
+	if (!sp) break;
+	cp = sp+1;
+      }
+      fputs("</w>",data->f_w);
+    }
+
+    //-- .a.xml: <w ref="#ID"> ... </w>
+    if (data->f_a) {
+      fputs("<w ref=\"#",data->f_a);
+      if (id) put_escaped_str(data->f_a,id,-1);
+      fputc('"',data->f_a);
+    }
+    data->aw_state = soOpen;
+    return;
+  }
+}
+
+//--------------------------------------------------------------
+void cb_end(ParseData *data, const XML_Char *name)
+{
+  if (data->depth==data->a_depth) {
+    so_end(data->f_a, &data->aa_state, "a");
+    data->a_depth = 0;
+  }
+  else if (data->depth==data->w_depth) {
+    so_end(data->f_s, &data->sw_state, "w");
+    so_end(data->f_a, &data->aw_state, "w");
+    data->w_depth = 0;
+  }
+  else if (data->depth==data->s_depth) {
+    so_end(data->f_s, &data->s_state, "s");
+    data->s_depth = 0;
+  }
+  else if (data->depth==1) {
+    if (data->f_s) fputs("</sentences>\n",data->f_s);
+    if (data->f_w) fputs("</tokens>\n",data->f_w);
+    if (data->f_a) fputs("</tokens>\n",data->f_a);
+  }
+  --data->depth;
+}
+
+//--------------------------------------------------------------
+void cb_char(ParseData *data, const XML_Char *s, int len)
+{
+  //-- only direct text content of <w>/<a> is copied (to .a.xml)
+  if (!data->a_depth || data->depth != data->a_depth || !data->f_a) return;
+  so_content(data->f_a, &data->aa_state);
+  put_escaped_str(data->f_a, s, len);
+}
+
+/*======================================================================
+ * MAIN
+ */
+
+//--------------------------------------------------------------
+// f = open_so_file(filename, label)
+//  + empty filename suppresses output (returns NULL)
+static
+FILE *open_so_file(const char *filename, const char *label)
+{
+  FILE *f;
+  if (!filename || !*filename) return NULL;
+  if (strcmp(filename,"-")==0) return stdout;
+  if ( !(f=fopen(filename,"wb")) ) {
+    fprintf(stderr, "%s: open failed for output %s file `%s': %s\n", prog, label, filename, strerror(errno));
+    exit(1);
+  }
+  return f;
+}
+
+int main(int argc, char **argv)
+{
+  ParseData data;
+  XML_Parser xp;
+  char *filename_in = "-";
+  char *filename_s = "";
+  char *filename_w = "";
+  char *filename_a = "";
+  FILE *f_in = stdin;
+  ByteOffset n_xbytes = 0;
+
+  //-- initialize: globals
+  prog = file_basename(NULL,argv[0],"",-1,0);
+  dtatw_stats_getopt(&argc, argv);
+  memset(&data,0,sizeof(data));
+
+  //-- command-line: usage
+  if (argc <= 1) {
+    fprintf(stderr, "(%s version %s / %s)\n", PACKAGE, PACKAGE_VERSION, PACKAGE_SVNID);
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, " %s [--stats=FILE] TXMLFILE SXMLFILE WXMLFILE AXMLFILE [XMLBASE [SOBASE]]\n", prog);
+    fprintf(stderr, " + TXMLFILE : XML-ified tokenizer output (.t.xml)\n");
+    fprintf(stderr, " + SXMLFILE : output sentence standoff file (.s.xml)\n");
+    fprintf(stderr, " + WXMLFILE : output token standoff file (.w.xml)\n");
+    fprintf(stderr, " + AXMLFILE : output token-analysis standoff file (.a.xml)\n");
+    fprintf(stderr, " + XMLBASE  : root xml:base for WXMLFILE (default: copy from TXMLFILE)\n");
+    fprintf(stderr, " + SOBASE   : root xml:base for SXMLFILE, AXMLFILE (default: basename(WXMLFILE))\n");
+    fprintf(stderr, " + \"-\" may be used in place of any filename to indicate standard (in|out)put\n");
+    fprintf(stderr, " + \"\" may be used in place of any output filename to suppress that output\n");
+    fprintf(stderr, "%s", " + --stats=FILE : write runtime statistics as JSON to FILE (\"-\" for stderr)\n");
+    exit(1);
+  }
+  //-- command-line: input file
+  if (argc > 1) {
+    filename_in = argv[1];
+    if (strcmp(filename_in,"-")!=0 && !(f_in=fopen(filename_in,"rb")) ) {
+      fprintf(stderr, "%s: open failed for input .t.xml file `%s': %s\n", prog, filename_in, strerror(errno));
+      exit(1);
+    }
+  }
+  //-- command-line: output files
+  if (argc > 2) filename_s = argv[2];
+  if (argc > 3) filename_w = argv[3];
+  if (argc > 4) filename_a = argv[4];
+  data.f_s = open_so_file(filename_s, ".s.xml");
+  data.f_w = open_so_file(filename_w, ".w.xml");
+  data.f_a = open_so_file(filename_a, ".a.xml");
+
+  //-- command-line: xml:base values
+  if (argc > 5 && argv[5][0]) data.wbase = argv[5];
+  if (argc > 6) data.sbase = argv[6];
+  else if (filename_w[0] && strcmp(filename_w,"-")!=0) data.sbase = file_basename(NULL,filename_w,"",-1,0);
+
+  //-- setup expat parser
+  xp = XML_ParserCreate("UTF-8");
+  if (!xp) {
+    fprintf(stderr, "%s: XML_ParserCreate failed", prog);
+    exit(1);
+  }
+  XML_SetUserData(xp, &data);
+  XML_SetElementHandler(xp, (XML_StartElementHandler)cb_start, (XML_EndElementHandler)cb_end);
+  XML_SetCharacterDataHandler(xp, (XML_CharacterDataHandler)cb_char);
+  data.xp = xp;
+
+  //-- parse input file
+  dtatw_stats_begin("token_loop");
+  n_xbytes = expat_parse_file(xp, f_in, filename_in);
+  dtatw_stats_end("token_loop");
+
+  //-- flush output
+  dtatw_stats_begin("flush");
+  if (data.f_s) fflush(data.f_s);
+  if (data.f_w) fflush(data.f_w);
+  if (data.f_a) fflush(data.f_a);
+  dtatw_stats_end("flush");
+  if (dtatw_stats.filename) {
+    dtatwError err;
+    dtatw_stats_add("bytes_in", "txml", n_xbytes);
+    dtatw_stats_stream("bytes_out", "s", data.f_s);
+    dtatw_stats_stream("bytes_out", "w", data.f_w);
+    dtatw_stats_stream("bytes_out", "a", data.f_a);
+    dtatw_stats_add("counts", "sentences", data.n_s);
+    dtatw_stats_add("counts", "tokens", data.n_w);
+    if (dtatw_stats_write(&err) != 0) dtatw_die(&err);
+  }
+
+  //-- cleanup
+  if (f_in && f_in != stdin) fclose(f_in);
+  if (data.f_s && data.f_s != stdout) fclose(data.f_s);
+  if (data.f_w && data.f_w != stdout) fclose(data.f_w);
+  if (data.f_a && data.f_a != stdout) fclose(data.f_a);
+  if (xp) XML_ParserFree(xp);
+
+  return 0;
+}
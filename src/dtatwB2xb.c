@@ -0,0 +1,432 @@
+#include "dtatwB2xb.h"
+#include "dtatwZio.h"
+
+/*======================================================================
+ * Globals
+ */
+
+// VERBOSE_IO : whether to print progress messages for load/save
+//#define VERBOSE_IO 1
+#undef VERBOSE_IO
+
+// WARN_ON_OVERLAP : whether to output warnings when token overlap is detected
+//  + whether or not this is defined, tokens where overlap was detected will be commented out
+#define WARN_ON_OVERLAP 1
+//#undef WARN_ON_OVERLAP
+
+// WARN_ON_NOCX : whether to output warnings when token without cx record is detected
+//  + whether or not this is defined, tokens with no cx records will be commented out
+#define WARN_ON_NOCX 1
+//#undef WARN_ON_NOCX
+
+/*======================================================================
+ * Utils: .cx, .bx file, indexing
+ *  + now in dtatwCommon.[ch]; state is in B2xbData (see dtatwB2xb.h)
+ */
+
+/*======================================================================
+ * Utils: .tt
+ */
+
+static const ByteLen CX_CLAIMED = (ByteLen)-1;
+
+//--------------------------------------------------------------
+// bool = cx_claimed(cx)
+//  + returns true iff cx has been claimed by some token
+//  + hack tests cx->tlen==(ByteLen)-1
+static inline int cx_claimed(const cxRecord *cx)
+{
+  return cx && cx->tlen==CX_CLAIMED;
+}
+
+//--------------------------------------------------------------
+// undef = cx_claim(cx)
+//  + claims cx record cx by setting cx->xlen=0
+//  + hack sets cx->tlen=(ByteLen)-1
+static inline void cx_claim(cxRecord *cx)
+{
+  if (cx) cx->tlen = CX_CLAIMED;
+}
+
+//--------------------------------------------------------------
+/* bool = cx_elt_ok(cx)
+ *  + returns true iff cx is a "real" character record with a valid element name, etc.
+ *  + bad names: none
+ *  + see dtatwCommon.h for id constants
+ */
+static inline int cx_elt_ok(const cxRecord *cx)
+{
+  return (cx != NULL
+	  //&& cx->elt
+	  //&& cx->elt[0]
+	  //&& strcmp(cx->id,CX_NIL_ID) !=0
+	  //&& strncmp(cx->id,CX_FORMULA_PREFIX,strlen(CX_FORMULA_PREFIX)) !=0
+	  //&& strcmp(cx->id,CX_LB_ID) !=0
+	  //&& strcmp(cx->id,CX_PB_ID) !=0
+	  );
+}
+
+
+//--------------------------------------------------------------
+/* Typedef(s) for .tt "word buffer"
+ */
+#define WORDBUF_TEXT_LEN 8192
+#define WORDBUF_CX_LEN   8192
+#define WORDBUF_REST_LEN 8192
+
+//-- flags for ttWordBuffer
+typedef enum {
+  ttwNone  = 0x0000,    //-- no special flags
+  ttwSB    = 0x0001,    //-- whether we saw a sentence boundary before this word
+  ttwOver  = 0x0004,    //-- did this word overlap?
+  ttwNoCx  = 0x0008,	//-- is this word missing any cx-record?
+  ttwAll   = 0x000f,    //-- all flags
+} ttWordFlags;
+
+
+typedef struct {
+  unsigned int w_flags;                //-- mask of ttWordFlags flags
+  ByteOffset w_off;                    //-- .txt byte offset, as reported by tokenizer
+  ByteOffset w_len;                    //-- .txt byte length, as reported by tokenizer
+  char       w_text[WORDBUF_TEXT_LEN]; //-- word text buffer
+  char       w_rest[WORDBUF_REST_LEN]; //-- word analyses buffer (TAB-separated)
+  cxRecord  *w_cx  [WORDBUF_CX_LEN];   //-- word .cx buffer
+} ttWordBuffer;
+
+//--------------------------------------------------------------
+/* tt_dump_coords(b, f_out, w)
+ *  + appends coordinate columns (B2XB_COORD_*) for word w to f_out (requires b->cxdata.coords)
+ *  + page and line are those of the first character; bbox is the union of all valid
+ *    character bboxes on that page (cf. bboxes() in dtatw-get-ddc-attrs.perl, without line- and column-break detection)
+ */
+static void tt_dump_coords(const B2xbData *b, FILE *f_out, const ttWordBuffer *w)
+{
+  const cxRecord *cx, *cx_prev = NULL;
+  const cxCoords *co, *co0 = NULL;
+  int32_t bb[4] = {-1,-1,-1,-1};
+  int i;
+
+  for (i=0; i < w->w_len; i++) {
+    if (!(cx = w->w_cx[i]) || cx == cx_prev) continue;
+    cx_prev = cx;
+    co = &b->cxdata.coords[cx - b->cxdata.data];
+    if (!co0) co0 = co;
+    if (co->pb != co0->pb || co->bbox[0] < 0 || co->bbox[1] < 0 || co->bbox[2] < 0 || co->bbox[3] < 0) continue;
+    if (bb[0] < 0) {
+      memcpy(bb, co->bbox, sizeof(bb));
+      continue;
+    }
+    if (co->bbox[0] < bb[0]) bb[0] = co->bbox[0];
+    if (co->bbox[1] < bb[1]) bb[1] = co->bbox[1];
+    if (co->bbox[2] > bb[2]) bb[2] = co->bbox[2];
+    if (co->bbox[3] > bb[3]) bb[3] = co->bbox[3];
+  }
+
+  if (!co0) {
+    fputs("\t" B2XB_COORD_PB "-1\t" B2XB_COORD_LB "-1\t" B2XB_COORD_BB, f_out);
+    return;
+  }
+  fprintf(f_out, "\t" B2XB_COORD_PB "%u\t" B2XB_COORD_LB "%u\t" B2XB_COORD_BB, (uint)co0->pb, (uint)co0->lb);
+  if (bb[0] >= 0) fprintf(f_out, "%d|%d|%d|%d", bb[0], bb[1], bb[2], bb[3]);
+}
+
+//--------------------------------------------------------------
+/* tt_dump_word(b, f_out, w1)
+ *  + checks for pathological conditions on word boundaries
+ *  + s_open is a flag indicating whether a sentence-element is currently open
+ */
+static void tt_dump_word(B2xbData *b, FILE *f_out, ttWordBuffer *w)
+{
+  int i,j;
+  char     *xmlpos   = b->w_xmlpos;
+  ByteOffset xmlend  = (ByteOffset)-1;
+  cxRecord *icx, *jcx, *jcx_prev;
+
+  //-- compute xml-bytes
+  *xmlpos = '\0';
+  for (i=0; i < w->w_len; i=j+1) {
+    icx    = jcx_prev = b->txtb2cx.data[w->w_off+i];
+    xmlend = icx ? (icx->xoff + icx->xlen) : (ByteOffset)-1;
+
+    for (j=i; j<w->w_len; j++) {
+      jcx = b->txtb2cx.data[w->w_off+j];
+      if (jcx && jcx->claimed > 1) {
+#if WARN_ON_OVERLAP
+	if ( !(w->w_flags&ttwOver) )
+	  fprintf(stderr, "%s: WARNING: `%s' line %u: overlapping word `%s' at XML-byte %" ByteOffsetF " (elt=%s)\n",
+		  prog, b->tt_filename, b->tt_linenum, w->w_text,
+		  (jcx ? jcx->xoff : 0),
+		  (jcx ? cxTypeNames[jcx->typ] : "?"));
+#endif
+	w->w_flags |= ttwOver;
+	break;
+      }
+      if (jcx==jcx_prev) continue; //-- ignore word-internal duplicates
+      if (!cx_elt_ok(jcx) || !cx_is_adjacent(jcx_prev,jcx)) {
+	--j;
+	break;
+      }
+
+      jcx->claimed = 1;
+      jcx_prev = jcx;
+      xmlend   = jcx->xoff + jcx->xlen;
+    }
+
+    //-- append to position buffer
+    if (!icx) {
+      //-- null character: ignore
+      continue;
+    } else if (icx->claimed <= 1) {
+      //-- append: unclaimed initial character
+      xmlpos += sprintf(xmlpos, " %" ByteOffsetF "+%d", icx->xoff, (int)(xmlend - icx->xoff));
+    } else if (icx->claimed > 1) {
+      //-- append: claimed character
+      xmlpos += sprintf(xmlpos, " %" ByteOffsetF "+%d", icx->xoff, 0);
+    }
+  }
+  if (b->w_xmlpos[0]) b->w_xmlpos[0] = '~';
+  else {
+#if WARN_ON_NOCX
+    fprintf(stderr, "%s: WARNING: `%s' line %u: no cx-records for word `%s' at txt-byte %" ByteOffsetF "\n",
+	    prog, b->tt_filename, (uint)b->tt_linenum, w->w_text, w->w_off);
+#endif
+    w->w_flags |= ttwNoCx; //-- no cx-record(s) for this word: wtf?
+  }
+
+  //-- claim all characters
+  for (i=0; i < w->w_len; ++i) {
+    if ((icx = b->txtb2cx.data[w->w_off+i])) icx->claimed = 2;
+#ifdef DTATW_DEBUG_OVERLAP
+    //-- "CLAIM" "\t" xoff xlen "\t" wtext "\t" txtoff txtlen "\n"
+    fprintf(stderr, "CLAIM\t%u %u\t%s\t%u %u\n",
+	    (uint)(icx ? icx->xoff : 0), (uint)(icx ? icx->xlen : 0),
+	    (w ? w->w_text : ""),
+	    (uint)(w ? w->w_off : 0), (uint)(w ? w->w_len : 0));
+#endif
+  }
+
+  //-- dump: bad-flag (comment)
+  if      (w->w_flags & ttwOver) fputs("%%$OVERLAP\t", f_out);
+  else if (w->w_flags & ttwNoCx) fputs("%%$NOCX\t", f_out);
+
+  //-- dump: text
+  fputs(w->w_text, f_out);
+
+  //-- dump: byte offsets: "TOFF TLEN @ XOFF1+XLEN1 XOFF2+XLEN2 ... XOFFn+XLENn"
+  fprintf(f_out, "\t%" ByteOffsetF " %" ByteLenF "%s", w->w_off, w->w_len, b->w_xmlpos);
+
+  //-- dump: rest
+  if (w->w_rest[0]) {
+    fputc('\t', f_out);
+    fputs(w->w_rest, f_out);
+  }
+
+  //-- dump: coordinates
+  if (b->want_coords) tt_dump_coords(b, f_out, w);
+  fputc('\n',f_out);
+
+  //-- update: profiling information
+  ++b->ntoks;
+
+  //-- update: clear word
+  memset(w, 0, sizeof(ttWordBuffer));
+#if 0
+  w->w_flags = ttwNone;
+  w->w_off   = 0;
+  w->w_len   = 0;
+  w->w_text[0] = '\0';
+  w->w_rest[0] = '\0';
+  w->w_cx[0]   = NULL;
+#endif
+}
+
+//--------------------------------------------------------------
+/* status = b2xb_process(b, f_in, filename_in, f_out, err)
+ *  + requires:
+ *    - populated b->cxdata struct (see cxDataLoad() in dtatwCommon.c)
+ *    - populated b->txtb2cx struct (see txt2cxIndex() in dtatwCommon.c)
+ */
+#define INITIAL_TT_LINEBUF_SIZE 8192
+int b2xb_process(B2xbData *b, FILE *f_in, const char *filename_in, FILE *f_out, dtatwError *err)
+{
+  char *linebuf=NULL; //, *s0, *s1;
+  size_t linebuf_alloc=0;
+  ssize_t linelen;
+  int last_was_eos = 1;          //-- bool: was the last line read an EOS?
+  int status = 0;
+  char *w_text, *w_loc, *w_loc_tail, *w_rest;  //-- temps for input parsing
+  ttWordBuffer w;     //-- word buffer(s);
+
+  //-- sanity checks
+  if (f_in == NULL || f_out == NULL)
+    return dtatw_error(err, 1, "b2xb_process(): no input or output file");
+  if (b->cxdata.data == NULL || b->txtb2cx.data == NULL)
+    return dtatw_error(err, 1, "b2xb_process(): no .cx data or index loaded");
+
+  //-- init line buffer
+  linebuf = (char*)malloc(INITIAL_TT_LINEBUF_SIZE);
+  assert(linebuf != NULL /* malloc failed */);
+  linebuf_alloc = INITIAL_TT_LINEBUF_SIZE;
+
+  //-- init error reporting
+  b->tt_linenum = 0;
+  b->tt_filename = filename_in;
+
+  //-- init word buffer(s)
+  memset(&w, 0, sizeof(ttWordBuffer));
+
+  //-- ye olde loope
+  while ( (linelen=getline(&linebuf,&linebuf_alloc,f_in)) >= 0 ) {
+    ++b->tt_linenum;
+    if (linebuf[0]=='%' && linebuf[1]=='%') {
+	//-- comment: just dump
+	fwrite(linebuf, linelen, 1, f_out);
+	continue;
+    }
+
+    //-- chomp newline (and maybe carriage return)
+    if (linelen>0 && linebuf[linelen-1]=='\n') linebuf[--linelen] = '\0';
+    if (linelen>0 && linebuf[linelen-1]=='\r') linebuf[--linelen] = '\0';
+
+    //-- check for EOS (blank line)
+    if (linebuf[0]=='\0') {
+      if (!last_was_eos) fputc('\n',f_out);
+      last_was_eos = 1;
+      continue;
+    }
+    last_was_eos = 0;
+
+    //-- word: inital parse into strings (w_text, w_loc, w_rest)
+    w_text = linebuf;
+    w_loc  = next_tab_z(w_text)+1;
+    w_rest = next_tab_z(w_loc)+1;
+    if (w_loc-w_text >= WORDBUF_TEXT_LEN || linelen-(w_rest-w_text) >= WORDBUF_REST_LEN) {
+      status = dtatw_error(err, 3, "`%s' line %u: buffer overflow", filename_in, (uint)b->tt_linenum);
+      break;
+    }
+
+    //-- word: parse to buffer 'w'
+    w.w_off = strtoull(w_loc,      &w_loc_tail, 0);
+    w.w_len = strtoull(w_loc_tail, NULL,        0);
+    strcpy(w.w_text, w_text);
+    strcpy(w.w_rest, w_rest);
+
+    //-- word: populate w.w_cx[] buffer
+    if (w.w_len >= WORDBUF_CX_LEN) {
+      status = dtatw_error(err, 3, "`%s' line %u: buffer overflow", filename_in, (uint)b->tt_linenum);
+      break;
+    }
+    if (w.w_off+w.w_len > b->txtb2cx.len) {
+      status = dtatw_error(err, 3, "`%s' line %u: text offset %" ByteOffsetF "+%" ByteLenF " out of range", filename_in, (uint)b->tt_linenum, w.w_off, w.w_len);
+      break;
+    }
+    memcpy(w.w_cx, b->txtb2cx.data+w.w_off, w.w_len*sizeof(cxRecord*));
+    w.w_cx[w.w_len] = NULL;
+
+    //-- word: delegate output to boundary-condition checker
+    tt_dump_word(b, f_out, &w);
+  }
+  if (status==0 && !last_was_eos) fputc('\n',f_out);
+
+  //-- cleanup
+  if (linebuf) free(linebuf);
+  return status;
+}
+
+/*======================================================================
+ * API
+ */
+
+//--------------------------------------------------------------
+int b2xb_init(B2xbData *b, FILE *f_cx, const char *filename_cx, FILE *f_bx, int want_coords, dtatwError *err)
+{
+  FILE *zf;
+  int ok;
+  memset(b, 0, sizeof(B2xbData));
+  b->tt_linenum  = 1;
+  b->tt_filename = "(?)";
+  b->want_coords = want_coords;
+
+  //-- load .cx data (possibly compressed: see zio_fwrap_in())
+  dtatw_stats_begin("cx_load");
+  if (f_cx && !(zf = zio_fwrap_in(f_cx, filename_cx, 0, err))) return (err ? err->code : 1);
+  ok = (f_cx && cxDataLoad(&b->cxdata, zf, filename_cx, want_coords) && !ferror(zf));
+  if (f_cx && zf != f_cx) fclose(zf);
+  if (!ok) {
+    return dtatw_error(err, 1, "failed to load .cx file `%s'", (filename_cx ? filename_cx : "?"));
+  }
+  dtatw_stats_end("cx_load");
+  dtatw_stats_add("counts", "cx_records", b->cxdata.len);
+#ifdef VERBOSE_IO
+  fprintf(stderr, "%s: parsed %zu records from .cx file '%s'\n", prog, (size_t)b->cxdata.len, filename_cx);
+#endif
+
+  //-- load .bx data
+  dtatw_stats_begin("bx_load");
+  if (f_bx && !(zf = zio_fwrap_in(f_bx, ".bx", 0, err))) {
+    b2xb_free(b);
+    return (err ? err->code : 1);
+  }
+  ok = (f_bx && bxDataLoad(&b->bxdata, zf) && !ferror(zf));
+  if (f_bx && zf != f_bx) fclose(zf);
+  if (!ok) {
+    b2xb_free(b);
+    return dtatw_error(err, 1, "failed to load .bx data");
+  }
+  dtatw_stats_end("bx_load");
+  dtatw_stats_add("counts", "bx_records", b->bxdata.len);
+#ifdef VERBOSE_IO
+  fprintf(stderr, "%s: parsed %zu records from .bx file\n", prog, (size_t)b->bxdata.len);
+#endif
+
+  //-- create (tx_byte_index => cx_record) lookup vector
+  dtatw_stats_begin("index");
+  tx2cxIndex(&b->txb2cx, &b->cxdata);
+#ifdef VERBOSE_IO
+  fprintf(stderr, "%s: initialized %zu-element .tx-byte => .cx-record index\n", prog, (size_t)b->txb2cx.len);
+#endif
+
+  //-- create (txt_byte_index => cx_record_or_NULL) lookup vector
+  txt2cxIndex(&b->txtb2cx, &b->bxdata, &b->txb2cx);
+  dtatw_stats_end("index");
+#ifdef VERBOSE_IO
+  fprintf(stderr, "%s: initialized %zu-element .txt-byte => .cx-record index\n", prog, (size_t)b->txtb2cx.len);
+#endif
+
+  return 0;
+}
+
+//--------------------------------------------------------------
+void b2xb_put_header(B2xbData *b, FILE *f_out, int argc, char **argv, const char *xmlbase, const char *xmlsuff)
+{
+  int i;
+
+  //-- doc header: comments
+  fprintf(f_out, "%%%% File created by %s (%s version %s)\n", prog, PACKAGE, PACKAGE_VERSION);
+  fprintf(f_out, "%%%% Command-line: %s", (argc > 0 ? argv[0] : prog));
+  for (i=1; i < argc; i++) {
+    fprintf(f_out, " '%s'", (argv[i][0] ? argv[i] : ""));
+  }
+  fprintf(f_out, "\n%%%%\n");
+
+  //-- doc header: xmlbase
+  if (xmlbase && *xmlbase) {
+    fprintf(f_out, "%%%% base=%s%s\n", xmlbase, (xmlsuff ? xmlsuff : ""));
+  }
+}
+
+//--------------------------------------------------------------
+ByteOffset b2xb_xml_bytes(const B2xbData *b)
+{
+  if (!b->cxdata.data || !b->cxdata.len) return 0;
+  return b->cxdata.data[b->cxdata.len-1].xoff + b->cxdata.data[b->cxdata.len-1].xlen;
+}
+
+//--------------------------------------------------------------
+void b2xb_free(B2xbData *b)
+{
+  Offset2CxIndexFree(&b->txtb2cx);
+  Offset2CxIndexFree(&b->txb2cx);
+  bxDataFree(&b->bxdata);
+  cxDataFree(&b->cxdata);
+}
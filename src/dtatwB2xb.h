@@ -0,0 +1,62 @@
+/*
+ * File: dtatwB2xb.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: tokenizer-output offset conversion (dtatw-b2xb core)
+ */
+
+#ifndef DTATW_B2XB_H
+#define DTATW_B2XB_H
+
+#include "dtatwCommon.h"
+
+/*======================================================================
+ * b2xb: types
+ */
+
+#define B2XB_XMLPOS_LEN 8192
+
+//-- coordinate columns appended to .tt output if B2xbData.want_coords is set (mapped to attributes by tok2xml_process() if Tok2XmlData.want_coords is set)
+#define B2XB_COORD_PB "$PB="  //-- "$PB=FACS": page of first character (see cxCoords.pb)
+#define B2XB_COORD_LB "$LB="  //-- "$LB=LINE": line of first character (see cxCoords.lb)
+#define B2XB_COORD_BB "$BB="  //-- "$BB=ULX|ULY|LRX|LRY": union of character bboxes on that page (empty if none)
+
+//-- B2xbData: conversion state (formerly dtatw-b2xb globals)
+typedef struct {
+  cxData cxdata;              //-- cxRecord *cx = &cxdata.data[c_index]; cxCoords *co = &cxdata.coords[c_index] if want_coords
+  bxData bxdata;              //-- bxRecord *bx = &bxdata.data[block_index]
+  Offset2CxIndex txb2cx;      //-- cxRecord *cx =  txb2cx.data[ tx_byte_index]
+  Offset2CxIndex txtb2cx;     //-- cxRecord *cx = txtb2cx.data[txt_byte_index]
+  const char  *tt_filename;   //-- current input filename (for error reporting)
+  unsigned int tt_linenum;    //-- current input line (for error reporting)
+  ByteOffset   ntoks;         //-- number of tokens processed
+  int          want_coords;   //-- if true, b2xb_process() appends $PB=, $LB=, $BB= columns (see B2XB_COORD_*)
+  char w_xmlpos[B2XB_XMLPOS_LEN]; //-- temp for output construction
+} B2xbData;
+
+/*======================================================================
+ * b2xb: API
+ *  + functions returning int return 0 on success, otherwise err->code (a suggested exit() status); err may be NULL
+ */
+
+// status = b2xb_init(b, f_cx,filename_cx, f_bx, want_coords, err)
+//  + loads .cx and .bx data (possibly compressed, cf. zio_fwrap_in()) and creates lookup indices
+//  + .cx coordinates (b->cxdata.coords) are only loaded if want_coords is true; sets b->want_coords
+int b2xb_init(B2xbData *b, FILE *f_cx, const char *filename_cx, FILE *f_bx, int want_coords, dtatwError *err);
+
+// b2xb_put_header(b, f_out, argc,argv, xmlbase,xmlsuff)
+//  + prints "%%"-comment header (including command-line argv[0..argc-1] and base=XMLBASE XMLSUFF if xmlbase is non-empty)
+void b2xb_put_header(B2xbData *b, FILE *f_out, int argc, char **argv, const char *xmlbase, const char *xmlsuff);
+
+// status = b2xb_process(b, f_in,filename_in, f_out, err)
+//  + converts tokenizer output (.t) from f_in to f_out (.tt with xml-byte offsets)
+int b2xb_process(B2xbData *b, FILE *f_in, const char *filename_in, FILE *f_out, dtatwError *err);
+
+// nxbytes = b2xb_xml_bytes(b)
+//  + approximate number of original source XML bytes (from .cx data)
+ByteOffset b2xb_xml_bytes(const B2xbData *b);
+
+// b2xb_free(b)
+//  + frees data allocated by b2xb_init() (but not b itself)
+void b2xb_free(B2xbData *b);
+
+#endif /* DTATW_B2XB_H */
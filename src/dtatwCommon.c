@@ -1,4 +1,11 @@
 #include "dtatwCommon.h"
+#include <stdarg.h>
+#if HAVE_SYS_TIME_H
+# include <sys/time.h>      /* for gettimeofday() */
+#endif
+#if HAVE_SYS_RESOURCE_H
+# include <sys/resource.h>  /* for getrusage() */
+#endif
 
 /*======================================================================
  * Globals
@@ -16,6 +23,198 @@ extern char *basename(const char *path);
 //-- suppress gcc warnings of the form "ignoring return value of `fread', declared with attribute warn_unused_result [-Wunused-result]"
 #pragma GCC diagnostic ignored "-Wunused-result"
 
+/*======================================================================
+ * Errors
+ */
+
+//--------------------------------------------------------------
+int dtatw_error(dtatwError *err, int code, const char *fmt, ...)
+{
+  va_list ap;
+  if (!err) return code;
+  err->code = code;
+  va_start(ap, fmt);
+  vsnprintf(err->msg, DTATW_ERRMSG_LEN, fmt, ap);
+  va_end(ap);
+  return code;
+}
+
+//--------------------------------------------------------------
+void dtatw_die(const dtatwError *err)
+{
+  fprintf(stderr, "%s: %s\n", prog, err->msg);
+  exit(err->code ? err->code : 255);
+}
+
+/*======================================================================
+ * Runtime statistics
+ */
+
+dtatwStats dtatw_stats;
+
+//--------------------------------------------------------------
+static double stats_wall(void)
+{
+#if HAVE_SYS_TIME_H
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + ((double)tv.tv_usec)/1e6;
+#else
+  return (double)time(NULL);
+#endif
+}
+
+//--------------------------------------------------------------
+static double stats_cpu(void)
+{
+  return ((double)clock()) / ((double)CLOCKS_PER_SEC);
+}
+
+//--------------------------------------------------------------
+int dtatw_stats_getopt(int *argcp, char **argv)
+{
+  int i, j;
+  for (i=j=1; i < *argcp; i++) {
+    if (strncmp(argv[i],"--stats=",8)==0)     dtatw_stats.filename = argv[i]+8;
+    else if (strncmp(argv[i],"-stats=",7)==0) dtatw_stats.filename = argv[i]+7;
+    else argv[j++] = argv[i];
+  }
+  *argcp = j;
+  argv[j] = NULL;
+  dtatw_stats.wall0 = stats_wall();
+  dtatw_stats.cpu0  = stats_cpu();
+  return dtatw_stats.filename != NULL;
+}
+
+//--------------------------------------------------------------
+static dtatwStatsPhase *stats_phase(const char *phase)
+{
+  int i;
+  for (i=0; i < dtatw_stats.nphases; i++) {
+    if (strcmp(dtatw_stats.phases[i].name, phase)==0) return &dtatw_stats.phases[i];
+  }
+  if (dtatw_stats.nphases >= DTATW_STATS_MAXPHASES) return NULL;
+  dtatw_stats.phases[i].name = phase;
+  dtatw_stats.nphases++;
+  return &dtatw_stats.phases[i];
+}
+
+//--------------------------------------------------------------
+void dtatw_stats_begin(const char *phase)
+{
+  dtatwStatsPhase *p;
+  if (!dtatw_stats.filename || !(p=stats_phase(phase))) return;
+  p->wall0   = stats_wall();
+  p->cpu0    = stats_cpu();
+  p->running = 1;
+}
+
+//--------------------------------------------------------------
+void dtatw_stats_end(const char *phase)
+{
+  dtatwStatsPhase *p;
+  if (!dtatw_stats.filename || !(p=stats_phase(phase)) || !p->running) return;
+  p->wall   += stats_wall() - p->wall0;
+  p->cpu    += stats_cpu()  - p->cpu0;
+  p->running = 0;
+}
+
+//--------------------------------------------------------------
+void dtatw_stats_add(const char *group, const char *name, uint64_t n)
+{
+  int i;
+  if (!dtatw_stats.filename) return;
+  for (i=0; i < dtatw_stats.ncounts; i++) {
+    if (strcmp(dtatw_stats.counts[i].group,group)==0 && strcmp(dtatw_stats.counts[i].name,name)==0) break;
+  }
+  if (i >= DTATW_STATS_MAXCOUNTS) return;
+  if (i == dtatw_stats.ncounts) {
+    dtatw_stats.counts[i].group = group;
+    dtatw_stats.counts[i].name  = name;
+    dtatw_stats.counts[i].val   = 0;
+    dtatw_stats.ncounts++;
+  }
+  dtatw_stats.counts[i].val += n;
+}
+
+//--------------------------------------------------------------
+void dtatw_stats_stream(const char *group, const char *name, FILE *f)
+{
+  off_t pos;
+  if (!dtatw_stats.filename || !f) return;
+  if ((pos = ftello(f)) >= 0) dtatw_stats_add(group, name, (uint64_t)pos);
+}
+
+//--------------------------------------------------------------
+static void stats_put_str(FILE *f, const char *s)
+{
+  fputc('"', f);
+  for (; *s; s++) {
+    if (*s=='"' || *s=='\\') fputc('\\', f);
+    if ((uchar)*s < 0x20) fprintf(f, "\\u%04x", (uint)(uchar)*s);
+    else fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+//--------------------------------------------------------------
+int dtatw_stats_write(dtatwError *err)
+{
+  FILE *f;
+  long maxrss = -1;
+  int i, j, k, first;
+  if (!dtatw_stats.filename) return 0;
+
+  if (strcmp(dtatw_stats.filename,"-")==0) f = stderr;
+  else if (!(f=fopen(dtatw_stats.filename,"w")))
+    return dtatw_error(err, 1, "open failed for stats file `%s': %s", dtatw_stats.filename, strerror(errno));
+
+#if HAVE_SYS_RESOURCE_H
+  {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru)==0) maxrss = ru.ru_maxrss; //-- kilobytes on linux
+  }
+#endif
+
+  fputs("{\"prog\":", f);
+  stats_put_str(f, prog);
+  fprintf(f, ",\"version\":\"%s\"", PACKAGE_VERSION);
+  fprintf(f, ",\"wall\":%.6f,\"cpu\":%.6f", stats_wall()-dtatw_stats.wall0, stats_cpu()-dtatw_stats.cpu0);
+  fprintf(f, ",\"maxrss_kb\":%ld", maxrss);
+  fprintf(f, ",\"allocs\":{\"count\":%" PRIu64 ",\"bytes\":%" PRIu64 "}", dtatw_stats.nallocs, dtatw_stats.nallocbytes);
+
+  //-- phases
+  fputs(",\"phases\":{", f);
+  for (i=0; i < dtatw_stats.nphases; i++) {
+    fputs((i ? "," : ""), f);
+    stats_put_str(f, dtatw_stats.phases[i].name);
+    fprintf(f, ":{\"wall\":%.6f,\"cpu\":%.6f}", dtatw_stats.phases[i].wall, dtatw_stats.phases[i].cpu);
+  }
+  fputc('}', f);
+
+  //-- counters, grouped (in order of first appearance)
+  for (i=0; i < dtatw_stats.ncounts; i++) {
+    for (k=0; k < i && strcmp(dtatw_stats.counts[k].group,dtatw_stats.counts[i].group)!=0; k++) ;
+    if (k < i) continue; //-- group already written
+    fputc(',', f);
+    stats_put_str(f, dtatw_stats.counts[i].group);
+    fputs(":{", f);
+    for (j=i, first=1; j < dtatw_stats.ncounts; j++) {
+      if (strcmp(dtatw_stats.counts[j].group,dtatw_stats.counts[i].group)!=0) continue;
+      fputs((first ? "" : ","), f);
+      stats_put_str(f, dtatw_stats.counts[j].name);
+      fprintf(f, ":%" PRIu64, dtatw_stats.counts[j].val);
+      first = 0;
+    }
+    fputc('}', f);
+  }
+  fputs("}\n", f);
+
+  if (f != stderr && fclose(f) != 0)
+    return dtatw_error(err, 1, "error writing stats file `%s': %s", dtatw_stats.filename, strerror(errno));
+  return 0;
+}
+
 /*======================================================================
  * Utils: basename
  */
@@ -50,10 +249,7 @@ char *file_basename(char *dst, const char *src, const char *suff, int srclen, in
 off_t file_size(FILE *f)
 {
   struct stat st;
-  if (fstat(fileno(f), &st) != 0) {
-    fprintf(stderr, "file_size(): ERROR: %s\n", strerror(errno));
-    exit(255);
-  }
+  if (fileno(f) < 0 || fstat(fileno(f), &st) != 0) return (off_t)-1;
   return st.st_size;
 }
 
@@ -62,9 +258,13 @@ size_t file_slurp(FILE *f, char **bufp, size_t buflen)
 {
   size_t nread=0;
   if (buflen==0) {
-    size_t nwanted = file_size(f) - ftello(f);
-    *bufp = (char*)malloc(nwanted);
+    off_t fsize = file_size(f);
+    size_t nwanted;
+    if (fsize < 0) { *bufp = NULL; return 0; }
+    nwanted = fsize - ftello(f);
+    *bufp = (char*)malloc(nwanted > 0 ? nwanted : 1);
     assert2(*bufp != NULL, "malloc failed");
+    dtatw_stats_alloc(nwanted > 0 ? nwanted : 1);
     buflen = nwanted;
   }
   assert2(bufp != NULL && *bufp != NULL, "bad buffer for file_slurp()");
@@ -81,7 +281,7 @@ const uchar cxfTypeMask = 0x7;
 const uchar cxfHasXmlOffset = 0x8;
 const uchar cxfHasTxtLength = 0x10;
 const uchar cxfHasAttrs = 0x20;
-const uchar cxfUnused1 = 0x40;
+const uchar cxfBboxDelta = 0x40;
 const uchar cxfUnused2 = 0x80;
 
 const  char *cxTypeNames[8] = {"c","lb","pb","formula","EOF","#5","#6","#7"};
@@ -95,6 +295,7 @@ const char *cxhMagic   = PACKAGE " cx bin\n";
 const char *cxhVersion = PACKAGE_VERSION; 
 const char *cxhVersionMinR = "0.40";
 const char *cxhVersionMinW = "0.40";
+const char *cxhVersionMinV = "0.99";
 
 //--------------------------------------------------------------
 int cx_version_cmp(const char *v1, const char *v2)
@@ -125,10 +326,16 @@ void cx_put_header(FILE *f)
   memset(&h, 0, sizeof(cxHeader));
   strncpy(h.magic,       cxhMagic,       CXH_MAGIC_LEN);
   strncpy(h.version,     cxhVersion,     CXH_VERSION_LEN);
-  strncpy(h.version_min, cxhVersionMinW, CXH_VERSION_LEN);
+  strncpy(h.version_min, (CX_VARINT ? cxhVersionMinV : cxhVersionMinW), CXH_VERSION_LEN);
   fwrite(&h, sizeof(cxHeader), 1, f);
 }
 
+//--------------------------------------------------------------
+int cx_header_varint(const cxHeader *h)
+{
+  return cx_version_cmp(h->version_min, cxhVersionMinV) >= 0;
+}
+
 
 //--------------------------------------------------------------
 cxHeader* cx_get_header(FILE *f, const char *filename, cxHeader *h)
@@ -140,7 +347,7 @@ cxHeader* cx_get_header(FILE *f, const char *filename, cxHeader *h)
   memset(h, 0, sizeof(cxHeader));
   if (fread(h, sizeof(cxHeader), 1, f) != 1) {
     fprintf(stderr, "%s: failed to read header from binary cx-file %s\n", prog, file);
-    exit(1);
+    return NULL;
   }
   h->magic[CXH_MAGIC_LEN-1] = '\0';
   h->version[CXH_VERSION_LEN-1] = '\0';
@@ -178,17 +385,32 @@ int cx_check_header(const cxHeader *h, const char *filename)
  */
 
 //--------------------------------------------------------------
-void cx_put_record(FILE *f, const cxStoredRecord *cxr)
+void cx_put_record(FILE *f, const cxStoredRecord *cxr, ByteOffset xmlOffset, uint32_t *bbox)
 {
+  int j;
   fputc(cxr->flags,f);
-  if (cxr->flags & cxfHasXmlOffset)
-    fwrite(&cxr->xoff,4,1,f);
+  if (cxr->flags & cxfHasXmlOffset) {
+#if CX_VARINT
+    put_packed_w(f, zigzag_enc((int64_t)cxr->xoff - (int64_t)xmlOffset));
+#else
+    uint32_t xoff = cxr->xoff;
+    fwrite(&xoff,4,1,f);
+#endif
+  }
   fputc(cxr->xlen,f);
   if (cxr->flags & cxfHasTxtLength)
     fputc(cxr->tlen,f);
   if (cxr->flags & cxfHasAttrs) {
     switch (cxr->flags&cxfTypeMask) {
-    case cxrChar: fwrite(cxr->attrs,4,4,f); break;
+    case cxrChar:
+      if (cxr->flags & cxfBboxDelta) {
+        for (j=0; j < 4; j++)
+          put_packed_w(f, zigzag_enc((int32_t)(cxr->attrs[j] - bbox[j])));
+      } else {
+        fwrite(cxr->attrs,4,4,f);
+      }
+      memcpy(bbox, cxr->attrs, 16);
+      break;
     case cxrPb:   fwrite(cxr->attrs,4,1,f); break;
     default: break;
     }
@@ -196,17 +418,29 @@ void cx_put_record(FILE *f, const cxStoredRecord *cxr)
 }
 
 //--------------------------------------------------------------
-int cx_get_record(FILE *f, cxStoredRecord *cxr, uint32_t xmlOffset)
+int cx_get_record(FILE *f, cxStoredRecord *cxr, ByteOffset xmlOffset, int varint, uint32_t *bbox)
 {
-  int i = fgetc(f);
+  int j, i = fgetc(f);
   if (i==EOF || feof(f)) {
     cxr->flags = cxrEOF;
     return cxrEOF;
   }
   cxr->flags = i;
 
-  if (cxr->flags & cxfHasXmlOffset)
-    fread(&cxr->xoff,4,1,f);
+  if ((cxr->flags & cxfHasXmlOffset) && varint) {
+    uint64_t xoff = (uint64_t)xmlOffset + (uint64_t)zigzag_dec(get_packed_w(f));
+    if (xoff > (uint64_t)ByteOffsetMax) {
+      fprintf(stderr, "%s: xml offset %" PRIu64 " in cx-file exceeds this build's offset range (see configure --enable-large-offsets)\n", prog, xoff);
+      cxr->flags = cxrEOF;
+      return -1;
+    }
+    cxr->xoff = (ByteOffset)xoff;
+  }
+  else if (cxr->flags & cxfHasXmlOffset) {
+    uint32_t xoff = 0;
+    fread(&xoff,4,1,f);
+    cxr->xoff = xoff;
+  }
   else
     cxr->xoff = xmlOffset;
 
@@ -219,7 +453,15 @@ int cx_get_record(FILE *f, cxStoredRecord *cxr, uint32_t xmlOffset)
 
   if (cxr->flags & cxfHasAttrs) {
     switch (cxr->flags&cxfTypeMask) {
-    case cxrChar: fread(cxr->attrs,4,4,f); break;
+    case cxrChar:
+      if (cxr->flags & cxfBboxDelta) {
+        for (j=0; j < 4; j++)
+          cxr->attrs[j] = bbox[j] + (uint32_t)zigzag_dec(get_packed_w(f));
+      } else {
+        fread(cxr->attrs,4,4,f);
+      }
+      memcpy(bbox, cxr->attrs, 16);
+      break;
     case cxrPb:   fread(cxr->attrs,4,1,f); break;
     default: break;
     }
@@ -229,23 +471,26 @@ int cx_get_record(FILE *f, cxStoredRecord *cxr, uint32_t xmlOffset)
 }
 
 //--------------------------------------------------------------
-void put_packed_w(FILE *f, ByteOffset i)
+void put_packed_w(FILE *f, uint64_t i)
 {
-  for (; i >= 0x80; i >>= 7) {
-    fputc( (0x80 | (i&0x7f)), f );
+  unsigned char buf[10];  //-- ceil(64/7) groups
+  int n = sizeof(buf);
+  buf[--n] = (i & 0x7f);
+  for (i >>= 7; i > 0; i >>= 7) {
+    buf[--n] = 0x80 | (i & 0x7f);
   }
-  fputc( (i&0x7f), f );
+  fwrite(buf+n, 1, sizeof(buf)-n, f);
 }
 
 //--------------------------------------------------------------
-ByteOffset get_packed_w(FILE *f)
+uint64_t get_packed_w(FILE *f)
 {
   int c;
-  ByteOffset i;
-  for (i=0, c=fgetc(f); (c&0x80); c=fgetc(f)) {
+  uint64_t i;
+  for (i=0, c=fgetc(f); c != EOF && (c&0x80); c=fgetc(f)) {
     i = (i<<7) | (c & 0x7f);
   }
-  return (i<<7) | (c & 0x7f);
+  return c == EOF ? i : ((i<<7) | (c & 0x7f));
 }
 
 
@@ -265,8 +510,10 @@ cxData *cxDataInit(cxData *cxd, size_t size)
   }
   cxd->data = (cxRecord*)malloc(size*sizeof(cxRecord));
   assert(cxd->data != NULL /* malloc failed */);
-  cxd->len   = 0;
-  cxd->alloc = size;
+  dtatw_stats_alloc(size*sizeof(cxRecord));
+  cxd->coords = NULL;
+  cxd->len    = 0;
+  cxd->alloc  = size;
   return cxd;
 }
 
@@ -277,38 +524,55 @@ cxRecord *cxDataPush(cxData *cxd, cxRecord *cx)
     //-- whoops: must reallocate
     cxd->data = (cxRecord*)realloc(cxd->data, cxd->alloc*2*sizeof(cxRecord));
     assert(cxd->data != NULL /* realloc failed */);
+    dtatw_stats_alloc(cxd->alloc*2*sizeof(cxRecord));
+    if (cxd->coords) {
+      cxd->coords = (cxCoords*)realloc(cxd->coords, cxd->alloc*2*sizeof(cxCoords));
+      assert(cxd->coords != NULL /* realloc failed */);
+      dtatw_stats_alloc(cxd->alloc*2*sizeof(cxCoords));
+    }
     cxd->alloc *= 2;
   }
   //-- just push copy raw data, pointers & all
   memcpy(&cxd->data[cxd->len], cx, sizeof(cxRecord));
+  if (cxd->coords) memset(&cxd->coords[cxd->len], 0, sizeof(cxCoords));
   return &cxd->data[cxd->len++];
 }
 
 
 //--------------------------------------------------------------
-cxData *cxDataLoad(cxData *cxd, FILE *f, const char *filename)
+cxData *cxDataLoad(cxData *cxd, FILE *f, const char *filename, int want_coords)
 {
   const char *file = filename ? filename : "(null)";
   cxHeader hdr;
   cxStoredRecord cxr;
-  uint32_t xmlOffset = 0; //-- current xml byte offset
-  uint32_t txOffset = 0; //-- current tx-file offset
+  ByteOffset xmlOffset = 0; //-- current xml byte offset
+  ByteOffset txOffset = 0; //-- current tx-file offset
+  uint32_t pn = 0, pb = 0, lb = 0; //-- current page index, page (facs), line
+  uint32_t bbox[4] = {0,0,0,0}; //-- bbox of last <c> with attributes (cxfBboxDelta base)
   cxRecord cx;
+  cxCoords co;
+  int i, typ, varint;
 
   //-- initialize data
   if (cxd==NULL || cxd->data==NULL) cxd=cxDataInit(cxd,0);
   assert(f!=NULL /* require .cx file */);
+  if (want_coords && !cxd->coords) {
+    cxd->coords = (cxCoords*)calloc(cxd->alloc, sizeof(cxCoords));
+    assert(cxd->coords != NULL /* calloc failed */);
+    dtatw_stats_alloc(cxd->alloc*sizeof(cxCoords));
+  }
 
   //-- get & check header
-  cx_get_header(f, file, &hdr);
-  if (!cx_check_header(&hdr,file)) exit(1);
+  if (!cx_get_header(f, file, &hdr) || !cx_check_header(&hdr,file)) return NULL;
+  varint = cx_header_varint(&hdr);
 
   //-- initialize temporaries
   memset(&cx, 0,sizeof(cx));
   memset(&cxr,0,sizeof(cxr));
 
   //-- churn cx-records
-  while (f && !feof(f) && cx_get_record(f, &cxr, xmlOffset) != cxrEOF) {
+  while (f && !feof(f) && (typ = cx_get_record(f, &cxr, xmlOffset, varint, bbox)) != cxrEOF) {
+    if (typ < 0) return NULL;
     cx.typ  = (cxr.flags & cxfTypeMask);
     cx.xoff = cxr.xoff;
     cx.xlen = cxr.xlen;
@@ -316,6 +580,22 @@ cxData *cxDataLoad(cxData *cxd, FILE *f, const char *filename)
     cx.tlen = cxr.tlen;
     cxDataPush(cxd, &cx);
 
+    if (cxd->coords) {
+      for (i=0; i < 4; i++)
+	co.bbox[i] = (cx.typ==cxrChar && (cxr.flags & cxfHasAttrs)) ? (int32_t)cxr.attrs[i] : -1;
+
+      //-- page & line (cf. load_cx() in dtatw-get-ddc-attrs.perl): only empty <pb/> records switch pages
+      if (cx.typ==cxrPb && cx.tlen==0) {
+	++pn;
+	pb = (cxr.flags & cxfHasAttrs) ? cxr.attrs[0] : pn;
+	lb = 1;
+      }
+      co.pb = pb;
+      co.lb = lb;
+      if (cx.typ==cxrLb && cx.tlen > 0) ++lb;
+      cxd->coords[cxd->len-1] = co;
+    }
+
     //-- update position globals
     xmlOffset = cxr.xoff + cxr.xlen;
     txOffset += cxr.tlen;
@@ -324,6 +604,18 @@ cxData *cxDataLoad(cxData *cxd, FILE *f, const char *filename)
   return cxd;
 }
 
+//--------------------------------------------------------------
+void cxDataFree(cxData *cxd)
+{
+  if (!cxd) return;
+  if (cxd->data) free(cxd->data);
+  if (cxd->coords) free(cxd->coords);
+  cxd->data   = NULL;
+  cxd->coords = NULL;
+  cxd->len    = 0;
+  cxd->alloc  = 0;
+}
+
 
 /*======================================================================
  * Utils: .bx file(s)
@@ -339,6 +631,7 @@ bxData *bxDataInit(bxData *bxd, size_t size)
   }
   bxd->data = (bxRecord*)malloc(size*sizeof(bxRecord));
   assert(bxd->data != NULL /* malloc failed */);
+  dtatw_stats_alloc(size*sizeof(bxRecord));
   bxd->len   = 0;
   bxd->alloc = size;
   return bxd;
@@ -351,6 +644,7 @@ bxRecord *bxDataPush(bxData *bxd, bxRecord *bx)
     //-- whoops: must reallocate
     bxd->data = (bxRecord*)realloc(bxd->data, bxd->alloc*2*sizeof(bxRecord));
     assert(bxd->data != NULL /* realloc failed */);
+    dtatw_stats_alloc(bxd->alloc*2*sizeof(bxRecord));
     bxd->alloc *= 2;
   }
   //-- just push copy raw data, pointers & all
@@ -392,17 +686,17 @@ bxData *bxDataLoad(bxData *bxd, FILE *f)
     //-- xoff
     s0 = s1+1;
     s1 = next_tab(s0);
-    bx.xoff = strtoul(s0,&tail,0);
+    bx.xoff = strtoull(s0,&tail,0);
 
     //-- xlen
     s0 = s1+1;
     s1 = next_tab(s0);
-    bx.xlen = strtoul(s0,&tail,0);
+    bx.xlen = strtoull(s0,&tail,0);
 
     //-- toff
     s0 = s1+1;
     s1 = next_tab(s0);
-    bx.toff = strtoul(s0,&tail,0);
+    bx.toff = strtoull(s0,&tail,0);
 
     //-- tlen
     s0 = s1+1;
@@ -412,7 +706,7 @@ bxData *bxDataLoad(bxData *bxd, FILE *f)
     //-- otoff
     s0 = s1+1;
     s1 = next_tab(s0);
-    bx.otoff = strtoul(s0,&tail,0);
+    bx.otoff = strtoull(s0,&tail,0);
 
     //-- otlen
     s0 = s1+1;
@@ -427,6 +721,23 @@ bxData *bxDataLoad(bxData *bxd, FILE *f)
   return bxd;
 }
 
+//--------------------------------------------------------------
+void bxDataFree(bxData *bxd)
+{
+  ByteOffset i;
+  if (!bxd) return;
+  if (bxd->data) {
+    for (i=0; i < bxd->len; i++) {
+      if (bxd->data[i].key) free(bxd->data[i].key);
+      if (bxd->data[i].elt) free(bxd->data[i].elt);
+    }
+    free(bxd->data);
+  }
+  bxd->data  = NULL;
+  bxd->len   = 0;
+  bxd->alloc = 0;
+}
+
 /*======================================================================
  * Utils: indexing
  */
@@ -458,6 +769,7 @@ Offset2CxIndex  *tx2cxIndex(Offset2CxIndex *txo2cx, cxData *cxd)
     if (txo2cx->data) free(txo2cx->data);
     txo2cx->data = (cxRecord**)malloc(ntxb*sizeof(cxRecord*));
     assert(txo2cx->data != NULL /* malloc failed for tx-byte to cx-record lookup vector */);
+    dtatw_stats_alloc(ntxb*sizeof(cxRecord*));
     memset(txo2cx->data, 0, ntxb*sizeof(cxRecord*)); //-- zero the block
     txo2cx->len = ntxb;
   }
@@ -505,6 +817,7 @@ Offset2CxIndex *txt2cxIndex(Offset2CxIndex *txto2cx, bxData *bxd, Offset2CxIndex
     if (txto2cx->data) free(txto2cx->data);
     txto2cx->data = (cxRecord**)malloc(ntxtb*sizeof(cxRecord*));
     assert(txto2cx->data != NULL /* malloc failed for tx-byte to cx-record lookup vector */);
+    dtatw_stats_alloc(ntxtb*sizeof(cxRecord*));
     memset(txto2cx->data, 0, ntxtb*sizeof(cxRecord*)); //-- zero the block
     txto2cx->len = ntxtb;
   }
@@ -526,6 +839,15 @@ Offset2CxIndex *txt2cxIndex(Offset2CxIndex *txto2cx, bxData *bxd, Offset2CxIndex
   return txto2cx;
 }
 
+//--------------------------------------------------------------
+void Offset2CxIndexFree(Offset2CxIndex *o2cx)
+{
+  if (!o2cx) return;
+  if (o2cx->data) free(o2cx->data);
+  o2cx->data = NULL;
+  o2cx->len  = 0;
+}
+
 //--------------------------------------------------------------
 int cx_is_adjacent(const cxRecord *cx1, const cxRecord *cx2) {
   if (!cx1 || !cx2) return 0;				//-- NULL records block adjacency
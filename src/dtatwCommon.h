@@ -29,11 +29,20 @@
  */
 
 #define FILE_BUFSIZE 8192 //-- file input buffer size
+
+//-- ByteOffset, ByteLen: byte offsets & lengths; 64-bit iff DTATW_LARGE_OFFSETS (configure --enable-large-offsets)
+#if DTATW_LARGE_OFFSETS
+typedef uint64_t ByteOffset;
+typedef uint64_t ByteLen;
+# define ByteOffsetF PRIu64
+# define ByteLenF    PRIu64
+#else
 typedef uint32_t ByteOffset;
 typedef uint32_t ByteLen;
-
-#define ByteOffsetF PRIu32
-#define ByteLenF    PRIu32
+# define ByteOffsetF PRIu32
+# define ByteLenF    PRIu32
+#endif
+#define ByteOffsetMax ((ByteOffset)-1)  //-- largest representable byte offset
 
 extern char *prog;
 
@@ -84,6 +93,106 @@ extern char *xmlid_name;
 # endif /* defined(ENABLE_ASSERT) */
 #endif /* !defined(assert) */
 
+/*======================================================================
+ * Errors (libdtatw)
+ *  + library routines don't exit() on error, but report to a caller-supplied dtatwError
+ */
+
+#define DTATW_ERRMSG_LEN 1024
+
+//-- dtatwError: error status for library routines
+typedef struct {
+  int  code;                   //-- error code (0: no error; otherwise suggested exit() status)
+  char msg[DTATW_ERRMSG_LEN];  //-- error message (without program-name prefix or trailing newline)
+} dtatwError;
+
+// code = dtatw_error(err, code, fmt, ...)
+//  + sets err->code and err->msg (if err is non-NULL); returns code
+int dtatw_error(dtatwError *err, int code, const char *fmt, ...);
+
+// dtatw_die(err)
+//  + prints err->msg to stderr and exits with status err->code (for command-line wrappers)
+void dtatw_die(const dtatwError *err);
+
+/*======================================================================
+ * Runtime statistics (--stats=FILE)
+ *  + process-wide profiling counters, written as a JSON object by dtatw_stats_write()
+ *  + phase timers and counters are no-ops unless enabled by dtatw_stats_getopt()
+ *  + allocation counters are always maintained (relaxed atomic increments)
+ */
+
+#define DTATW_STATS_MAXPHASES 16
+#define DTATW_STATS_MAXCOUNTS 32
+
+//-- dtatwStatsPhase: wall-clock and cpu time for a named processing phase
+typedef struct {
+  const char *name;   //-- phase name (static string), e.g. "cx_load", "token_loop"
+  double wall;        //-- total wall-clock seconds
+  double cpu;         //-- total cpu seconds
+  double wall0;       //-- start of current run (if running)
+  double cpu0;        //-- start of current run (if running)
+  int    running;     //-- true iff phase is currently running
+} dtatwStatsPhase;
+
+//-- dtatwStatsCount: named counter
+typedef struct {
+  const char *group;  //-- counter group (static string): "bytes_in", "bytes_out", or "counts"
+  const char *name;   //-- counter name (static string), e.g. "cx", "tokens"
+  uint64_t    val;    //-- counter value
+} dtatwStatsCount;
+
+//-- dtatwStats: runtime statistics
+typedef struct {
+  const char     *filename;     //-- JSON output filename ("-" for stderr); NULL if disabled
+  double          wall0;        //-- wall-clock time at dtatw_stats_getopt()
+  double          cpu0;         //-- cpu time at dtatw_stats_getopt()
+  dtatwStatsPhase phases[DTATW_STATS_MAXPHASES];
+  int             nphases;
+  dtatwStatsCount counts[DTATW_STATS_MAXCOUNTS];
+  int             ncounts;
+  uint64_t        nallocs;      //-- number of libdtatw buffer (re-)allocations
+  uint64_t        nallocbytes;  //-- number of bytes requested by libdtatw buffer (re-)allocations
+} dtatwStats;
+
+extern dtatwStats dtatw_stats;
+
+// enabled = dtatw_stats_getopt(&argc, argv)
+//  + removes "--stats=FILE" (or "-stats=FILE") options from argv, enabling statistics if any was present
+//  + starts the global timers; call this before any other command-line processing
+int dtatw_stats_getopt(int *argcp, char **argv);
+
+// dtatw_stats_begin(phase), dtatw_stats_end(phase)
+//  + start/stop timer for phase (a static string); phases may be run more than once
+void dtatw_stats_begin(const char *phase);
+void dtatw_stats_end(const char *phase);
+
+// dtatw_stats_add(group, name, n)
+//  + adds n to counter (group,name) (both static strings)
+void dtatw_stats_add(const char *group, const char *name, uint64_t n);
+
+// dtatw_stats_stream(group, name, f)
+//  + adds current stream position of f to counter (group,name), if f is seekable
+//  + call after reading input to EOF or after flushing output
+void dtatw_stats_stream(const char *group, const char *name, FILE *f);
+
+// status = dtatw_stats_write(err)
+//  + writes JSON statistics to dtatw_stats.filename (if enabled)
+int dtatw_stats_write(dtatwError *err);
+
+// dtatw_stats_alloc(nbytes)
+//  + count a libdtatw buffer (re-)allocation of nbytes bytes
+static inline
+void dtatw_stats_alloc(size_t nbytes)
+{
+#if defined(__GNUC__)
+  __atomic_fetch_add(&dtatw_stats.nallocs, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&dtatw_stats.nallocbytes, (uint64_t)nbytes, __ATOMIC_RELAXED);
+#else
+  dtatw_stats.nallocs++;
+  dtatw_stats.nallocbytes += nbytes;
+#endif
+}
+
 /*======================================================================
  * Utils: XML-escapes
  */
@@ -226,6 +335,7 @@ inline static char *next_char_z(char *s, char c)
 
 // size = file_size(f)
 //  + get file size; uses fstat()
+//  + returns (off_t)-1 on error (errno is set)
 off_t file_size(FILE *f);
 
 // slurp_file()
@@ -234,7 +344,7 @@ off_t file_size(FILE *f);
 //    which on return contains all the (remaining) bytes of the file
 //  + if buflen is nonzero, *bufp should have that many bytes allocated,
 //    and only that many bytes will be slurped
-//  + return value is number of bytes actually slurped
+//  + return value is number of bytes actually slurped (0 and *bufp==NULL if file size could not be determined)
 size_t file_slurp(FILE *f, char **bufp, size_t buflen);
 
 /*======================================================================
@@ -256,24 +366,54 @@ extern const uchar cxfTypeMask;		//-- cx flag mask: record type
 extern const uchar cxfHasXmlOffset;	//-- cx flag: xoff != (xoff[i-1]+xlen[i-1])
 extern const uchar cxfHasTxtLength;  	//-- cx flag: xlen != tlen
 extern const uchar cxfHasAttrs;		//-- cx flag: attributes present?
+extern const uchar cxfBboxDelta;	//-- cx flag: cxrChar attributes are delta-coded (varint cx-files only)
 
 /// cxStoredRecord: basic i/o unit
+///  + xml offsets are stored either as 4 raw bytes (legacy) or as zigzag-coded BER deltas against
+///    the end of the preceding record (varint .cx files, see cx_header_varint())
+///  + cxrChar attributes with cxfBboxDelta are stored as 4 zigzag-coded BER deltas against the
+///    bbox of the preceding cxrChar record with attributes (initially 0,0,0,0), otherwise as 16 raw bytes
 typedef struct {
-  uchar   flags;	//-- ((cxRecordType typ) & cxfTypeMask) |cxfHasXmlOffset? |cxfHasTxtLength? |cxfHasAttrs?
-  uint32_t xoff;	//-- xml offset (only written if (flags & cxfHasXmlOffset))
+  uchar   flags;	//-- ((cxRecordType typ) & cxfTypeMask) |cxfHasXmlOffset? |cxfHasTxtLength? |cxfHasAttrs? |cxfBboxDelta?
+  ByteOffset xoff;	//-- xml offset (only written if (flags & cxfHasXmlOffset))
   uchar    xlen;	//-- xml length
   uchar    tlen;	//-- text length (only written if (flags & cxfHasTxtLen))
   uint32_t attrs[4];	//-- attributes (only written if (flags & cxfHasAttrs)): pb->@facs, c->(@ulx,@uly,@lrx,@lry)
 } cxStoredRecord;
 
-void cx_put_record(FILE *f, const cxStoredRecord *cxr);
-int cx_get_record(FILE *f, cxStoredRecord *cxr, uint32_t xmlOffset); //-- returns cxRecordType
+// cx_put_record(f,cxr,xmlOffset,bbox)
+//  + xmlOffset is the end offset of the preceding record (xoff+xlen), i.e. the implicit xoff for cxr
+//  + bbox[0..3] is the bbox of the preceding cxrChar record with attributes (0,0,0,0 at start of file);
+//    it is updated if cxr is a cxrChar record with attributes
+//  + writes varint-coded xml offsets iff CX_VARINT; callers set cxfBboxDelta only if CX_VARINT
+void cx_put_record(FILE *f, const cxStoredRecord *cxr, ByteOffset xmlOffset, uint32_t *bbox);
+
+// typ = cx_get_record(f,cxr,xmlOffset,varint,bbox)
+//  + returns cxRecordType (cxrEOF at end of file), or -1 on error (offset overflow; reported to stderr)
+//  + varint is the offset coding of f (see cx_header_varint())
+//  + bbox[0..3] is tracked as for cx_put_record()
+int cx_get_record(FILE *f, cxStoredRecord *cxr, ByteOffset xmlOffset, int varint, uint32_t *bbox);
 
 //-- cx: packed: header
 extern const char *cxhMagic;		//-- cx header: magic
 extern const char *cxhVersion;		//-- cx header: current tokwrap version
 extern const char *cxhVersionMinR;	//-- cx header: min tokwrap-version of cx-files we can read
 extern const char *cxhVersionMinW;	//-- cx header: min tokwrap-version required for cx-files we write
+extern const char *cxhVersionMinV;	//-- cx header: min tokwrap-version required for varint cx-files (see cx_header_varint())
+
+//-- CX_VARINT: whether this build writes varint cx-files (varint xml offsets, cxfBboxDelta);
+//   set by configure --enable-cx-varint (implied by --enable-large-offsets); otherwise legacy cx-files
+//   readable by tokwrap < v0.99 are written. All builds read both formats.
+#ifndef CX_VARINT
+# if DTATW_LARGE_OFFSETS
+#  define CX_VARINT 1
+# else
+#  define CX_VARINT 0
+# endif
+#endif
+#if DTATW_LARGE_OFFSETS && !CX_VARINT
+# error "DTATW_LARGE_OFFSETS requires CX_VARINT"
+#endif
 
 #define CXH_MAGIC_LEN 32
 #define CXH_VERSION_LEN 8
@@ -287,12 +427,23 @@ void      cx_put_header(FILE *f);
 cxHeader* cx_get_header(FILE *f, const char *filename, cxHeader *h);
 int	  cx_check_header(const cxHeader *h, const char *filename);
 
+// bool = cx_header_varint(h)
+//  + true iff h describes a cx-file with varint-coded xml offsets (and possibly cxfBboxDelta records),
+//    negotiated via h->version_min:
+//    varint cx-files are written with version_min=cxhVersionMinV, so older versions refuse to load them
+int       cx_header_varint(const cxHeader *h);
+
 
 //-- packed i/o: perl pack('w',$i)
-// + BER-compressed integers (unsigned int in base-128, high bit (0x80) set on all but final byte)
-// + unused
-void       put_packed_w(FILE *f, ByteOffset i);
-ByteOffset get_packed_w(FILE *f);
+// + BER-compressed integers (unsigned int in base-128, most significant group first,
+//   high bit (0x80) set on all but final byte)
+// + used for varint-coded xml offsets and bbox deltas (see cx_put_record())
+void       put_packed_w(FILE *f, uint64_t i);
+uint64_t   get_packed_w(FILE *f);
+
+//-- zigzag coding of signed deltas for put_packed_w(): 0,-1,1,-2,2,... -> 0,1,2,3,4,...
+static inline uint64_t zigzag_enc(int64_t d)  { return ((uint64_t)d << 1) ^ (0 - ((uint64_t)d >> 63)); }
+static inline int64_t  zigzag_dec(uint64_t z) { return (int64_t)((z >> 1) ^ (0 - (z & 1))); }
 
 
 /*======================================================================
@@ -311,9 +462,17 @@ typedef struct {
   uchar claimed;	//-- claimed (0:unclaimed, 1: claimed by current word, >1: claimed by other word)
 } cxRecord;
 
+/// cxCoords : page, line & bbox for a cxRecord (only loaded on request, see cxDataLoad())
+typedef struct {
+  uint32_t pb;          //-- page: pb/@facs of most recent <pb> (1-based <pb> index if @facs is missing; 0 before first <pb>)
+  uint32_t lb;          //-- line number on current page (as for dtatw-get-ddc-attrs)
+  int32_t  bbox[4];     //-- <c> bounding box (ulx,uly,lrx,lry); -1 if undefined
+} cxCoords;
+
 // cxData : array of .cx records
 typedef struct {
   cxRecord   *data;              //-- vector of cx records
+  cxCoords   *coords;            //-- parallel vector of coordinates for data[] (NULL unless loaded with want_coords)
   ByteOffset  len;               //-- number of used cx records (index of 1st unused record)
   ByteOffset  alloc;             //-- number of allocated cx records
 } cxData;
@@ -324,8 +483,9 @@ typedef struct {
 #endif
 
 cxData   *cxDataInit(cxData *cxd, size_t size);     //-- initializes/allocates *cxd
-cxRecord *cxDataPush(cxData *cxd, cxRecord *cx);    //-- append *cx to *cxd->data, re-allocating if required
-cxData   *cxDataLoad(cxData *cx, FILE *f, const char *filename);  //-- loads *cxd from file f (filename is for error-reporting)
+cxRecord *cxDataPush(cxData *cxd, cxRecord *cx);    //-- append *cx to *cxd->data (and an empty cxd->coords entry if allocated), re-allocating if required
+cxData   *cxDataLoad(cxData *cx, FILE *f, const char *filename, int want_coords);  //-- loads *cxd from file f (filename is for error-reporting; coords only if want_coords); NULL on error
+void      cxDataFree(cxData *cxd);                  //-- frees *cxd->data and *cxd->coords (but not cxd itself)
 
 /*======================================================================
  * Utils: .bx file(s)
@@ -358,6 +518,7 @@ typedef struct {
 bxData   *bxDataInit(bxData *bxd, size_t size);   //-- initialize/allocate bxdata
 bxRecord *bxDataPush(bxData *bxd, bxRecord *bx);      //-- append *bx to *bxd, re-allocating if required
 bxData   *bxDataLoad(bxData *bxd, FILE *f);           //-- loads *bxd from file f
+void      bxDataFree(bxData *bxd);                    //-- frees *bxd->data and record strings (but not bxd itself)
 
 
 /*======================================================================
@@ -375,6 +536,9 @@ Offset2CxIndex  *tx2cxIndex(Offset2CxIndex *txo2cx,  cxData *cxd);
 // txt2cxIndex(): init/alloc: cxRecord *cx = txto2cx->data[txt_byte_index]
 Offset2CxIndex *txt2cxIndex(Offset2CxIndex *txto2cx, bxData *bxd, Offset2CxIndex *txb2cx);
 
+// Offset2CxIndexFree(): frees o2cx->data (but not o2cx itself)
+void Offset2CxIndexFree(Offset2CxIndex *o2cx);
+
 // cx_is_adjacent(): check whether cx1 immediately follows cx2
 int cx_is_adjacent(const cxRecord *cx1, const cxRecord *cx2);
 
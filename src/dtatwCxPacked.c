@@ -0,0 +1,270 @@
+#include "dtatwCxPacked.h"
+#include "dtatwZio.h"
+
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// q = cxp_skip_w(p,end)
+//  + returns pointer to the byte following the BER-compressed integer at p (see put_packed_w())
+//  + scans at most up to end; an unterminated integer runs to end+1 (i.e. truncated)
+static inline
+const uchar *cxp_skip_w(const uchar *p, const uchar *end)
+{
+  while (p < end && (*p & 0x80)) ++p;
+  return p+1;
+}
+
+//--------------------------------------------------------------
+// reclen = cxp_record_len(p,end,varint)
+//  + stored length of the binary .cx record starting at p (see cx_put_record())
+static inline
+size_t cxp_record_len(const uchar *p, const uchar *end, int varint)
+{
+  uchar flags = *p;
+  const uchar *q = p+1;
+  int j;
+  if (flags & cxfHasXmlOffset) q = varint ? cxp_skip_w(q,end) : q+4;
+  q += (flags & cxfHasTxtLength) ? 2 : 1; //-- xlen, tlen?
+  if (flags & cxfHasAttrs) {
+    switch (flags & cxfTypeMask) {
+    case cxrChar:
+      if (flags & cxfBboxDelta) { for (j=0; j < 4; j++) q = cxp_skip_w(q,end); }
+      else                      q += 16;
+      break;
+    case cxrPb:   q += 4; break;
+    default: break;
+    }
+  }
+  return q - p;
+}
+
+//--------------------------------------------------------------
+// uval = cxp_get_packed_w(&p)
+//  + like get_packed_w(), but decodes from a buffer; p must point to a complete varint (see cxp_record_len())
+static inline
+uint64_t cxp_get_packed_w(const uchar **pp)
+{
+  const uchar *p = *pp;
+  uint64_t i;
+  for (i=0; (*p & 0x80); ++p) {
+    i = (i<<7) | (*p & 0x7f);
+  }
+  *pp = p+1;
+  return (i<<7) | (*p & 0x7f);
+}
+
+//--------------------------------------------------------------
+// ok = cxp_check_header(buf,buflen, srcname, varint, err)
+//  + like cx_get_header() + cx_check_header(), but reports to err
+//  + sets *varint to the xml offset coding of buf (see cx_header_varint())
+static
+int cxp_check_header(const char *buf, size_t buflen, const char *srcname, int *varint, dtatwError *err)
+{
+  cxHeader h;
+  if (buflen < sizeof(cxHeader))
+    return dtatw_error(err,1,"failed to read header from binary cx-file %s", srcname);
+
+  memcpy(&h, buf, sizeof(cxHeader));
+  h.magic[CXH_MAGIC_LEN-1] = '\0';
+  h.version[CXH_VERSION_LEN-1] = '\0';
+  h.version_min[CXH_VERSION_LEN-1] = '\0';
+
+  if (strcmp(h.magic,cxhMagic) != 0)
+    return dtatw_error(err,1,"bad magic `%s' from cx-file %s", h.magic, srcname);
+  if (cx_version_cmp(h.version_min, cxhVersion) > 0)
+    return dtatw_error(err,1,"cx file %s requires v%s, but we have only v%s", srcname, h.version_min, cxhVersion);
+  if (cx_version_cmp(h.version, cxhVersionMinR) < 0)
+    return dtatw_error(err,1,"cx file %s is only v%s, but we require >= v%s", srcname, h.version, cxhVersionMinR);
+
+  *varint = cx_header_varint(&h);
+  return 0;
+}
+
+/*======================================================================
+ * API
+ */
+
+//--------------------------------------------------------------
+int cxPackedLoadBuffer(cxPacked *cxp, const char *buf, size_t buflen, const char *srcname, dtatwError *err)
+{
+  const uchar *p, *end = (const uchar*)buf + buflen;
+  ByteOffset n, na, i;
+  ByteOffset xmlOffset = 0, txOffset = 0;
+  uint32_t bbox[4] = {0,0,0,0}; //-- last bbox (cxfBboxDelta base)
+  uint64_t xoff;
+  uchar flags;
+  int j, status, varint = 0;
+
+  if (!srcname) srcname = "(null)";
+  cxPackedFree(cxp);
+  if ((status = cxp_check_header(buf, buflen, srcname, &varint, err)) != 0) return status;
+
+  //-- pass 1: count records (so columns can be allocated exactly)
+  for (n=0, na=0, p=(const uchar*)buf+sizeof(cxHeader); p < end; ++n) {
+    if ((*p & cxfTypeMask) == cxrEOF) break;
+    if (*p & cxfHasAttrs) ++na;
+    p += cxp_record_len(p, end, varint);
+  }
+  if (p > end)
+    return dtatw_error(err,1,"truncated record at byte %zu of cx-file %s", buflen, srcname);
+
+  //-- allocate columns
+  cxp->flags = (uchar*)malloc(n ? n : 1);
+  cxp->xoff  = (ByteOffset*)malloc((n ? n : 1)*sizeof(ByteOffset));
+  cxp->xlen  = (uchar*)malloc(n ? n : 1);
+  cxp->toff  = (ByteOffset*)malloc((n ? n : 1)*sizeof(ByteOffset));
+  cxp->tlen  = (uchar*)malloc(n ? n : 1);
+  cxp->aidx  = (uint32_t*)malloc((n ? n : 1)*sizeof(uint32_t));
+  cxp->attrs = (uint32_t*)malloc((na ? na : 1)*4*sizeof(uint32_t));
+  if (!cxp->flags || !cxp->xoff || !cxp->xlen || !cxp->toff || !cxp->tlen || !cxp->aidx || !cxp->attrs) {
+    cxPackedFree(cxp);
+    return dtatw_error(err,2,"failed to allocate %" PRIuMAX " packed records for cx-file %s", (uintmax_t)n, srcname);
+  }
+  memset(cxp->attrs, 0xff, na*4*sizeof(uint32_t)); //-- CXP_NOATTR
+
+  //-- pass 2: decode (cf. cx_get_record(), cxDataLoad())
+  for (i=0, p=(const uchar*)buf+sizeof(cxHeader); i < n; ++i) {
+    flags = cxp->flags[i] = *p++;
+    if ((flags & cxfHasXmlOffset) && varint) {
+      xoff = (uint64_t)xmlOffset + (uint64_t)zigzag_dec(cxp_get_packed_w(&p));
+      if (xoff > (uint64_t)ByteOffsetMax) {
+        cxPackedFree(cxp);
+        return dtatw_error(err,1,"xml offset %" PRIu64 " in cx-file %s exceeds this build's offset range (see configure --enable-large-offsets)", xoff, srcname);
+      }
+      cxp->xoff[i] = (ByteOffset)xoff;
+    } else if (flags & cxfHasXmlOffset) {
+      uint32_t xoff32;
+      memcpy(&xoff32, p, 4);
+      cxp->xoff[i] = xoff32;
+      p += 4;
+    } else {
+      cxp->xoff[i] = xmlOffset;
+    }
+    cxp->xlen[i] = *p++;
+    cxp->tlen[i] = (flags & cxfHasTxtLength) ? *p++ : cxp->xlen[i];
+    if (flags & cxfHasAttrs) {
+      cxp->aidx[i] = cxp->nattrs++;
+      switch (flags & cxfTypeMask) {
+      case cxrChar:
+        if (flags & cxfBboxDelta) {
+          for (j=0; j < 4; j++)
+            bbox[j] += (uint32_t)zigzag_dec(cxp_get_packed_w(&p));
+        } else {
+          memcpy(bbox, p, 16);
+          p += 16;
+        }
+        memcpy(&cxp_attr(cxp,i,0), bbox, 16);
+        break;
+      case cxrPb:   memcpy(&cxp_attr(cxp,i,0), p,  4); p +=  4; break;
+      default: break;
+      }
+    } else {
+      cxp->aidx[i] = CXP_NOATTR;
+    }
+    cxp->toff[i] = txOffset;
+
+    //-- update position trackers
+    xmlOffset = cxp->xoff[i] + cxp->xlen[i];
+    txOffset += cxp->tlen[i];
+  }
+  cxp->len = n;
+
+  return 0;
+}
+
+//--------------------------------------------------------------
+int cxPackedLoadFile(cxPacked *cxp, const char *filename, dtatwError *err)
+{
+  FILE *f;
+  char *buf = NULL;
+  size_t buflen;
+  off_t fsize;
+  int mapped = 0, compressed = 0;
+  int status;
+  dtatwError zerr;
+
+  if (!filename) filename = "-";
+  if (strcmp(filename,"-")==0) {
+    f = stdin;
+  }
+  else if ( !(f = fopen(filename,"rb")) ) {
+    return dtatw_error(err,1,"open failed for .cx file `%s': %s", filename, strerror(errno));
+  }
+
+  fsize  = (f == stdin ? -1 : file_size(f));
+  buflen = (fsize > 0 ? (size_t)fsize : 0);
+  if (buflen > 0 && zio_sniff(f) != zioRaw) {
+    //-- compressed .cx file (see dtatwZio.h): decompress into memory
+    memset(&zerr, 0, sizeof(zerr));
+    compressed = 1;
+    buflen = zio_fslurp(f, filename, &buf, &zerr);
+  }
+#if HAVE_SYS_MMAN_H
+  else if (buflen > 0 && (buf = (char*)mmap(NULL, buflen, PROT_READ, MAP_PRIVATE, fileno(f), 0)) != MAP_FAILED) {
+    mapped = 1;
+  }
+#endif
+  else {
+    buf = NULL;
+    buflen = file_slurp(f, &buf, 0);
+  }
+
+  if (compressed && !buf)
+    status = dtatw_error(err, zerr.code, "%s", zerr.msg);
+  else
+    status = cxPackedLoadBuffer(cxp, buf, buflen, filename, err);
+
+#if HAVE_SYS_MMAN_H
+  if (mapped) munmap(buf, buflen);
+  else
+#endif
+  if (buf) free(buf);
+  if (f != stdin) fclose(f);
+
+  return status;
+}
+
+//--------------------------------------------------------------
+void cxPackedFree(cxPacked *cxp)
+{
+  if (!cxp) return;
+  if (cxp->flags) free(cxp->flags);
+  if (cxp->xoff)  free(cxp->xoff);
+  if (cxp->xlen)  free(cxp->xlen);
+  if (cxp->toff)  free(cxp->toff);
+  if (cxp->tlen)  free(cxp->tlen);
+  if (cxp->aidx)  free(cxp->aidx);
+  if (cxp->attrs) free(cxp->attrs);
+  memset(cxp, 0, sizeof(cxPacked));
+}
+
+//--------------------------------------------------------------
+ByteOffset cxPackedFindXoff(const cxPacked *cxp, ByteOffset xoff)
+{
+  ByteOffset lo = 0, hi = cxp->len, mid;
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (cxp->xoff[mid] < xoff) lo = mid+1;
+    else                       hi = mid;
+  }
+  return lo;
+}
+
+//--------------------------------------------------------------
+ByteOffset cxPackedFindToff(const cxPacked *cxp, ByteOffset toff)
+{
+  ByteOffset lo = 0, hi = cxp->len, mid;
+  if (cxp->len == 0 || toff >= cxp->toff[cxp->len-1] + cxp->tlen[cxp->len-1]) return cxp->len;
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (cxp->toff[mid] <= toff) lo = mid+1;
+    else                        hi = mid;
+  }
+  return lo-1;
+}
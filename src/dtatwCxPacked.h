@@ -0,0 +1,64 @@
+/*
+ * File: dtatwCxPacked.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: column-packed .cx data (for perl consumers)
+ */
+
+#ifndef DTATW_CXPACKED_H
+#define DTATW_CXPACKED_H
+
+#include "dtatwCommon.h"
+
+/*======================================================================
+ * cxPacked: types
+ */
+
+//-- CXP_NOATTR: value of undefined cxPacked.aidx[] and cxPacked.attrs[] slots
+#define CXP_NOATTR ((uint32_t)0xffffffff)
+
+//-- cxPacked: binary .cx data, decoded into flat columns (one entry per record, no per-record pointers)
+//   + 15 bytes/record (23 with DTATW_LARGE_OFFSETS) plus 16 bytes per record with attributes
+//     (vs. ~48 for cxRecord, and several hundred for a perl array)
+typedef struct {
+  ByteOffset  len;    //-- number of records (not counting the EOF pseudo-record)
+  uchar      *flags;  //-- flags[i]: raw record flags; record type is (flags[i] & cxfTypeMask)
+  ByteOffset *xoff;   //-- xoff[i]: xml byte offset (monotonically non-decreasing)
+  uchar      *xlen;   //-- xlen[i]: xml byte length
+  ByteOffset *toff;   //-- toff[i]: .tx byte offset (cumulative tlen, monotonically non-decreasing)
+  uchar      *tlen;   //-- tlen[i]: .tx byte length
+  uint32_t   *aidx;   //-- aidx[i]: index of record attributes in attrs[] (CXP_NOATTR if !(flags[i] & cxfHasAttrs))
+  uint32_t   *attrs;  //-- attrs[4*aidx[i]+j]: attributes as for cxStoredRecord (CXP_NOATTR if undefined)
+  ByteOffset  nattrs; //-- number of 4-tuples in attrs[]
+} cxPacked;
+
+//-- cxp_attr(cxp,i,j): j-th attribute of record i (requires (cxp->flags[i] & cxfHasAttrs))
+#define cxp_attr(cxp,i,j) ((cxp)->attrs[4*(ByteOffset)(cxp)->aidx[i]+(j)])
+
+/*======================================================================
+ * cxPacked: API
+ *  + functions returning int return 0 on success, otherwise err->code; err may be NULL
+ */
+
+// status = cxPackedLoadBuffer(cxp, buf,buflen, srcname, err)
+//  + decodes binary .cx data (including header) from buf[0..buflen-1] into *cxp
+//  + *cxp must be zeroed or previously loaded; any previous contents are freed
+int cxPackedLoadBuffer(cxPacked *cxp, const char *buf, size_t buflen, const char *srcname, dtatwError *err);
+
+// status = cxPackedLoadFile(cxp, filename, err)
+//  + mmap()s (or slurps) filename and calls cxPackedLoadBuffer()
+int cxPackedLoadFile(cxPacked *cxp, const char *filename, dtatwError *err);
+
+// cxPackedFree(cxp)
+//  + frees column data (but not cxp itself)
+void cxPackedFree(cxPacked *cxp);
+
+// i = cxPackedFindXoff(cxp, xoff)
+//  + returns index of first record i with cxp->xoff[i] >= xoff, or cxp->len if none exists
+ByteOffset cxPackedFindXoff(const cxPacked *cxp, ByteOffset xoff);
+
+// i = cxPackedFindToff(cxp, toff)
+//  + returns index of last record i with cxp->toff[i] <= toff (i.e. the record containing .tx byte toff),
+//    or cxp->len if toff is out of range
+ByteOffset cxPackedFindToff(const cxPacked *cxp, ByteOffset toff);
+
+#endif /* DTATW_CXPACKED_H */
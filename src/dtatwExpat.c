@@ -1,77 +1,101 @@
 #include "dtatwExpat.h"
+#include "dtatwZio.h"
 
 //----------------------------------------------------------------------
-ByteOffset expat_parse_file(XML_Parser xp, FILE *f_in, const char *filename_in) 
+// status = expat_xml_error(xp,srcname,err)
+//  + sets err from the current expat error (including error context)
+static
+int expat_xml_error(XML_Parser xp, const char *srcname, dtatwError *err)
+{
+  int ctx_offset = 0, ctx_len = 0;
+  const char *ctx_buf;
+  if (XML_GetErrorCode(xp) == XML_ERROR_ABORTED && err && err->code) {
+    //-- aborted by a handler which has already set err
+    return err->code;
+  }
+  ctx_buf = get_error_context(xp, 64, &ctx_offset, &ctx_len);
+  return dtatw_error(err, 3, "`%s' (line %u, col %u, byte %u): XML error: %s\n%s: Error Context:\n%.*s%s%.*s",
+		     (srcname ? srcname : "?"),
+		     (uint)XML_GetCurrentLineNumber(xp), (uint)XML_GetCurrentColumnNumber(xp), (uint)XML_GetCurrentByteIndex(xp),
+		     XML_ErrorString(XML_GetErrorCode(xp)),
+		     prog,
+		     (int)ctx_offset, ctx_buf,
+		     "\n---HERE---\n",
+		     (int)(ctx_len-ctx_offset), ctx_buf+ctx_offset);
+}
+
+//----------------------------------------------------------------------
+int expat_try_parse_file(XML_Parser xp, FILE *f_in, const char *filename_in, ByteOffset *n_xbytes, dtatwError *err)
 {
-  ByteOffset n_xbytes=0;
   size_t nread;
   int status, is_final = 0;
+  zioReader *zr;
+  *n_xbytes = 0;
+
+  //-- open (maybe compressed) input: byte offsets & counts refer to the uncompressed stream
+  if (!(zr = zio_open(f_in, filename_in, err))) return err->code;
+
   do {
     //-- setup & read into buffer (uses expat functions to avoid double-copy)
     void *buf = XML_GetBuffer(xp, FILE_BUFSIZE);
     if (!buf) {
-      fprintf(stderr, "%s: XML_GetBuffer() failed!\n", prog);
-      exit(1);
+      zio_close(zr);
+      return dtatw_error(err, 1, "XML_GetBuffer() failed!");
     }
-    nread = fread(buf, 1,FILE_BUFSIZE, f_in);
-    n_xbytes += nread;
+    nread = zio_read(zr, buf, FILE_BUFSIZE);
+    *n_xbytes += nread;
 
     //-- check for file errors
-    is_final = feof(f_in);
-    if (ferror(f_in) && !is_final) {
-      fprintf(stderr, "%s: `%s' (line %u, col %u, byte %u): I/O error: %s\n",
-	      prog, filename_in,
-	      (uint)XML_GetCurrentLineNumber(xp), (uint)XML_GetCurrentColumnNumber(xp), (uint)XML_GetCurrentByteIndex(xp),
-	      strerror(errno));
-      exit(2);
+    is_final = zio_eof(zr);
+    if (zio_error(zr)) {
+      status = dtatw_error(err, 2, "`%s' (line %u, col %u, byte %u): %s",
+			   filename_in,
+			   (uint)XML_GetCurrentLineNumber(xp), (uint)XML_GetCurrentColumnNumber(xp), (uint)(*n_xbytes),
+			   zio_errmsg(zr));
+      zio_close(zr);
+      return status;
     }
 
     status = XML_ParseBuffer(xp, (int)nread, is_final);
 
     //-- check for expat errors
     if (status != XML_STATUS_OK) {
-      int ctx_offset = 0, ctx_len = 0;
-      const char *ctx_buf;
-      fprintf(stderr, "%s: `%s' (line %u, col %u, byte %u): XML error: %s\n",
-	      prog, filename_in,
-	      (uint)XML_GetCurrentLineNumber(xp), (uint)XML_GetCurrentColumnNumber(xp), (uint)XML_GetCurrentByteIndex(xp),
-	      XML_ErrorString(XML_GetErrorCode(xp)));
-
-      ctx_buf = get_error_context(xp, 64, &ctx_offset, &ctx_len);
-      fprintf(stderr, "%s: Error Context:\n%.*s%s%.*s\n",
-	      prog,
-	      (int)ctx_offset, ctx_buf,
-	      "\n---HERE---\n",
-	      (int)(ctx_len-ctx_offset), ctx_buf+ctx_offset);
-      exit(3);
+      zio_close(zr);
+      return expat_xml_error(xp, filename_in, err);
     }
   } while (!is_final);
-  return n_xbytes;
+  zio_close(zr);
+  return 0;
 }
 
 //----------------------------------------------------------------------
-ByteOffset expat_parse_string(XML_Parser xp, const char *buf, int buflen, const char *srcname)
+int expat_try_parse_string(XML_Parser xp, const char *buf, int buflen, const char *srcname, dtatwError *err)
 {
   int status;
-  status = XML_Parse(xp, buf, buflen, 1);  
+  status = XML_Parse(xp, buf, buflen, 1);
 
   //-- check for expat errors
   if (status != XML_STATUS_OK) {
-    int ctx_offset = 0, ctx_len = 0;
-    const char *ctx_buf;
-    fprintf(stderr, "%s: `%s' (line %u, col %u, byte %u): XML error: %s\n",
-	    prog, (srcname ? srcname : "?"),
-	    (uint)XML_GetCurrentLineNumber(xp), (uint)XML_GetCurrentColumnNumber(xp), (uint)XML_GetCurrentByteIndex(xp),
-	    XML_ErrorString(XML_GetErrorCode(xp)));
-    
-    ctx_buf = get_error_context(xp, 64, &ctx_offset, &ctx_len);
-    fprintf(stderr, "%s: Error Context:\n%.*s%s%.*s\n",
-	    prog,
-	    (int)ctx_offset, ctx_buf,
-	    "\n---HERE---\n",
-	    (int)(ctx_len-ctx_offset), ctx_buf+ctx_offset);
-    exit(3);
+    return expat_xml_error(xp, srcname, err);
   }
+  return 0;
+}
 
+//----------------------------------------------------------------------
+ByteOffset expat_parse_file(XML_Parser xp, FILE *f_in, const char *filename_in) 
+{
+  ByteOffset n_xbytes=0;
+  dtatwError err;
+  memset(&err,0,sizeof(err));
+  if (expat_try_parse_file(xp, f_in, filename_in, &n_xbytes, &err) != 0) dtatw_die(&err);
+  return n_xbytes;
+}
+
+//----------------------------------------------------------------------
+ByteOffset expat_parse_string(XML_Parser xp, const char *buf, int buflen, const char *srcname)
+{
+  dtatwError err;
+  memset(&err,0,sizeof(err));
+  if (expat_try_parse_string(xp, buf, buflen, srcname, &err) != 0) dtatw_die(&err);
   return (ByteOffset)buflen;
 }
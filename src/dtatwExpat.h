@@ -90,12 +90,23 @@ const char *get_event_context(XML_Parser xp, int *len)
 
 // n_xmlbytes_read = expat_parse_file(xp,f,filename)
 //   + exit()s on error
+//   + gzip- and zstd-compressed input is decompressed transparently (see dtatwZio.h);
+//     n_xmlbytes_read and expat byte offsets refer to the uncompressed stream
 ByteOffset expat_parse_file(XML_Parser xp, FILE *f_in, const char *filename_in);
 
 // n_xmlbytes_read = expat_parse_buffer(xp,buf,buflen,srcname)
 //   + exit()s on error
 ByteOffset expat_parse_string(XML_Parser xp, const char *buf, int buflen, const char *srcname);
 
+// status = expat_try_parse_file(xp,f,filename,&n_xmlbytes_read,err)
+//   + library version of expat_parse_file(): returns 0 on success, otherwise err->code
+//   + if a handler aborted the parse with XML_StopParser() after setting err, the handler's error is kept
+int expat_try_parse_file(XML_Parser xp, FILE *f_in, const char *filename_in, ByteOffset *n_xbytes, dtatwError *err);
+
+// status = expat_try_parse_string(xp,buf,buflen,srcname,err)
+//   + library version of expat_parse_string(): returns 0 on success, otherwise err->code
+int expat_try_parse_string(XML_Parser xp, const char *buf, int buflen, const char *srcname, dtatwError *err);
+
 
 #endif /* DTATW_EXPAT_H */
 
@@ -0,0 +1,1106 @@
+#include "dtatwMkindex.h"
+#include "dtatwUtf8.h"
+#include "dtatwExpat.h"
+#include "dtatwZio.h"
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_LIBPTHREAD)
+# include <pthread.h>
+# define MKINDEX_THREADS 1
+#endif
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/*======================================================================
+ * Globals
+ */
+
+#define CTBUFSIZE    256 //-- buffer size for character-local text data
+
+struct ChunkData_;      //-- chunked mode: per-chunk state (see below)
+
+typedef struct {
+  XML_Parser xp;        //-- expat parser
+  FILE *f_cx;           //-- output character-index file
+  FILE *f_sx;           //-- output structure-index file
+  FILE *f_tx;           //-- output text file
+  int text_depth;       //-- number of open <text> elements
+  int total_depth;      //-- total number of open elements (global depth)
+  int c_depth;          //-- total number of open <c> elements (either 0 or 1: nested <c>s are not allowed)
+  int is_chardata;      //-- true if current event is character data (used by cb_default)
+  int last_c_was_text;	//-- true iff last cx-record output was from a raw text node (if so, we don't ignore whitespace text nodes)
+  ByteOffset n_chrs;    //-- number of logical characters read
+  ByteOffset loc_xoff;  //-- last xml-offset written to .sx as location-block (see LOC_FMT, cb_default())
+  ByteOffset loc_toff;  //-- last text-offset written to .sx as location-block (see LOC_FMT, cb_default())
+  XML_Char c_tbuf[CTBUFSIZE];	//-- text buffer for current character
+  int c_tlen;			//-- byte length of text in character buffer c_tbuf[]
+  ByteOffset c_xoffset;		//-- byte offset in XML stream at which current <c> started
+  ByteOffset c_toffset;		//-- byte offset in text stream at which current <c> started
+  uint32_t   cx_attrs[4];	//-- stores bbox for <c> records
+  cxStoredRecord cxr;		//-- last record written by put_record_raw()
+  uint32_t   cx_bbox[4];	//-- last bbox written by put_record_raw() (cxfBboxDelta base)
+  ByteOffset xbase;		//-- input byte offset of expat byte-index 0 (chunked mode; 0 for serial mode)
+  ByteOffset xend;		//-- stop parsing at first start-tag at or after this input offset (0: never)
+  struct ChunkData_ *chunk;	//-- chunked mode: current chunk (NULL for serial mode and for the first chunk)
+  dtatwError *err;		//-- error status (set by handlers before XML_StopParser())
+} TokWrapData;
+
+//-- xml_byte_index(data): input byte offset of current event
+#define xml_byte_index(data) ((ByteOffset)(XML_GetCurrentByteIndex((data)->xp) + (data)->xbase))
+
+/*----------------------------------------------------------------------
+ * Globals: chunked mode
+ *  + input is split at <pb> start-tags inside <text> (see prescan_chunks())
+ *  + each chunk is parsed by its own expat parser, seeded with the start-tags open at its split-point
+ *  + output depending on the preceding chunk (text offsets in .sx, cxfHasXmlOffset of the 1st .cx record,
+ *    the 1st delta-coded .cx bbox, the 1st .sx location record, last_c_was_text) is fixed up when stitching
+ *    (see stitch_chunk())
+ */
+
+//-- LocRecord: deferred .sx location record
+typedef struct {
+  const char *fmt;      //-- printf format (LOC_FMT_PRE or LOC_FMT_POST), or NULL for 1st pre-copy record
+  ByteOffset pos;       //-- byte offset in chunk .sx output at which record is to be inserted
+  ByteOffset xoff;      //-- xml offset (NULL fmt: end offset)
+  ByteOffset xlen;      //-- xml length (NULL fmt: unused)
+  ByteOffset toff;      //-- chunk-local text offset (NULL fmt: end offset)
+  ByteOffset tlen;      //-- text length (NULL fmt: unused)
+} LocRecord;
+
+typedef struct ChunkData_ {
+  TokWrapData data;     //-- parser state
+  const char *buf;      //-- input buffer
+  ByteOffset buflen;    //-- input buffer length
+  const char *filename; //-- input filename (for error messages)
+  ByteOffset xbeg;      //-- input byte offset of chunk start
+  ByteOffset xend;      //-- input byte offset of chunk end
+  char *prefix;         //-- synthetic context prefix (start-tags open at xbeg)
+  int prefix_len;       //-- byte length of prefix
+  int lcwt_guess;       //-- assumed initial value of last_c_was_text
+  int lcwt_known;       //-- true iff last_c_was_text has been set by this chunk
+  int lcwt_used;        //-- true iff lcwt_guess was used (whitespace text node before 1st char/lb record)
+  int loc_known;        //-- true iff loc_xoff, loc_toff have been set by this chunk
+  ByteOffset n_cx;      //-- number of .cx records written
+  cxStoredRecord cx_first; //-- first .cx record written
+  ByteOffset cx_first_xoff; //-- xml offset of first .cx record
+  off_t cx_first_len;   //-- byte length of first .cx record
+  int cx_bbox_known;    //-- true iff a .cx record with cxfBboxDelta has been written
+  cxStoredRecord cx_bbox_first; //-- first .cx record with cxfBboxDelta (coded against a zero bbox)
+  ByteOffset cx_bbox_xexpect;   //-- implicit xml offset of cx_bbox_first
+  off_t cx_bbox_pos;    //-- byte offset of cx_bbox_first in f_cx (0 if cx_bbox_first is cx_first)
+  off_t cx_bbox_end;    //-- byte offset of the record following cx_bbox_first in f_cx
+  ByteOffset sx_len;    //-- number of literal bytes written to .sx output
+  LocRecord *locs;      //-- deferred .sx location records
+  size_t nlocs;         //-- number of used locs[]
+  size_t alocs;         //-- number of allocated locs[]
+  FILE *f_cx;           //-- chunk .cx output (temporary)
+  FILE *f_sx;           //-- chunk .sx output (temporary)
+  FILE *f_tx;           //-- chunk .tx output (temporary)
+  dtatwError err;       //-- chunk error status
+} ChunkData;
+
+/*======================================================================
+ * Utils
+ */
+
+//--------------------------------------------------------------
+// mkindex_abort(data,code,fmt,...)
+//  + sets error status for data and stops the parser
+#define mkindex_abort(data,...) \
+  do { dtatw_error((data)->err, __VA_ARGS__); XML_StopParser((data)->xp, XML_FALSE); } while (0)
+
+//--------------------------------------------------------------
+static
+void put_raw_text(TokWrapData *data, int tlen, const char *txt)
+{
+  if (data->f_tx) fwrite(txt, 1,tlen, data->f_tx);
+  data->c_toffset += tlen;
+}
+
+//--------------------------------------------------------------
+static
+void put_record_raw(TokWrapData *data, cxRecordType elt, ByteOffset xoffset, int xlen, int tlen, const uint32_t *attrs)
+{
+  cxStoredRecord *cxr = &data->cxr;
+  ByteOffset xexpect = cxr->xoff + cxr->xlen;  //-- implicit xml offset (end of preceding record)
+  ChunkData *ch = data->chunk;
+  int bbox_first = 0;
+  if (ch && (elt==cxrChar || elt==cxrLb)) ch->lcwt_known = 1;
+  if (!data->f_cx) return;
+
+  cxr->flags = elt;
+  if (xoffset != xexpect) {
+    cxr->flags |= cxfHasXmlOffset;
+  }
+  cxr->xoff = xoffset;  //-- always set cxr->xoff because we'll use it to check for the NEXT record's cxfHasXmlOffset flag
+  cxr->xlen = xlen;
+  if (tlen != xlen) {
+    cxr->flags |= cxfHasTxtLength;
+    cxr->tlen   = tlen;
+  }
+  if (attrs && attrs[0] != (uint32_t)-1) {
+    cxr->flags |= cxfHasAttrs;
+    memcpy(cxr->attrs, attrs, 16);
+    if (CX_VARINT && elt==cxrChar) cxr->flags |= cxfBboxDelta;
+  }
+  if (ch && (cxr->flags & cxfBboxDelta) && !ch->cx_bbox_known) {
+    //-- chunked mode: remember 1st delta-coded bbox (delta base depends on preceding chunk)
+    bbox_first = ch->cx_bbox_known = 1;
+    ch->cx_bbox_first   = *cxr;
+    ch->cx_bbox_xexpect = xexpect;
+    ch->cx_bbox_pos     = ch->n_cx ? ftello(data->f_cx) : 0;
+  }
+  cx_put_record(data->f_cx, cxr, xexpect, data->cx_bbox);
+  if (bbox_first) ch->cx_bbox_end = ftello(data->f_cx);
+
+  if (ch && ch->n_cx++ == 0) {
+    //-- chunked mode: remember 1st record (cxfHasXmlOffset depends on preceding chunk)
+    ch->cx_first      = *cxr;
+    ch->cx_first_xoff = xoffset;
+    ch->cx_first_len  = ftello(data->f_cx);
+  }
+}
+
+//--------------------------------------------------------------
+static
+void put_record_c_elt(TokWrapData *data)
+{
+  ByteOffset c_xlen = xml_byte_index(data) + XML_GetCurrentByteCount(data->xp) - data->c_xoffset;
+  put_record_raw(data,
+		 cxrChar,
+		 data->c_xoffset, c_xlen,
+		 /*data->c_toffset,*/ data->c_tlen,
+		 data->cx_attrs
+		 );
+  put_raw_text(data, data->c_tlen, data->c_tbuf);
+  data->last_c_was_text = 0;
+  data->c_tlen = 0; //-- reset character-data buffer
+}
+
+//--------------------------------------------------------------
+static
+void put_record_c_text(TokWrapData *data, ByteOffset xoff, ByteOffset xlen)
+{
+  put_record_raw(data,
+		 cxrChar,
+		 xoff, xlen,
+		 /*data->c_toffset,*/ data->c_tlen,
+		 NULL
+		 );
+  put_raw_text(data, data->c_tlen, data->c_tbuf);
+  data->last_c_was_text = 1;
+  data->c_tlen = 0; //-- reset character-data buffer
+}
+
+//--------------------------------------------------------------
+static
+int is_ws(const XML_Char *s, int len)
+{
+  int i;
+  for (i=0; (len < 0 && *s) || i < len; ++i) {
+    if (!isspace(s[i])) return 0;
+  }
+  return 1;
+}
+
+//--------------------------------------------------------------
+static
+void put_record_lb(TokWrapData *data, const XML_Char **attrs)
+{
+  ByteOffset my_xoff = xml_byte_index(data);
+  ByteOffset my_xlen = XML_GetCurrentByteCount(data->xp);
+  put_record_raw(data,
+		 cxrLb,
+		 my_xoff, my_xlen,
+		 /*data->c_toffset,*/ 1,
+		 NULL
+		 );
+  put_raw_text(data, 1, "\n");
+  data->last_c_was_text = 0;
+}
+
+//--------------------------------------------------------------
+static inline
+uint32_t pbfacs2n(const XML_Char *s)
+{
+  if (*s=='#') ++s; 
+  if (*s=='f') ++s;
+  return strtoul(s,NULL,10);
+}
+
+//--------------------------------------------------------------
+static
+void put_record_pb(TokWrapData *data, const XML_Char **attrs)
+{
+  ByteOffset my_xoff = xml_byte_index(data);
+  ByteOffset my_xlen = XML_GetCurrentByteCount(data->xp);
+  const uint32_t *cx_attrs = NULL;
+
+  //-- parse attrs
+  memset(data->cx_attrs,0,16);
+  for ( ; *attrs; attrs += 2) {
+    if (strcmp(attrs[0],"facs")==0) {
+      data->cx_attrs[0] = pbfacs2n(attrs[1]);
+      cx_attrs = data->cx_attrs;
+      break;
+    }
+    else if (strcmp(attrs[0],"n")==0) {
+      //-- fallback: use pb/@n if available (but allow pb/@facs to override it)
+      data->cx_attrs[0] = pbfacs2n(attrs[1]);
+      cx_attrs = data->cx_attrs;
+    }
+  }
+
+  put_record_raw(data,
+		 cxrPb,
+		 my_xoff, my_xlen,
+		 /*data->c_toffset,*/ 0,
+		 cx_attrs
+		 );
+  //put_raw_text(data, 1, "\n");
+}
+
+//--------------------------------------------------------------
+static
+void put_record_formula(TokWrapData *data, const XML_Char **attrs)
+{
+  ByteOffset my_xoff = xml_byte_index(data);
+  //ByteOffset my_xlen = XML_GetCurrentByteCount(data->xp);
+  ByteOffset my_xlen = 0;
+  int my_tlen = strlen(CX_FORMULA_TEXT);
+  //char formula_id[CIDBUFSIZE];
+  //snprintf(formula_id, CIDBUFSIZE, CX_FORMULA_ID, my_xoff);
+  put_record_raw(data,
+		 cxrFormula,
+		 my_xoff, my_xlen,
+		 /*data->c_toffset,*/ my_tlen,
+		 NULL
+		 );
+  put_raw_text(data, my_tlen, CX_FORMULA_TEXT);
+}
+
+
+/*======================================================================
+ * Handlers
+ */
+
+//--------------------------------------------------------------
+static
+void cb_start(TokWrapData *data, const XML_Char *name, const XML_Char **attrs)
+{
+#if !DTATW_LARGE_OFFSETS
+  if ((uint64_t)XML_GetCurrentByteIndex(data->xp) + data->xbase > (uint64_t)ByteOffsetMax) {
+    mkindex_abort(data, 2, "input exceeds %" PRIu64 " bytes (rebuild with configure --enable-large-offsets)",
+		  (uint64_t)ByteOffsetMax);
+    return;
+  }
+#endif
+  if (data->xend && xml_byte_index(data) >= data->xend) {
+    //-- chunked mode: start of next chunk
+    XML_StopParser(data->xp, XML_FALSE);
+    return;
+  }
+  if (data->text_depth) {
+
+    if (strcmp(name,"c")==0) { // || strcmp(name,"formula")==0
+      if (data->c_depth) {
+	mkindex_abort(data, 3, "cannot handle nested <c> elements starting at bytes %u, %u",
+		      (uint)data->c_xoffset, (uint)xml_byte_index(data));
+	return;
+      }
+      //-- parse attributes
+      memset(data->cx_attrs,0xff,16);
+      for ( ; *attrs; attrs += 2) {
+	if (strlen(*attrs) != 3) continue;
+	switch (attrs[0][0]) {
+	case 'u':
+	  switch (attrs[0][2]) {
+	  case 'x': data->cx_attrs[0] = strtoul(attrs[1],NULL,10); break; //-- 0: u[l]x
+	  case 'y': data->cx_attrs[1] = strtoul(attrs[1],NULL,10); break; //-- 1: u[l]y
+	  default: break;
+	  }
+	  break;
+	case 'l':
+	  switch (attrs[0][2]) {
+	  case 'x': data->cx_attrs[2] = strtoul(attrs[1],NULL,10); break; //-- 2: l[r]x
+	  case 'y': data->cx_attrs[3] = strtoul(attrs[1],NULL,10); break; //-- 3: l[r]x
+	  default: break;
+	  }
+	  break;
+	default: break;
+	}
+      }
+      data->c_xoffset = xml_byte_index(data);
+      data->c_tlen    = 0;
+      data->n_chrs++;
+      data->total_depth++;
+      data->c_depth = 1;
+      return;
+    }
+    else if (strcmp(name,"lb")==0) {
+      put_record_lb(data,attrs);
+      data->total_depth++;
+      return;
+    }
+    else if (strcmp(name,"pb")==0) {
+      put_record_pb(data,attrs);
+    }
+    else if (strcmp(name,"formula")==0) {
+      put_record_formula(data,attrs);
+    }
+  }
+  else if (strcmp(name,"text")==0) {
+    data->text_depth++;
+  }
+  data->is_chardata = 0;
+  XML_DefaultCurrent(data->xp);
+  data->total_depth++;
+}
+
+//--------------------------------------------------------------
+static
+void cb_end(TokWrapData *data, const XML_Char *name)
+{
+  if (data->xend && xml_byte_index(data) >= data->xend) {
+    //-- chunked mode: end of empty element at start of next chunk (expat doesn't check for XML_StopParser() here)
+    return;
+  }
+  if (strcmp(name,"c")==0) {
+    put_record_c_elt(data);  //-- output: index record + raw text
+    data->total_depth--;
+    data->c_depth = 0;      //-- ... and leave <c>-parsing mode
+    return;
+  }
+  else if (strcmp(name,"lb")==0) {
+    data->total_depth--;
+    return;
+  }
+  else if (strcmp(name,"text")==0) {
+    data->text_depth--;
+  }
+  data->is_chardata = 0;
+  XML_DefaultCurrent(data->xp);
+  data->total_depth--;
+}
+
+//--------------------------------------------------------------
+// U8_DECODE_BLOCK: number of characters bulk-decoded at a time by cb_char()
+#define U8_DECODE_BLOCK 256
+
+// put_text_char(data,u,xoff,xlen)
+//  + output: index record + UTF-8 text for a single text-node character with code point u
+static inline
+void put_text_char(TokWrapData *data, uint32_t u, ByteOffset xoff, ByteOffset xlen)
+{
+  data->c_tlen = u8_wc_toutf8(data->c_tbuf, u);
+  data->c_tbuf[data->c_tlen] = '\0'; //-- nul-terminate
+  put_record_c_text(data, xoff, xlen);
+}
+
+//--------------------------------------------------------------
+static
+void cb_char(TokWrapData *data, const XML_Char *s, int len)
+{
+  if (data->c_depth) {
+    if (data->c_tlen + len >= CTBUFSIZE) {
+      mkindex_abort(data, 3, "<c> text buffer overflow at byte %u", (uint)data->c_xoffset);
+      return;
+    }
+    memcpy(data->c_tbuf+data->c_tlen, s, len); //-- copy required, else clobbered by nested elts (e.g. <c><g>...</g></c>)
+    data->c_tlen += len;
+    return;
+  }
+  else if (data->text_depth>0) {
+    //-- character data: generate pseudo-elements
+    if (is_ws(s,len)) {
+      //-- whitespace-only: ignore it
+      if (data->chunk && !data->chunk->lcwt_known) data->chunk->lcwt_used = 1;
+      if (data->last_c_was_text) {
+	//-- ... unless it follows a text-node cx-record
+	ByteOffset xoff = xml_byte_index(data);
+	ByteOffset xlen = XML_GetCurrentByteCount(data->xp);
+	data->c_tbuf[0] = ' ';
+	data->c_tbuf[1] = '\0';
+	data->c_tlen = 1;
+	put_record_c_text(data, xoff, xlen);
+      }
+      return;
+    }
+    else {
+      //-- non-whitespace: parse and dump character data
+      int i,j,k,n;
+      int ctx_len;
+      char *ctx = (char*)get_event_context(data->xp,&ctx_len), *tail;
+      ByteOffset xoff = xml_byte_index(data);
+      uint32_t u = 0;
+      uint32_t wcs[U8_DECODE_BLOCK]; //-- bulk-decoded text characters (code points)
+      uchar    wls[U8_DECODE_BLOCK]; //-- bulk-decoded text characters (byte lengths)
+      for (i=0; i < ctx_len; i=j) {
+	j=i;
+
+	//-- text: character entity
+	if (ctx[i] == '&') {
+	  //-- text: character entity: numeric escape
+	  if (ctx[i+1]=='#') {
+	    if (ctx[i+2]=='x') {
+	      u = strtoul((const char*)&ctx[i+3],&tail,16);
+	    } else {
+	      u = strtoul((const char*)&ctx[i+2],&tail,10);
+	    }
+	    j = 1+tail-ctx;
+	  }
+	  //-- text: character entity: built-in
+	  else if (i+3 < ctx_len && strncmp(ctx+i+1,"lt;",3)==0) { u='<'; j=i+4; }
+	  else if (i+3 < ctx_len && strncmp(ctx+i+1,"gt;",3)==0)  { u='>'; j=i+4; }
+	  else if (i+4 < ctx_len && strncmp(ctx+i+1,"amp;",4)==0) { u='&'; j=i+5; }
+	  else if (i+5 < ctx_len && strncmp(ctx+i+1,"quot;",5)==0) { u='"'; j=i+6; }
+	  else if (i+5 < ctx_len && strncmp(ctx+i+1,"apos;",5)==0) { u='\''; j=i+5; }
+	  else {
+	    fprintf(stderr, "%s: WARNING: unparsed entity at XML byte %u\n", prog, (uint)data->c_xoffset);
+	  }
+	}
+	if (j==i) {
+	  //-- normal text (or unparsed entity fallback): bulk-decode up to the next entity
+	  //   + no error count: the parser is created with encoding "UTF-8", so expat has already
+	  //     rejected malformed UTF-8 in ctx (U+FFFD mapping only matters for other u8_decoden() callers)
+	  const char *amp = (const char*)memchr(ctx+i+1, '&', ctx_len-i-1);
+	  int        tend = amp ? (int)(amp-ctx) : ctx_len;
+	  while (j < tend) {
+	    n = u8_decoden(ctx, tend, &j, wcs, wls, U8_DECODE_BLOCK, NULL);
+	    for (k=0; k < n; i += wls[k++]) {
+	      put_text_char(data, wcs[k], xoff+i, wls[k]);
+	    }
+	  }
+	  continue;
+	}
+
+	//-- we've got a text character in $ctx[i:j] and its unicode codepoint in $u
+	put_text_char(data, u, xoff+i, j-i);
+      }
+    }
+  }
+  else {
+    //-- character data outside of //text : shunt it to sx
+    data->is_chardata = 1;
+    XML_DefaultCurrent(data->xp);
+  }
+}
+
+//--------------------------------------------------------------
+// location printf format: xoff xlen toff tlen
+#define LOC_FMT "%"ByteOffsetF" %"ByteOffsetF" %"ByteOffsetF" %"ByteOffsetF
+
+//--------------------------------------------------------------
+//#define TW_DEBUG_LOC
+#ifdef TW_DEBUG_LOC
+static const char *LOC_FMT_PRE  = "<c type=\"pre\" n=\""LOC_FMT"\"/>";
+static const char *LOC_FMT_POST = "<c type=\"post\" n=\""LOC_FMT"\"/>";
+#else
+static const char *LOC_FMT_PRE  = "<c n=\""LOC_FMT"\"/>";
+static const char *LOC_FMT_POST = "<c n=\""LOC_FMT"\"/>";
+#endif
+
+//--------------------------------------------------------------
+// chunk_push_loc(chunk,fmt,xoff,xlen,toff,tlen)
+//  + chunked mode: defer .sx location record until text offset of chunk is known
+static
+void chunk_push_loc(ChunkData *ch, const char *fmt, ByteOffset xoff, ByteOffset xlen, ByteOffset toff, ByteOffset tlen)
+{
+  LocRecord *loc;
+  if (ch->nlocs == ch->alocs) {
+    ch->alocs = ch->alocs ? 2*ch->alocs : 256;
+    ch->locs  = (LocRecord*)realloc(ch->locs, ch->alocs*sizeof(LocRecord));
+    assert2(ch->locs != NULL, "realloc failed");
+    dtatw_stats_alloc(ch->alocs*sizeof(LocRecord));
+  }
+  loc = &ch->locs[ch->nlocs++];
+  loc->pos = ch->sx_len;
+  if (!ch->loc_known) {
+    //-- 1st pre-copy record: starts wherever the preceding chunk left off; keep only end offsets
+    assert2(fmt == LOC_FMT_PRE, "bad initial location record");
+    loc->fmt  = NULL;
+    loc->xoff = xoff + xlen;
+    loc->toff = toff + tlen;
+    ch->loc_known = 1;
+    return;
+  }
+  loc->fmt  = fmt;
+  loc->xoff = xoff;
+  loc->xlen = xlen;
+  loc->toff = toff;
+  loc->tlen = tlen;
+}
+
+//--------------------------------------------------------------
+static inline
+void put_loc(TokWrapData *data, const char *fmt, ByteOffset xoff, ByteOffset xlen, ByteOffset toff, ByteOffset tlen)
+{
+  if (!data->f_sx) return;
+  if (data->chunk) chunk_push_loc(data->chunk, fmt, xoff, xlen, toff, tlen);
+  else fprintf(data->f_sx, fmt, xoff, xlen, toff, tlen);
+}
+
+//--------------------------------------------------------------
+static
+void cb_default(TokWrapData *data, const XML_Char *s, int len)
+{
+  int ctx_len;
+  const XML_Char *ctx = get_event_context(data->xp, &ctx_len);
+  ByteOffset     xoff = xml_byte_index(data);
+  if (data->total_depth > 0 && !data->is_chardata && xoff != data->loc_xoff) {
+    //-- pre-copy location element (for close-tags)
+    ByteOffset xlen = xoff - data->loc_xoff;
+    ByteOffset tlen = data->c_toffset + data->c_tlen - data->loc_toff;
+    put_loc(data, LOC_FMT_PRE, data->loc_xoff, xlen, data->loc_toff, tlen);
+    data->loc_xoff = xoff;
+    data->loc_toff = data->c_toffset + data->c_tlen;
+  }
+  if (data->f_sx) {
+    //-- copy literal event to sx
+    fwrite(ctx, 1,ctx_len, data->f_sx);
+    if (data->chunk) data->chunk->sx_len += ctx_len;
+  }
+  if (data->total_depth > 1 && !data->is_chardata && xoff+ctx_len != data->loc_xoff) {
+    //-- post-copy location element (for open-tags)
+    ByteOffset xlen = xoff + ctx_len - data->loc_xoff;
+    ByteOffset tlen = data->c_toffset + data->c_tlen - data->loc_toff;
+    put_loc(data, LOC_FMT_POST, data->loc_xoff, xlen, data->loc_toff, tlen);
+    data->loc_xoff = xoff + ctx_len;
+    data->loc_toff = data->c_toffset + data->c_tlen;
+  }
+}
+
+/*======================================================================
+ * Chunked mode
+ */
+
+//--------------------------------------------------------------
+// parser = mkindex_parser(data)
+//  + creates & sets up a new expat parser for data
+//  + returns NULL (and sets data->err) on failure
+static
+XML_Parser mkindex_parser(TokWrapData *data)
+{
+  XML_Parser xp = XML_ParserCreate("UTF-8");
+  if (!xp) {
+    dtatw_error(data->err, 1, "XML_ParserCreate failed");
+    return NULL;
+  }
+  XML_SetUserData(xp, data);
+  XML_SetElementHandler(xp, (XML_StartElementHandler)cb_start, (XML_EndElementHandler)cb_end);
+  XML_SetCharacterDataHandler(xp, (XML_CharacterDataHandler)cb_char);
+  XML_SetDefaultHandler(xp, (XML_DefaultHandler)cb_default);
+  data->xp = xp;
+  return xp;
+}
+
+//--------------------------------------------------------------
+// p = find_str(s,end,str,len)
+//  + like memmem(s,end-s,str,len), returns NULL if not found
+static inline
+const char *find_str(const char *s, const char *end, const char *str, size_t len)
+{
+  for ( ; (s = memchr(s,str[0],end-s)) != NULL && (size_t)(end-s) >= len; ++s) {
+    if (memcmp(s,str,len)==0) return s;
+  }
+  return NULL;
+}
+
+//--------------------------------------------------------------
+// bool = tag_name_is(s,end,name)
+//  + true iff tag-name starting at s (and ending before end) is name
+static inline
+int tag_name_is(const char *s, const char *end, const char *name)
+{
+  size_t len = strlen(name);
+  if ((size_t)(end-s) < len || strncmp(s,name,len)!=0) return 0;
+  return (isspace(s[len]) || s[len]=='/' || s[len]=='>');
+}
+
+//--------------------------------------------------------------
+// nchunks = prescan_chunks(buf,buflen,nwant,chunks)
+//  + scans buf[] for split-points: <pb> start-tags inside <text> and outside of <c>, <lb>, <pb>, and <formula>
+//  + populates chunks[0..nchunks-1] byte ranges and context prefixes
+//  + uses memchr() to skip over character data between tags
+//  + returns 1 (don't split) if the document has an internal DTD subset or looks malformed
+static
+int prescan_chunks(const char *buf, ByteOffset buflen, int nwant, ChunkData *chunks)
+{
+  const char *p=buf, *q, *end=buf+buflen;
+  const char **stack = NULL;  //-- open start-tags (pairs: begin, end)
+  size_t depth=0, alloc=0, i;
+  int text_depth=0, bad_depth=0, quote, n=1;
+  ByteOffset target = buflen/nwant;
+
+  memset(chunks, 0, nwant*sizeof(ChunkData));
+  chunks[0].xbeg = 0;
+  chunks[0].xend = buflen;
+
+  while (n < nwant && p < end && (p = memchr(p,'<',end-p)) != NULL && p+1 < end) {
+    if (p[1]=='!') {
+      if (end-p >= 4 && strncmp(p,"<!--",4)==0) {
+	if (!(q = find_str(p+4,end,"-->",3))) break;
+	p = q+3;
+      }
+      else if (end-p >= 9 && strncmp(p,"<![CDATA[",9)==0) {
+	if (!(q = find_str(p+9,end,"]]>",3))) break;
+	p = q+3;
+      }
+      else {
+	//-- <!DOCTYPE ...>: don't split documents with an internal subset (entity declarations)
+	for (q=p+2; q < end && *q != '>' && *q != '['; ++q) ;
+	if (q >= end || *q=='[') { n=1; break; }
+	p = q+1;
+      }
+      continue;
+    }
+    else if (p[1]=='?') {
+      if (!(q = find_str(p+2,end,"?>",2))) break;
+      p = q+2;
+      continue;
+    }
+
+    //-- find end of tag (skipping quoted attribute values)
+    for (q=p+1, quote=0; q < end && (quote || *q != '>'); ++q) {
+      if (quote) { if (*q==quote) quote=0; }
+      else if (*q=='"' || *q=='\'') quote = *q;
+    }
+    if (q >= end) break;
+
+    if (p[1]=='/') {
+      //-- end-tag
+      if (!depth) { n=1; break; }
+      --depth;
+      if (tag_name_is(stack[2*depth]+1,stack[2*depth+1],"text")) --text_depth;
+      else if (tag_name_is(stack[2*depth]+1,stack[2*depth+1],"c")
+	       || tag_name_is(stack[2*depth]+1,stack[2*depth+1],"lb")
+	       || tag_name_is(stack[2*depth]+1,stack[2*depth+1],"pb")
+	       || tag_name_is(stack[2*depth]+1,stack[2*depth+1],"formula")) --bad_depth;
+    }
+    else {
+      //-- start-tag or empty element: check for split-point
+      if (text_depth && !bad_depth && p-buf >= target*n && tag_name_is(p+1,q,"pb")) {
+	ChunkData *ch = &chunks[n];
+	const char *r;
+	chunks[n-1].xend = ch->xbeg = p-buf;
+	ch->xend = buflen;
+	for (i=0; i < depth; i++) ch->prefix_len += stack[2*i+1]-stack[2*i];
+	ch->prefix = (char*)malloc(ch->prefix_len);
+	assert2(ch->prefix != NULL, "malloc failed");
+	for (i=0, ch->prefix_len=0; i < depth; i++) {
+	  memcpy(ch->prefix+ch->prefix_len, stack[2*i], stack[2*i+1]-stack[2*i]);
+	  ch->prefix_len += stack[2*i+1]-stack[2*i];
+	}
+	//-- guess last_c_was_text: true iff <pb> is preceded by (non-whitespace) text
+	for (r=p-1; r > buf && isspace(*r); --r) ;
+	ch->lcwt_guess = (*r != '>');
+	++n;
+      }
+      if (q[-1] != '/') {
+	//-- start-tag: push
+	if (depth == alloc) {
+	  alloc = alloc ? 2*alloc : 64;
+	  stack = (const char**)realloc(stack, 2*alloc*sizeof(const char*));
+	  assert2(stack != NULL, "realloc failed");
+	}
+	stack[2*depth]   = p;
+	stack[2*depth+1] = q+1;
+	++depth;
+	if (tag_name_is(p+1,q,"text")) ++text_depth;
+	else if (tag_name_is(p+1,q,"c") || tag_name_is(p+1,q,"lb") || tag_name_is(p+1,q,"pb") || tag_name_is(p+1,q,"formula")) ++bad_depth;
+      }
+    }
+    p = q+1;
+  }
+  if (stack) free(stack);
+
+  if (n==1) {
+    //-- no (safe) split-points: single chunk
+    for (i=1; i < nwant; i++) if (chunks[i].prefix) free(chunks[i].prefix);
+    memset(chunks, 0, nwant*sizeof(ChunkData));
+    chunks[0].xend = buflen;
+  }
+  return n;
+}
+
+//--------------------------------------------------------------
+// status = chunk_run(ch)
+//  + parses input bytes [ch->xbeg,ch->xend) to chunk outputs
+//  + feeds expat with the same FILE_BUFSIZE-aligned blocks as expat_parse_file(), so that
+//    character data is reported in exactly the same pieces as in serial mode
+//  + returns 0 on success, otherwise ch->err.code
+static
+int chunk_run(ChunkData *ch)
+{
+  TokWrapData *data = &ch->data;
+  XML_Parser xp;
+  ByteOffset pos, end;
+  int status, is_final;
+
+  data->err = &ch->err;
+  if (!(xp = mkindex_parser(data))) return ch->err.code;
+
+  if (ch->prefix_len) {
+    //-- replay context prefix with all output suppressed
+    data->xbase = ch->xbeg - ch->prefix_len;
+    if (XML_Parse(xp, ch->prefix, ch->prefix_len, 0) != XML_STATUS_OK) {
+      dtatw_error(&ch->err, 3, "`%s': XML error in context prefix for byte %u: %s",
+		  ch->filename, (uint)ch->xbeg, XML_ErrorString(XML_GetErrorCode(xp)));
+      XML_ParserFree(xp);
+      data->xp = NULL;
+      return ch->err.code;
+    }
+    //-- ... and start with unknown inherited state (fixed up by stitch_chunk())
+    data->chunk    = ch;
+    data->c_toffset = 0;
+    data->loc_xoff = (ByteOffset)-1;
+    data->loc_toff = 0;
+    data->last_c_was_text = ch->lcwt_guess;
+  }
+  data->f_cx = ch->f_cx;
+  data->f_sx = ch->f_sx;
+  data->f_tx = ch->f_tx;
+  data->xend = (ch->xend < ch->buflen ? ch->xend : 0);
+
+  for (pos=ch->xbeg; ; pos=end) {
+    end = (pos/FILE_BUFSIZE + 1)*FILE_BUFSIZE;
+    if (end >= ch->buflen) end = ch->buflen;
+    is_final = (end == ch->buflen);
+    status = XML_Parse(xp, ch->buf+pos, end-pos, is_final);
+    if (status != XML_STATUS_OK) {
+      if (XML_GetErrorCode(xp) == XML_ERROR_ABORTED && !ch->err.code) break; //-- reached xend
+      if (!ch->err.code) {
+	dtatw_error(&ch->err, 3, "`%s' (byte %u): XML error: %s",
+		    ch->filename, (uint)xml_byte_index(data), XML_ErrorString(XML_GetErrorCode(xp)));
+      }
+      break;
+    }
+    if (is_final) break;
+  }
+
+  XML_ParserFree(xp);
+  data->xp = NULL;
+  return ch->err.code;
+}
+
+#ifdef MKINDEX_THREADS
+//--------------------------------------------------------------
+static
+void *chunk_thread(void *arg)
+{
+  chunk_run((ChunkData*)arg);
+  return NULL;
+}
+#endif
+
+//--------------------------------------------------------------
+// status = chunk_open(ch, f_cx,f_sx,f_tx)
+//  + (re-)initializes chunk state and temporary outputs (for each non-NULL final output)
+//  + returns 0 on success, otherwise ch->err.code
+static
+int chunk_open(ChunkData *ch, FILE *f_cx, FILE *f_sx, FILE *f_tx)
+{
+  memset(&ch->data, 0, sizeof(TokWrapData));
+  ch->lcwt_known = ch->lcwt_used = ch->loc_known = 0;
+  ch->n_cx = ch->sx_len = 0;
+  ch->nlocs = 0;
+  ch->cx_first_len = 0;
+  ch->cx_bbox_known = 0;
+  ch->cx_bbox_pos = ch->cx_bbox_end = 0;
+  ch->f_cx = f_cx ? tmpfile() : NULL;
+  ch->f_sx = f_sx ? tmpfile() : NULL;
+  ch->f_tx = f_tx ? tmpfile() : NULL;
+  if ((f_cx && !ch->f_cx) || (f_sx && !ch->f_sx) || (f_tx && !ch->f_tx)) {
+    return dtatw_error(&ch->err, 1, "failed to create temporary file: %s", strerror(errno));
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+static
+void chunk_close(ChunkData *ch)
+{
+  if (ch->f_cx) fclose(ch->f_cx);
+  if (ch->f_sx) fclose(ch->f_sx);
+  if (ch->f_tx) fclose(ch->f_tx);
+  ch->f_cx = ch->f_sx = ch->f_tx = NULL;
+}
+
+//--------------------------------------------------------------
+// file_copy(f_in,f_out,n)
+//  + copies n bytes from f_in to f_out, or all remaining bytes if n==(off_t)-1
+static
+void file_copy(FILE *f_in, FILE *f_out, off_t n)
+{
+  char buf[FILE_BUFSIZE];
+  size_t nwant, nread;
+  while (n != 0) {
+    nwant = (n < 0 || n > FILE_BUFSIZE) ? FILE_BUFSIZE : (size_t)n;
+    nread = fread(buf, 1,nwant, f_in);
+    if (nread > 0) fwrite(buf, 1,nread, f_out);
+    if (nread < nwant) break;
+    if (n > 0) n -= nread;
+  }
+}
+
+//--------------------------------------------------------------
+// ChunkState: state inherited from preceding chunks
+typedef struct {
+  cxStoredRecord cxr;   //-- last .cx record
+  uint32_t cx_bbox[4];  //-- last .cx bbox (cxfBboxDelta base)
+  ByteOffset loc_xoff;  //-- last .sx location xml-offset
+  ByteOffset loc_toff;  //-- last .sx location text-offset
+  ByteOffset toff;      //-- text offset of chunk start
+  int last_c_was_text;  //-- last_c_was_text flag
+} ChunkState;
+
+//--------------------------------------------------------------
+// status = stitch_chunk(ch, st, f_cx,f_sx,f_tx)
+//  + appends temporary outputs of chunk ch to final outputs, fixing up inherited state st
+//  + re-parses ch if its guess for last_c_was_text turned out wrong
+//  + updates st
+//  + returns 0 on success, otherwise ch->err.code
+static
+int stitch_chunk(ChunkData *ch, ChunkState *st, FILE *f_cx, FILE *f_sx, FILE *f_tx)
+{
+  size_t i;
+
+  if (ch->lcwt_used && ch->lcwt_guess != st->last_c_was_text) {
+    //-- bad guess for last_c_was_text: re-parse
+    chunk_close(ch);
+    if (chunk_open(ch, f_cx,f_sx,f_tx) != 0) return ch->err.code;
+    ch->lcwt_guess = st->last_c_was_text;
+    if (chunk_run(ch) != 0) return ch->err.code;
+  }
+
+  //-- .cx: re-encode 1st record and 1st delta-coded bbox record, then copy
+  if (f_cx && ch->n_cx) {
+    cxStoredRecord cxr = ch->cx_first;
+    if (ch->cx_first_xoff != st->cxr.xoff + st->cxr.xlen) cxr.flags |= cxfHasXmlOffset;
+    else cxr.flags &= ~cxfHasXmlOffset;
+    cx_put_record(f_cx, &cxr, st->cxr.xoff + st->cxr.xlen, st->cx_bbox);
+    fseeko(ch->f_cx, ch->cx_first_len, SEEK_SET);
+    if (ch->cx_bbox_pos > 0) {
+      file_copy(ch->f_cx, f_cx, ch->cx_bbox_pos - ch->cx_first_len);
+      cx_put_record(f_cx, &ch->cx_bbox_first, ch->cx_bbox_xexpect, st->cx_bbox);
+      fseeko(ch->f_cx, ch->cx_bbox_end, SEEK_SET);
+    }
+    file_copy(ch->f_cx, f_cx, (off_t)-1);
+  }
+
+  //-- .sx: copy, inserting location records
+  if (f_sx) {
+    ByteOffset pos = 0;
+    rewind(ch->f_sx);
+    for (i=0; i < ch->nlocs; i++) {
+      LocRecord *loc = &ch->locs[i];
+      file_copy(ch->f_sx, f_sx, loc->pos - pos);
+      pos = loc->pos;
+      if (!loc->fmt) {
+	if (loc->xoff != st->loc_xoff)
+	  fprintf(f_sx, LOC_FMT_PRE, st->loc_xoff, loc->xoff-st->loc_xoff, st->loc_toff, st->toff+loc->toff-st->loc_toff);
+      } else {
+	fprintf(f_sx, loc->fmt, loc->xoff, loc->xlen, st->toff+loc->toff, loc->tlen);
+      }
+    }
+    file_copy(ch->f_sx, f_sx, (off_t)-1);
+  }
+
+  //-- .tx: copy
+  if (f_tx) {
+    rewind(ch->f_tx);
+    file_copy(ch->f_tx, f_tx, (off_t)-1);
+  }
+
+  //-- update inherited state
+  if (ch->n_cx) st->cxr = ch->data.cxr;
+  if (ch->cx_bbox_known) memcpy(st->cx_bbox, ch->data.cx_bbox, 16);
+  if (ch->loc_known) {
+    st->loc_xoff = ch->data.loc_xoff;
+    st->loc_toff = st->toff + ch->data.loc_toff;
+  }
+  if (ch->lcwt_known) st->last_c_was_text = ch->data.last_c_was_text;
+  st->toff += ch->data.c_toffset;
+  return 0;
+}
+
+/*======================================================================
+ * API
+ */
+
+//--------------------------------------------------------------
+int mkindex_buffer(const char *buf, ByteOffset buflen, const char *srcname,
+		   FILE *f_cx, FILE *f_sx, FILE *f_tx,
+		   int njobs, MkindexStats *stats, dtatwError *err)
+{
+  ChunkData *chunks;
+  ChunkState st;
+  dtatwError err_local;
+  int i, nchunks, status=0;
+
+  if (!err) { memset(&err_local,0,sizeof(err_local)); err = &err_local; }
+
+  //-- chunked mode requires distinct output files
+  if (njobs < 1
+      || (f_cx && (f_cx==f_sx || f_cx==f_tx))
+      || (f_sx && f_sx==f_tx))
+    {
+      njobs = 1;
+    }
+  if (!srcname) srcname = "(buffer)";
+
+  //-- print output header(s)
+  if (f_cx) cx_put_header(f_cx);
+
+  //-- pre-scan
+  chunks  = (ChunkData*)malloc(njobs*sizeof(ChunkData));
+  assert2(chunks != NULL, "malloc failed");
+  nchunks = prescan_chunks(buf, buflen, njobs, chunks);
+
+  //-- parse: first chunk writes directly to final outputs
+  for (i=0; i < nchunks; i++) {
+    chunks[i].buf      = buf;
+    chunks[i].buflen   = buflen;
+    chunks[i].filename = srcname;
+    if (i==0) {
+      chunks[i].f_cx = f_cx;
+      chunks[i].f_sx = f_sx;
+      chunks[i].f_tx = f_tx;
+    } else if (status==0) {
+      status = chunk_open(&chunks[i], f_cx,f_sx,f_tx);
+      if (status != 0) *err = chunks[i].err;
+    }
+  }
+  if (status==0) {
+#ifdef MKINDEX_THREADS
+    pthread_t *threads = (pthread_t*)malloc(nchunks*sizeof(pthread_t));
+    char *started = (char*)calloc(nchunks, 1);
+    assert2(threads != NULL && started != NULL, "malloc failed");
+    for (i=1; i < nchunks; i++) {
+      started[i] = (pthread_create(&threads[i], NULL, chunk_thread, &chunks[i]) == 0);
+    }
+    chunk_run(&chunks[0]);
+    for (i=1; i < nchunks; i++) {
+      if (started[i]) pthread_join(threads[i], NULL);
+      else chunk_run(&chunks[i]); //-- couldn't create thread: parse in this thread
+    }
+    free(started);
+    free(threads);
+#else
+    for (i=0; i < nchunks; i++) chunk_run(&chunks[i]);
+#endif
+    for (i=0; i < nchunks; i++) {
+      if (chunks[i].err.code) { *err = chunks[i].err; status = err->code; break; }
+    }
+  }
+
+  //-- stitch
+  if (status==0) {
+    memset(&st, 0, sizeof(st));
+    st.cxr      = chunks[0].data.cxr;
+    memcpy(st.cx_bbox, chunks[0].data.cx_bbox, 16);
+    st.loc_xoff = chunks[0].data.loc_xoff;
+    st.loc_toff = chunks[0].data.loc_toff;
+    st.toff     = chunks[0].data.c_toffset;
+    st.last_c_was_text = chunks[0].data.last_c_was_text;
+    if (stats) stats->n_chrs = chunks[0].data.n_chrs;
+    for (i=1; i < nchunks && status==0; i++) {
+      if ((status = stitch_chunk(&chunks[i], &st, f_cx,f_sx,f_tx)) != 0) *err = chunks[i].err;
+      else if (stats) stats->n_chrs += chunks[i].data.n_chrs;
+    }
+  }
+  if (stats) {
+    stats->n_xbytes = buflen;
+    stats->n_chunks = nchunks;
+  }
+
+  //-- cleanup
+  for (i=1; i < nchunks; i++) {
+    chunk_close(&chunks[i]);
+    if (chunks[i].prefix) free(chunks[i].prefix);
+    if (chunks[i].locs) free(chunks[i].locs);
+  }
+  free(chunks);
+
+  return status;
+}
+
+//--------------------------------------------------------------
+int mkindex_file(FILE *f_in, const char *filename_in,
+		 FILE *f_cx, FILE *f_sx, FILE *f_tx,
+		 int njobs, MkindexStats *stats, dtatwError *err)
+{
+  TokWrapData data;
+  XML_Parser xp;
+  ByteOffset n_xbytes = 0;
+  dtatwError err_local;
+  off_t fsize;
+  int status;
+
+  if (!err) { memset(&err_local,0,sizeof(err_local)); err = &err_local; }
+
+#if !DTATW_LARGE_OFFSETS
+  if ((fsize = file_size(f_in)) > 0 && (uint64_t)fsize > (uint64_t)ByteOffsetMax) {
+    return dtatw_error(err, 2, "`%s': input exceeds %" PRIu64 " bytes (rebuild with configure --enable-large-offsets)",
+		       filename_in, (uint64_t)ByteOffsetMax);
+  }
+#endif
+
+  //-- chunked mode requires a seekable input file
+  if (njobs > 1 && f_in != stdin && (fsize = file_size(f_in)) > 0 && ftello(f_in) == 0) {
+    char *buf = NULL;
+    ByteOffset buflen = fsize;
+    int mapped = 0;
+    if (zio_sniff(f_in) != zioRaw) {
+      //-- compressed input: decompress to memory (chunk split-points are uncompressed offsets)
+      zioReader *zr = zio_open(f_in, filename_in, err);
+      if (!zr) return err->code;
+      buflen = zio_slurp(zr, &buf);
+      if (zio_error(zr)) {
+	status = dtatw_error(err, 2, "`%s': %s", filename_in, zio_errmsg(zr));
+	zio_close(zr);
+	return status;
+      }
+      zio_close(zr);
+      status = mkindex_buffer(buf, buflen, filename_in, f_cx,f_sx,f_tx, njobs, stats, err);
+      free(buf);
+      return status;
+    }
+#if HAVE_SYS_MMAN_H
+    if ((buf = (char*)mmap(NULL, buflen, PROT_READ, MAP_PRIVATE, fileno(f_in), 0)) != MAP_FAILED) {
+      mapped = 1;
+    } else
+#endif
+    {
+      buf = NULL;
+      buflen = file_slurp(f_in, &buf, 0);
+    }
+    status = mkindex_buffer(buf, buflen, filename_in, f_cx,f_sx,f_tx, njobs, stats, err);
+#if HAVE_SYS_MMAN_H
+    if (mapped) munmap(buf, buflen);
+    else
+#endif
+    if (buf) free(buf);
+    return status;
+  }
+
+  //-- print output header(s)
+  if (f_cx) cx_put_header(f_cx);
+
+  //-- parse input file: serial
+  memset(&data,0,sizeof(data));
+  data.f_cx = f_cx;
+  data.f_sx = f_sx;
+  data.f_tx = f_tx;
+  data.err  = err;
+  if (!(xp = mkindex_parser(&data))) return err->code;
+  status = expat_try_parse_file(xp, f_in, filename_in, &n_xbytes, err);
+  XML_ParserFree(xp);
+
+  if (stats) {
+    stats->n_xbytes = n_xbytes;
+    stats->n_chrs   = data.n_chrs;
+    stats->n_chunks = 1;
+  }
+  return status;
+}
@@ -0,0 +1,44 @@
+/*
+ * File: dtatwMkindex.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: index generation (dtatw-mkindex core)
+ */
+
+#ifndef DTATW_MKINDEX_H
+#define DTATW_MKINDEX_H
+
+#include "dtatwCommon.h"
+
+/*======================================================================
+ * mkindex: types
+ */
+
+//-- MkindexStats: summary information returned by mkindex_file(), mkindex_buffer()
+typedef struct {
+  ByteOffset n_xbytes;  //-- number of XML bytes read
+  ByteOffset n_chrs;    //-- number of logical characters read
+  int        n_chunks;  //-- number of chunks actually parsed (1 for serial mode)
+} MkindexStats;
+
+/*======================================================================
+ * mkindex: API
+ *  + outputs are the binary character-index (.cx, including header), structure-index (.sx), and raw text (.tx)
+ *  + any output FILE may be NULL to discard it
+ *  + njobs > 1 requests parallel chunked mode (split at <pb> elements; output is identical to serial mode),
+ *    which is silently disabled for shared output FILEs and non-seekable input
+ *  + return value is 0 on success, otherwise err->code (a suggested exit() status); err may be NULL
+ */
+
+// status = mkindex_file(f_in,filename_in, f_cx,f_sx,f_tx, njobs, stats, err)
+//  + filename_in is used for error messages only
+int mkindex_file(FILE *f_in, const char *filename_in,
+		 FILE *f_cx, FILE *f_sx, FILE *f_tx,
+		 int njobs, MkindexStats *stats, dtatwError *err);
+
+// status = mkindex_buffer(buf,buflen,srcname, f_cx,f_sx,f_tx, njobs, stats, err)
+//  + parses in-memory XML data buf[0..buflen-1]; srcname is used for error messages only
+int mkindex_buffer(const char *buf, ByteOffset buflen, const char *srcname,
+		   FILE *f_cx, FILE *f_sx, FILE *f_tx,
+		   int njobs, MkindexStats *stats, dtatwError *err);
+
+#endif /* DTATW_MKINDEX_H */
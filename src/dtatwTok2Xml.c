@@ -0,0 +1,255 @@
+//-*- Mode: C; c-basic-offset: 2; -*-
+#include "dtatwTok2Xml.h"
+#include "dtatwB2xb.h"
+
+/*======================================================================
+ * Globals
+ */
+
+// VERBOSE_IO : whether to print progress messages for load/save
+//#define VERBOSE_IO 1
+#undef VERBOSE_IO
+
+// SUPPRESS_HEADER_COMMENTS : define this to suppress header comments into output file
+//  + non-suppression can lead to errors of the form:
+//     :10: parser error : Double hyphen within comment:
+//      <!-- base=1949%_%27%_%wenn-zelluloidgoetter-reden
+//      <!-- base=1949%_%27%_%wenn-zelluloidgoetter-reden--_TEIexport.xml -->
+//    in subsequent processing steps (example from dwds)
+//  + errors should disappear now with put_escaped_cmt_str() in dta-tokwrap v0.55
+#undef SUPPRESS_HEADER_COMMENTS
+
+//-- indentation constants (set these to empty strings to output size-optimized XML)
+static const char *indent_root = "\n"; //-- pre-indentation for root (<sentences>)
+static const char *indent_s    = "\n"; //-- pre-indentation for <s>, </s>
+static const char *indent_w    = "\n"; //-- pre-indentation for <w>
+//static const char *indent_alw  = "";	//-- pre-indentation for </w> following non-empty <toka>
+static const char *indent_al   = "";   //-- pre-indentation for <toka> within <w>
+static const char *indent_a    = "";   //-- pre-indentation for <a> within <toka>
+
+//-- xml structure constants (should jive with 'mkbx0', 'mkbx')
+static const char *docElt = "sentences";  //-- output document element
+static const char *sElt   = "s";          //-- output sentence element
+static const char *pnAttr = "pn";         //-- output paragraph-number attribute (for sentences)
+static const char *wElt   = "w";          //-- output token element
+static const char *alElt  = "toka";	   //-- output token-analyses element
+static const char *aElt   = "a";          //-- output token-analysis element
+static const char *tbAttr  = "b";    	   //-- output .txt byte-position attribute ( b="OFFSET LEN")
+static const char *xbAttr  = "xb";    	   //-- output .xml byte-position attribute (xb="OFFSET_0+LEN_0... OFFSET_N+LEN_N")
+static const char *textAttr = "t";        //-- output token-text attribute
+
+//-- coordinate attributes (from dtatw-b2xb -coords columns; should jive with dtatw-get-ddc-attrs)
+static const char *coordPrefixes[] = {B2XB_COORD_PB, B2XB_COORD_LB, B2XB_COORD_BB, NULL};
+static const char *coordAttrs[]    = {"pb", "lb", "bb", NULL};
+
+//--------------------------------------------------------------
+// i = tt_coord_index(t, col, &seen)
+//  + returns index in coordPrefixes[] for .tt column col, or -1 if col is not to be mapped to an attribute
+//  + only maps columns if t->want_coords is set, and each coordinate attribute at most once per word
+//    (bitmask *seen; later columns with the same prefix are written as ordinary analyses)
+static int tt_coord_index(const Tok2XmlData *t, const char *col, int *seen)
+{
+  int i;
+  if (!t->want_coords) return -1;
+  for (i=0; coordPrefixes[i]; i++) {
+    if (strncmp(col, coordPrefixes[i], strlen(coordPrefixes[i]))==0) {
+      if (*seen & (1<<i)) return -1;
+      *seen |= (1<<i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*======================================================================
+ * API
+ */
+
+//--------------------------------------------------------------
+void tok2xml_init(Tok2XmlData *t)
+{
+  memset(t, 0, sizeof(Tok2XmlData));
+  t->tt_filename = "(?)";
+  t->tt_linenum  = 1;
+}
+
+//--------------------------------------------------------------
+void tok2xml_put_header(Tok2XmlData *t, FILE *f_out, int argc, char **argv, const char *xmlbase, const char *xmlsuff)
+{
+  //-- print basic XML header
+  fprintf(f_out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+#ifdef VERBOSE_HEADER_COMMENTS
+  {
+    int i;
+    fprintf(f_out, "<!--\n");
+    fprintf(f_out, " ! File created by %s (%s version %s)\n", prog, PACKAGE, PACKAGE_VERSION);
+    fprintf(f_out, " ! Command-line: %s", (argc > 0 ? argv[0] : prog));
+    for (i=1; i < argc; i++) {
+      fputs(" '", f_out);
+      put_escaped_cmt_str(f_out, (argv[i][0] ? argv[i] : ""), -1);
+      fputc('\'', f_out);
+    }
+    fputs("\n !-->\n", f_out);
+  }
+#endif
+
+  //-- print XML root element
+  fprintf(f_out,"<%s",docElt);
+  if (xmlbase && *xmlbase) {
+    fputs(" xml:base=\"", f_out);
+    put_escaped_str(f_out, xmlbase, -1);
+    put_escaped_str(f_out, (xmlsuff ? xmlsuff : ""), -1);
+    fputc('"', f_out);
+  }
+  fputc('>',f_out);
+}
+
+//--------------------------------------------------------------
+void tok2xml_put_footer(Tok2XmlData *t, FILE *f_out)
+{
+  fprintf(f_out, "%s</%s>\n", indent_root, docElt);
+}
+
+//--------------------------------------------------------------
+/* status = tok2xml_process(t, f_in, filename_in, f_out, err)
+ *  + converts .tt input (with xml-byte locations, as created by dtatw-b2xb) to XML
+ */
+#define INITIAL_TT_LINEBUF_SIZE 8192
+int tok2xml_process(Tok2XmlData *t, FILE *f_in, const char *filename_in, FILE *f_out, dtatwError *err)
+{
+  char *linebuf=NULL; //, *s0, *s1;
+  size_t linebuf_alloc=0;
+  ssize_t linelen;
+  int   s_open = 0;          		//-- bool: is an <s> element currently open?
+  char *w_text, *w_tloc, *w_xloc, *w_rest, *tail;	//-- temps for input parsing
+  char *w_col;				//-- temp for column scanning
+  int   w_nana, ci, seen;		//-- number of (non-coordinate) analysis columns, coordinate index & bitmask
+  ByteOffset w_off,w_len;		//-- location offset, for estimating number of xml bytes
+
+  //-- sanity checks
+  if (f_in == NULL || f_out == NULL)
+    return dtatw_error(err, 1, "tok2xml_process(): no input or output file");
+
+  //-- init line buffer
+  linebuf = (char*)malloc(INITIAL_TT_LINEBUF_SIZE);
+  assert(linebuf != NULL /* malloc failed */);
+  linebuf_alloc = INITIAL_TT_LINEBUF_SIZE;
+
+  //-- init error reporting
+  t->tt_linenum = 0;
+  t->tt_filename = filename_in;
+
+  //-- ye olde loope
+  while ( (linelen=getline(&linebuf,&linebuf_alloc,f_in)) >= 0 ) {
+    ++t->tt_linenum;
+
+    //-- chomp newline (and maybe carriage return)
+    if (linelen>0 && linebuf[linelen-1]=='\n') linebuf[--linelen] = '\0';
+    if (linelen>0 && linebuf[linelen-1]=='\r') linebuf[--linelen] = '\0';
+
+    //-- check for comments
+    if (linebuf[0]=='%' && linebuf[1]=='%') {
+      if (strcmp(linebuf+2,"$SB$")==0) {
+	//-- tokenizer $SB$ hint: increment paragraph counter
+	++t->s_pn_ctr;
+      }
+      //-- other comment (e.g "base=\"BASE\"),
+      fputs("\n<!--", f_out);
+      put_escaped_cmt_str(f_out, linebuf+2, -1);
+      if (linebuf[2]==' ') fputc(' ', f_out);		//-- add a trailing space for leading-space tt-comments
+      fputs("-->", f_out);
+      continue;
+    }
+
+    //-- check for EOS (blank line)
+    if (linebuf[0]=='\0') {
+      if (s_open) {
+	fprintf(f_out,"%s</%s>", indent_s, sElt);
+	s_open = 0;
+      }
+      continue;
+    }
+
+    //-- word: inital parse into strings (w_text, w_tloc, w_xloc, w_rest)
+    w_text = linebuf;
+    w_tloc = next_tab_z(w_text)+1;
+    w_xloc = next_char_z(w_tloc,'~')+1;
+    w_rest = next_tab_z(w_xloc)+1;
+
+    //-- output: BOS
+    if (!s_open) {
+      fprintf(f_out, "%s<%s %s=\"s%x\" %s=\"p%x\">", indent_s, sElt, xmlid_name, ++t->s_id_ctr, pnAttr, t->s_pn_ctr);
+      s_open = 1;
+    }
+
+    //-- output: w: begin: open <w ...>
+    fprintf(f_out, "%s<%s %s=\"w%x\"", indent_w, wElt, xmlid_name, ++t->w_id_ctr);
+
+    //-- output: w: text
+    if (textAttr) {
+      fprintf(f_out, " %s=\"", textAttr);
+      put_escaped_str(f_out, w_text, -1);
+      fputc('"', f_out);
+    }
+
+    //-- output: w: location: .txt
+    if (tbAttr) {
+      fprintf(f_out, " %s=\"%s\"", tbAttr, w_tloc);
+    }
+
+    //-- output: w: location: .xml
+    if (xbAttr) {
+      fprintf(f_out, " %s=\"%s\"", xbAttr, w_xloc);
+    }
+
+    //-- output: w: coordinates (dtatw-b2xb -coords columns)
+    w_nana = 0;
+    seen   = 0;
+    for (w_col=w_rest; *w_col; w_col=tail) {
+      tail = next_tab(w_col);
+      if ((ci = tt_coord_index(t, w_col, &seen)) >= 0) {
+	fprintf(f_out, " %s=\"", coordAttrs[ci]);
+	put_escaped_str(f_out, w_col+strlen(coordPrefixes[ci]), tail-w_col-strlen(coordPrefixes[ci]));
+	fputc('"', f_out);
+      }
+      else ++w_nana;
+      if (*tail) tail++;
+    }
+
+    //-- output: w: analyses (finishing <w ...>, also writing </w> if required)
+    if (w_nana) {
+      fprintf(f_out, ">%s<%s>", indent_al, alElt);
+      seen = 0;
+      do {
+	tail = next_tab(w_rest);
+	if (tt_coord_index(t, w_rest, &seen) < 0) {
+	  fprintf(f_out, "%s<%s>", indent_a, aElt);
+	  put_escaped_str(f_out, w_rest, tail-w_rest);
+	  fprintf(f_out, "</%s>", aElt);
+	}
+	if (tail && *tail) tail++;
+	w_rest = tail;
+      } while (*w_rest);
+      fprintf(f_out, "%s</%s>%s</w>", indent_al, alElt, (*indent_al ? indent_w : ""));
+    } else {
+      //-- no analyses: empty word
+      fputs("/>", f_out);
+    }
+
+    //-- profile
+    ++t->ntoks;
+    if (t->want_stats) {
+      w_off = strtoull(w_xloc,  &tail, 0);
+      w_len = (tail[0] && tail[1] ? strtoull(tail+1, &tail, 0) : 0);
+      if (w_off+w_len > t->nxbytes) t->nxbytes = w_off+w_len;
+    }
+  }
+
+  //-- close open sentence if any
+  if (s_open) fprintf(f_out, "%s</%s>", indent_s, sElt);
+
+  //-- cleanup
+  if (linebuf) free(linebuf);
+  return 0;
+}
+
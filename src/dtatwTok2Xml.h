@@ -0,0 +1,51 @@
+/*
+ * File: dtatwTok2Xml.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: tokenizer-output XML conversion (dtatw-tok2xml core)
+ */
+
+#ifndef DTATW_TOK2XML_H
+#define DTATW_TOK2XML_H
+
+#include "dtatwCommon.h"
+
+/*======================================================================
+ * tok2xml: types
+ */
+
+//-- Tok2XmlData: conversion state (formerly dtatw-tok2xml globals)
+typedef struct {
+  const char  *tt_filename; //-- current input filename (for error reporting)
+  unsigned int tt_linenum;  //-- current input line (for error reporting)
+  unsigned int s_id_ctr;    //-- counter for generated //s/@(xml:)?id
+  unsigned int w_id_ctr;    //-- counter for generated //w/@(xml:)?id
+  unsigned int s_pn_ctr;    //-- counter for generated //s/@pn (paragraph number ~ preceding number of $SB$ hints)
+  int          want_stats;  //-- if true, nxbytes will be computed
+  int          want_coords; //-- if true, dtatw-b2xb -coords columns are mapped to //w/@pb,@lb,@bb (see B2XB_COORD_*)
+  ByteOffset   ntoks;       //-- number of tokens processed
+  ByteOffset   nxbytes;     //-- approximate number of xml-bytes in original input (from location field; only if want_stats)
+} Tok2XmlData;
+
+/*======================================================================
+ * tok2xml: API
+ *  + functions returning int return 0 on success, otherwise err->code (a suggested exit() status); err may be NULL
+ */
+
+// tok2xml_init(t)
+//  + initializes t (no dynamic allocation)
+void tok2xml_init(Tok2XmlData *t);
+
+// tok2xml_put_header(t, f_out, argc,argv, xmlbase,xmlsuff)
+//  + prints XML declaration and root start-tag (with @xml:base=XMLBASE XMLSUFF if xmlbase is non-empty)
+//  + argc,argv are only used if compiled with VERBOSE_HEADER_COMMENTS
+void tok2xml_put_header(Tok2XmlData *t, FILE *f_out, int argc, char **argv, const char *xmlbase, const char *xmlsuff);
+
+// status = tok2xml_process(t, f_in,filename_in, f_out, err)
+//  + converts .tt data with xml-byte locations (as created by dtatw-b2xb) from f_in to XML on f_out
+int tok2xml_process(Tok2XmlData *t, FILE *f_in, const char *filename_in, FILE *f_out, dtatwError *err);
+
+// tok2xml_put_footer(t, f_out)
+//  + prints root end-tag
+void tok2xml_put_footer(Tok2XmlData *t, FILE *f_out);
+
+#endif /* DTATW_TOK2XML_H */
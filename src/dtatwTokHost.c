@@ -0,0 +1,162 @@
+#include "dtatwTokHost.h"
+
+#if HAVE_DLFCN_H && HAVE_DLOPEN
+# include <dlfcn.h>
+#endif
+
+/*======================================================================
+ * Utils
+ */
+#if HAVE_DLFCN_H && HAVE_DLOPEN
+
+//-- tokhost_plugindir: default plugin directory (-DDTATW_PLUGINDIR=$(tokplugindir) from src/Makefile.am)
+#ifdef DTATW_PLUGINDIR
+static const char *tokhost_plugindir = DTATW_PLUGINDIR;
+#else
+static const char *tokhost_plugindir = NULL;
+#endif
+
+//--------------------------------------------------------------
+// filename = tokhost_find(dir,dirlen, name)
+//  + returns malloc()d dir/PREFIX name SUFFIX if that file exists, otherwise NULL
+static char *tokhost_find(const char *dir, size_t dirlen, const char *name)
+{
+  size_t len = dirlen + 1 + strlen(TOKHOST_PREFIX) + strlen(name) + strlen(TOKHOST_SUFFIX) + 1;
+  char *filename = (char*)malloc(len);
+  struct stat st;
+  if (!filename) return NULL;
+  snprintf(filename, len, "%.*s/%s%s%s", (int)dirlen, dir, TOKHOST_PREFIX, name, TOKHOST_SUFFIX);
+  if (stat(filename,&st)==0) return filename;
+  free(filename);
+  return NULL;
+}
+
+//--------------------------------------------------------------
+// filename = tokhost_resolve(plugin)
+//  + returns malloc()d plugin filename (see tokhost_open()), or NULL if not found
+static char *tokhost_resolve(const char *plugin)
+{
+  const char *path = getenv(TOKHOST_PATH_ENV), *sep;
+  char *filename;
+  if (strchr(plugin,'/')) return strdup(plugin);
+  while (path && *path) {
+    sep = strchr(path,':');
+    if (!sep) sep = path + strlen(path);
+    if (sep > path && (filename = tokhost_find(path, sep-path, plugin))) return filename;
+    path = *sep ? sep+1 : sep;
+  }
+  if (tokhost_plugindir && (filename = tokhost_find(tokhost_plugindir, strlen(tokhost_plugindir), plugin))) return filename;
+  return NULL;
+}
+
+//--------------------------------------------------------------
+// code = tokhost_fail(th, code)
+//  + closes th and returns code (for error returns from tokhost_open())
+static int tokhost_fail(TokHost *th, int code)
+{
+  tokhost_close(th);
+  return code;
+}
+#endif /* HAVE_DLFCN_H && HAVE_DLOPEN */
+
+/*======================================================================
+ * API
+ */
+
+//--------------------------------------------------------------
+int tokhost_open(TokHost *th, const char *plugin, int nopts, const char *const *opts, dtatwError *err)
+{
+  memset(th,0,sizeof(TokHost));
+#if HAVE_DLFCN_H && HAVE_DLOPEN
+  {
+    char errbuf[DTATW_TOKPLUGIN_ERRLEN];
+    dtatwTokPluginEntryFn entry;
+
+    if (!(th->filename = tokhost_resolve(plugin)))
+      return dtatw_error(err, 1, "tokenizer plugin `%s' not found (searched $%s and %s)",
+			 plugin, TOKHOST_PATH_ENV, (tokhost_plugindir ? tokhost_plugindir : "(none)"));
+
+    if (!(th->dl = dlopen(th->filename, RTLD_NOW|RTLD_LOCAL)))
+      return tokhost_fail(th, dtatw_error(err, 1, "failed to load tokenizer plugin `%s': %s", th->filename, dlerror()));
+
+    if (!(entry = (dtatwTokPluginEntryFn)dlsym(th->dl, DTATW_TOKPLUGIN_SYMBOL)) || !(th->plugin = entry()))
+      return tokhost_fail(th, dtatw_error(err, 1, "`%s' is not a tokenizer plugin (no %s() entry point)",
+					  th->filename, DTATW_TOKPLUGIN_SYMBOL));
+
+    if (th->plugin->abi_version != DTATW_TOKPLUGIN_ABI)
+      return tokhost_fail(th, dtatw_error(err, 1, "tokenizer plugin `%s' has ABI version %u, expected %u",
+					  th->filename, (unsigned)th->plugin->abi_version, (unsigned)DTATW_TOKPLUGIN_ABI));
+
+    errbuf[0] = '\0';
+    if (!(th->tok = th->plugin->init(nopts, opts, errbuf)))
+      return tokhost_fail(th, dtatw_error(err, 1, "tokenizer plugin `%s': init failed: %s",
+					  th->filename, errbuf[0] ? errbuf : "unknown error"));
+    return 0;
+  }
+#else
+  return dtatw_error(err, 1, "cannot load tokenizer plugin `%s': dlopen() not available", plugin);
+#endif
+}
+
+//--------------------------------------------------------------
+int tokhost_tokenize(TokHost *th, const char *buf, size_t len, const dtatwTokPluginCallbacks *cb, dtatwError *err)
+{
+  char errbuf[DTATW_TOKPLUGIN_ERRLEN];
+  int rc;
+  if (!th->tok)
+    return dtatw_error(err, 1, "tokhost_tokenize(): no tokenizer plugin loaded");
+  errbuf[0] = '\0';
+  if ((rc = th->plugin->tokenize(th->tok, buf, len, cb, errbuf)) < 0)
+    return dtatw_error(err, 1, "tokenizer plugin `%s' failed: %s", th->filename, errbuf[0] ? errbuf : "unknown error");
+  else if (rc > 0)
+    return dtatw_error(err, rc, "tokenizer plugin `%s': tokenization aborted by callback (status %d)", th->filename, rc);
+  return 0;
+}
+
+//--------------------------------------------------------------
+// tokhost_write() callbacks: data is a TokHostWriter*
+typedef struct {
+  TokHost *th;
+  FILE    *f;
+} TokHostWriter;
+
+static int tokhost_write_token(void *data, const char *text, size_t textlen, uint64_t off, uint64_t len, const char *analyses)
+{
+  TokHostWriter *w = (TokHostWriter*)data;
+  fwrite(text, 1, textlen, w->f);
+  fprintf(w->f, "\t%" PRIu64 " %" PRIu64, off, len);
+  if (analyses) { fputc('\t', w->f); fputs(analyses, w->f); }
+  fputc('\n', w->f);
+  ++w->th->ntoks;
+  return ferror(w->f) ? 1 : 0;
+}
+
+static int tokhost_write_eos(void *data)
+{
+  TokHostWriter *w = (TokHostWriter*)data;
+  fputc('\n', w->f);
+  return ferror(w->f) ? 1 : 0;
+}
+
+int tokhost_write(TokHost *th, const char *buf, size_t len, FILE *f_out, dtatwError *err)
+{
+  TokHostWriter w = { th, f_out };
+  dtatwTokPluginCallbacks cb = { &w, tokhost_write_token, tokhost_write_eos };
+  if (tokhost_tokenize(th, buf, len, &cb, err) != 0) {
+    if (ferror(f_out))
+      return dtatw_error(err, 1, "write error on tokenizer output: %s", strerror(errno));
+    return err ? err->code : 1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+void tokhost_close(TokHost *th)
+{
+  if (th->tok && th->plugin && th->plugin->free) th->plugin->free(th->tok);
+#if HAVE_DLFCN_H && HAVE_DLOPEN
+  if (th->dl) dlclose(th->dl);
+#endif
+  if (th->filename) free(th->filename);
+  memset(th,0,sizeof(TokHost));
+}
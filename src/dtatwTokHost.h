@@ -0,0 +1,58 @@
+/*
+ * File: dtatwTokHost.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: host side of the tokenizer plugin ABI (see dtatwTokPlugin.h)
+ */
+
+#ifndef DTATW_TOKHOST_H
+#define DTATW_TOKHOST_H
+
+#include "dtatwCommon.h"
+#include "dtatwTokPlugin.h"
+
+/*======================================================================
+ * tokhost: types
+ */
+
+//-- TOKHOST_PREFIX, TOKHOST_SUFFIX: plugin NAME resolves to file TOKHOST_PREFIX NAME TOKHOST_SUFFIX
+#define TOKHOST_PREFIX "dtatw-tokplugin-"
+#define TOKHOST_SUFFIX ".so"
+
+//-- TOKHOST_PATH_ENV: environment variable: colon-separated plugin search path (searched before DTATW_PLUGINDIR)
+#define TOKHOST_PATH_ENV "DTATW_PLUGIN_PATH"
+
+//-- TokHost: a loaded plugin with a single tokenizer instance
+typedef struct {
+  void                  *dl;       //-- dlopen() handle
+  const dtatwTokPlugin *plugin;   //-- plugin descriptor
+  void                  *tok;      //-- plugin instance, from plugin->init()
+  char                  *filename; //-- resolved plugin filename (malloc()d)
+  ByteOffset             ntoks;    //-- number of tokens reported by tokhost_write()
+} TokHost;
+
+/*======================================================================
+ * tokhost: API
+ *  + functions returning int return 0 on success, otherwise err->code (a suggested exit() status); err may be NULL
+ */
+
+// status = tokhost_open(th, plugin, nopts,opts, err)
+//  + loads plugin and creates a tokenizer instance with "KEY=VALUE" options opts[0..nopts-1]
+//  + plugin is a filename if it contains a '/', otherwise a plugin NAME which is searched for as
+//    TOKHOST_PREFIX NAME TOKHOST_SUFFIX in $TOKHOST_PATH_ENV and DTATW_PLUGINDIR
+//  + fails if dlopen() is not available
+int tokhost_open(TokHost *th, const char *plugin, int nopts, const char *const *opts, dtatwError *err);
+
+// status = tokhost_tokenize(th, buf,len, cb, err)
+//  + tokenizes buf[0..len-1] with user callbacks cb
+int tokhost_tokenize(TokHost *th, const char *buf, size_t len, const dtatwTokPluginCallbacks *cb, dtatwError *err);
+
+// status = tokhost_write(th, buf,len, f_out, err)
+//  + tokenizes buf[0..len-1] and writes raw tokenizer output ("TEXT\tOFF LEN[\tANALYSES]" lines,
+//    blank line after each sentence) to f_out, without header comments
+int tokhost_write(TokHost *th, const char *buf, size_t len, FILE *f_out, dtatwError *err);
+
+// tokhost_close(th)
+//  + frees the tokenizer instance and unloads the plugin (but doesn't free th itself)
+void tokhost_close(TokHost *th);
+
+#endif /* DTATW_TOKHOST_H */
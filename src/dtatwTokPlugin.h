@@ -0,0 +1,87 @@
+/*
+ * File: dtatwTokPlugin.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: in-process tokenizer plugin ABI
+ *  + self-contained: plugins need only this header (installed as $(includedir)/dta-tokwrap/dtatwTokPlugin.h)
+ *  + a plugin is a shared object exporting DTATW_TOKPLUGIN_SYMBOL, loaded with dlopen() (see dtatwTokHost.h)
+ */
+
+#ifndef DTATW_TOKPLUGIN_H
+#define DTATW_TOKPLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*======================================================================
+ * ABI versioning
+ *  + DTATW_TOKPLUGIN_ABI is incremented whenever the layout or semantics of the structures below change
+ *  + hosts refuse plugins reporting a different abi_version
+ */
+#define DTATW_TOKPLUGIN_ABI 1
+
+//-- DTATW_TOKPLUGIN_SYMBOL: name of the plugin entry point (type dtatwTokPluginEntryFn)
+#define DTATW_TOKPLUGIN_SYMBOL "dtatw_tokplugin"
+
+//-- flags for dtatwTokPlugin.flags
+#define DTATW_TOKPLUGIN_REENTRANT 0x1  //-- distinct instances may tokenize concurrently in different threads
+
+//-- DTATW_TOKPLUGIN_ERRLEN: minimum size of errbuf arguments
+#define DTATW_TOKPLUGIN_ERRLEN 1024
+
+/*======================================================================
+ * Callbacks (host -> plugin)
+ *  + return 0 to continue; a positive value aborts tokenization, and is returned by dtatwTokPlugin.tokenize()
+ */
+typedef struct dtatwTokPluginCallbacks_s {
+  void *data;  //-- host data, passed as 1st argument to each callback
+
+  // token(data, text,textlen, off,len, analyses)
+  //  + text: normalized token text (NUL-terminated, textlen bytes, no TAB or newline)
+  //  + off,len: byte offset and length of the token in the input buffer
+  //  + analyses: TAB-separated analysis strings, or NULL
+  int (*token)(void *data, const char *text, size_t textlen, uint64_t off, uint64_t len, const char *analyses);
+
+  // eos(data)
+  //  + end of sentence; never called twice in a row or before the first token
+  int (*eos)(void *data);
+} dtatwTokPluginCallbacks;
+
+/*======================================================================
+ * Plugin descriptor (plugin -> host)
+ */
+typedef struct dtatwTokPlugin_s {
+  uint32_t    abi_version; //-- DTATW_TOKPLUGIN_ABI the plugin was compiled against
+  uint32_t    flags;       //-- mask of DTATW_TOKPLUGIN_* flags
+  const char *name;        //-- short plugin name, e.g. "dummy"
+  const char *version;     //-- plugin version string
+
+  // tok = init(nopts, opts, errbuf)
+  //  + creates a new tokenizer instance; opts[0..nopts-1] are "KEY=VALUE" option strings
+  //  + returns NULL on error, with a message in errbuf[DTATW_TOKPLUGIN_ERRLEN]
+  void *(*init)(int nopts, const char *const *opts, char *errbuf);
+
+  // status = tokenize(tok, buf,len, cb, errbuf)
+  //  + tokenizes UTF-8 text buf[0..len-1] (not necessarily NUL-terminated), calling cb->token() and cb->eos()
+  //  + the last sentence is terminated by cb->eos() (if it contains any tokens)
+  //  + returns 0 on success, the (positive) callback status if a callback aborted,
+  //    or -1 on error (with a message in errbuf[DTATW_TOKPLUGIN_ERRLEN])
+  int (*tokenize)(void *tok, const char *buf, size_t len, const dtatwTokPluginCallbacks *cb, char *errbuf);
+
+  // free(tok)
+  //  + destroys an instance created by init()
+  void (*free)(void *tok);
+} dtatwTokPlugin;
+
+// plugin = dtatw_tokplugin()
+//  + entry point exported by each plugin under the name DTATW_TOKPLUGIN_SYMBOL
+typedef const dtatwTokPlugin *(*dtatwTokPluginEntryFn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DTATW_TOKPLUGIN_H */
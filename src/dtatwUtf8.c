@@ -279,6 +279,367 @@ uint32_t u8_peekn(const char *s, int slen)
   return u8_nextcharn(s,slen,&i);
 }
 
+/*======================================================================
+ * (moo): bulk decoding & validation
+ *  + scalar code follows the Unicode "well-formed UTF-8 byte sequences" table (Unicode 3.0+, table 3-7)
+ *  + x86 SIMD code is compiled with per-function target attributes and selected at runtime,
+ *    so the library still runs on CPUs without SSE4.1 / AVX2
+ *  + u8_validate() SIMD kernels use the lookup-table algorithm of Keiser & Lemire,
+ *    "Validating UTF-8 In Less Than One Instruction Per Byte" (Software: Practice and Experience, 2021)
+ */
+
+#if !defined(DTATW_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define U8_HAVE_X86_SIMD 1
+# include <immintrin.h>
+#endif
+
+/* u8_decode1(): decode & validate a single character at u[0:n] (n > 0)
+   returns byte length (1..4) and sets *ch, or 0 if u[0:n] doesn't start with a valid sequence */
+static inline int u8_decode1(const unsigned char *u, int n, uint32_t *ch)
+{
+    unsigned char c = u[0];
+    if (c < 0x80) {
+        *ch = c;
+        return 1;
+    }
+    else if (c < 0xC2) {
+        return 0; //-- continuation byte or overlong 2-byte lead
+    }
+    else if (c < 0xE0) {
+        if (n < 2 || (u[1]&0xC0) != 0x80) return 0;
+        *ch = ((uint32_t)(c&0x1F)<<6) | (u[1]&0x3F);
+        return 2;
+    }
+    else if (c < 0xF0) {
+        if (n < 3 || (u[2]&0xC0) != 0x80) return 0;
+        if (c == 0xE0)      { if (u[1] < 0xA0 || u[1] > 0xBF) return 0; } //-- overlong
+        else if (c == 0xED) { if (u[1] < 0x80 || u[1] > 0x9F) return 0; } //-- surrogate
+        else if ((u[1]&0xC0) != 0x80) return 0;
+        *ch = ((uint32_t)(c&0x0F)<<12) | ((uint32_t)(u[1]&0x3F)<<6) | (u[2]&0x3F);
+        return 3;
+    }
+    else if (c < 0xF5) {
+        if (n < 4 || (u[2]&0xC0) != 0x80 || (u[3]&0xC0) != 0x80) return 0;
+        if (c == 0xF0)      { if (u[1] < 0x90 || u[1] > 0xBF) return 0; } //-- overlong
+        else if (c == 0xF4) { if (u[1] < 0x80 || u[1] > 0x8F) return 0; } //-- > U+10FFFF
+        else if ((u[1]&0xC0) != 0x80) return 0;
+        *ch = ((uint32_t)(c&0x07)<<18) | ((uint32_t)(u[1]&0x3F)<<12) | ((uint32_t)(u[2]&0x3F)<<6) | (u[3]&0x3F);
+        return 4;
+    }
+    return 0; //-- > U+10FFFF or 5-/6-byte lead
+}
+
+/* u8_ascii_scalar(): widen leading ASCII bytes of u[0:n] into wcs[]; returns number of ASCII bytes */
+static int u8_ascii_scalar(const unsigned char *u, int n, uint32_t *wcs)
+{
+    int k;
+    for (k=0; k < n && u[k] < 0x80; k++)
+        wcs[k] = u[k];
+    return k;
+}
+
+/* u8_validate_scalar(): returns offset of 1st invalid sequence in u[0:n], or -1 */
+static int u8_validate_scalar(const unsigned char *u, int n)
+{
+    int i = 0, len;
+    uint32_t ch;
+    while (i < n) {
+        if (u[i] < 0x80) { ++i; continue; }
+        if (!(len = u8_decode1(u+i, n-i, &ch)))
+            return i;
+        i += len;
+    }
+    return -1;
+}
+
+#ifdef U8_HAVE_X86_SIMD
+
+/*-- SSE4: widen ASCII prefix in 16-byte blocks */
+__attribute__((target("sse4.1")))
+static int u8_ascii_sse4(const unsigned char *u, int n, uint32_t *wcs)
+{
+    int k = 0, mask;
+    for ( ; n-k >= 16; k += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(u+k));
+        //-- store all 16 widened bytes (wcs has room), then check for non-ASCII
+        _mm_storeu_si128((__m128i*)(wcs+k),    _mm_cvtepu8_epi32(v));
+        _mm_storeu_si128((__m128i*)(wcs+k+4),  _mm_cvtepu8_epi32(_mm_srli_si128(v,4)));
+        _mm_storeu_si128((__m128i*)(wcs+k+8),  _mm_cvtepu8_epi32(_mm_srli_si128(v,8)));
+        _mm_storeu_si128((__m128i*)(wcs+k+12), _mm_cvtepu8_epi32(_mm_srli_si128(v,12)));
+        if ((mask = _mm_movemask_epi8(v)) != 0)
+            return k + __builtin_ctz(mask);
+    }
+    return k + u8_ascii_scalar(u+k, n-k, wcs+k);
+}
+
+/*-- AVX2: widen ASCII prefix in 32-byte blocks */
+__attribute__((target("avx2")))
+static int u8_ascii_avx2(const unsigned char *u, int n, uint32_t *wcs)
+{
+    int k = 0;
+    unsigned int mask;
+    for ( ; n-k >= 32; k += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(u+k));
+        _mm256_storeu_si256((__m256i*)(wcs+k),    _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(u+k))));
+        _mm256_storeu_si256((__m256i*)(wcs+k+8),  _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(u+k+8))));
+        _mm256_storeu_si256((__m256i*)(wcs+k+16), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(u+k+16))));
+        _mm256_storeu_si256((__m256i*)(wcs+k+24), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(u+k+24))));
+        if ((mask = (unsigned int)_mm256_movemask_epi8(v)) != 0)
+            return k + __builtin_ctz(mask);
+    }
+    return k + u8_ascii_sse4(u+k, n-k, wcs+k);
+}
+
+/*-- Keiser-Lemire error classes (1 bit each) for (byte1_high, byte1_low, byte2_high) lookups */
+#define U8KL_TOO_SHORT   (1<<0) //-- 11______ 0_______ | 11______ 11______
+#define U8KL_TOO_LONG    (1<<1) //-- 0_______ 10______
+#define U8KL_OVERLONG_3  (1<<2) //-- 11100000 100_____
+#define U8KL_TOO_LARGE   (1<<3) //-- 11110100 1001____ | 11110100 101_____ | 11110101+ 10______
+#define U8KL_SURROGATE   (1<<4) //-- 11101101 101_____
+#define U8KL_OVERLONG_2  (1<<5) //-- 1100000_ 10______
+#define U8KL_TOO_LARGE_1000 (1<<6) //-- 11110101+ 1000____
+#define U8KL_OVERLONG_4  (1<<6) //-- 11110000 1000____
+#define U8KL_TWO_CONTS   (1<<7) //-- 10______ 10______
+#define U8KL_CARRY       (U8KL_TOO_SHORT|U8KL_TOO_LONG|U8KL_TWO_CONTS)
+
+#define U8KL_BYTE1_HIGH \
+    U8KL_TOO_LONG, U8KL_TOO_LONG, U8KL_TOO_LONG, U8KL_TOO_LONG, \
+    U8KL_TOO_LONG, U8KL_TOO_LONG, U8KL_TOO_LONG, U8KL_TOO_LONG, \
+    U8KL_TWO_CONTS, U8KL_TWO_CONTS, U8KL_TWO_CONTS, U8KL_TWO_CONTS, \
+    U8KL_TOO_SHORT|U8KL_OVERLONG_2, \
+    U8KL_TOO_SHORT, \
+    U8KL_TOO_SHORT|U8KL_OVERLONG_3|U8KL_SURROGATE, \
+    U8KL_TOO_SHORT|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000|U8KL_OVERLONG_4
+
+#define U8KL_BYTE1_LOW \
+    U8KL_CARRY|U8KL_OVERLONG_3|U8KL_OVERLONG_2|U8KL_OVERLONG_4, \
+    U8KL_CARRY|U8KL_OVERLONG_2, \
+    U8KL_CARRY, \
+    U8KL_CARRY, \
+    U8KL_CARRY|U8KL_TOO_LARGE, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000|U8KL_SURROGATE, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000, \
+    U8KL_CARRY|U8KL_TOO_LARGE|U8KL_TOO_LARGE_1000
+
+#define U8KL_BYTE2_HIGH \
+    U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT, \
+    U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT, \
+    U8KL_TOO_LONG|U8KL_OVERLONG_2|U8KL_TWO_CONTS|U8KL_OVERLONG_3|U8KL_TOO_LARGE_1000|U8KL_OVERLONG_4, \
+    U8KL_TOO_LONG|U8KL_OVERLONG_2|U8KL_TWO_CONTS|U8KL_OVERLONG_3|U8KL_TOO_LARGE, \
+    U8KL_TOO_LONG|U8KL_OVERLONG_2|U8KL_TWO_CONTS|U8KL_SURROGATE|U8KL_TOO_LARGE, \
+    U8KL_TOO_LONG|U8KL_OVERLONG_2|U8KL_TWO_CONTS|U8KL_SURROGATE|U8KL_TOO_LARGE, \
+    U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT, U8KL_TOO_SHORT
+
+/*-- u8_validate_resume(): locate 1st error once a SIMD kernel flagged the block at offset k
+ *   + earlier blocks passed, so only a sequence whose lead byte is among the 3 bytes before k
+ *     can be involved: rescan from that lead byte (if any) with the scalar validator */
+static int u8_validate_resume(const unsigned char *u, int n, int k)
+{
+    int p = k, q, rc;
+    for (q=k-1; q >= 0 && q >= k-3; q--) {
+        if (u[q] < 0x80) break;             //-- ASCII: no sequence spans the block boundary
+        if (u[q] >= 0xC0) { p = q; break; } //-- lead byte: sequence may span the block boundary
+    }
+    rc = u8_validate_scalar(u+p, n-p);
+    return rc < 0 ? -1 : p+rc;
+}
+
+/*-- SSE4: validate in 16-byte blocks */
+__attribute__((target("ssse3,sse4.1")))
+static int u8_validate_sse4(const unsigned char *u, int n)
+{
+    const __m128i tb1h = _mm_setr_epi8(U8KL_BYTE1_HIGH);
+    const __m128i tb1l = _mm_setr_epi8(U8KL_BYTE1_LOW);
+    const __m128i tb2h = _mm_setr_epi8(U8KL_BYTE2_HIGH);
+    const __m128i nib  = _mm_set1_epi8(0x0F);
+    const __m128i maxv = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                       (char)(0xF0-1),(char)(0xE0-1),(char)(0xC0-1));
+    __m128i prev = _mm_setzero_si128(), prev_incomplete = _mm_setzero_si128();
+    unsigned char tail[16];
+    int k, blk = 0;
+
+    for (k=0; k < n; k += 16) {
+        __m128i v, err;
+        if (n-k >= 16) {
+            v = _mm_loadu_si128((const __m128i*)(u+k));
+        } else {
+            memset(tail, 0, sizeof(tail)); //-- pad with NUL (ASCII): flags sequences truncated at end-of-buffer
+            memcpy(tail, u+k, n-k);
+            v = _mm_loadu_si128((const __m128i*)tail);
+        }
+        blk = k;
+        if (_mm_movemask_epi8(v) == 0) {
+            //-- ASCII block: only an incomplete sequence at the end of the previous block is an error
+            err = prev_incomplete;
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(v, prev, 15);
+            __m128i prev2 = _mm_alignr_epi8(v, prev, 14);
+            __m128i prev3 = _mm_alignr_epi8(v, prev, 13);
+            __m128i b1h = _mm_shuffle_epi8(tb1h, _mm_and_si128(_mm_srli_epi16(prev1,4), nib));
+            __m128i b1l = _mm_shuffle_epi8(tb1l, _mm_and_si128(prev1, nib));
+            __m128i b2h = _mm_shuffle_epi8(tb2h, _mm_and_si128(_mm_srli_epi16(v,4), nib));
+            __m128i sc  = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+            __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0-0x80))),
+                                          _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0-0x80))));
+            err = _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8((char)0x80)), sc);
+            prev_incomplete = _mm_subs_epu8(v, maxv);
+        }
+        if (!_mm_testz_si128(err, err))
+            return u8_validate_resume(u, n, blk);
+        prev = v;
+    }
+    if (!_mm_testz_si128(prev_incomplete, prev_incomplete))
+        return u8_validate_resume(u, n, blk);
+    return -1;
+}
+
+/*-- AVX2: validate in 32-byte blocks */
+__attribute__((target("avx2")))
+static int u8_validate_avx2(const unsigned char *u, int n)
+{
+    const __m256i tb1h = _mm256_setr_epi8(U8KL_BYTE1_HIGH, U8KL_BYTE1_HIGH);
+    const __m256i tb1l = _mm256_setr_epi8(U8KL_BYTE1_LOW, U8KL_BYTE1_LOW);
+    const __m256i tb2h = _mm256_setr_epi8(U8KL_BYTE2_HIGH, U8KL_BYTE2_HIGH);
+    const __m256i nib  = _mm256_set1_epi8(0x0F);
+    const __m256i maxv = _mm256_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                          -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                          (char)(0xF0-1),(char)(0xE0-1),(char)(0xC0-1));
+    __m256i prev = _mm256_setzero_si256(), prev_incomplete = _mm256_setzero_si256();
+    unsigned char tail[32];
+    int k, blk = 0;
+
+    for (k=0; k < n; k += 32) {
+        __m256i v, err;
+        if (n-k >= 32) {
+            v = _mm256_loadu_si256((const __m256i*)(u+k));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, u+k, n-k);
+            v = _mm256_loadu_si256((const __m256i*)tail);
+        }
+        blk = k;
+        if (_mm256_movemask_epi8(v) == 0) {
+            err = prev_incomplete;
+        } else {
+            //-- shift across the 128-bit lane boundary: combine with (prev.hi, v.lo)
+            __m256i pv    = _mm256_permute2x128_si256(prev, v, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(v, pv, 15);
+            __m256i prev2 = _mm256_alignr_epi8(v, pv, 14);
+            __m256i prev3 = _mm256_alignr_epi8(v, pv, 13);
+            __m256i b1h = _mm256_shuffle_epi8(tb1h, _mm256_and_si256(_mm256_srli_epi16(prev1,4), nib));
+            __m256i b1l = _mm256_shuffle_epi8(tb1l, _mm256_and_si256(prev1, nib));
+            __m256i b2h = _mm256_shuffle_epi8(tb2h, _mm256_and_si256(_mm256_srli_epi16(v,4), nib));
+            __m256i sc  = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+            __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0-0x80))),
+                                             _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0-0x80))));
+            err = _mm256_xor_si256(_mm256_and_si256(must23, _mm256_set1_epi8((char)0x80)), sc);
+            prev_incomplete = _mm256_subs_epu8(v, maxv);
+        }
+        if (!_mm256_testz_si256(err, err))
+            return u8_validate_resume(u, n, blk);
+        prev = v;
+    }
+    if (!_mm256_testz_si256(prev_incomplete, prev_incomplete))
+        return u8_validate_resume(u, n, blk);
+    return -1;
+}
+
+#endif /* U8_HAVE_X86_SIMD */
+
+/*-- runtime dispatch */
+static int (*u8_ascii_impl)(const unsigned char *u, int n, uint32_t *wcs) = NULL;
+static int (*u8_validate_impl)(const unsigned char *u, int n) = NULL;
+
+u8SimdLevel u8_simd_init(u8SimdLevel level)
+{
+    u8SimdLevel maxlevel = U8_SIMD_SCALAR;
+#ifdef U8_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        maxlevel = U8_SIMD_AVX2;
+    else if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1"))
+        maxlevel = U8_SIMD_SSE4;
+#endif
+    if (level < 0 || level > maxlevel)
+        level = maxlevel;
+
+    switch (level) {
+#ifdef U8_HAVE_X86_SIMD
+    case U8_SIMD_AVX2:
+        u8_validate_impl = u8_validate_avx2;
+        u8_ascii_impl    = u8_ascii_avx2;
+        break;
+    case U8_SIMD_SSE4:
+        u8_validate_impl = u8_validate_sse4;
+        u8_ascii_impl    = u8_ascii_sse4;
+        break;
+#endif
+    default:
+        level = U8_SIMD_SCALAR;
+        u8_validate_impl = u8_validate_scalar;
+        u8_ascii_impl    = u8_ascii_scalar;
+        break;
+    }
+    return level;
+}
+
+const char *u8_simd_name(u8SimdLevel level)
+{
+    switch (level) {
+    case U8_SIMD_AVX2:   return "avx2";
+    case U8_SIMD_SSE4:   return "sse4";
+    case U8_SIMD_SCALAR: return "scalar";
+    default: break;
+    }
+    return "auto";
+}
+
+int u8_decoden(const char *s, int slen, int *i, uint32_t *wcs, uchar *lens, int maxc, int *nerrs)
+{
+    const unsigned char *u = (const unsigned char*)s;
+    int pos = *i, nc = 0, len, k;
+    uint32_t ch;
+
+    if (!u8_ascii_impl) u8_simd_init(U8_SIMD_AUTO);
+
+    while (nc < maxc && pos < slen) {
+        if (u[pos] < 0x80) {
+            //-- ASCII run: vectorised
+            k = maxc-nc < slen-pos ? maxc-nc : slen-pos;
+            k = u8_ascii_impl(u+pos, k, wcs+nc);
+            if (lens) memset(lens+nc, 1, k);
+            nc  += k;
+            pos += k;
+            continue;
+        }
+        if (!(len = u8_decode1(u+pos, slen-pos, &ch))) {
+            ch  = U8_REPLACEMENT_CHAR;
+            len = 1;
+            if (nerrs) ++(*nerrs);
+        }
+        wcs[nc] = ch;
+        if (lens) lens[nc] = (uchar)len;
+        ++nc;
+        pos += len;
+    }
+    *i = pos;
+    return nc;
+}
+
+int u8_validate(const char *s, int slen)
+{
+    if (!u8_validate_impl) u8_simd_init(U8_SIMD_AUTO);
+    return u8_validate_impl((const unsigned char*)s, slen);
+}
+
 
 
 /* number of characters */
@@ -94,6 +94,48 @@ uint32_t u8_peek(const char *s);
 /** (moo): return next character; uses buffer length */
 uint32_t u8_peekn(const char *s, int slen);
 
+/** (moo): replacement character returned by u8_decoden() for invalid UTF-8 */
+#define U8_REPLACEMENT_CHAR 0xFFFD
+
+/** (moo): SIMD levels for u8_decoden(), u8_validate() (see u8_simd_init()) */
+typedef enum {
+  U8_SIMD_AUTO   = -1,  /**< best level supported by the CPU */
+  U8_SIMD_SCALAR = 0,   /**< portable scalar code */
+  U8_SIMD_SSE4   = 1,   /**< x86 SSSE3 + SSE4.1 (16-byte blocks) */
+  U8_SIMD_AVX2   = 2    /**< x86 AVX2 (32-byte blocks) */
+} u8SimdLevel;
+
+/** (moo): select implementation for u8_decoden(), u8_validate()
+ * \param level requested level, or U8_SIMD_AUTO for the best supported level
+ * \returns level actually selected: requested level is clamped to what the CPU supports (runtime check)
+ * \li called implicitly with U8_SIMD_AUTO on first use; only needed to force a lower level (e.g. for benchmarks)
+ * \li compile with -DDTATW_NO_SIMD to build scalar code only
+ */
+u8SimdLevel u8_simd_init(u8SimdLevel level);
+
+/** (moo): get name of SIMD level \a level ("scalar", "sse4", "avx2") */
+const char *u8_simd_name(u8SimdLevel level);
+
+/** (moo): bulk decode with validation
+ * \param s UTF-8 buffer
+ * \param slen byte length of \a s
+ * \param i byte index at which to start decoding; updated to index of 1st undecoded byte
+ * \param wcs output: decoded code points (at least \a maxc elements)
+ * \param lens output: byte length of each decoded character (at least \a maxc elements), or NULL
+ * \param maxc maximum number of characters to decode
+ * \param nerrs if non-NULL, incremented for each invalid or truncated sequence
+ * \returns number of characters decoded (0 <= RETVAL <= \a maxc)
+ * \li invalid sequences (stray continuation bytes, overlong forms, surrogates, code points > 0x10FFFF, truncated sequences)
+ *     decode as U8_REPLACEMENT_CHAR with length 1
+ * \li uses a vectorised ASCII fast path (see u8_simd_init())
+ */
+int u8_decoden(const char *s, int slen, int *i, uint32_t *wcs, uchar *lens, int maxc, int *nerrs);
+
+/** (moo): validate UTF-8
+ * \returns byte offset of the 1st invalid or truncated sequence in \a s[0:slen], or -1 if \a s is valid UTF-8
+ */
+int u8_validate(const char *s, int slen);
+
 /** move to next character */
 void u8_inc(const char *s, int *i);
 
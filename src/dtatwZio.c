@@ -0,0 +1,1138 @@
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE 1  //-- for fopencookie()
+#endif
+#include "dtatwZio.h"
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_LIBPTHREAD)
+# include <pthread.h>
+# define ZIO_THREADS 1
+#endif
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+# include <zlib.h>
+# define ZIO_GZIP 1
+#endif
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+# include <zstd.h>
+# define ZIO_ZSTD 1
+#endif
+
+/*======================================================================
+ * zio: formats
+ */
+
+const char *zioFormatNames[3] = {"raw","gzip","zstd"};
+
+//--------------------------------------------------------------
+zioFormat zio_detect(const unsigned char *buf, size_t len)
+{
+  if (len >= 2 && buf[0]==0x1f && buf[1]==0x8b)
+    return zioGzip;
+  if (len >= 4 && buf[0]==0x28 && buf[1]==0xb5 && buf[2]==0x2f && buf[3]==0xfd)
+    return zioZstd;
+  return zioRaw;
+}
+
+//--------------------------------------------------------------
+zioFormat zio_sniff(FILE *f)
+{
+  unsigned char magic[ZIO_MAGIC_LEN];
+  off_t pos = ftello(f);
+  size_t len;
+  if (pos < 0) return zioRaw;
+  len = fread(magic, 1, ZIO_MAGIC_LEN, f);
+  clearerr(f);
+  fseeko(f, pos, SEEK_SET);
+  return zio_detect(magic, len);
+}
+
+//--------------------------------------------------------------
+int zio_supported(zioFormat fmt)
+{
+  switch (fmt) {
+  case zioRaw:  return 1;
+#ifdef ZIO_GZIP
+  case zioGzip: return 1;
+#endif
+#ifdef ZIO_ZSTD
+  case zioZstd: return 1;
+#endif
+  default: break;
+  }
+  return 0;
+}
+
+/*======================================================================
+ * zio: reader: types
+ */
+
+struct zioReader_ {
+  FILE         *f;                   //-- underlying (compressed) stream
+  const char   *filename;            //-- for error messages
+  zioFormat     fmt;                 //-- compression format
+  dtatwError    err;                 //-- error status (set by decoder or raw reads)
+  int           eof;                 //-- consumer: end of uncompressed stream (or error) reached
+
+  //-- sniffed magic bytes (not yet consumed)
+  unsigned char head[ZIO_MAGIC_LEN];
+  size_t        headlen;
+  size_t        headpos;
+
+  //-- decoder (producer) state
+  unsigned char *inbuf;              //-- compressed input buffer (ZIO_BUFSIZE bytes)
+  int           in_eof;              //-- no more compressed input
+  int           zdone;               //-- decoder: end of (last) compressed stream reached
+#ifdef ZIO_GZIP
+  z_stream      zs;
+  int           zs_init;
+#endif
+#ifdef ZIO_ZSTD
+  ZSTD_DStream *zds;
+  ZSTD_inBuffer zin;
+  size_t        zpending;            //-- last ZSTD_decompressStream() hint with progress: 0 iff at a frame boundary
+#endif
+
+  //-- ring of decompressed buffers: producer fills ring[rhead], consumer drains ring[rtail]
+  char         *ring[ZIO_NBUFS];
+  size_t        ringlen[ZIO_NBUFS];
+  int           rhead;
+  int           rtail;
+  int           rcount;              //-- number of filled buffers
+  size_t        rpos;                //-- consumer read offset in ring[rtail]
+  int           rcur;                //-- consumer: true iff ring[rtail] is being drained
+  int           done;                //-- producer finished (EOF or error)
+  int           abort;               //-- consumer closed before EOF
+#ifdef ZIO_THREADS
+  int             threaded;
+  pthread_t       thr;
+  pthread_mutex_t mu;
+  pthread_cond_t  cv;                //-- signalled on any change of rcount, done, abort
+#endif
+};
+
+/*======================================================================
+ * zio: reader: decoding (producer)
+ */
+
+//--------------------------------------------------------------
+// n = zio_raw_read(zr,buf,len)
+//  + reads from sniffed head bytes, then from zr->f
+static size_t zio_raw_read(zioReader *zr, void *buf, size_t len)
+{
+  size_t n = 0;
+  if (zr->headpos < zr->headlen) {
+    n = zr->headlen - zr->headpos;
+    if (n > len) n = len;
+    memcpy(buf, zr->head + zr->headpos, n);
+    zr->headpos += n;
+  }
+  if (n < len) n += fread((char*)buf + n, 1, len-n, zr->f);
+  return n;
+}
+
+//--------------------------------------------------------------
+// n = zio_refill(zr)
+//  + reads next block of compressed input into zr->inbuf; sets zr->in_eof and maybe zr->err
+static size_t zio_refill(zioReader *zr)
+{
+  size_t n = zio_raw_read(zr, zr->inbuf, ZIO_BUFSIZE);
+  if (n == 0) {
+    zr->in_eof = 1;
+    if (ferror(zr->f))
+      dtatw_error(&zr->err, 2, "I/O error: %s", strerror(errno));
+  }
+  return n;
+}
+
+#ifdef ZIO_GZIP
+//--------------------------------------------------------------
+static size_t zio_decode_gzip(zioReader *zr, char *out, size_t outsize)
+{
+  int rc;
+  uInt before;
+  zr->zs.next_out  = (Bytef*)out;
+  zr->zs.avail_out = (uInt)outsize;
+  while (zr->zs.avail_out > 0 && !zr->zdone && !zr->err.code) {
+    if (zr->zs.avail_in == 0 && !zr->in_eof) {
+      zr->zs.next_in  = zr->inbuf;
+      zr->zs.avail_in = (uInt)zio_refill(zr);
+    }
+    before = zr->zs.avail_out;
+    rc = inflate(&zr->zs, Z_NO_FLUSH);
+    if (rc == Z_STREAM_END) {
+      //-- end of gzip member: continue with the next member (as for `cat a.gz b.gz`), ignore trailing garbage
+      if (zr->zs.avail_in == 0 && !zr->in_eof) {
+	zr->zs.next_in  = zr->inbuf;
+	zr->zs.avail_in = (uInt)zio_refill(zr);
+      }
+      if (zr->zs.avail_in == 0 || zr->zs.next_in[0] != 0x1f) {
+	zr->zdone = 1;
+	break;
+      }
+      inflateReset(&zr->zs);
+    }
+    else if (rc == Z_OK || rc == Z_BUF_ERROR) {
+      if (zr->in_eof && zr->zs.avail_in == 0 && zr->zs.avail_out == before && !zr->err.code)
+	dtatw_error(&zr->err, 2, "gzip error: unexpected end of compressed data");
+    }
+    else {
+      dtatw_error(&zr->err, 2, "gzip error: %s", zr->zs.msg ? zr->zs.msg : "inflate() failed");
+    }
+  }
+  return outsize - zr->zs.avail_out;
+}
+#endif /* ZIO_GZIP */
+
+#ifdef ZIO_ZSTD
+//--------------------------------------------------------------
+static size_t zio_decode_zstd(zioReader *zr, char *out, size_t outsize)
+{
+  ZSTD_outBuffer zout = {out, outsize, 0};
+  size_t rc, before, inbefore;
+  while (zout.pos < zout.size && !zr->zdone && !zr->err.code) {
+    if (zr->zin.pos == zr->zin.size && !zr->in_eof) {
+      zr->zin.src  = zr->inbuf;
+      zr->zin.size = zio_refill(zr);
+      zr->zin.pos  = 0;
+    }
+    before   = zout.pos;
+    inbefore = zr->zin.pos;
+    rc = ZSTD_decompressStream(zr->zds, &zout, &zr->zin);
+    if (ZSTD_isError(rc)) {
+      dtatw_error(&zr->err, 2, "zstd error: %s", ZSTD_getErrorName(rc));
+    }
+    else if (zout.pos != before || zr->zin.pos != inbefore) {
+      zr->zpending = rc;
+    }
+    else if (zr->in_eof) {
+      //-- no more input and no more buffered output: complete iff the last frame was finished
+      if (zr->zpending != 0 && !zr->err.code)
+	dtatw_error(&zr->err, 2, "zstd error: unexpected end of compressed data");
+      zr->zdone = 1;
+    }
+  }
+  return zout.pos;
+}
+#endif /* ZIO_ZSTD */
+
+//--------------------------------------------------------------
+// n = zio_decode(zr,out,outsize)
+//  + decompresses up to outsize bytes into out; short counts only at end of stream or on error
+static size_t zio_decode(zioReader *zr, char *out, size_t outsize)
+{
+  switch (zr->fmt) {
+#ifdef ZIO_GZIP
+  case zioGzip: return zio_decode_gzip(zr, out, outsize);
+#endif
+#ifdef ZIO_ZSTD
+  case zioZstd: return zio_decode_zstd(zr, out, outsize);
+#endif
+  default: break;
+  }
+  return 0;
+}
+
+#ifdef ZIO_THREADS
+//--------------------------------------------------------------
+// zio_producer(zr)
+//  + decompression thread: fills ring buffers until end of stream, error, or abort
+static void *zio_producer(void *arg)
+{
+  zioReader *zr = (zioReader*)arg;
+  int slot;
+  size_t n;
+  for (;;) {
+    pthread_mutex_lock(&zr->mu);
+    while (zr->rcount == ZIO_NBUFS && !zr->abort)
+      pthread_cond_wait(&zr->cv, &zr->mu);
+    if (zr->abort) {
+      pthread_mutex_unlock(&zr->mu);
+      break;
+    }
+    slot = zr->rhead;
+    pthread_mutex_unlock(&zr->mu);
+
+    n = zio_decode(zr, zr->ring[slot], ZIO_BUFSIZE);
+
+    pthread_mutex_lock(&zr->mu);
+    if (n > 0) {
+      zr->ringlen[slot] = n;
+      zr->rhead = (zr->rhead+1) % ZIO_NBUFS;
+      zr->rcount++;
+    }
+    if (n < ZIO_BUFSIZE || zr->zdone || zr->err.code)
+      zr->done = 1;
+    pthread_cond_broadcast(&zr->cv);
+    pthread_mutex_unlock(&zr->mu);
+    if (zr->done) break;
+  }
+  return NULL;
+}
+#endif /* ZIO_THREADS */
+
+/*======================================================================
+ * zio: reader: API
+ */
+
+//--------------------------------------------------------------
+zioReader *zio_open(FILE *f, const char *filename, dtatwError *err)
+{
+  zioReader *zr = (zioReader*)calloc(1, sizeof(zioReader));
+  int i;
+  assert2(zr != NULL, "calloc failed for zioReader");
+  zr->f        = f;
+  zr->filename = filename;
+  zr->headlen  = fread(zr->head, 1, ZIO_MAGIC_LEN, f);
+  zr->fmt      = zio_detect(zr->head, zr->headlen);
+  if (zr->fmt == zioRaw) return zr;
+
+  if (!zio_supported(zr->fmt)) {
+    dtatw_error(err, 2, "`%s': %s-compressed input is not supported by this build of %s",
+		(filename ? filename : "?"), (zr->fmt == zioGzip ? "gzip" : "zstd"), PACKAGE);
+    free(zr);
+    return NULL;
+  }
+
+  //-- compressed: allocate buffers
+  zr->inbuf = (unsigned char*)malloc(ZIO_BUFSIZE);
+  assert2(zr->inbuf != NULL, "malloc failed for zio input buffer");
+  for (i=0; i < ZIO_NBUFS; i++) {
+    zr->ring[i] = (char*)malloc(ZIO_BUFSIZE);
+    assert2(zr->ring[i] != NULL, "malloc failed for zio ring buffer");
+  }
+  dtatw_stats_alloc((ZIO_NBUFS+1) * ZIO_BUFSIZE);
+
+  //-- compressed: initialize decoder
+#ifdef ZIO_GZIP
+  if (zr->fmt == zioGzip) {
+    if (inflateInit2(&zr->zs, 15+16) != Z_OK) {
+      dtatw_error(err, 2, "`%s': gzip error: inflateInit2() failed", (filename ? filename : "?"));
+      zio_close(zr);
+      return NULL;
+    }
+    zr->zs_init = 1;
+  }
+#endif
+#ifdef ZIO_ZSTD
+  if (zr->fmt == zioZstd) {
+    zr->zpending = 1;
+    if (!(zr->zds = ZSTD_createDStream()) || ZSTD_isError(ZSTD_initDStream(zr->zds))) {
+      dtatw_error(err, 2, "`%s': zstd error: ZSTD_initDStream() failed", (filename ? filename : "?"));
+      zio_close(zr);
+      return NULL;
+    }
+  }
+#endif
+
+  //-- compressed: start decompression thread
+#ifdef ZIO_THREADS
+  pthread_mutex_init(&zr->mu, NULL);
+  pthread_cond_init(&zr->cv, NULL);
+  zr->threaded = (pthread_create(&zr->thr, NULL, zio_producer, zr) == 0);
+  if (!zr->threaded) {
+    pthread_mutex_destroy(&zr->mu);
+    pthread_cond_destroy(&zr->cv);
+  }
+#endif
+
+  return zr;
+}
+
+//--------------------------------------------------------------
+// bool = zio_next_buffer(zr)
+//  + consumer: releases current ring buffer (if any) and waits for the next one; false at end of stream
+static int zio_next_buffer(zioReader *zr)
+{
+#ifdef ZIO_THREADS
+  if (zr->threaded) {
+    pthread_mutex_lock(&zr->mu);
+    if (zr->rcur) {
+      zr->rtail = (zr->rtail+1) % ZIO_NBUFS;
+      zr->rcount--;
+      zr->rcur = 0;
+      pthread_cond_broadcast(&zr->cv);
+    }
+    while (zr->rcount == 0 && !zr->done)
+      pthread_cond_wait(&zr->cv, &zr->mu);
+    zr->rcur = (zr->rcount > 0);
+    pthread_mutex_unlock(&zr->mu);
+    zr->rpos = 0;
+    return zr->rcur;
+  }
+#endif
+  //-- unthreaded: decode on demand into ring[0]
+  zr->rtail = 0;
+  zr->rpos  = 0;
+  zr->rcur  = 0;
+  if (zr->done) return 0;
+  zr->ringlen[0] = zio_decode(zr, zr->ring[0], ZIO_BUFSIZE);
+  if (zr->ringlen[0] < ZIO_BUFSIZE || zr->zdone || zr->err.code) zr->done = 1;
+  zr->rcur = (zr->ringlen[0] > 0);
+  return zr->rcur;
+}
+
+//--------------------------------------------------------------
+size_t zio_read(zioReader *zr, void *buf, size_t len)
+{
+  size_t got = 0, n;
+  if (zr->eof) return 0;
+
+  if (zr->fmt == zioRaw) {
+    got = zio_raw_read(zr, buf, len);
+    if (got < len) {
+      zr->eof = 1;
+      if (ferror(zr->f)) dtatw_error(&zr->err, 2, "I/O error: %s", strerror(errno));
+    }
+    return got;
+  }
+
+  while (got < len) {
+    if (!zr->rcur || zr->rpos == zr->ringlen[zr->rtail]) {
+      if (!zio_next_buffer(zr)) {
+	zr->eof = 1;
+	break;
+      }
+    }
+    n = zr->ringlen[zr->rtail] - zr->rpos;
+    if (n > len-got) n = len-got;
+    memcpy((char*)buf + got, zr->ring[zr->rtail] + zr->rpos, n);
+    zr->rpos += n;
+    got      += n;
+  }
+  return got;
+}
+
+//--------------------------------------------------------------
+int zio_eof(const zioReader *zr)
+{
+  return zr->eof;
+}
+
+//--------------------------------------------------------------
+int zio_error(const zioReader *zr)
+{
+  //-- decoder errors are only reported once the consumer has drained all data decoded before the error
+  return zr->eof ? zr->err.code : 0;
+}
+
+const char *zio_errmsg(const zioReader *zr)
+{
+  return zr->err.msg;
+}
+
+zioFormat zio_format(const zioReader *zr)
+{
+  return zr->fmt;
+}
+
+//--------------------------------------------------------------
+size_t zio_slurp(zioReader *zr, char **bufp)
+{
+  size_t len = 0, alloc = ZIO_BUFSIZE, n;
+  char *buf = (char*)malloc(alloc);
+  assert2(buf != NULL, "malloc failed in zio_slurp()");
+  while ((n = zio_read(zr, buf+len, alloc-len)) > 0) {
+    len += n;
+    if (len == alloc) {
+      alloc *= 2;
+      buf = (char*)realloc(buf, alloc);
+      assert2(buf != NULL, "realloc failed in zio_slurp()");
+    }
+    if (zio_eof(zr)) break;
+  }
+  dtatw_stats_alloc(alloc);
+  if (zio_error(zr)) {
+    free(buf);
+    buf = NULL;
+    len = 0;
+  }
+  *bufp = buf;
+  return len;
+}
+
+//--------------------------------------------------------------
+void zio_close(zioReader *zr)
+{
+  int i;
+  if (!zr) return;
+#ifdef ZIO_THREADS
+  if (zr->threaded) {
+    pthread_mutex_lock(&zr->mu);
+    zr->abort = 1;
+    pthread_cond_broadcast(&zr->cv);
+    pthread_mutex_unlock(&zr->mu);
+    pthread_join(zr->thr, NULL);
+    pthread_mutex_destroy(&zr->mu);
+    pthread_cond_destroy(&zr->cv);
+  }
+#endif
+#ifdef ZIO_GZIP
+  if (zr->zs_init) inflateEnd(&zr->zs);
+#endif
+#ifdef ZIO_ZSTD
+  if (zr->zds) ZSTD_freeDStream(zr->zds);
+#endif
+  for (i=0; i < ZIO_NBUFS; i++) {
+    if (zr->ring[i]) free(zr->ring[i]);
+  }
+  if (zr->inbuf) free(zr->inbuf);
+  free(zr);
+}
+
+//--------------------------------------------------------------
+size_t zio_fslurp(FILE *f, const char *filename, char **bufp, dtatwError *err)
+{
+  zioReader *zr = zio_open(f, filename, err);
+  size_t len;
+  *bufp = NULL;
+  if (!zr) return 0;
+  len = zio_slurp(zr, bufp);
+  if (zio_error(zr))
+    dtatw_error(err, zio_error(zr), "`%s': %s", (filename ? filename : "?"), zio_errmsg(zr));
+  zio_close(zr);
+  return len;
+}
+
+/*======================================================================
+ * zio: writer: types
+ */
+
+zioSpec zio_output = {zioRaw, 0};
+
+struct zioWriter_ {
+  FILE         *f;                   //-- underlying (compressed) stream
+  zioFormat     fmt;                 //-- compression format
+  int           level;               //-- compression level (0: library default)
+  dtatwError    err;                 //-- error status
+  char         *obuf;                //-- compressed output buffer
+  size_t        osize;               //-- allocated size of obuf
+#ifdef ZIO_GZIP
+  z_stream      zs;
+  int           zs_init;
+#endif
+#ifdef ZIO_ZSTD
+  ZSTD_CCtx    *cctx;
+  char         *fbuf;                //-- uncompressed data for the current frame (ZIO_FRAME_SIZE bytes)
+  size_t        flen;                //-- number of bytes used in fbuf
+  uint32_t     *seektab;             //-- seek table: (compressed size, decompressed size) for each frame
+  size_t        nframes;
+  size_t        seekalloc;           //-- allocated number of frames in seektab
+#endif
+};
+
+/*======================================================================
+ * zio: writer: options
+ */
+
+//--------------------------------------------------------------
+int zio_parse_spec(const char *str, zioSpec *spec, dtatwError *err)
+{
+  const char *colon = str ? strchr(str,':') : NULL;
+  size_t len = str ? (colon ? (size_t)(colon-str) : strlen(str)) : 0;
+  char *tail;
+
+  spec->level = 0;
+  if (len==0 || (len==4 && strncmp(str,"none",4)==0) || (len==3 && strncmp(str,"raw",3)==0))
+    spec->fmt = zioRaw;
+  else if ((len==4 && strncmp(str,"gzip",4)==0) || (len==2 && strncmp(str,"gz",2)==0))
+    spec->fmt = zioGzip;
+  else if ((len==4 && strncmp(str,"zstd",4)==0) || (len==3 && strncmp(str,"zst",3)==0))
+    spec->fmt = zioZstd;
+  else
+    return dtatw_error(err, 1, "unknown compression format in `%s' (expected one of zstd, gzip, none)", str);
+
+  if (colon) {
+    spec->level = (int)strtol(colon+1, &tail, 10);
+    if (tail == colon+1 || *tail)
+      return dtatw_error(err, 1, "bad compression level in `%s'", str);
+  }
+
+  if (!zio_supported(spec->fmt))
+    return dtatw_error(err, 1, "%s-compressed output is not supported by this build of %s",
+		       (spec->fmt == zioGzip ? "gzip" : "zstd"), PACKAGE);
+  return 0;
+}
+
+//--------------------------------------------------------------
+int zio_getopt(int *argcp, char **argv)
+{
+  dtatwError err;
+  const char *val;
+  int i, j;
+  memset(&err, 0, sizeof(err));
+  for (i=j=1; i < *argcp; i++) {
+    if (strncmp(argv[i],"--compress=",11)==0)     val = argv[i]+11;
+    else if (strncmp(argv[i],"-compress=",10)==0) val = argv[i]+10;
+    else if (strcmp(argv[i],"--sync-output")==0 || strcmp(argv[i],"-sync-output")==0) {
+      zio_async = 0;
+      continue;
+    }
+    else {
+      argv[j++] = argv[i];
+      continue;
+    }
+    if (zio_parse_spec(val, &zio_output, &err) != 0) dtatw_die(&err);
+  }
+  *argcp = j;
+  argv[j] = NULL;
+  return zio_output.fmt != zioRaw;
+}
+
+/*======================================================================
+ * zio: writer: encoding
+ */
+
+//--------------------------------------------------------------
+// status = zio_wflush(zw,len)
+//  + writes len bytes from zw->obuf to zw->f
+static int zio_wflush(zioWriter *zw, size_t len)
+{
+  if (len > 0 && fwrite(zw->obuf, 1, len, zw->f) != len)
+    return dtatw_error(&zw->err, 2, "I/O error: %s", strerror(errno));
+  return 0;
+}
+
+#ifdef ZIO_GZIP
+//--------------------------------------------------------------
+// status = zio_encode_gzip(zw,buf,len,flush)
+static int zio_encode_gzip(zioWriter *zw, const void *buf, size_t len, int flush)
+{
+  int rc;
+  zw->zs.next_in  = (Bytef*)buf;
+  zw->zs.avail_in = (uInt)len;
+  do {
+    zw->zs.next_out  = (Bytef*)zw->obuf;
+    zw->zs.avail_out = (uInt)zw->osize;
+    rc = deflate(&zw->zs, flush);
+    if (rc == Z_STREAM_ERROR)
+      return dtatw_error(&zw->err, 2, "gzip error: %s", zw->zs.msg ? zw->zs.msg : "deflate() failed");
+    if (zio_wflush(zw, zw->osize - zw->zs.avail_out) != 0) return zw->err.code;
+  } while (zw->zs.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+  return 0;
+}
+#endif /* ZIO_GZIP */
+
+#ifdef ZIO_ZSTD
+//--------------------------------------------------------------
+// zio_put_u32le(p,u)
+static void zio_put_u32le(unsigned char *p, uint32_t u)
+{
+  p[0] =  u        & 0xff;
+  p[1] = (u >>  8) & 0xff;
+  p[2] = (u >> 16) & 0xff;
+  p[3] = (u >> 24) & 0xff;
+}
+
+//--------------------------------------------------------------
+// status = zio_encode_frame(zw)
+//  + compresses zw->fbuf as a single independent zstd frame and records it in the seek table
+static int zio_encode_frame(zioWriter *zw)
+{
+  size_t csize = ZSTD_compressCCtx(zw->cctx, zw->obuf, zw->osize, zw->fbuf, zw->flen, zw->level);
+  if (ZSTD_isError(csize))
+    return dtatw_error(&zw->err, 2, "zstd error: %s", ZSTD_getErrorName(csize));
+  if (zio_wflush(zw, csize) != 0) return zw->err.code;
+  if (zw->nframes == zw->seekalloc) {
+    zw->seekalloc = zw->seekalloc ? 2*zw->seekalloc : 64;
+    zw->seektab = (uint32_t*)realloc(zw->seektab, 2*zw->seekalloc*sizeof(uint32_t));
+    assert2(zw->seektab != NULL, "realloc failed for zstd seek table");
+  }
+  zw->seektab[2*zw->nframes]   = (uint32_t)csize;
+  zw->seektab[2*zw->nframes+1] = (uint32_t)zw->flen;
+  zw->nframes++;
+  zw->flen = 0;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// status = zio_encode_seektab(zw)
+//  + writes the seek table as a skippable frame (zstd seekable format, without checksums)
+static int zio_encode_seektab(zioWriter *zw)
+{
+  size_t i, len = 8 + 8*zw->nframes + 9;
+  unsigned char *p;
+  if (len > zw->osize) {
+    zw->obuf  = (char*)realloc(zw->obuf, len);
+    assert2(zw->obuf != NULL, "realloc failed for zstd seek table");
+    zw->osize = len;
+  }
+  p = (unsigned char*)zw->obuf;
+  zio_put_u32le(p,   0x184D2A5E);                    //-- skippable frame magic
+  zio_put_u32le(p+4, (uint32_t)(len-8));             //-- skippable frame size
+  for (i=0, p += 8; i < zw->nframes; i++, p += 8) {
+    zio_put_u32le(p,   zw->seektab[2*i]);
+    zio_put_u32le(p+4, zw->seektab[2*i+1]);
+  }
+  zio_put_u32le(p, (uint32_t)zw->nframes);           //-- footer: number of frames
+  p[4] = 0;                                          //-- footer: descriptor (no checksums)
+  zio_put_u32le(p+5, 0x8F92EAB1);                    //-- footer: seekable magic
+  return zio_wflush(zw, len);
+}
+#endif /* ZIO_ZSTD */
+
+/*======================================================================
+ * zio: writer: API
+ */
+
+//--------------------------------------------------------------
+zioWriter *zio_wopen(FILE *f, const zioSpec *spec, const char *filename, dtatwError *err)
+{
+  zioWriter *zw;
+  if (spec->fmt == zioRaw || !zio_supported(spec->fmt)) {
+    dtatw_error(err, 2, "`%s': %s-compressed output is not supported by this build of %s",
+		(filename ? filename : "?"), (spec->fmt == zioGzip ? "gzip" : "zstd"), PACKAGE);
+    return NULL;
+  }
+  zw = (zioWriter*)calloc(1, sizeof(zioWriter));
+  assert2(zw != NULL, "calloc failed for zioWriter");
+  zw->f     = f;
+  zw->fmt   = spec->fmt;
+  zw->level = spec->level;
+
+#ifdef ZIO_GZIP
+  if (zw->fmt == zioGzip) {
+    zw->osize = ZIO_BUFSIZE;
+    if (deflateInit2(&zw->zs, (zw->level ? zw->level : Z_DEFAULT_COMPRESSION), Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      dtatw_error(err, 2, "`%s': gzip error: deflateInit2() failed", (filename ? filename : "?"));
+      free(zw);
+      return NULL;
+    }
+    zw->zs_init = 1;
+  }
+#endif
+#ifdef ZIO_ZSTD
+  if (zw->fmt == zioZstd) {
+    zw->osize = ZSTD_compressBound(ZIO_FRAME_SIZE);
+    zw->fbuf  = (char*)malloc(ZIO_FRAME_SIZE);
+    assert2(zw->fbuf != NULL, "malloc failed for zstd frame buffer");
+    if (!(zw->cctx = ZSTD_createCCtx())) {
+      dtatw_error(err, 2, "`%s': zstd error: ZSTD_createCCtx() failed", (filename ? filename : "?"));
+      free(zw->fbuf);
+      free(zw);
+      return NULL;
+    }
+  }
+#endif
+  zw->obuf = (char*)malloc(zw->osize);
+  assert2(zw->obuf != NULL, "malloc failed for zio output buffer");
+  dtatw_stats_alloc(zw->osize + (zw->fmt == zioZstd ? ZIO_FRAME_SIZE : 0));
+  return zw;
+}
+
+//--------------------------------------------------------------
+size_t zio_write(zioWriter *zw, const void *buf, size_t len)
+{
+  if (zw->err.code) return 0;
+  switch (zw->fmt) {
+#ifdef ZIO_GZIP
+  case zioGzip:
+    if (zio_encode_gzip(zw, buf, len, Z_NO_FLUSH) != 0) return 0;
+    return len;
+#endif
+#ifdef ZIO_ZSTD
+  case zioZstd: {
+    size_t done = 0, n;
+    while (done < len) {
+      n = ZIO_FRAME_SIZE - zw->flen;
+      if (n > len-done) n = len-done;
+      memcpy(zw->fbuf + zw->flen, (const char*)buf + done, n);
+      zw->flen += n;
+      done     += n;
+      if (zw->flen == ZIO_FRAME_SIZE && zio_encode_frame(zw) != 0) return 0;
+    }
+    return len;
+  }
+#endif
+  default: break;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+int zio_werror(const zioWriter *zw)
+{
+  return zw->err.code;
+}
+
+const char *zio_werrmsg(const zioWriter *zw)
+{
+  return zw->err.msg;
+}
+
+//--------------------------------------------------------------
+int zio_wclose(zioWriter *zw, dtatwError *err)
+{
+  int status;
+  if (!zw) return 0;
+#ifdef ZIO_GZIP
+  if (zw->fmt == zioGzip && zw->zs_init) {
+    if (!zw->err.code) zio_encode_gzip(zw, NULL, 0, Z_FINISH);
+    deflateEnd(&zw->zs);
+  }
+#endif
+#ifdef ZIO_ZSTD
+  if (zw->fmt == zioZstd) {
+    //-- always write at least one frame, so that the output starts with the zstd magic
+    if (!zw->err.code && (zw->flen > 0 || zw->nframes == 0)) zio_encode_frame(zw);
+    if (!zw->err.code) zio_encode_seektab(zw);
+    if (zw->cctx)    ZSTD_freeCCtx(zw->cctx);
+    if (zw->fbuf)    free(zw->fbuf);
+    if (zw->seektab) free(zw->seektab);
+  }
+#endif
+  if (!zw->err.code && fflush(zw->f) != 0)
+    dtatw_error(&zw->err, 2, "I/O error: %s", strerror(errno));
+  status = zw->err.code;
+  if (status && err) *err = zw->err;
+  if (zw->obuf) free(zw->obuf);
+  free(zw);
+  return status;
+}
+
+/*======================================================================
+ * zio: asynchronous output
+ */
+
+int zio_async = 1;
+
+typedef struct zioAsync_ zioAsync;
+
+#if defined(HAVE_FOPENCOOKIE) && defined(ZIO_THREADS)
+# define ZIO_ASYNC 1
+
+struct zioAsync_ {
+  FILE           *f;                 //-- underlying stream
+  char           *ring[ZIO_NBUFS];   //-- producer fills ring[whead], writer thread drains ring[wtail]
+  size_t          ringlen[ZIO_NBUFS];
+  int             whead;
+  int             wtail;
+  int             wcount;            //-- number of full buffers waiting to be written
+  size_t          wpos;              //-- producer write offset in ring[whead]
+  int             done;              //-- producer closed
+  int             werrno;            //-- errno of first failed write (0 if none); later buffers are discarded
+  pthread_t       thr;
+  pthread_mutex_t mu;
+  pthread_cond_t  cv;                //-- signalled on any change of wcount, done
+};
+
+//--------------------------------------------------------------
+// zio_async_writer(za)
+//  + writer thread: writes queued buffers to za->f until the producer is done
+static void *zio_async_writer(void *arg)
+{
+  zioAsync *za = (zioAsync*)arg;
+  int slot, werrno;
+  for (;;) {
+    pthread_mutex_lock(&za->mu);
+    while (za->wcount == 0 && !za->done)
+      pthread_cond_wait(&za->cv, &za->mu);
+    if (za->wcount == 0) {
+      pthread_mutex_unlock(&za->mu);
+      break;
+    }
+    slot   = za->wtail;
+    werrno = za->werrno;
+    pthread_mutex_unlock(&za->mu);
+
+    if (!werrno && fwrite(za->ring[slot], 1, za->ringlen[slot], za->f) != za->ringlen[slot])
+      werrno = (errno ? errno : EIO);
+
+    pthread_mutex_lock(&za->mu);
+    za->werrno = werrno;
+    za->wtail  = (za->wtail+1) % ZIO_NBUFS;
+    za->wcount--;
+    pthread_cond_broadcast(&za->cv);
+    pthread_mutex_unlock(&za->mu);
+  }
+  return NULL;
+}
+
+//--------------------------------------------------------------
+// za = zio_async_open(f)
+//  + allocates buffers and starts the writer thread; returns NULL (with errno set) if the thread could not be created
+static zioAsync *zio_async_open(FILE *f)
+{
+  zioAsync *za = (zioAsync*)calloc(1, sizeof(zioAsync));
+  int i;
+  assert2(za != NULL, "calloc failed for zioAsync");
+  za->f = f;
+  for (i=0; i < ZIO_NBUFS; i++) {
+    za->ring[i] = (char*)malloc(ZIO_ABUFSIZE);
+    assert2(za->ring[i] != NULL, "malloc failed for zio async buffer");
+  }
+  dtatw_stats_alloc(ZIO_NBUFS * ZIO_ABUFSIZE);
+  pthread_mutex_init(&za->mu, NULL);
+  pthread_cond_init(&za->cv, NULL);
+  if ((errno = pthread_create(&za->thr, NULL, zio_async_writer, za)) != 0) {
+    pthread_mutex_destroy(&za->mu);
+    pthread_cond_destroy(&za->cv);
+    for (i=0; i < ZIO_NBUFS; i++) free(za->ring[i]);
+    free(za);
+    return NULL;
+  }
+  return za;
+}
+
+//--------------------------------------------------------------
+// werrno = zio_async_push(za)
+//  + producer: queues ring[whead] (if non-empty) and waits for a free buffer
+//  + returns the writer's errno (0 if no write has failed so far)
+static int zio_async_push(zioAsync *za)
+{
+  int werrno;
+  pthread_mutex_lock(&za->mu);
+  if (za->wpos > 0) {
+    za->ringlen[za->whead] = za->wpos;
+    za->whead = (za->whead+1) % ZIO_NBUFS;
+    za->wcount++;
+    za->wpos  = 0;
+    pthread_cond_broadcast(&za->cv);
+  }
+  while (za->wcount == ZIO_NBUFS)
+    pthread_cond_wait(&za->cv, &za->mu);
+  werrno = za->werrno;
+  pthread_mutex_unlock(&za->mu);
+  return werrno;
+}
+
+//--------------------------------------------------------------
+// werrno = zio_async_write(za,buf,len)
+//  + producer: copies len bytes from buf into the ring, queueing buffers as they fill up
+static int zio_async_write(zioAsync *za, const char *buf, size_t len)
+{
+  size_t n;
+  int werrno;
+  while (len > 0) {
+    n = ZIO_ABUFSIZE - za->wpos;
+    if (n > len) n = len;
+    memcpy(za->ring[za->whead] + za->wpos, buf, n);
+    za->wpos += n;
+    buf      += n;
+    len      -= n;
+    if (za->wpos == ZIO_ABUFSIZE && (werrno = zio_async_push(za)) != 0) return werrno;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// werrno = zio_async_close(za)
+//  + producer: queues pending output, waits for the writer thread to finish, flushes za->f and frees za
+//  + does not close za->f; returns the writer's errno (0 on success)
+static int zio_async_close(zioAsync *za)
+{
+  int i, werrno;
+  zio_async_push(za);
+  pthread_mutex_lock(&za->mu);
+  za->done = 1;
+  pthread_cond_broadcast(&za->cv);
+  pthread_mutex_unlock(&za->mu);
+  pthread_join(za->thr, NULL);
+  werrno = za->werrno;
+  if (!werrno && fflush(za->f) != 0) werrno = (errno ? errno : EIO);
+  pthread_mutex_destroy(&za->mu);
+  pthread_cond_destroy(&za->cv);
+  for (i=0; i < ZIO_NBUFS; i++) free(za->ring[i]);
+  free(za);
+  return werrno;
+}
+#endif /* HAVE_FOPENCOOKIE && ZIO_THREADS */
+
+/*======================================================================
+ * zio: stdio wrappers
+ */
+
+#ifdef HAVE_FOPENCOOKIE
+typedef struct {
+  FILE       *f;         //-- underlying stream
+  char       *filename;  //-- for error messages
+  int         own;       //-- close f on close?
+  zioReader  *zr;        //-- reader (input wrappers)
+  zioWriter  *zw;        //-- writer (output wrappers)
+  zioAsync   *za;        //-- asynchronous writer (async output wrappers)
+  off64_t     pos;       //-- uncompressed position
+  int         reported;  //-- error already reported?
+} zioCookie;
+
+//--------------------------------------------------------------
+// zio_cookie_report(zc,msg)
+//  + reports an error message to stderr (once)
+static void zio_cookie_report(zioCookie *zc, const char *msg)
+{
+  if (zc->reported) return;
+  fprintf(stderr, "%s: `%s': %s\n", (prog ? prog : PACKAGE), zc->filename, msg);
+  zc->reported = 1;
+}
+
+//--------------------------------------------------------------
+static ssize_t zio_cookie_read(void *cookie, char *buf, size_t len)
+{
+  zioCookie *zc = (zioCookie*)cookie;
+  size_t n = zio_read(zc->zr, buf, len);
+  zc->pos += n;
+  if (n == 0 && zio_error(zc->zr)) {
+    zio_cookie_report(zc, zio_errmsg(zc->zr));
+    errno = EIO;
+    return -1;
+  }
+  return (ssize_t)n;
+}
+
+//--------------------------------------------------------------
+static ssize_t zio_cookie_write(void *cookie, const char *buf, size_t len)
+{
+  zioCookie *zc = (zioCookie*)cookie;
+#ifdef ZIO_ASYNC
+  if (zc->za) {
+    int werrno = zio_async_write(zc->za, buf, len);
+    if (werrno) {
+      zio_cookie_report(zc, strerror(werrno));
+      errno = EIO;
+      return -1;
+    }
+    zc->pos += len;
+    return (ssize_t)len;
+  }
+#endif
+  if (zio_write(zc->zw, buf, len) != len) {
+    zio_cookie_report(zc, zio_werrmsg(zc->zw));
+    errno = EIO;
+    return -1;
+  }
+  zc->pos += len;
+  return (ssize_t)len;
+}
+
+//--------------------------------------------------------------
+static int zio_cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+  zioCookie *zc = (zioCookie*)cookie;
+  if (whence == SEEK_CUR && *offset == 0) {
+    //-- ftello()
+    *offset = zc->pos;
+    return 0;
+  }
+  errno = ESPIPE;
+  return -1;
+}
+
+//--------------------------------------------------------------
+static int zio_cookie_close(void *cookie)
+{
+  zioCookie *zc = (zioCookie*)cookie;
+  int status = 0;
+  if (zc->zr) zio_close(zc->zr);
+#ifdef ZIO_ASYNC
+  if (zc->za) {
+    int werrno = zio_async_close(zc->za);
+    if (werrno) {
+      zio_cookie_report(zc, strerror(werrno));
+      status = -1;
+    }
+  }
+#endif
+  if (zc->zw) {
+    dtatwError err;
+    memset(&err, 0, sizeof(err));
+    if (zio_wclose(zc->zw, &err) != 0) {
+      zio_cookie_report(zc, err.msg);
+      status = -1;
+    }
+  }
+  if (zc->own && fclose(zc->f) != 0) status = -1;
+  free(zc->filename);
+  free(zc);
+  return status;
+}
+
+//--------------------------------------------------------------
+// fz = zio_cookie_open(f,filename,own,zr,zw,za,err)
+//  + exactly one of zr, zw, za should be non-NULL; it is freed if the wrapper cannot be created
+static FILE *zio_cookie_open(FILE *f, const char *filename, int own, zioReader *zr, zioWriter *zw, zioAsync *za,
+			     dtatwError *err)
+{
+  cookie_io_functions_t fns = {zio_cookie_read, zio_cookie_write, zio_cookie_seek, zio_cookie_close};
+  zioCookie *zc = (zioCookie*)calloc(1, sizeof(zioCookie));
+  FILE *fz;
+  assert2(zc != NULL, "calloc failed for zio cookie");
+  zc->f        = f;
+  zc->filename = strdup(filename ? filename : "?");
+  zc->own      = own;
+  zc->zr       = zr;
+  zc->zw       = zw;
+  zc->za       = za;
+  if (!(fz = fopencookie(zc, (zr ? "rb" : "wb"), fns))) {
+    dtatw_error(err, 2, "`%s': fopencookie() failed: %s", zc->filename, strerror(errno));
+    if (zr) zio_close(zr);
+    if (zw) zio_wclose(zw, NULL);
+#ifdef ZIO_ASYNC
+    if (za) zio_async_close(za);
+#endif
+    free(zc->filename);
+    free(zc);
+    return NULL;
+  }
+  return fz;
+}
+#endif /* HAVE_FOPENCOOKIE */
+
+//--------------------------------------------------------------
+FILE *zio_fwrap_in(FILE *f, const char *filename, int own, dtatwError *err)
+{
+  zioFormat fmt;
+  int c;
+  if (!f) return f;
+
+  if (ftello(f) >= 0) {
+    //-- seekable: sniff magic
+    if ((fmt = zio_sniff(f)) == zioRaw) return f;
+  } else {
+    //-- pipe: peek at the first byte (cf. zio_detect())
+    if ((c = getc(f)) == EOF) return f;
+    ungetc(c, f);
+    if (c != 0x1f && c != 0x28) return f;
+    fmt = (c == 0x1f ? zioGzip : zioZstd);
+  }
+
+#ifdef HAVE_FOPENCOOKIE
+  {
+    //-- (a pipe starting with a magic-like byte may still turn out to be raw: zio_open() passes it through)
+    zioReader *zr = zio_open(f, filename, err);
+    if (!zr) return NULL;
+    return zio_cookie_open(f, filename, own, zr, NULL, NULL, err);
+  }
+#else
+  dtatw_error(err, 2, "`%s': %s-compressed input is not supported by this build of %s (no fopencookie())",
+	      (filename ? filename : "?"), (fmt == zioZstd ? "zstd" : "gzip"), PACKAGE);
+  return NULL;
+#endif
+}
+
+//--------------------------------------------------------------
+FILE *zio_fwrap_out(FILE *f, const zioSpec *spec, const char *filename, int own, dtatwError *err)
+{
+  if (!spec) spec = &zio_output;
+  if (!f || spec->fmt == zioRaw) return f;
+#ifdef HAVE_FOPENCOOKIE
+  {
+    zioWriter *zw = zio_wopen(f, spec, filename, err);
+    if (!zw) return NULL;
+    return zio_cookie_open(f, filename, own, NULL, zw, NULL, err);
+  }
+#else
+  dtatw_error(err, 2, "`%s': compressed output is not supported by this build of %s (no fopencookie())",
+	      (filename ? filename : "?"), PACKAGE);
+  return NULL;
+#endif
+}
+
+//--------------------------------------------------------------
+FILE *zio_fwrap_async(FILE *f, const char *filename, int own, dtatwError *err)
+{
+#ifdef ZIO_ASYNC
+  zioAsync *za;
+  if (!f || !zio_async) return f;
+  if (!(za = zio_async_open(f))) return f; //-- couldn't create writer thread: write synchronously
+  return zio_cookie_open(f, filename, own, NULL, NULL, za, err);
+#else
+  return f;
+#endif
+}
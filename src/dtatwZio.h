@@ -0,0 +1,203 @@
+/*
+ * File: dtatwZio.h
+ * Author: Bryan Jurish <configure.ac>
+ * Description: DTA tokenizer wrappers: C utilities: libdtatw: transparent (de-)compression of file streams
+ */
+
+#ifndef DTATW_ZIO_H
+#define DTATW_ZIO_H
+
+#include "dtatwCommon.h"
+
+/*======================================================================
+ * zio: formats
+ *  + compressed input is detected by magic number, not by filename suffix
+ *  + compressed output is opt-in (see zio_fwrap_out())
+ *  + gzip requires zlib (HAVE_LIBZ), zstd requires libzstd (HAVE_LIBZSTD); see configure
+ */
+
+typedef enum {
+  zioRaw  = 0,  //-- uncompressed
+  zioGzip = 1,  //-- gzip (RFC 1952), possibly multi-member
+  zioZstd = 2   //-- zstd (RFC 8878), possibly multi-frame
+} zioFormat;
+
+extern const char *zioFormatNames[3];  //-- "raw", "gzip", "zstd"
+
+//-- ZIO_MAGIC_LEN: number of leading bytes inspected by zio_detect()
+#define ZIO_MAGIC_LEN 4
+
+// fmt = zio_detect(buf,len)
+//  + detects compression format from the first len (<= ZIO_MAGIC_LEN) bytes of a stream
+zioFormat zio_detect(const unsigned char *buf, size_t len);
+
+// fmt = zio_sniff(f)
+//  + detects compression format of seekable f at its current position, which is restored
+zioFormat zio_sniff(FILE *f);
+
+// bool = zio_supported(fmt)
+//  + true iff fmt can be decompressed by this build
+int zio_supported(zioFormat fmt);
+
+/*======================================================================
+ * zio: reader
+ *  + transparent reading of (possibly) compressed FILE* streams; the underlying FILE* is not closed
+ *  + compressed input: with pthreads, decompression runs in a separate thread filling a ring of
+ *    ZIO_NBUFS buffers of ZIO_BUFSIZE bytes each, so decompression overlaps with the consumer
+ *    (e.g. expat); without pthreads, buffers are decompressed on demand
+ *  + uncompressed input is fread() directly into the caller's buffer
+ *  + byte counts and offsets always refer to the uncompressed stream
+ */
+
+//-- ZIO_NBUFS: number of decompressed buffers in the ring
+#ifndef ZIO_NBUFS
+# define ZIO_NBUFS 4
+#endif
+
+//-- ZIO_BUFSIZE: size of each decompressed (and compressed input) buffer
+#ifndef ZIO_BUFSIZE
+# define ZIO_BUFSIZE 65536
+#endif
+
+typedef struct zioReader_ zioReader;
+
+// zr = zio_open(f,filename,err)
+//  + opens a reader for f, detecting compression from the first ZIO_MAGIC_LEN bytes (works for pipes)
+//  + returns NULL and sets err if f is compressed in an unsupported format
+//  + filename is used for error messages only
+zioReader *zio_open(FILE *f, const char *filename, dtatwError *err);
+
+// nread = zio_read(zr,buf,len)
+//  + reads up to len uncompressed bytes into buf, as for fread(): short counts only at EOF or on error
+size_t zio_read(zioReader *zr, void *buf, size_t len);
+
+// bool = zio_eof(zr)
+//  + true iff the end of the (uncompressed) stream has been reached, or reading stopped on error
+int zio_eof(const zioReader *zr);
+
+// code = zio_error(zr)
+//  + error code of zr (0 if none); message (without filename) is available via zio_errmsg()
+int zio_error(const zioReader *zr);
+const char *zio_errmsg(const zioReader *zr);
+
+// fmt = zio_format(zr)
+zioFormat zio_format(const zioReader *zr);
+
+// len = zio_slurp(zr,&buf)
+//  + reads all remaining uncompressed data into newly malloc()d *buf (caller must free())
+//  + on error, *buf is NULL and zio_error(zr) is non-zero
+size_t zio_slurp(zioReader *zr, char **bufp);
+
+// zio_close(zr)
+//  + stops decompression (if running) and frees zr; does not close the underlying FILE*
+void zio_close(zioReader *zr);
+
+// len = zio_fslurp(f,filename,&buf,err)
+//  + convenience wrapper: zio_open(), zio_slurp(), zio_close()
+//  + returns 0 with *buf==NULL and sets err on error
+size_t zio_fslurp(FILE *f, const char *filename, char **bufp, dtatwError *err);
+
+/*======================================================================
+ * zio: writer
+ *  + opt-in compressed output for intermediate files (see zio_getopt())
+ *  + zstd output uses the zstd "seekable" format: independent frames of at most ZIO_FRAME_SIZE
+ *    uncompressed bytes each, followed by a skippable frame holding the seek table
+ *    (compressed & decompressed size of each frame); ordinary zstd decoders (including zio_open())
+ *    read it as a multi-frame stream
+ *  + gzip output is a single gzip member
+ *  + compression is synchronous (in the caller's thread)
+ */
+
+//-- ZIO_FRAME_SIZE: maximum uncompressed size of a single zstd output frame
+#ifndef ZIO_FRAME_SIZE
+# define ZIO_FRAME_SIZE (1<<20)
+#endif
+
+//-- zioSpec: output compression specification
+typedef struct {
+  zioFormat fmt;     //-- output format (zioRaw for none)
+  int       level;   //-- compression level; 0 for the library default
+} zioSpec;
+
+//-- zio_output: process-global default output compression (default: none); set by zio_getopt()
+extern zioSpec zio_output;
+
+// status = zio_parse_spec(str,spec,err)
+//  + parses str as FORMAT[:LEVEL], where FORMAT is one of "zstd", "gzip", "none" (or "raw", "")
+//  + returns 0 on success, otherwise sets err; fails if FORMAT is not supported by this build
+int zio_parse_spec(const char *str, zioSpec *spec, dtatwError *err);
+
+// bool = zio_getopt(&argc,argv)
+//  + parses and removes --compress=SPEC and --sync-output options from argv into zio_output and zio_async
+//    (cf. dtatw_stats_getopt())
+//  + exits with an error message on bad SPEC
+//  + returns true iff output compression is enabled
+int zio_getopt(int *argcp, char **argv);
+
+typedef struct zioWriter_ zioWriter;
+
+// zw = zio_wopen(f,spec,filename,err)
+//  + opens a compressing writer on f; spec->fmt must be zioGzip or zioZstd
+//  + returns NULL and sets err on failure; filename is used for error messages only
+zioWriter *zio_wopen(FILE *f, const zioSpec *spec, const char *filename, dtatwError *err);
+
+// nwritten = zio_write(zw,buf,len)
+//  + compresses len bytes from buf; returns len on success, less on error (see zio_werror())
+size_t zio_write(zioWriter *zw, const void *buf, size_t len);
+
+// code = zio_werror(zw)
+int zio_werror(const zioWriter *zw);
+const char *zio_werrmsg(const zioWriter *zw);
+
+// status = zio_wclose(zw,err)
+//  + flushes pending data, writes trailers (e.g. the zstd seek table) and frees zw
+//  + does not close the underlying FILE*; returns 0 on success, otherwise the writer's error code
+//  + on error, the writer's error status is copied to err (if non-NULL)
+int zio_wclose(zioWriter *zw, dtatwError *err);
+
+/*======================================================================
+ * zio: asynchronous output
+ *  + output is copied into a ring of ZIO_NBUFS buffers of ZIO_ABUFSIZE bytes each, which a separate
+ *    writer thread drains to the underlying FILE* with one fwrite() per full buffer, so that I/O
+ *    (and compression, if the underlying FILE* is a zio_fwrap_out() wrapper) overlaps with the producer
+ *  + the producer blocks only if all ZIO_NBUFS buffers are waiting to be written
+ *  + requires pthreads and fopencookie(); see zio_fwrap_async()
+ */
+
+//-- ZIO_ABUFSIZE: size of each asynchronous output buffer
+#ifndef ZIO_ABUFSIZE
+# define ZIO_ABUFSIZE (1<<20)
+#endif
+
+//-- zio_async: process-global default for zio_fwrap_async() (default: enabled); cleared by --sync-output
+extern int zio_async;
+
+/*======================================================================
+ * zio: stdio wrappers
+ *  + wrap (de-)compression in a FILE* (via fopencookie(), where available),
+ *    so that existing stdio-based readers and writers work unchanged
+ *  + ftello() on a wrapped FILE* reports the uncompressed position; other seeks fail
+ *  + if own is true, fclose() on the wrapper also closes f
+ */
+
+// fz = zio_fwrap_in(f,filename,own,err)
+//  + returns f itself if it is not compressed, otherwise a new FILE* reading the decompressed stream
+//  + returns NULL and sets err if f is compressed in an unsupported format
+//  + decompression errors are reported to stderr and as read errors (ferror())
+FILE *zio_fwrap_in(FILE *f, const char *filename, int own, dtatwError *err);
+
+// fz = zio_fwrap_out(f,spec,filename,own,err)
+//  + returns f itself if spec (default: &zio_output) is uncompressed, otherwise a new compressing FILE*
+//  + returns NULL and sets err on failure
+//  + compression errors are reported to stderr and as write errors (ferror(), fclose())
+FILE *zio_fwrap_out(FILE *f, const zioSpec *spec, const char *filename, int own, dtatwError *err);
+
+// fa = zio_fwrap_async(f,filename,own,err)
+//  + returns a new FILE* whose output is written to f by a separate writer thread (see "asynchronous output"),
+//    or f itself if zio_async is false or this build lacks pthreads or fopencookie()
+//  + fflush() on the wrapper does not wait for the writer thread; fclose() does
+//  + write errors are reported to stderr and as write errors (ferror(), fclose())
+//  + returns NULL and sets err on failure
+FILE *zio_fwrap_async(FILE *f, const char *filename, int own, dtatwError *err);
+
+#endif /* DTATW_ZIO_H */